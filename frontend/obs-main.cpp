@@ -997,6 +997,9 @@ int main(int argc, char *argv[])
 		} else if (arg_is(argv[i], "--unfiltered_log", nullptr)) {
 			unfiltered_log = true;
 
+		} else if (arg_is(argv[i], "--memory-pool", nullptr)) {
+			bmem_set_pool_enabled(true);
+
 		} else if (arg_is(argv[i], "--startstreaming", nullptr)) {
 			opt_start_streaming = true;
 
@@ -1064,6 +1067,7 @@ int main(int argc, char *argv[])
 				"--verbose: Make log more verbose.\n"
 				"--always-on-top: Start in 'always on top' mode.\n\n"
 				"--unfiltered_log: Make log unfiltered.\n\n"
+				"--memory-pool: Serve small allocations from a size class pool.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
 				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n";
 
@@ -1116,6 +1120,18 @@ int main(int argc, char *argv[])
 #endif
 
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
+
+	struct bmem_stats mem_stats;
+	bmem_get_stats(&mem_stats);
+	if (mem_stats.pool_enabled) {
+		blog(LOG_INFO,
+		     "Memory pool: %llu hits, %llu misses, %llu bytes reserved, %llu bytes cached, "
+		     "%.1f%% fragmentation",
+		     (unsigned long long)mem_stats.pool_hits, (unsigned long long)mem_stats.pool_misses,
+		     (unsigned long long)mem_stats.reserved_bytes, (unsigned long long)mem_stats.cached_bytes,
+		     mem_stats.fragmentation * 100.0);
+	}
+
 	base_set_log_handler(nullptr, nullptr);
 
 	if (restart || restart_safe) {
@@ -655,8 +655,10 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 #endif
 	delete ui->processPriorityLabel;
 	delete ui->processPriority;
+#ifndef __linux__
 	delete ui->enableNewSocketLoop;
 	delete ui->enableLowLatencyMode;
+#endif
 	delete ui->hideOBSFromCapture;
 #if !defined(__APPLE__) && !defined(__linux__)
 	delete ui->browserHWAccel;
@@ -666,8 +668,10 @@ OBSBasicSettings::OBSBasicSettings(QWidget *parent)
 
 	ui->processPriorityLabel = nullptr;
 	ui->processPriority = nullptr;
+#ifndef __linux__
 	ui->enableNewSocketLoop = nullptr;
 	ui->enableLowLatencyMode = nullptr;
+#endif
 	ui->hideOBSFromCapture = nullptr;
 #if !defined(__APPLE__) && !defined(__linux__)
 	ui->browserHWAccel = nullptr;
@@ -2676,14 +2680,16 @@ void OBSBasicSettings::LoadAdvancedSettings()
 	ui->disableAudioDucking->setChecked(disableAudioDucking);
 
 	const char *processPriority = config_get_string(App()->GetAppConfig(), "General", "ProcessPriority");
-	bool enableNewSocketLoop = config_get_bool(main->Config(), "Output", "NewSocketLoopEnable");
-	bool enableLowLatencyMode = config_get_bool(main->Config(), "Output", "LowLatencyEnable");
 
 	int idx = ui->processPriority->findData(processPriority);
 	if (idx == -1) {
 		idx = ui->processPriority->findData("Normal");
 	}
 	ui->processPriority->setCurrentIndex(idx);
+#endif
+#if defined(_WIN32) || defined(__linux__)
+	bool enableNewSocketLoop = config_get_bool(main->Config(), "Output", "NewSocketLoopEnable");
+	bool enableLowLatencyMode = config_get_bool(main->Config(), "Output", "LowLatencyEnable");
 
 	ui->enableNewSocketLoop->setChecked(enableNewSocketLoop);
 	ui->enableLowLatencyMode->setChecked(enableLowLatencyMode);
@@ -3282,7 +3288,8 @@ void OBSBasicSettings::SaveAdvancedSettings()
 	if (main->Active()) {
 		SetProcessPriority(priority.c_str());
 	}
-
+#endif
+#if defined(_WIN32) || defined(__linux__)
 	SaveCheckBox(ui->enableNewSocketLoop, "Output", "NewSocketLoopEnable");
 	SaveCheckBox(ui->enableLowLatencyMode, "Output", "LowLatencyEnable");
 #endif
@@ -5847,7 +5854,7 @@ void OBSBasicSettings::UpdateAdvNetworkGroup()
 	ui->dynBitrate->setVisible(enabled);
 	ui->ipFamilyLabel->setVisible(enabled);
 	ui->ipFamily->setVisible(enabled);
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	ui->enableNewSocketLoop->setVisible(enabled);
 	ui->enableLowLatencyMode->setVisible(enabled);
 #endif
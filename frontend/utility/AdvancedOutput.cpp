@@ -728,7 +728,7 @@ bool AdvancedOutput::StartStreaming(obs_service_t *service)
 	bool preserveDelay = config_get_bool(main->Config(), "Output", "DelayPreserve");
 	const char *bindIP = config_get_string(main->Config(), "Output", "BindIP");
 	const char *ipFamily = config_get_string(main->Config(), "Output", "IPFamily");
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	bool enableNewSocketLoop = config_get_bool(main->Config(), "Output", "NewSocketLoopEnable");
 	bool enableLowLatencyMode = config_get_bool(main->Config(), "Output", "LowLatencyEnable");
 #endif
@@ -746,7 +746,7 @@ bool AdvancedOutput::StartStreaming(obs_service_t *service)
 	OBSDataAutoRelease settings = obs_data_create();
 	obs_data_set_string(settings, "bind_ip", bindIP);
 	obs_data_set_string(settings, "ip_family", ipFamily);
-#ifdef _WIN32
+#if defined(_WIN32) || defined(__linux__)
 	obs_data_set_bool(settings, "new_socket_loop_enabled", enableNewSocketLoop);
 	obs_data_set_bool(settings, "low_latency_mode_enabled", enableLowLatencyMode);
 #endif
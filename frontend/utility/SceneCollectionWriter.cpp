@@ -0,0 +1,133 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "SceneCollectionWriter.hpp"
+
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <algorithm>
+
+namespace {
+constexpr uint64_t SlowSaveThresholdNs = 500000000;
+
+inline double nsToMs(uint64_t ns)
+{
+	return static_cast<double>(ns) / 1000000.0;
+}
+} // namespace
+
+SceneCollectionWriter::SceneCollectionWriter() : thread(&SceneCollectionWriter::Run, this) {}
+
+SceneCollectionWriter::~SceneCollectionWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	pendingCondition.notify_one();
+	thread.join();
+}
+
+void SceneCollectionWriter::Queue(OBSData data, const std::string &filePath, uint64_t snapshotTimeNs,
+				  WriteCallback callback)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto isSameFile = [&filePath](const PendingWrite &write) {
+			return write.filePath == filePath;
+		};
+		auto existing = std::find_if(pending.begin(), pending.end(), isSameFile);
+
+		if (existing != pending.end()) {
+			existing->data = std::move(data);
+			existing->snapshotTimeNs = snapshotTimeNs;
+			existing->coalesced++;
+			existing->callback = std::move(callback);
+			return;
+		}
+
+		pending.push_back({std::move(data), filePath, snapshotTimeNs, os_gettime_ns(), 0, std::move(callback)});
+	}
+
+	pendingCondition.notify_one();
+}
+
+void SceneCollectionWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idleCondition.wait(lock, [this]() { return pending.empty() && !writing; });
+}
+
+void SceneCollectionWriter::Run()
+{
+	os_set_thread_name("scene collection writer");
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+		pendingCondition.wait(lock, [this]() { return stopping || !pending.empty(); });
+
+		/* anything still queued when stopping is written before exiting */
+		if (pending.empty()) {
+			break;
+		}
+
+		PendingWrite write = std::move(pending.front());
+		pending.pop_front();
+		writing = true;
+
+		lock.unlock();
+		Write(write);
+		lock.lock();
+
+		writing = false;
+
+		if (pending.empty()) {
+			idleCondition.notify_all();
+		}
+	}
+}
+
+void SceneCollectionWriter::Write(PendingWrite &write)
+{
+	uint64_t startTime = os_gettime_ns();
+	bool success = obs_data_save_json_pretty_safe(write.data, write.filePath.c_str(), "tmp", "bak");
+	uint64_t endTime = os_gettime_ns();
+
+	/* the snapshot is released here, off the UI thread as well */
+	write.data = nullptr;
+
+	if (!success) {
+		blog(LOG_ERROR, "Could not save scene data to %s", write.filePath.c_str());
+	} else {
+		uint64_t writeTimeNs = endTime - startTime;
+		int level = writeTimeNs + write.snapshotTimeNs >= SlowSaveThresholdNs ? LOG_INFO : LOG_DEBUG;
+
+		blog(level,
+		     "Saved scene data to %s (snapshot: %.1f ms, write: %.1f ms, queued: %.1f ms, "
+		     "coalesced saves: %d)",
+		     write.filePath.c_str(), nsToMs(write.snapshotTimeNs), nsToMs(writeTimeNs),
+		     nsToMs(startTime - write.queuedTime), write.coalesced);
+	}
+
+	if (write.callback) {
+		write.callback(success);
+	}
+}
@@ -0,0 +1,72 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/* Serializes and writes scene collections on a separate thread.
+ *
+ * Queued data must not be modified by anything else afterwards, so callers
+ * pass a snapshot of the collection.  If a file is queued again before its
+ * previous snapshot was written, only the newest snapshot is written. */
+class SceneCollectionWriter {
+public:
+	/* called on the writer thread once the file was written */
+	using WriteCallback = std::function<void(bool success)>;
+
+	SceneCollectionWriter();
+	~SceneCollectionWriter();
+
+	SceneCollectionWriter(const SceneCollectionWriter &) = delete;
+	SceneCollectionWriter &operator=(const SceneCollectionWriter &) = delete;
+
+	void Queue(OBSData data, const std::string &filePath, uint64_t snapshotTimeNs, WriteCallback callback = {});
+
+	/* blocks until every queued snapshot has been written */
+	void Flush();
+
+private:
+	struct PendingWrite {
+		OBSData data;
+		std::string filePath;
+		uint64_t snapshotTimeNs;
+		uint64_t queuedTime;
+		int coalesced;
+		WriteCallback callback;
+	};
+
+	std::mutex mutex;
+	std::condition_variable pendingCondition;
+	std::condition_variable idleCondition;
+	std::deque<PendingWrite> pending;
+	bool writing = false;
+	bool stopping = false;
+
+	std::thread thread;
+
+	void Run();
+	void Write(PendingWrite &write);
+};
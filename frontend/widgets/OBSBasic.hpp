@@ -26,6 +26,7 @@
 #include <utility/BasicOutputHandler.hpp>
 #include <utility/OBSCanvas.hpp>
 #include <utility/PreviewProgramSizeObserver.hpp>
+#include <utility/SceneCollectionWriter.hpp>
 #include <utility/VCamConfig.hpp>
 #include <utility/platform.hpp>
 #include <utility/undo_stack.hpp>
@@ -1076,6 +1077,8 @@ private:
 	bool projectChanged = false;
 	bool clearingFailed = false;
 
+	SceneCollectionWriter sceneCollectionWriter;
+
 	QPointer<OBSMissingFiles> missDialog;
 
 	OBSSceneCollectionCache collections;
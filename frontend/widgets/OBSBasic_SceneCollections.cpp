@@ -27,7 +27,9 @@
 #include <QDir>
 
 #include <filesystem>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 extern bool safe_mode;
@@ -43,6 +45,7 @@ using SceneCollection = OBS::SceneCollection;
 // MARK: Constant Expressions
 
 static constexpr std::string_view SceneCollectionPath = "/obs-studio/basic/scenes/";
+static constexpr std::string_view SceneCollectionIndexFile = "collections.index";
 
 namespace DataKeys {
 static constexpr std::string_view AbsoluteCoordinates = "AbsoluteCoordinates";
@@ -58,6 +61,105 @@ static constexpr std::string_view Remigrate = "Basic.MainMenu.SceneCollection.Re
 namespace {
 QList<QString> sortedSceneCollections{};
 
+/* Maps collection file names to their collection names, so that only
+ * collections that changed since they were last seen have to be parsed. */
+struct SceneCollectionIndexEntry {
+	std::string name;
+	long long modifiedTime;
+	unsigned long long size;
+};
+
+using SceneCollectionIndex = std::unordered_map<std::string, SceneCollectionIndexEntry>;
+
+/* Saves update the index from the scene collection writer thread */
+std::mutex sceneCollectionIndexMutex;
+SceneCollectionIndex sceneCollectionIndex{};
+
+bool getFileInfo(const std::filesystem::path &filePath, long long &modifiedTime, unsigned long long &size)
+{
+	std::error_code error;
+
+	auto fileTime = std::filesystem::last_write_time(filePath, error);
+	if (error) {
+		return false;
+	}
+
+	auto fileSize = std::filesystem::file_size(filePath, error);
+	if (error) {
+		return false;
+	}
+
+	modifiedTime = static_cast<long long>(fileTime.time_since_epoch().count());
+	size = static_cast<unsigned long long>(fileSize);
+	return true;
+}
+
+SceneCollectionIndex loadSceneCollectionIndex(const std::filesystem::path &indexFilePath)
+{
+	SceneCollectionIndex index{};
+
+	OBSDataAutoRelease indexData = obs_data_create_from_json_file(indexFilePath.u8string().c_str());
+	OBSDataArrayAutoRelease entries = obs_data_get_array(indexData, "collections");
+
+	size_t count = obs_data_array_count(entries);
+	for (size_t i = 0; i < count; i++) {
+		OBSDataAutoRelease entry = obs_data_array_item(entries, i);
+
+		std::string fileName = obs_data_get_string(entry, "file");
+		std::string name = obs_data_get_string(entry, "name");
+
+		if (fileName.empty() || name.empty()) {
+			continue;
+		}
+
+		index[fileName] = {name, obs_data_get_int(entry, "mtime"),
+				   static_cast<unsigned long long>(obs_data_get_int(entry, "size"))};
+	}
+
+	return index;
+}
+
+void saveSceneCollectionIndex(const std::filesystem::path &indexFilePath, const SceneCollectionIndex &index)
+{
+	OBSDataAutoRelease indexData = obs_data_create();
+	OBSDataArrayAutoRelease entries = obs_data_array_create();
+
+	for (const auto &[fileName, indexEntry] : index) {
+		OBSDataAutoRelease entry = obs_data_create();
+
+		obs_data_set_string(entry, "file", fileName.c_str());
+		obs_data_set_string(entry, "name", indexEntry.name.c_str());
+		obs_data_set_int(entry, "mtime", indexEntry.modifiedTime);
+		obs_data_set_int(entry, "size", static_cast<long long>(indexEntry.size));
+
+		obs_data_array_push_back(entries, entry);
+	}
+
+	obs_data_set_array(indexData, "collections", entries);
+
+	if (!obs_data_save_json_safe(indexData, indexFilePath.u8string().c_str(), "tmp", nullptr)) {
+		blog(LOG_WARNING, "Failed to save scene collection index");
+	}
+}
+
+void updateSceneCollectionIndex(const std::filesystem::path &collectionFilePath, const std::string &collectionName)
+{
+	if (collectionName.empty()) {
+		return;
+	}
+
+	SceneCollectionIndexEntry indexEntry{collectionName, 0, 0};
+
+	if (!getFileInfo(collectionFilePath, indexEntry.modifiedTime, indexEntry.size)) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(sceneCollectionIndexMutex);
+
+	sceneCollectionIndex[collectionFilePath.filename().u8string()] = std::move(indexEntry);
+	saveSceneCollectionIndex(collectionFilePath.parent_path() / SceneCollectionIndexFile, sceneCollectionIndex);
+}
+
 void updateSortedSceneCollections(const OBSSceneCollectionCache &collections)
 {
 	const QLocale locale = QLocale::system();
@@ -437,6 +539,11 @@ void OBSBasic::RefreshSceneCollectionCache()
 		return;
 	}
 
+	const std::filesystem::path indexFilePath = collectionsPath / SceneCollectionIndexFile;
+	const SceneCollectionIndex previousIndex = loadSceneCollectionIndex(indexFilePath);
+	SceneCollectionIndex foundIndex{};
+	bool indexChanged = false;
+
 	for (const auto &entry : std::filesystem::directory_iterator(collectionsPath)) {
 		if (entry.is_directory()) {
 			continue;
@@ -446,22 +553,47 @@ void OBSBasic::RefreshSceneCollectionCache()
 			continue;
 		}
 
-		OBSDataAutoRelease collectionData =
-			obs_data_create_from_json_file_safe(entry.path().u8string().c_str(), "bak");
+		const std::string fileName = entry.path().filename().u8string();
+		SceneCollectionIndexEntry indexEntry{};
+		bool hasFileInfo = getFileInfo(entry.path(), indexEntry.modifiedTime, indexEntry.size);
 
-		std::string candidateName;
-		std::string collectionName = obs_data_get_string(collectionData, "name");
+		const auto &previousEntry = previousIndex.find(fileName);
 
-		if (collectionName.empty()) {
-			candidateName = entry.path().stem().u8string();
+		if (hasFileInfo && previousEntry != previousIndex.end() &&
+		    previousEntry->second.modifiedTime == indexEntry.modifiedTime &&
+		    previousEntry->second.size == indexEntry.size) {
+			indexEntry.name = previousEntry->second.name;
 		} else {
-			candidateName = std::move(collectionName);
+			OBSDataAutoRelease collectionData =
+				obs_data_create_from_json_file_safe(entry.path().u8string().c_str(), "bak");
+
+			std::string collectionName = obs_data_get_string(collectionData, "name");
+
+			if (collectionName.empty()) {
+				indexEntry.name = entry.path().stem().u8string();
+			} else {
+				indexEntry.name = std::move(collectionName);
+			}
+
+			indexChanged = true;
 		}
 
-		foundCollections.try_emplace(candidateName, candidateName, entry.path());
+		foundCollections.try_emplace(indexEntry.name, indexEntry.name, entry.path());
+
+		if (hasFileInfo) {
+			foundIndex[fileName] = std::move(indexEntry);
+		}
 	}
 
 	collections.swap(foundCollections);
+
+	std::lock_guard<std::mutex> lock(sceneCollectionIndexMutex);
+
+	if (indexChanged || foundIndex.size() != previousIndex.size()) {
+		saveSceneCollectionIndex(indexFilePath, foundIndex);
+	}
+
+	sceneCollectionIndex.swap(foundIndex);
 }
 
 SceneCollection &OBSBasic::GetCurrentSceneCollection()
@@ -805,6 +937,7 @@ constexpr std::string_view AUX_AUDIO_4{"AuxAudioDevice4"};
 
 void OBSBasic::Save(SceneCollection &collection)
 {
+	uint64_t startTime = os_gettime_ns();
 	OBSDataAutoRelease saveData = obs_data_create();
 
 	// Scene collection name
@@ -981,12 +1114,22 @@ void OBSBasic::Save(SceneCollection &collection)
 	int sceneCollectionVersion = collection.getVersion();
 	obs_data_set_int(saveData, "version", sceneCollectionVersion);
 
-	const std::string collectionFileName = collection.getFilePathString();
-	bool success = obs_data_save_json_pretty_safe(saveData, collectionFileName.c_str(), "tmp", "bak");
+	// The save data references live objects such as source settings, which can change while the file is being
+	// written, so the writer gets its own copy.
+	OBSDataAutoRelease snapshot = obs_data_create();
+	obs_data_apply(snapshot, saveData);
 
-	if (!success) {
-		blog(LOG_ERROR, "Could not save scene data to %s", collectionFileName.c_str());
-	}
+	uint64_t snapshotTime = os_gettime_ns() - startTime;
+
+	std::filesystem::path collectionFilePath = collection.getFilePath();
+	std::string collectionName = sceneCollection ? sceneCollection : "";
+
+	sceneCollectionWriter.Queue(snapshot.Get(), collection.getFilePathString(), snapshotTime,
+				    [collectionFilePath, collectionName](bool success) {
+					    if (success) {
+						    updateSceneCollectionIndex(collectionFilePath, collectionName);
+					    }
+				    });
 }
 
 void OBSBasic::DeferSaveBegin()
@@ -1521,12 +1664,13 @@ retryScene:
 
 void OBSBasic::SaveProjectNow()
 {
-	if (disableSaving) {
-		return;
+	if (!disableSaving) {
+		projectChanged = true;
+		SaveProjectDeferred();
 	}
 
-	projectChanged = true;
-	SaveProjectDeferred();
+	// Callers rely on the file being up to date once this returns
+	sceneCollectionWriter.Flush();
 }
 
 void OBSBasic::SaveProject()
@@ -62,10 +62,14 @@ static inline const char *cd_serialize_string(uint8_t **pos)
 static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
 {
 	size_t name_size;
+	size_t target_size;
 
 	if (!data->size)
 		return false;
 
+	/* names are stored with their size, so most parameters can be skipped
+	 * without comparing strings */
+	target_size = strlen(name) + 1;
 	*pos = data->stack;
 
 	name_size = cd_serialize_size(pos);
@@ -74,7 +78,7 @@ static bool cd_getparam(const calldata_t *data, const char *name, uint8_t **pos)
 		size_t param_size;
 
 		*pos += name_size;
-		if (strcmp(param_name, name) == 0)
+		if (name_size == target_size && memcmp(param_name, name, target_size) == 0)
 			return true;
 
 		param_size = cd_serialize_size(pos);
@@ -14,12 +14,86 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <stdlib.h>
+
 #include "../util/darray.h"
 #include "../util/threading.h"
+#include "../util/uthash.h"
 
 #include "decl.h"
 #include "signal.h"
 
+/* ------------------------------------------------------------------------- */
+/* signal IDs
+ *
+ *   Signal names are interned into a global table, so that a signal can be
+ * looked up by its ID, which is an index into a per-handler array, instead of
+ * by name.  IDs stay valid for the lifetime of the process, which is why the
+ * table uses malloc rather than bmalloc: it would show up as leaked memory
+ * otherwise. */
+
+#define SIGNAL_ID_BUCKETS 256
+
+struct signal_id {
+	struct signal_id *next;
+	size_t index;
+	char name[];
+};
+
+static pthread_mutex_t signal_ids_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct signal_id *signal_id_buckets[SIGNAL_ID_BUCKETS];
+static size_t num_signal_ids = 0;
+
+static inline uint32_t hash_signal_name(const char *name)
+{
+	/* FNV-1a */
+	uint32_t hash = 2166136261u;
+	while (*name) {
+		hash ^= (uint8_t)*(name++);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+signal_id_t signal_get_id(const char *name)
+{
+	struct signal_id *id;
+	size_t len;
+
+	if (!name)
+		return NULL;
+
+	struct signal_id **bucket = &signal_id_buckets[hash_signal_name(name) % SIGNAL_ID_BUCKETS];
+
+	pthread_mutex_lock(&signal_ids_mutex);
+
+	for (id = *bucket; id; id = id->next) {
+		if (strcmp(id->name, name) == 0)
+			goto done;
+	}
+
+	len = strlen(name);
+	id = malloc(sizeof(*id) + len + 1);
+	if (!id)
+		bcrash("Out of memory while trying to allocate signal ID");
+
+	memcpy(id->name, name, len + 1);
+	id->index = num_signal_ids++;
+	id->next = *bucket;
+	*bucket = id;
+
+done:
+	pthread_mutex_unlock(&signal_ids_mutex);
+	return id;
+}
+
+const char *signal_id_get_name(signal_id_t id)
+{
+	return id ? id->name : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct signal_callback {
 	signal_callback_t callback;
 	void *data;
@@ -29,18 +103,19 @@ struct signal_callback {
 
 struct signal_info {
 	struct decl_info func;
+	signal_id_t id;
 	DARRAY(struct signal_callback) callbacks;
 	pthread_mutex_t mutex;
 	bool signalling;
 
-	struct signal_info *next;
+	UT_hash_handle hh;
 };
 
 static inline struct signal_info *signal_info_create(struct decl_info *info)
 {
-	struct signal_info *si = bmalloc(sizeof(struct signal_info));
+	struct signal_info *si = bzalloc(sizeof(struct signal_info));
 	si->func = *info;
-	si->next = NULL;
+	si->id = signal_get_id(info->name);
 	si->signalling = false;
 	da_init(si->callbacks);
 
@@ -85,7 +160,9 @@ struct global_callback_info {
 };
 
 struct signal_handler {
-	struct signal_info *first;
+	/* hashed by name, and indexed by signal ID */
+	struct signal_info *signals;
+	DARRAY(struct signal_info *) signals_by_id;
 	pthread_mutex_t mutex;
 	volatile long refs;
 
@@ -93,30 +170,23 @@ struct signal_handler {
 	pthread_mutex_t global_callbacks_mutex;
 };
 
-static struct signal_info *getsignal(signal_handler_t *handler, const char *name, struct signal_info **p_last)
+static inline struct signal_info *getsignal(signal_handler_t *handler, const char *name)
 {
-	struct signal_info *signal, *last = NULL;
-
-	signal = handler->first;
-	while (signal != NULL) {
-		if (strcmp(signal->func.name, name) == 0)
-			break;
-
-		last = signal;
-		signal = signal->next;
-	}
-
-	if (p_last)
-		*p_last = last;
+	struct signal_info *signal;
+	HASH_FIND_STR(handler->signals, name, signal);
 	return signal;
 }
 
+static inline struct signal_info *getsignal_by_id(signal_handler_t *handler, signal_id_t id)
+{
+	return id->index < handler->signals_by_id.num ? handler->signals_by_id.array[id->index] : NULL;
+}
+
 /* ------------------------------------------------------------------------- */
 
 signal_handler_t *signal_handler_create(void)
 {
 	struct signal_handler *handler = bzalloc(sizeof(struct signal_handler));
-	handler->first = NULL;
 	handler->refs = 1;
 
 	if (pthread_mutex_init(&handler->mutex, NULL) != 0) {
@@ -137,13 +207,14 @@ signal_handler_t *signal_handler_create(void)
 
 static void signal_handler_actually_destroy(signal_handler_t *handler)
 {
-	struct signal_info *sig = handler->first;
-	while (sig != NULL) {
-		struct signal_info *next = sig->next;
+	struct signal_info *sig, *tmp;
+
+	HASH_ITER (hh, handler->signals, sig, tmp) {
+		HASH_DELETE(hh, handler->signals, sig);
 		signal_info_destroy(sig);
-		sig = next;
 	}
 
+	da_free(handler->signals_by_id);
 	da_free(handler->global_callbacks);
 	pthread_mutex_destroy(&handler->global_callbacks_mutex);
 	pthread_mutex_destroy(&handler->mutex);
@@ -160,7 +231,7 @@ void signal_handler_destroy(signal_handler_t *handler)
 bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 {
 	struct decl_info func = {0};
-	struct signal_info *sig, *last;
+	struct signal_info *sig;
 	bool success = true;
 
 	if (!parse_decl_string(&func, signal_decl)) {
@@ -170,17 +241,27 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 
 	pthread_mutex_lock(&handler->mutex);
 
-	sig = getsignal(handler, func.name, &last);
+	sig = getsignal(handler, func.name);
 	if (sig) {
 		blog(LOG_WARNING, "Signal declaration '%s' exists", func.name);
 		decl_info_free(&func);
 		success = false;
 	} else {
 		sig = signal_info_create(&func);
-		if (!last)
-			handler->first = sig;
-		else
-			last->next = sig;
+	}
+
+	if (sig && success) {
+		size_t idx = sig->id->index;
+
+		HASH_ADD_KEYPTR(hh, handler->signals, sig->func.name, strlen(sig->func.name), sig);
+
+		if (idx >= handler->signals_by_id.num) {
+			size_t old_num = handler->signals_by_id.num;
+			da_resize(handler->signals_by_id, idx + 1);
+			memset(handler->signals_by_id.array + old_num, 0,
+			       (idx + 1 - old_num) * sizeof(*handler->signals_by_id.array));
+		}
+		handler->signals_by_id.array[idx] = sig;
 	}
 
 	pthread_mutex_unlock(&handler->mutex);
@@ -191,7 +272,7 @@ bool signal_handler_add(signal_handler_t *handler, const char *signal_decl)
 static void signal_handler_connect_internal(signal_handler_t *handler, const char *signal, signal_callback_t callback,
 					    void *data, bool keep_ref)
 {
-	struct signal_info *sig, *last;
+	struct signal_info *sig;
 	struct signal_callback cb_data = {callback, data, false, keep_ref};
 	size_t idx;
 
@@ -199,7 +280,7 @@ static void signal_handler_connect_internal(signal_handler_t *handler, const cha
 		return;
 
 	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, signal, &last);
+	sig = getsignal(handler, signal);
 	pthread_mutex_unlock(&handler->mutex);
 
 	if (!sig) {
@@ -242,7 +323,21 @@ static inline struct signal_info *getsignal_locked(signal_handler_t *handler, co
 		return NULL;
 
 	pthread_mutex_lock(&handler->mutex);
-	sig = getsignal(handler, name, NULL);
+	sig = getsignal(handler, name);
+	pthread_mutex_unlock(&handler->mutex);
+
+	return sig;
+}
+
+static inline struct signal_info *getsignal_by_id_locked(signal_handler_t *handler, signal_id_t id)
+{
+	struct signal_info *sig;
+
+	if (!handler || !id)
+		return NULL;
+
+	pthread_mutex_lock(&handler->mutex);
+	sig = getsignal_by_id(handler, id);
 	pthread_mutex_unlock(&handler->mutex);
 
 	return sig;
@@ -287,14 +382,11 @@ void signal_handler_remove_current(void)
 		current_global_cb->remove = true;
 }
 
-void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+static void signal_handler_signal_internal(signal_handler_t *handler, struct signal_info *sig, calldata_t *params)
 {
-	struct signal_info *sig = getsignal_locked(handler, signal);
+	const char *signal = sig->func.name;
 	long remove_refs = 0;
 
-	if (!sig)
-		return;
-
 	pthread_mutex_lock(&sig->mutex);
 	sig->signalling = true;
 
@@ -350,6 +442,20 @@ void signal_handler_signal(signal_handler_t *handler, const char *signal, callda
 	}
 }
 
+void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params)
+{
+	struct signal_info *sig = getsignal_locked(handler, signal);
+	if (sig)
+		signal_handler_signal_internal(handler, sig, params);
+}
+
+void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params)
+{
+	struct signal_info *sig = getsignal_by_id_locked(handler, id);
+	if (sig)
+		signal_handler_signal_internal(handler, sig, params);
+}
+
 void signal_handler_connect_global(signal_handler_t *handler, global_signal_callback_t callback, void *data)
 {
 	struct global_callback_info cb_data = {callback, data, 0, false};
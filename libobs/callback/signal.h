@@ -36,6 +36,26 @@ typedef struct signal_handler signal_handler_t;
 typedef void (*global_signal_callback_t)(void *, const char *, calldata_t *);
 typedef void (*signal_callback_t)(void *, calldata_t *);
 
+/*
+ *   Signal names can be resolved to IDs once, and signals can then be emitted
+ * by ID, which skips looking the signal up by name.  IDs are shared between
+ * all signal handlers and remain valid for the lifetime of the process.
+ */
+
+struct signal_id;
+typedef const struct signal_id *signal_id_t;
+
+EXPORT signal_id_t signal_get_id(const char *name);
+EXPORT const char *signal_id_get_name(signal_id_t id);
+
+/* resolves the ID on first use, meant for static variables */
+static inline signal_id_t signal_get_id_cached(signal_id_t *id, const char *name)
+{
+	if (!*id)
+		*id = signal_get_id(name);
+	return *id;
+}
+
 EXPORT signal_handler_t *signal_handler_create(void);
 EXPORT void signal_handler_destroy(signal_handler_t *handler);
 
@@ -67,6 +87,7 @@ EXPORT void signal_handler_disconnect_global(signal_handler_t *handler, global_s
 EXPORT void signal_handler_remove_current(void);
 
 EXPORT void signal_handler_signal(signal_handler_t *handler, const char *signal, calldata_t *params);
+EXPORT void signal_handler_signal_id(signal_handler_t *handler, signal_id_t id, calldata_t *params);
 
 #ifdef __cplusplus
 }
@@ -19,6 +19,7 @@
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
 #include "vec4.h"
 
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -69,8 +70,266 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 	return bzalloc(size);
 }
 
+/* ------------------------------------------------------------------------- */
+/* streamed animations                                                       */
+
+#define DEFAULT_GIF_MEMORY_LIMIT (256ULL * 1024 * 1024)
+#define MIN_STREAM_FRAMES 2
+#define MAX_STREAM_FRAMES 16
+
+static uint64_t gif_memory_limit = DEFAULT_GIF_MEMORY_LIMIT;
+
+void gs_image_file_set_gif_memory_limit(uint64_t limit)
+{
+	gif_memory_limit = limit;
+}
+
+/* Frames are decoded in order on a worker thread into a small set of slots,
+ * which hold the frames from the playback position onwards.  libnsgif can
+ * only decode frames in sequence, so the gif decoder is only touched by the
+ * worker once it has been started. */
+struct gs_gif_stream {
+	gs_image_file_t *image;
+	enum gs_image_alpha_mode alpha_mode;
+	size_t frame_size;
+
+	pthread_t thread;
+	bool thread_active;
+	pthread_mutex_t mutex;
+	os_sem_t *sem;
+	bool stop;
+
+	size_t num_slots;
+	uint8_t *slot_data;
+	int *slot_frame;
+
+	int want_frame;
+	int shown_frame;
+	int decoded_pos;
+};
+
+static inline uint8_t *slot_ptr(struct gs_gif_stream *stream, size_t slot)
+{
+	return stream->slot_data + slot * stream->frame_size;
+}
+
+static inline int find_slot(struct gs_gif_stream *stream, int frame)
+{
+	for (size_t i = 0; i < stream->num_slots; i++) {
+		if (stream->slot_frame[i] == frame)
+			return (int)i;
+	}
+	return -1;
+}
+
+static inline bool in_window(struct gs_gif_stream *stream, int frame)
+{
+	int count = (int)stream->image->gif.frame_count;
+	int offset = (frame - stream->want_frame + count) % count;
+	return offset < (int)stream->num_slots;
+}
+
+/* finds the first frame from the playback position on that isn't decoded
+ * yet, along with a slot that doesn't hold a frame that is still needed */
+static bool next_job(struct gs_gif_stream *stream, int *frame, size_t *slot)
+{
+	int count = (int)stream->image->gif.frame_count;
+
+	*frame = -1;
+	for (size_t i = 0; i < stream->num_slots; i++) {
+		int f = (stream->want_frame + (int)i) % count;
+		if (find_slot(stream, f) == -1) {
+			*frame = f;
+			break;
+		}
+	}
+
+	if (*frame == -1)
+		return false;
+
+	for (size_t i = 0; i < stream->num_slots; i++) {
+		int f = stream->slot_frame[i];
+		if (f == -1 || !in_window(stream, f)) {
+			*slot = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool stream_decode(struct gs_gif_stream *stream, int frame, uint8_t *dst)
+{
+	gs_image_file_t *image = stream->image;
+	const size_t area = (size_t)image->gif.width * image->gif.height;
+
+	/* restart from the beginning when looping */
+	if (frame <= stream->decoded_pos) {
+		stream->decoded_pos = -1;
+		image->gif.decoded_frame = -1;
+	}
+
+	for (int i = stream->decoded_pos + 1; i <= frame; i++) {
+		if (gif_decode_frame(&image->gif, i) != GIF_OK)
+			return false;
+		stream->decoded_pos = i;
+	}
+
+	memcpy(dst, image->gif.frame_image, stream->frame_size);
+
+	if (stream->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB)
+		gs_premultiply_xyza_srgb_loop(dst, area);
+	else if (stream->alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY)
+		gs_premultiply_xyza_loop(dst, area);
+
+	return true;
+}
+
+static void *gif_stream_thread(void *data)
+{
+	struct gs_gif_stream *stream = data;
+	int frame;
+	size_t slot;
+
+	os_set_thread_name("gif decode thread");
+
+	for (;;) {
+		pthread_mutex_lock(&stream->mutex);
+		if (stream->stop) {
+			pthread_mutex_unlock(&stream->mutex);
+			break;
+		}
+
+		bool have_job = next_job(stream, &frame, &slot);
+		if (have_job)
+			stream->slot_frame[slot] = -1;
+
+		pthread_mutex_unlock(&stream->mutex);
+
+		if (!have_job) {
+			os_sem_wait(stream->sem);
+			continue;
+		}
+
+		bool success = stream_decode(stream, frame, slot_ptr(stream, slot));
+
+		pthread_mutex_lock(&stream->mutex);
+		if (success) {
+			stream->slot_frame[slot] = frame;
+		} else {
+			/* keep the frames that could be decoded playing */
+			stream->decoded_pos = -1;
+			stream->image->gif.decoded_frame = -1;
+		}
+		pthread_mutex_unlock(&stream->mutex);
+
+		if (!success) {
+			blog(LOG_WARNING, "Couldn't decode frame %d", frame);
+			os_sem_wait(stream->sem);
+		}
+	}
+
+	return NULL;
+}
+
+static struct gs_gif_stream *gif_stream_create(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+					       uint64_t *mem_usage)
+{
+	struct gs_gif_stream *stream = bzalloc(sizeof(*stream));
+	size_t frame_size = (size_t)image->gif.width * image->gif.height * 4;
+	uint64_t num_slots = gif_memory_limit / frame_size;
+
+	if (num_slots < MIN_STREAM_FRAMES)
+		num_slots = MIN_STREAM_FRAMES;
+	if (num_slots > MAX_STREAM_FRAMES)
+		num_slots = MAX_STREAM_FRAMES;
+
+	stream->image = image;
+	stream->alpha_mode = alpha_mode;
+	stream->frame_size = frame_size;
+	stream->num_slots = (size_t)num_slots;
+	stream->slot_data = alloc_mem(image, mem_usage, stream->num_slots * frame_size);
+	stream->slot_frame = bmalloc(stream->num_slots * sizeof(int));
+	stream->shown_frame = 0;
+	stream->decoded_pos = -1;
+
+	for (size_t i = 0; i < stream->num_slots; i++)
+		stream->slot_frame[i] = -1;
+
+	pthread_mutex_init_value(&stream->mutex);
+	if (pthread_mutex_init(&stream->mutex, NULL) != 0 || os_sem_init(&stream->sem, 0) != 0) {
+		pthread_mutex_destroy(&stream->mutex);
+		bfree(stream->slot_frame);
+		bfree(stream->slot_data);
+		bfree(stream);
+		return NULL;
+	}
+
+	return stream;
+}
+
+static void gif_stream_destroy(struct gs_gif_stream *stream)
+{
+	if (!stream)
+		return;
+
+	if (stream->thread_active) {
+		pthread_mutex_lock(&stream->mutex);
+		stream->stop = true;
+		pthread_mutex_unlock(&stream->mutex);
+
+		os_sem_post(stream->sem);
+		pthread_join(stream->thread, NULL);
+	}
+
+	os_sem_destroy(stream->sem);
+	pthread_mutex_destroy(&stream->mutex);
+	bfree(stream->slot_frame);
+	bfree(stream->slot_data);
+	bfree(stream);
+}
+
+/* moves the playback position, and returns whether the frame at it can be
+ * shown and isn't yet */
+static bool gif_stream_seek(struct gs_gif_stream *stream, int frame)
+{
+	bool ready;
+
+	pthread_mutex_lock(&stream->mutex);
+
+	/* the worker is started on first use, until then the gif decoder
+	 * still holds the first frame for gs_image_file_init_texture */
+	if (!stream->thread_active)
+		stream->thread_active = pthread_create(&stream->thread, NULL, gif_stream_thread, stream) == 0;
+
+	if (stream->want_frame != frame) {
+		stream->want_frame = frame;
+		os_sem_post(stream->sem);
+	}
+
+	ready = stream->shown_frame != frame && find_slot(stream, frame) != -1;
+
+	pthread_mutex_unlock(&stream->mutex);
+	return ready;
+}
+
+static void gif_stream_update_texture(struct gs_gif_stream *stream, gs_texture_t *texture, int frame)
+{
+	pthread_mutex_lock(&stream->mutex);
+
+	int slot = find_slot(stream, frame);
+	if (slot != -1) {
+		gs_texture_set_image(texture, slot_ptr(stream, slot), stream->image->gif.width * 4, false);
+		stream->shown_frame = frame;
+	}
+
+	pthread_mutex_unlock(&stream->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
-			      enum gs_image_alpha_mode alpha_mode)
+			      enum gs_image_alpha_mode alpha_mode, struct gs_gif_stream **stream)
 {
 	bool is_animated_gif = true;
 	gif_result result;
@@ -131,19 +390,28 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 	if (image->is_animated_gif) {
 		gif_decode_frame(&image->gif, 0);
 
-		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
-		image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+		if (stream && max_size > gif_memory_limit)
+			*stream = gif_stream_create(image, alpha_mode, mem_usage);
+
+		if (stream && *stream) {
+			blog(LOG_INFO, "'%s' is too large to keep decoded (%" PRIu64 " MiB), decoding frames ahead",
+			     path, max_size / (1024 * 1024));
+		} else {
+			image->animation_frame_cache =
+				alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
+			image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+
+			for (unsigned int i = 0; i < image->gif.frame_count; i++) {
+				if (gif_decode_frame(&image->gif, i) != GIF_OK)
+					blog(LOG_WARNING,
+					     "Couldn't decode frame %u "
+					     "of '%s'",
+					     i, path);
+			}
 
-		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
-			if (gif_decode_frame(&image->gif, i) != GIF_OK)
-				blog(LOG_WARNING,
-				     "Couldn't decode frame %u "
-				     "of '%s'",
-				     i, path);
+			gif_decode_frame(&image->gif, 0);
 		}
 
-		gif_decode_frame(&image->gif, 0);
-
 		image->cx = (uint32_t)image->gif.width;
 		image->cy = (uint32_t)image->gif.height;
 		image->format = GS_RGBA;
@@ -179,7 +447,8 @@ not_animated:
 }
 
 static void gs_image_file_init_internal(gs_image_file_t *image, const char *file, uint64_t *mem_usage,
-					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode)
+					enum gs_color_space *space, enum gs_image_alpha_mode alpha_mode,
+					struct gs_gif_stream **stream)
 {
 	size_t len;
 
@@ -194,7 +463,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 	len = strlen(file);
 
 	if (len > 4 && astrcmpi(file + len - 4, ".gif") == 0) {
-		if (init_animated_gif(image, file, mem_usage, alpha_mode)) {
+		if (init_animated_gif(image, file, mem_usage, alpha_mode, stream)) {
 			return;
 		}
 	}
@@ -216,7 +485,7 @@ static void gs_image_file_init_internal(gs_image_file_t *image, const char *file
 void gs_image_file_init(gs_image_file_t *image, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(image, file, NULL, &unused, GS_IMAGE_ALPHA_STRAIGHT, NULL);
 }
 
 void gs_image_file_free(gs_image_file_t *image)
@@ -242,23 +511,42 @@ void gs_image_file_free(gs_image_file_t *image)
 void gs_image_file2_init(gs_image_file2_t *if2, const char *file)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT);
+	gs_image_file_init_internal(&if2->image, file, &if2->mem_usage, &unused, GS_IMAGE_ALPHA_STRAIGHT, NULL);
 }
 
 void gs_image_file3_init(gs_image_file3_t *if3, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	enum gs_color_space unused;
-	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode);
+	gs_image_file_init_internal(&if3->image2.image, file, &if3->image2.mem_usage, &unused, alpha_mode, NULL);
 	if3->alpha_mode = alpha_mode;
 }
 
 void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs_image_alpha_mode alpha_mode)
 {
 	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
-				    alpha_mode);
+				    alpha_mode, NULL);
 	if4->image3.alpha_mode = alpha_mode;
 }
 
+void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+
+	if5->gif_stream = NULL;
+	gs_image_file_init_internal(&if4->image3.image2.image, file, &if4->image3.image2.mem_usage, &if4->space,
+				    alpha_mode, &if5->gif_stream);
+	if4->image3.alpha_mode = alpha_mode;
+}
+
+void gs_image_file5_free(gs_image_file5_t *if5)
+{
+	/* the worker uses the gif decoder, so it has to go first */
+	gif_stream_destroy(if5->gif_stream);
+	if5->gif_stream = NULL;
+
+	gs_image_file4_free(&if5->image4);
+}
+
 void gs_image_file_init_texture(gs_image_file_t *image)
 {
 	if (!image->loaded)
@@ -344,7 +632,7 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 }
 
 static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed_time_ns,
-					enum gs_image_alpha_mode alpha_mode)
+					enum gs_image_alpha_mode alpha_mode, struct gs_gif_stream *stream)
 {
 	int loops;
 
@@ -355,6 +643,19 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 	if (loops >= 0xFFFF)
 		loops = 0;
 
+	if (stream) {
+		bool changed = false;
+
+		if (!loops || image->cur_loop < loops) {
+			int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
+			changed = new_frame != image->cur_frame;
+			image->cur_frame = new_frame;
+		}
+
+		/* a frame that wasn't decoded in time is shown once it is */
+		return gif_stream_seek(stream, image->cur_frame) || changed;
+	}
+
 	if (!loops || image->cur_loop < loops) {
 		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
 
@@ -369,29 +670,43 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 
 bool gs_image_file_tick(gs_image_file_t *image, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file2_tick(gs_image_file2_t *if2, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false);
+	return gs_image_file_tick_internal(&if2->image, elapsed_time_ns, false, NULL);
 }
 
 bool gs_image_file3_tick(gs_image_file3_t *if3, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode);
+	return gs_image_file_tick_internal(&if3->image2.image, elapsed_time_ns, if3->alpha_mode, NULL);
 }
 
 bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns)
 {
-	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode);
+	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode, NULL);
+}
+
+bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	return gs_image_file_tick_internal(&if4->image3.image2.image, elapsed_time_ns, if4->image3.alpha_mode,
+					   if5->gif_stream);
 }
 
-static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode)
+static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode,
+						  struct gs_gif_stream *stream)
 {
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	if (stream) {
+		gif_stream_seek(stream, image->cur_frame);
+		gif_stream_update_texture(stream, image->texture, image->cur_frame);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame, alpha_mode);
 
@@ -401,20 +716,26 @@ static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum g
 
 void gs_image_file_update_texture(gs_image_file_t *image)
 {
-	gs_image_file_update_texture_internal(image, false);
+	gs_image_file_update_texture_internal(image, false, NULL);
 }
 
 void gs_image_file2_update_texture(gs_image_file2_t *if2)
 {
-	gs_image_file_update_texture_internal(&if2->image, false);
+	gs_image_file_update_texture_internal(&if2->image, false, NULL);
 }
 
 void gs_image_file3_update_texture(gs_image_file3_t *if3)
 {
-	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode);
+	gs_image_file_update_texture_internal(&if3->image2.image, if3->alpha_mode, NULL);
 }
 
 void gs_image_file4_update_texture(gs_image_file4_t *if4)
 {
-	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode);
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode, NULL);
+}
+
+void gs_image_file5_update_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_t *if4 = &if5->image4;
+	gs_image_file_update_texture_internal(&if4->image3.image2.image, if4->image3.alpha_mode, if5->gif_stream);
 }
@@ -24,6 +24,8 @@
 extern "C" {
 #endif
 
+struct gs_gif_stream;
+
 struct gs_image_file {
 	gs_texture_t *texture;
 	enum gs_color_format format;
@@ -61,10 +63,26 @@ struct gs_image_file4 {
 	enum gs_color_space space;
 };
 
+struct gs_image_file5 {
+	struct gs_image_file4 image4;
+
+	/* set if the animation is too large to be kept decoded in memory,
+	 * in which case frames are decoded ahead of playback */
+	struct gs_gif_stream *gif_stream;
+};
+
 typedef struct gs_image_file gs_image_file_t;
 typedef struct gs_image_file2 gs_image_file2_t;
 typedef struct gs_image_file3 gs_image_file3_t;
 typedef struct gs_image_file4 gs_image_file4_t;
+typedef struct gs_image_file5 gs_image_file5_t;
+
+/**
+ * Sets the amount of memory a fully decoded animated GIF may use.  Larger
+ * animations loaded with gs_image_file5_init only keep a few frames around
+ * the playback position decoded.
+ */
+EXPORT void gs_image_file_set_gif_memory_limit(uint64_t limit);
 
 EXPORT void gs_image_file_init(gs_image_file_t *image, const char *file);
 EXPORT void gs_image_file_free(gs_image_file_t *image);
@@ -88,6 +106,12 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+EXPORT void gs_image_file5_init(gs_image_file5_t *if5, const char *file, enum gs_image_alpha_mode alpha_mode);
+EXPORT void gs_image_file5_free(gs_image_file5_t *if5);
+
+EXPORT bool gs_image_file5_tick(gs_image_file5_t *if5, uint64_t elapsed_time_ns);
+EXPORT void gs_image_file5_update_texture(gs_image_file5_t *if5);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
@@ -119,6 +143,11 @@ static inline void gs_image_file4_init_texture(gs_image_file4_t *if4)
 	gs_image_file3_init_texture(&if4->image3);
 }
 
+static inline void gs_image_file5_init_texture(gs_image_file5_t *if5)
+{
+	gs_image_file4_init_texture(&if5->image4);
+}
+
 #ifdef __cplusplus
 }
 #endif
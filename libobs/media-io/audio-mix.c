@@ -0,0 +1,267 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "audio-mix.h"
+
+#include "../util/sse-intrin.h"
+#include "../util/threading.h"
+
+#if (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)) && !defined(_M_ARM64EC)
+#define ENABLE_AVX_KERNELS
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+#define VECTOR_KERNELS_NAME "neon"
+#elif defined(ENABLE_AVX_KERNELS)
+#define VECTOR_KERNELS_NAME "sse2"
+#else
+#define VECTOR_KERNELS_NAME "simde"
+#endif
+
+/* ------------------------------------------------------------------------- */
+/* reference */
+
+static void add_c(float *out, const float *in, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] += in[i];
+}
+
+static void add_gain_c(float *out, const float *in, float gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] += in[i] * gain;
+}
+
+static void add_gain_ramp_c(float *out, const float *in, const float *gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] += in[i] * gain[i];
+}
+
+static void mul_c(float *out, float gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] *= gain;
+}
+
+static void mul_ramp_c(float *out, const float *gain, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		out[i] *= gain[i];
+}
+
+static const struct audio_mix_kernels reference_kernels = {
+	.name = "c",
+	.add = add_c,
+	.add_gain = add_gain_c,
+	.add_gain_ramp = add_gain_ramp_c,
+	.mul = mul_c,
+	.mul_ramp = mul_ramp_c,
+};
+
+/* ------------------------------------------------------------------------- */
+/* sse2, or neon through simde */
+
+static void add_sse(float *out, const float *in, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(in + i)));
+
+	add_c(out + i, in + i, count - i);
+}
+
+static void add_gain_sse(float *out, const float *in, float gain, size_t count)
+{
+	__m128 gain_v = _mm_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_mul_ps(_mm_loadu_ps(in + i), gain_v);
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), val));
+	}
+
+	add_gain_c(out + i, in + i, gain, count - i);
+}
+
+static void add_gain_ramp_sse(float *out, const float *in, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 val = _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(gain + i));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), val));
+	}
+
+	add_gain_ramp_c(out + i, in + i, gain + i, count - i);
+}
+
+static void mul_sse(float *out, float gain, size_t count)
+{
+	__m128 gain_v = _mm_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(out + i), gain_v));
+
+	mul_c(out + i, gain, count - i);
+}
+
+static void mul_ramp_sse(float *out, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(out + i), _mm_loadu_ps(gain + i)));
+
+	mul_ramp_c(out + i, gain + i, count - i);
+}
+
+static const struct audio_mix_kernels sse_kernels = {
+	.name = VECTOR_KERNELS_NAME,
+	.add = add_sse,
+	.add_gain = add_gain_sse,
+	.add_gain_ramp = add_gain_ramp_sse,
+	.mul = mul_sse,
+	.mul_ramp = mul_ramp_sse,
+};
+
+/* ------------------------------------------------------------------------- */
+/* avx, only the float instructions are needed so avx2 is not required */
+
+#ifdef ENABLE_AVX_KERNELS
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX __attribute__((target("avx")))
+#else
+#define TARGET_AVX
+#endif
+
+TARGET_AVX static void add_avx(float *out, const float *in, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(in + i)));
+
+	add_c(out + i, in + i, count - i);
+}
+
+TARGET_AVX static void add_gain_avx(float *out, const float *in, float gain, size_t count)
+{
+	__m256 gain_v = _mm256_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 val = _mm256_mul_ps(_mm256_loadu_ps(in + i), gain_v);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), val));
+	}
+
+	add_gain_c(out + i, in + i, gain, count - i);
+}
+
+TARGET_AVX static void add_gain_ramp_avx(float *out, const float *in, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+		__m256 val = _mm256_mul_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(gain + i));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), val));
+	}
+
+	add_gain_ramp_c(out + i, in + i, gain + i, count - i);
+}
+
+TARGET_AVX static void mul_avx(float *out, float gain, size_t count)
+{
+	__m256 gain_v = _mm256_set1_ps(gain);
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(out + i), gain_v));
+
+	mul_c(out + i, gain, count - i);
+}
+
+TARGET_AVX static void mul_ramp_avx(float *out, const float *gain, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(out + i), _mm256_loadu_ps(gain + i)));
+
+	mul_ramp_c(out + i, gain + i, count - i);
+}
+
+static const struct audio_mix_kernels avx_kernels = {
+	.name = "avx",
+	.add = add_avx,
+	.add_gain = add_gain_avx,
+	.add_gain_ramp = add_gain_ramp_avx,
+	.mul = mul_avx,
+	.mul_ramp = mul_ramp_avx,
+};
+
+static bool cpu_has_avx(void)
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+
+	bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	bool has_avx = (info[2] & (1 << 28)) != 0;
+
+	return has_osxsave && has_avx && (_xgetbv(0) & 6) == 6;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx");
+#endif
+}
+
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+static const struct audio_mix_kernels *kernels = &reference_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void init_kernels(void)
+{
+	kernels = &sse_kernels;
+
+#ifdef ENABLE_AVX_KERNELS
+	if (cpu_has_avx())
+		kernels = &avx_kernels;
+#endif
+}
+
+const struct audio_mix_kernels *audio_mix_get_kernels(void)
+{
+	pthread_once(&kernels_once, init_kernels);
+	return kernels;
+}
+
+const struct audio_mix_kernels *audio_mix_get_reference_kernels(void)
+{
+	return &reference_kernels;
+}
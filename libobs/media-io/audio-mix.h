@@ -0,0 +1,57 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "../util/c99defs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Mixing kernels for planar float audio.  The fastest implementation
+ * supported by the CPU is selected at runtime.
+ */
+
+struct audio_mix_kernels {
+	const char *name;
+
+	/* out[i] += in[i] */
+	void (*add)(float *out, const float *in, size_t count);
+
+	/* out[i] += in[i] * gain */
+	void (*add_gain)(float *out, const float *in, float gain, size_t count);
+
+	/* out[i] += in[i] * gain[i] */
+	void (*add_gain_ramp)(float *out, const float *in, const float *gain, size_t count);
+
+	/* out[i] *= gain */
+	void (*mul)(float *out, float gain, size_t count);
+
+	/* out[i] *= gain[i] */
+	void (*mul_ramp)(float *out, const float *gain, size_t count);
+};
+
+EXPORT const struct audio_mix_kernels *audio_mix_get_kernels(void);
+
+/* plain C implementation, mainly useful for testing */
+EXPORT const struct audio_mix_kernels *audio_mix_get_reference_kernels(void);
+
+#ifdef __cplusplus
+}
+#endif
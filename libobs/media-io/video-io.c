@@ -33,6 +33,9 @@ extern profiler_name_store_t *obs_get_profiler_name_store(void);
 
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
+#define MAX_INPUT_QUEUE_SIZE 16
+#define MAX_POOLED_FRAMES 32
+#define MAX_SCALE_THREADS 4
 
 struct cached_frame_info {
 	struct video_data frame;
@@ -40,12 +43,351 @@ struct cached_frame_info {
 	int count;
 };
 
+/* ------------------------------------------------------------------------- */
+/* refcounted frames used by threaded inputs.  inputs that don't need any
+ * conversion share a single copy of the composited frame. */
+
+struct video_frame_pool;
+
+struct video_frame_ref {
+	struct video_frame frame;
+	enum video_format format;
+	uint32_t width;
+	uint32_t height;
+
+	struct video_frame_pool *pool;
+	volatile long refs;
+};
+
+struct video_frame_pool {
+	pthread_mutex_t mutex;
+	DARRAY(struct video_frame_ref *) frames;
+
+	/* one reference for the video output, one for each frame in use */
+	volatile long refs;
+};
+
+static struct video_frame_pool *video_frame_pool_create(void)
+{
+	struct video_frame_pool *pool = bzalloc(sizeof(struct video_frame_pool));
+
+	if (pthread_mutex_init(&pool->mutex, NULL) != 0) {
+		bfree(pool);
+		return NULL;
+	}
+
+	pool->refs = 1;
+	return pool;
+}
+
+static inline void video_frame_ref_free(struct video_frame_ref *ref)
+{
+	video_frame_free(&ref->frame);
+	bfree(ref);
+}
+
+static void video_frame_pool_release(struct video_frame_pool *pool)
+{
+	if (!pool || os_atomic_dec_long(&pool->refs) != 0)
+		return;
+
+	for (size_t i = 0; i < pool->frames.num; i++)
+		video_frame_ref_free(pool->frames.array[i]);
+
+	da_free(pool->frames);
+	pthread_mutex_destroy(&pool->mutex);
+	bfree(pool);
+}
+
+static struct video_frame_ref *video_frame_pool_get(struct video_frame_pool *pool, enum video_format format,
+						    uint32_t width, uint32_t height)
+{
+	struct video_frame_ref *ref = NULL;
+
+	pthread_mutex_lock(&pool->mutex);
+
+	for (size_t i = pool->frames.num; i > 0; i--) {
+		struct video_frame_ref *cur = pool->frames.array[i - 1];
+
+		if (cur->format == format && cur->width == width && cur->height == height) {
+			ref = cur;
+			da_erase(pool->frames, i - 1);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (!ref) {
+		ref = bzalloc(sizeof(struct video_frame_ref));
+		ref->format = format;
+		ref->width = width;
+		ref->height = height;
+		ref->pool = pool;
+		video_frame_init(&ref->frame, format, width, height);
+	}
+
+	ref->refs = 1;
+	os_atomic_inc_long(&pool->refs);
+	return ref;
+}
+
+static inline void video_frame_ref_addref(struct video_frame_ref *ref)
+{
+	os_atomic_inc_long(&ref->refs);
+}
+
+static void video_frame_ref_release(struct video_frame_ref *ref)
+{
+	struct video_frame_pool *pool;
+
+	if (!ref || os_atomic_dec_long(&ref->refs) != 0)
+		return;
+
+	pool = ref->pool;
+
+	pthread_mutex_lock(&pool->mutex);
+	if (pool->frames.num < MAX_POOLED_FRAMES) {
+		da_push_back(pool->frames, &ref);
+		ref = NULL;
+	}
+	pthread_mutex_unlock(&pool->mutex);
+
+	if (ref)
+		video_frame_ref_free(ref);
+
+	video_frame_pool_release(pool);
+}
+
+/* ------------------------------------------------------------------------- */
+/* threaded inputs: each one has a bounded frame queue and its own thread so
+ * that a slow callback (e.g. an encoder) does not stall the other inputs */
+
+struct video_queued_frame {
+	struct video_frame_ref *ref;
+	uint64_t timestamp;
+
+	/* if the queue is full, the newest frame is delivered again with an
+	 * advanced timestamp instead of queueing a new one, same as skipped
+	 * frames in the output cache */
+	uint32_t count;
+};
+
+struct video_input_thread {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	os_sem_t *semaphore;
+	bool stop;
+	bool detached;
+
+	struct video_queued_frame *queue;
+	size_t queue_size;
+	size_t queue_start;
+	size_t queue_num;
+	uint64_t frame_interval;
+
+	volatile long dropped_frames;
+	volatile long total_frames;
+
+	void (*callback)(void *param, struct video_data *frame);
+	void *param;
+};
+
+static void video_input_thread_free(struct video_input_thread *worker)
+{
+	long dropped = os_atomic_load_long(&worker->dropped_frames);
+
+	if (dropped)
+		blog(LOG_INFO,
+		     "video-io: Input thread stopped, number of "
+		     "duplicated frames due to encoding lag: %ld/%ld",
+		     dropped, os_atomic_load_long(&worker->total_frames));
+
+	for (size_t i = 0; i < worker->queue_num; i++) {
+		size_t idx = (worker->queue_start + i) % worker->queue_size;
+		video_frame_ref_release(worker->queue[idx].ref);
+	}
+
+	os_sem_destroy(worker->semaphore);
+	pthread_mutex_destroy(&worker->mutex);
+	bfree(worker->queue);
+	bfree(worker);
+}
+
+static void *video_input_thread(void *param)
+{
+	struct video_input_thread *worker = param;
+	bool detached;
+
+	os_set_thread_name("video-io: input thread");
+
+	while (os_sem_wait(worker->semaphore) == 0) {
+		struct video_frame_ref *ref = NULL;
+		struct video_data frame;
+
+		pthread_mutex_lock(&worker->mutex);
+
+		if (worker->stop) {
+			pthread_mutex_unlock(&worker->mutex);
+			break;
+		}
+
+		if (worker->queue_num) {
+			struct video_queued_frame *queued = &worker->queue[worker->queue_start];
+
+			ref = queued->ref;
+			frame.timestamp = queued->timestamp;
+
+			if (--queued->count) {
+				video_frame_ref_addref(ref);
+				queued->timestamp += worker->frame_interval;
+			} else {
+				if (++worker->queue_start == worker->queue_size)
+					worker->queue_start = 0;
+				worker->queue_num--;
+			}
+		}
+
+		pthread_mutex_unlock(&worker->mutex);
+
+		if (!ref)
+			continue;
+
+		for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+			frame.data[i] = ref->frame.data[i];
+			frame.linesize[i] = ref->frame.linesize[i];
+		}
+
+		worker->callback(worker->param, &frame);
+		video_frame_ref_release(ref);
+
+		os_atomic_inc_long(&worker->total_frames);
+	}
+
+	pthread_mutex_lock(&worker->mutex);
+	detached = worker->detached;
+	pthread_mutex_unlock(&worker->mutex);
+
+	if (detached)
+		video_input_thread_free(worker);
+
+	return NULL;
+}
+
+static struct video_input_thread *video_input_thread_create(uint32_t queue_size, uint64_t frame_interval,
+							    void (*callback)(void *param, struct video_data *frame),
+							    void *param)
+{
+	struct video_input_thread *worker = bzalloc(sizeof(struct video_input_thread));
+
+	if (queue_size > MAX_INPUT_QUEUE_SIZE)
+		queue_size = MAX_INPUT_QUEUE_SIZE;
+
+	worker->queue_size = queue_size;
+	worker->queue = bzalloc(sizeof(struct video_queued_frame) * queue_size);
+	worker->frame_interval = frame_interval;
+	worker->callback = callback;
+	worker->param = param;
+
+	if (pthread_mutex_init(&worker->mutex, NULL) != 0)
+		goto fail0;
+	if (os_sem_init(&worker->semaphore, 0) != 0)
+		goto fail1;
+
+	return worker;
+
+fail1:
+	pthread_mutex_destroy(&worker->mutex);
+fail0:
+	bfree(worker->queue);
+	bfree(worker);
+	return NULL;
+}
+
+static bool video_input_thread_start(struct video_input_thread *worker)
+{
+	return pthread_create(&worker->thread, NULL, video_input_thread, worker) == 0;
+}
+
+/* must not be called with input_mutex held, the input thread may be inside
+ * of a callback that is trying to disconnect itself */
+static void video_input_thread_stop(struct video_input_thread *worker)
+{
+	bool self;
+
+	if (!worker)
+		return;
+
+	pthread_mutex_lock(&worker->mutex);
+	self = pthread_equal(pthread_self(), worker->thread);
+	worker->stop = true;
+	worker->detached = self;
+	pthread_mutex_unlock(&worker->mutex);
+
+	os_sem_post(worker->semaphore);
+
+	if (self) {
+		pthread_detach(worker->thread);
+		return;
+	}
+
+	pthread_join(worker->thread, NULL);
+	video_input_thread_free(worker);
+}
+
+/* only the video thread adds frames, so if the queue is not full here it
+ * will not be full when the frame is pushed */
+static bool video_input_thread_duplicate_last(struct video_input_thread *worker)
+{
+	bool full;
+
+	pthread_mutex_lock(&worker->mutex);
+
+	full = worker->queue_num == worker->queue_size;
+	if (full) {
+		size_t last = (worker->queue_start + worker->queue_num - 1) % worker->queue_size;
+		worker->queue[last].count++;
+		os_atomic_inc_long(&worker->dropped_frames);
+	}
+
+	pthread_mutex_unlock(&worker->mutex);
+
+	if (full)
+		os_sem_post(worker->semaphore);
+	return full;
+}
+
+static void video_input_thread_push(struct video_input_thread *worker, struct video_frame_ref *ref,
+				    uint64_t timestamp)
+{
+	pthread_mutex_lock(&worker->mutex);
+
+	size_t idx = (worker->queue_start + worker->queue_num) % worker->queue_size;
+	worker->queue[idx].ref = ref;
+	worker->queue[idx].timestamp = timestamp;
+	worker->queue[idx].count = 1;
+	worker->queue_num++;
+
+	pthread_mutex_unlock(&worker->mutex);
+
+	os_sem_post(worker->semaphore);
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct video_input {
 	struct video_scale_info conversion;
 	video_scaler_t *scaler;
 	struct video_frame frame[MAX_CONVERT_BUFFERS];
 	int cur_frame;
 
+	/* only set for inputs connected with video_output_connect_threaded */
+	struct video_input_thread *thread;
+
+	/* per frame state used by video_output_cur_frame */
+	bool receive_frame;
+	size_t scale_job;
+
 	// allow outputting at fractions of main composition FPS,
 	// e.g. 60 FPS with frame_rate_divisor = 1 turns into 30 FPS
 	//
@@ -67,6 +409,125 @@ static inline void video_input_free(struct video_input *input)
 	video_scaler_destroy(input->scaler);
 }
 
+/* ------------------------------------------------------------------------- */
+/* conversions of a frame are collected as jobs, with inputs requesting the
+ * same conversion sharing one job, and then run in parallel on a pool of
+ * scale threads before any callbacks are made */
+
+struct video_scale_job {
+	struct video_input *input;
+	struct video_frame *frame;
+
+	/* jobs used by more than one input or by a threaded input scale in to
+	 * a refcounted frame so the result doesn't depend on the lifetime of
+	 * the first input, other jobs use that input's conversion buffers */
+	bool shared;
+	struct video_frame_ref *ref;
+
+	bool success;
+};
+
+struct video_scale_pool {
+	pthread_t threads[MAX_SCALE_THREADS];
+	size_t num_threads;
+
+	os_sem_t *start_semaphore;
+	os_sem_t *done_semaphore;
+	bool stop;
+
+	const struct video_data *source;
+	struct video_scale_job *jobs;
+	size_t num_jobs;
+	volatile long next_job;
+};
+
+static void run_scale_jobs(struct video_scale_pool *pool)
+{
+	for (;;) {
+		size_t idx = (size_t)os_atomic_inc_long(&pool->next_job) - 1;
+		if (idx >= pool->num_jobs)
+			break;
+
+		struct video_scale_job *job = &pool->jobs[idx];
+		const struct video_data *source = pool->source;
+
+		job->success = video_scaler_scale(job->input->scaler, job->frame->data, job->frame->linesize,
+						  (const uint8_t *const *)source->data, source->linesize);
+		if (!job->success)
+			blog(LOG_WARNING, "video-io: Could not scale frame!");
+	}
+}
+
+static void *video_scale_thread(void *param)
+{
+	struct video_scale_pool *pool = param;
+
+	os_set_thread_name("video-io: scale thread");
+
+	while (os_sem_wait(pool->start_semaphore) == 0) {
+		if (pool->stop)
+			break;
+
+		run_scale_jobs(pool);
+		os_sem_post(pool->done_semaphore);
+	}
+
+	return NULL;
+}
+
+static void video_scale_pool_destroy(struct video_scale_pool *pool)
+{
+	if (!pool)
+		return;
+
+	pool->stop = true;
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->start_semaphore);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	os_sem_destroy(pool->start_semaphore);
+	os_sem_destroy(pool->done_semaphore);
+	bfree(pool);
+}
+
+static struct video_scale_pool *video_scale_pool_create(void)
+{
+	struct video_scale_pool *pool;
+	int num_threads = os_get_logical_cores() - 1;
+
+	if (num_threads <= 0)
+		return NULL;
+	if (num_threads > MAX_SCALE_THREADS)
+		num_threads = MAX_SCALE_THREADS;
+
+	pool = bzalloc(sizeof(struct video_scale_pool));
+
+	if (os_sem_init(&pool->start_semaphore, 0) != 0)
+		goto fail0;
+	if (os_sem_init(&pool->done_semaphore, 0) != 0)
+		goto fail1;
+
+	for (int i = 0; i < num_threads; i++) {
+		if (pthread_create(&pool->threads[i], NULL, video_scale_thread, pool) != 0)
+			break;
+		pool->num_threads++;
+	}
+
+	if (!pool->num_threads)
+		goto fail2;
+
+	return pool;
+
+fail2:
+	os_sem_destroy(pool->done_semaphore);
+fail1:
+	os_sem_destroy(pool->start_semaphore);
+fail0:
+	bfree(pool);
+	return NULL;
+}
+
 struct video_output {
 	struct video_output_info info;
 
@@ -87,6 +548,12 @@ struct video_output {
 	size_t last_added;
 	struct cached_frame_info cache[MAX_CACHE_SIZE];
 
+	struct video_frame_pool *frame_pool;
+
+	DARRAY(struct video_scale_job) scale_jobs;
+	struct video_scale_pool *scale_pool;
+	bool scale_pool_failed;
+
 	struct video_output *parent;
 
 	volatile bool raw_active;
@@ -95,37 +562,116 @@ struct video_output {
 
 /* ------------------------------------------------------------------------- */
 
-static inline bool scale_video_output(struct video_input *input, struct video_data *data)
+static inline bool scale_info_equal(const struct video_scale_info *a, const struct video_scale_info *b)
 {
-	bool success = true;
+	return a->format == b->format && a->width == b->width && a->height == b->height && a->range == b->range &&
+	       a->colorspace == b->colorspace;
+}
 
-	if (input->scaler) {
-		struct video_frame *frame;
+static size_t get_scale_job(struct video_output *video, struct video_input *input)
+{
+	struct video_scale_job *job;
 
-		if (++input->cur_frame == MAX_CONVERT_BUFFERS)
-			input->cur_frame = 0;
+	for (size_t i = 0; i < video->scale_jobs.num; i++) {
+		job = &video->scale_jobs.array[i];
 
-		frame = &input->frame[input->cur_frame];
+		if (scale_info_equal(&job->input->conversion, &input->conversion)) {
+			job->shared = true;
+			return i;
+		}
+	}
 
-		success = video_scaler_scale(input->scaler, frame->data, frame->linesize,
-					     (const uint8_t *const *)data->data, data->linesize);
+	job = da_push_back_new(video->scale_jobs);
+	job->input = input;
+	job->shared = input->thread != NULL;
 
-		if (success) {
-			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-				data->data[i] = frame->data[i];
-				data->linesize[i] = frame->linesize[i];
-			}
+	return video->scale_jobs.num - 1;
+}
+
+static void prepare_scale_jobs(struct video_output *video)
+{
+	for (size_t i = 0; i < video->scale_jobs.num; i++) {
+		struct video_scale_job *job = &video->scale_jobs.array[i];
+		struct video_input *input = job->input;
+
+		if (job->shared) {
+			job->ref = video_frame_pool_get(video->frame_pool, input->conversion.format,
+							input->conversion.width, input->conversion.height);
+			job->frame = &job->ref->frame;
 		} else {
-			blog(LOG_WARNING, "video-io: Could not scale frame!");
+			if (++input->cur_frame == MAX_CONVERT_BUFFERS)
+				input->cur_frame = 0;
+
+			job->frame = &input->frame[input->cur_frame];
 		}
 	}
+}
 
-	return success;
+static void scale_video_output(struct video_output *video, const struct video_data *source)
+{
+	struct video_scale_pool local = {0};
+	struct video_scale_pool *pool = video->scale_pool;
+	size_t num_threads = 0;
+
+	if (!video->scale_jobs.num)
+		return;
+
+	prepare_scale_jobs(video);
+
+	if (video->scale_jobs.num > 1 && !pool && !video->scale_pool_failed) {
+		pool = video->scale_pool = video_scale_pool_create();
+		video->scale_pool_failed = !pool;
+	}
+
+	/* the video thread runs jobs as well, so one job needs no help */
+	if (!pool || video->scale_jobs.num == 1) {
+		pool = &local;
+	} else {
+		num_threads = video->scale_jobs.num - 1;
+		if (num_threads > pool->num_threads)
+			num_threads = pool->num_threads;
+	}
+
+	pool->source = source;
+	pool->jobs = video->scale_jobs.array;
+	pool->num_jobs = video->scale_jobs.num;
+	pool->next_job = 0;
+
+	for (size_t i = 0; i < num_threads; i++)
+		os_sem_post(pool->start_semaphore);
+
+	run_scale_jobs(pool);
+
+	for (size_t i = 0; i < num_threads; i++)
+		os_sem_wait(pool->done_semaphore);
+}
+
+static void queue_video_input(struct video_output *video, struct video_input *input, const struct video_data *data,
+			      struct video_frame_ref **shared)
+{
+	struct video_frame_ref *ref;
+
+	if (input->scale_job != DARRAY_INVALID) {
+		ref = video->scale_jobs.array[input->scale_job].ref;
+	} else {
+		if (!*shared) {
+			*shared = video_frame_pool_get(video->frame_pool, video->info.format, video->info.width,
+						       video->info.height);
+			video_frame_copy(&(*shared)->frame, (const struct video_frame *)data, video->info.format,
+					 video->info.height);
+		}
+
+		ref = *shared;
+	}
+
+	video_frame_ref_addref(ref);
+	video_input_thread_push(input->thread, ref, data->timestamp);
 }
 
 static inline bool video_output_cur_frame(struct video_output *video)
 {
 	struct cached_frame_info *frame_info;
+	struct video_frame_ref *shared = NULL;
 	bool complete;
 	bool skipped;
 
@@ -141,9 +687,13 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 	pthread_mutex_lock(&video->input_mutex);
 
+	video->scale_jobs.num = 0;
+
 	for (size_t i = 0; i < video->inputs.num; i++) {
 		struct video_input *input = video->inputs.array + i;
-		struct video_data frame = frame_info->frame;
+
+		input->receive_frame = false;
+		input->scale_job = DARRAY_INVALID;
 
 		// an explicit counter is used instead of remainder calculation
 		// to allow multiple encoders started at the same time to start on
@@ -154,13 +704,48 @@ static inline bool video_output_cur_frame(struct video_output *video)
 
 		if (skip)
 			continue;
+		if (input->thread && video_input_thread_duplicate_last(input->thread))
+			continue;
+
+		input->receive_frame = true;
+
+		if (input->scaler)
+			input->scale_job = get_scale_job(video, input);
+	}
+
+	scale_video_output(video, &frame_info->frame);
+
+	for (size_t i = 0; i < video->inputs.num; i++) {
+		struct video_input *input = video->inputs.array + i;
+		struct video_data frame = frame_info->frame;
+
+		if (!input->receive_frame)
+			continue;
+
+		if (input->scale_job != DARRAY_INVALID) {
+			struct video_scale_job *job = &video->scale_jobs.array[input->scale_job];
+			if (!job->success)
+				continue;
+
+			for (size_t j = 0; j < MAX_AV_PLANES; j++) {
+				frame.data[j] = job->frame->data[j];
+				frame.linesize[j] = job->frame->linesize[j];
+			}
+		}
 
-		if (scale_video_output(input, &frame))
+		if (input->thread)
+			queue_video_input(video, input, &frame, &shared);
+		else
 			input->callback(input->param, &frame);
 	}
 
+	for (size_t i = 0; i < video->scale_jobs.num; i++)
+		video_frame_ref_release(video->scale_jobs.array[i].ref);
+
 	pthread_mutex_unlock(&video->input_mutex);
 
+	video_frame_ref_release(shared);
+
 	/* -------------------------------- */
 
 	pthread_mutex_lock(&video->data_mutex);
@@ -256,14 +841,19 @@ int video_output_open(video_t **video, struct video_output_info *info)
 		goto fail1;
 	if (os_sem_init(&out->update_semaphore, 0) != 0)
 		goto fail2;
-	if (pthread_create(&out->thread, NULL, video_thread, out) != 0)
+	out->frame_pool = video_frame_pool_create();
+	if (!out->frame_pool)
 		goto fail3;
+	if (pthread_create(&out->thread, NULL, video_thread, out) != 0)
+		goto fail4;
 
 	init_cache(out);
 
 	*video = out;
 	return VIDEO_OUTPUT_SUCCESS;
 
+fail4:
+	video_frame_pool_release(out->frame_pool);
 fail3:
 	os_sem_destroy(out->update_semaphore);
 fail2:
@@ -282,16 +872,33 @@ void video_output_close(video_t *video)
 
 	video_output_stop(video);
 
+	DARRAY(struct video_input_thread *) workers;
+	da_init(workers);
+
 	pthread_mutex_lock(&video->input_mutex);
 
-	for (size_t i = 0; i < video->inputs.num; i++)
-		video_input_free(&video->inputs.array[i]);
+	for (size_t i = 0; i < video->inputs.num; i++) {
+		struct video_input *input = &video->inputs.array[i];
+
+		if (input->thread)
+			da_push_back(workers, &input->thread);
+		video_input_free(input);
+	}
 	da_free(video->inputs);
 
 	for (size_t i = 0; i < video->info.cache_size; i++)
 		video_frame_free((struct video_frame *)&video->cache[i]);
 
 	pthread_mutex_unlock(&video->input_mutex);
+
+	for (size_t i = 0; i < workers.num; i++)
+		video_input_thread_stop(workers.array[i]);
+	da_free(workers);
+
+	video_scale_pool_destroy(video->scale_pool);
+	da_free(video->scale_jobs);
+
+	video_frame_pool_release(video->frame_pool);
 	os_sem_destroy(video->update_semaphore);
 	pthread_mutex_destroy(&video->data_mutex);
 	pthread_mutex_destroy(&video->input_mutex);
@@ -361,9 +968,12 @@ static inline bool video_input_init(struct video_input *input, struct video_outp
 			return false;
 		}
 
-		for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-			video_frame_init(&input->frame[i], input->conversion.format, input->conversion.width,
-					 input->conversion.height);
+		/* threaded inputs scale directly in to their queued frames */
+		if (!input->thread) {
+			for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
+				video_frame_init(&input->frame[i], input->conversion.format,
+						 input->conversion.width, input->conversion.height);
+		}
 	}
 
 	return true;
@@ -398,13 +1008,20 @@ bool video_output_connect(video_t *video, const struct video_scale_info *convers
 bool video_output_connect2(video_t *video, const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
 			   void (*callback)(void *param, struct video_data *frame), void *param)
 {
-	bool success = false;
+	return video_output_connect_threaded(video, conversion, frame_rate_divisor, 0, callback, param);
+}
 
-	video = get_root(video);
+bool video_output_connect_threaded(video_t *video, const struct video_scale_info *conversion,
+				   uint32_t frame_rate_divisor, uint32_t queue_size,
+				   void (*callback)(void *param, struct video_data *frame), void *param)
+{
+	bool success = false;
 
 	if (!video || !callback || frame_rate_divisor == 0)
 		return false;
 
+	video = get_root(video);
+
 	pthread_mutex_lock(&video->input_mutex);
 
 	if (video_get_input_idx(video, callback, param) == DARRAY_INVALID) {
@@ -431,7 +1048,22 @@ bool video_output_connect2(video_t *video, const struct video_scale_info *conver
 		if (input.conversion.height == 0)
 			input.conversion.height = video->info.height;
 
+		if (queue_size) {
+			input.thread = video_input_thread_create(queue_size, video->frame_time * frame_rate_divisor,
+								 callback, param);
+			if (!input.thread)
+				blog(LOG_WARNING, "video-io: Failed to create input thread, "
+						  "falling back to the video thread");
+		}
+
 		success = video_input_init(&input, video);
+		if (success && input.thread && !video_input_thread_start(input.thread)) {
+			video_input_free(&input);
+			success = false;
+		}
+		if (!success && input.thread)
+			video_input_thread_free(input.thread);
+
 		if (success) {
 			if (video->inputs.num == 0) {
 				if (!os_atomic_load_long(&video->gpu_refs)) {
@@ -474,10 +1106,13 @@ bool video_output_disconnect2(video_t *video, void (*callback)(void *param, stru
 
 	video = get_root(video);
 
+	struct video_input_thread *worker = NULL;
+
 	pthread_mutex_lock(&video->input_mutex);
 
 	size_t idx = video_get_input_idx(video, callback, param);
 	if (idx != DARRAY_INVALID) {
+		worker = video->inputs.array[idx].thread;
 		video_input_free(video->inputs.array + idx);
 		da_erase(video->inputs, idx);
 
@@ -491,6 +1126,8 @@ bool video_output_disconnect2(video_t *video, void (*callback)(void *param, stru
 
 	pthread_mutex_unlock(&video->input_mutex);
 
+	video_input_thread_stop(worker);
+
 	return idx != DARRAY_INVALID;
 }
 
@@ -623,6 +1260,53 @@ uint32_t video_output_get_total_frames(const video_t *video)
 	return (uint32_t)os_atomic_load_long(&get_const_root(video)->total_frames);
 }
 
+uint32_t video_output_get_input_queued_frames(const video_t *video,
+					      void (*callback)(void *param, struct video_data *frame), void *param)
+{
+	uint32_t queued = 0;
+
+	if (!video)
+		return 0;
+
+	video_t *root = (video_t *)get_const_root(video);
+
+	pthread_mutex_lock(&root->input_mutex);
+
+	size_t idx = video_get_input_idx(root, callback, param);
+	if (idx != DARRAY_INVALID && root->inputs.array[idx].thread) {
+		struct video_input_thread *worker = root->inputs.array[idx].thread;
+
+		pthread_mutex_lock(&worker->mutex);
+		queued = (uint32_t)worker->queue_num;
+		pthread_mutex_unlock(&worker->mutex);
+	}
+
+	pthread_mutex_unlock(&root->input_mutex);
+
+	return queued;
+}
+
+uint32_t video_output_get_input_dropped_frames(const video_t *video,
+					       void (*callback)(void *param, struct video_data *frame), void *param)
+{
+	uint32_t dropped = 0;
+
+	if (!video)
+		return 0;
+
+	video_t *root = (video_t *)get_const_root(video);
+
+	pthread_mutex_lock(&root->input_mutex);
+
+	size_t idx = video_get_input_idx(root, callback, param);
+	if (idx != DARRAY_INVALID && root->inputs.array[idx].thread)
+		dropped = (uint32_t)os_atomic_load_long(&root->inputs.array[idx].thread->dropped_frames);
+
+	pthread_mutex_unlock(&root->input_mutex);
+
+	return dropped;
+}
+
 /* Note: These four functions below are a very slight bit of a hack.  If the
  * texture encoder thread is active while the raw encoder thread is active, the
  * total frame count will just be doubled while they're both active.  Which is
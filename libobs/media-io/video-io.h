@@ -303,6 +303,12 @@ EXPORT bool video_output_connect(video_t *video, const struct video_scale_info *
 EXPORT bool video_output_connect2(video_t *video, const struct video_scale_info *conversion,
 				  uint32_t frame_rate_divisor, void (*callback)(void *param, struct video_data *frame),
 				  void *param);
+/* Connects an input that receives its frames on a dedicated thread through a
+ * bounded queue of queue_size frames instead of on the video thread.  A
+ * queue_size of 0 is equivalent to video_output_connect2. */
+EXPORT bool video_output_connect_threaded(video_t *video, const struct video_scale_info *conversion,
+					  uint32_t frame_rate_divisor, uint32_t queue_size,
+					  void (*callback)(void *param, struct video_data *frame), void *param);
 EXPORT void video_output_disconnect(video_t *video, void (*callback)(void *param, struct video_data *frame),
 				    void *param);
 EXPORT bool video_output_disconnect2(video_t *video, void (*callback)(void *param, struct video_data *frame),
@@ -324,6 +330,12 @@ EXPORT double video_output_get_frame_rate(const video_t *video);
 
 EXPORT uint32_t video_output_get_skipped_frames(const video_t *video);
 EXPORT uint32_t video_output_get_total_frames(const video_t *video);
+EXPORT uint32_t video_output_get_input_queued_frames(const video_t *video,
+						     void (*callback)(void *param, struct video_data *frame),
+						     void *param);
+EXPORT uint32_t video_output_get_input_dropped_frames(const video_t *video,
+						      void (*callback)(void *param, struct video_data *frame),
+						      void *param);
 
 extern void video_output_inc_texture_encoders(video_t *video);
 extern void video_output_dec_texture_encoders(video_t *video);
@@ -708,6 +708,14 @@ bool obs_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *platform, obs_key_t
     return platform->is_key_down[key];
 }
 
+bool obs_hotkeys_platform_wait_events(obs_hotkeys_platform_t *platform __unused)
+{
+    return false;
+}
+
+void obs_hotkeys_platform_wake(obs_hotkeys_platform_t *platform __unused)
+{}
+
 static void unichar_to_utf8(const UniChar *character, char *buffer)
 {
     CFStringRef string = CFStringCreateWithCharactersNoCopy(NULL, character, 2, kCFAllocatorNull);
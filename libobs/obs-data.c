@@ -27,7 +27,12 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
 
 struct obs_data_item {
 	volatile long ref;
@@ -440,157 +445,892 @@ static inline void obs_data_item_set_autoselect_data(struct obs_data_item **p_it
 
 /* ------------------------------------------------------------------------- */
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json);
+/*
+ * JSON parsing
+ *
+ *   Items are created directly while parsing, without building an
+ * intermediate tree first.  Strings are decoded in place, so the parser
+ * works on a buffer it's allowed to modify.
+ *
+ *   The accepted syntax and the resulting data are the same as before with
+ * jansson: duplicate keys are rejected, arrays only keep their objects, and
+ * a root array results in empty data.
+ */
+
+#define JSON_MAX_DEPTH 2048
+
+struct json_parser {
+	char *p;
+	char *end;
+	int line;
+	int depth;
+	char decimal_point;
+	char error[128];
+};
+
+static bool json_parse_value(struct json_parser *parser, obs_data_t *data, const char *key);
+
+static bool json_error(struct json_parser *parser, const char *format, ...)
+{
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(parser->error, sizeof(parser->error), format, args);
+	va_end(args);
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+	return false;
+}
+
+static inline bool json_is_plain_char(uint8_t c)
 {
-	const char *item_key;
-	json_t *jitem;
+	return c >= 0x20 && c < 0x80 && c != '"' && c != '\\';
+}
+
+#define JSON_BYTES(b) (0x0101010101010101ULL * (b))
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+/* Returns the first byte that can't be copied as is within a JSON string:
+ * quotes, backslashes, control characters and non-ASCII bytes.  Strings are
+ * mostly plain ASCII, so this checks 8 bytes at a time. */
+static inline const char *json_find_special(const char *p, const char *end)
+{
+	while (end - p >= 8) {
+		uint64_t word;
+		memcpy(&word, p, sizeof(word));
+
+		uint64_t quote = word ^ JSON_BYTES('"');
+		uint64_t backslash = word ^ JSON_BYTES('\\');
+		uint64_t special = ((quote - JSON_BYTES(0x01)) & ~quote) |
+				   ((backslash - JSON_BYTES(0x01)) & ~backslash) | ((word - JSON_BYTES(0x20)) & ~word) |
+				   word;
+
+		if (special & JSON_BYTES(0x80))
+			break;
+		p += 8;
 	}
+
+	while (p < end && json_is_plain_char((uint8_t)*p))
+		p++;
+
+	return p;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key, json_t *jobj)
+/* same checks as jansson, returns the length of the UTF-8 sequence at str,
+ * or 0 if it's invalid */
+static size_t json_utf8_sequence(const char *str, int32_t *codepoint)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	uint8_t first = (uint8_t)str[0];
+	int32_t value;
+	size_t size;
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+	if (first < 0x80) {
+		*codepoint = first;
+		return 1;
+	} else if (first >= 0xC2 && first <= 0xDF) {
+		size = 2;
+		value = first & 0x1F;
+	} else if (first >= 0xE0 && first <= 0xEF) {
+		size = 3;
+		value = first & 0x0F;
+	} else if (first >= 0xF0 && first <= 0xF4) {
+		size = 4;
+		value = first & 0x07;
+	} else {
+		return 0;
+	}
+
+	/* stops at the null terminator */
+	for (size_t i = 1; i < size; i++) {
+		uint8_t c = (uint8_t)str[i];
+		if (c < 0x80 || c > 0xBF)
+			return 0;
+
+		value = (value << 6) | (c & 0x3F);
+	}
+
+	if (value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF))
+		return 0;
+	if ((size == 3 && value < 0x800) || (size == 4 && value < 0x10000))
+		return 0;
+
+	*codepoint = value;
+	return size;
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key, json_t *jarray)
+static inline size_t json_utf8_encode(int32_t codepoint, char *out)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	if (codepoint < 0x80) {
+		out[0] = (char)codepoint;
+		return 1;
+	} else if (codepoint < 0x800) {
+		out[0] = (char)(0xC0 | (codepoint >> 6));
+		out[1] = (char)(0x80 | (codepoint & 0x3F));
+		return 2;
+	} else if (codepoint < 0x10000) {
+		out[0] = (char)(0xE0 | (codepoint >> 12));
+		out[1] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+		out[2] = (char)(0x80 | (codepoint & 0x3F));
+		return 3;
+	}
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+	out[0] = (char)(0xF0 | (codepoint >> 18));
+	out[1] = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+	out[2] = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+	out[3] = (char)(0x80 | (codepoint & 0x3F));
+	return 4;
+}
 
-		if (!json_is_object(jitem))
-			continue;
+static inline void json_skip_whitespace(struct json_parser *parser)
+{
+	char *p = parser->p;
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+	for (;;) {
+		if (*p == ' ' || *p == '\t' || *p == '\r') {
+			p++;
+		} else if (*p == '\n') {
+			parser->line++;
+			p++;
+		} else {
+			break;
+		}
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	parser->p = p;
 }
 
-static inline void obs_data_add_json_null(obs_data_t *data, const char *key)
+static bool json_parse_hex4(const char *p, int32_t *value)
 {
-	obs_data_set_obj(data, key, NULL);
+	int32_t result = 0;
+
+	for (size_t i = 0; i < 4; i++) {
+		char c = p[i];
+		result <<= 4;
+
+		if (c >= '0' && c <= '9')
+			result |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			result |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			result |= c - 'A' + 10;
+		else
+			return false;
+	}
+
+	*value = result;
+	return true;
+}
+
+/* escape sequences are never shorter than what they decode to, so the
+ * output can't overtake the input */
+static bool json_parse_escape(struct json_parser *parser, char **p_in, char **p_out)
+{
+	char *in = *p_in;
+	char *out = *p_out;
+	int32_t codepoint;
+
+	switch (in[1]) {
+	case '"':
+	case '\\':
+	case '/':
+		*out++ = in[1];
+		break;
+	case 'b':
+		*out++ = '\b';
+		break;
+	case 'f':
+		*out++ = '\f';
+		break;
+	case 'n':
+		*out++ = '\n';
+		break;
+	case 'r':
+		*out++ = '\r';
+		break;
+	case 't':
+		*out++ = '\t';
+		break;
+	case 'u':
+		if (!json_parse_hex4(in + 2, &codepoint))
+			return json_error(parser, "invalid escape");
+
+		if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+			int32_t low;
+
+			if (in[6] != '\\' || in[7] != 'u' || !json_parse_hex4(in + 8, &low))
+				return json_error(parser, "invalid Unicode '\\u%04X'", codepoint);
+			if (low < 0xDC00 || low > 0xDFFF)
+				return json_error(parser, "invalid Unicode '\\u%04X\\u%04X'", codepoint, low);
+
+			codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+			in += 6;
+
+		} else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+			return json_error(parser, "invalid Unicode '\\u%04X'", codepoint);
+		} else if (codepoint == 0) {
+			return json_error(parser, "\\u0000 is not allowed");
+		}
+
+		out += json_utf8_encode(codepoint, out);
+		in += 4;
+		break;
+	default:
+		return json_error(parser, "invalid escape");
+	}
+
+	*p_in = in + 2;
+	*p_out = out;
+	return true;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json)
+static bool json_parse_string(struct json_parser *parser, char **str, size_t *len)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
-	else if (json_is_null(json))
-		obs_data_add_json_null(data, key);
+	char *in = parser->p + 1;
+	char *out = in;
+
+	*str = in;
+
+	for (;;) {
+		char *run = in;
+		int32_t codepoint;
+		size_t size;
+
+		in = (char *)json_find_special(in, parser->end);
+		if (out != run)
+			memmove(out, run, in - run);
+		out += in - run;
+
+		uint8_t c = (uint8_t)*in;
+
+		if (c == '"') {
+			break;
+
+		} else if (c == '\\') {
+			if (!json_parse_escape(parser, &in, &out))
+				return false;
+
+		} else if (c >= 0x80) {
+			size = json_utf8_sequence(in, &codepoint);
+			if (!size)
+				return json_error(parser, "unable to decode byte 0x%x", c);
+
+			if (out != in)
+				memmove(out, in, size);
+			out += size;
+			in += size;
+
+		} else if (in == parser->end) {
+			return json_error(parser, "premature end of input");
+		} else {
+			return json_error(parser, "control character 0x%x", c);
+		}
+	}
+
+	*out = 0;
+	*len = out - *str;
+	parser->p = in + 1;
+	return true;
 }
 
-/* ------------------------------------------------------------------------- */
+static bool json_parse_double(struct json_parser *parser, const char *start, size_t len, double *val)
+{
+	char buf[64];
+	char *str = len < sizeof(buf) ? buf : bmalloc(len + 1);
+
+	memcpy(str, start, len);
+	str[len] = 0;
+
+	/* strtod is locale dependent */
+	char *point = memchr(str, '.', len);
+	if (point)
+		*point = parser->decimal_point;
+
+	errno = 0;
+	*val = strtod(str, NULL);
+
+	bool overflow = (*val == HUGE_VAL || *val == -HUGE_VAL) && errno == ERANGE;
 
-static inline void set_json_string(json_t *json, const char *name, obs_data_item_t *item)
+	if (str != buf)
+		bfree(str);
+
+	return overflow ? json_error(parser, "real number overflow") : true;
+}
+
+static inline bool json_is_digit(char c)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	return c >= '0' && c <= '9';
 }
 
-static inline void set_json_number(json_t *json, const char *name, obs_data_item_t *item)
+static bool json_parse_number(struct json_parser *parser, struct obs_data_number *num)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	char *start = parser->p;
+	char *p = start;
+	bool negative = *p == '-';
+	unsigned long long limit = negative ? (unsigned long long)LLONG_MAX + 1 : LLONG_MAX;
+	unsigned long long int_val = 0;
+	bool int_overflow = false;
+
+	if (negative)
+		p++;
+
+	if (*p == '0') {
+		p++;
+		if (json_is_digit(*p))
+			return json_error(parser, "invalid token");
+
+	} else if (json_is_digit(*p)) {
+		do {
+			unsigned long long digit = *p - '0';
+
+			if (int_val > (limit - digit) / 10)
+				int_overflow = true;
+			else
+				int_val = int_val * 10 + digit;
+		} while (json_is_digit(*++p));
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		return json_error(parser, "invalid token");
 	}
+
+	num->type = OBS_DATA_NUM_INT;
+
+	if (*p == '.') {
+		if (!json_is_digit(*++p))
+			return json_error(parser, "invalid token");
+		while (json_is_digit(*p))
+			p++;
+
+		num->type = OBS_DATA_NUM_DOUBLE;
+	}
+
+	if (*p == 'e' || *p == 'E') {
+		p++;
+		if (*p == '+' || *p == '-')
+			p++;
+		if (!json_is_digit(*p))
+			return json_error(parser, "invalid token");
+		while (json_is_digit(*p))
+			p++;
+
+		num->type = OBS_DATA_NUM_DOUBLE;
+	}
+
+	parser->p = p;
+
+	if (num->type == OBS_DATA_NUM_DOUBLE)
+		return json_parse_double(parser, start, p - start, &num->double_val);
+
+	if (int_overflow)
+		return json_error(parser, negative ? "too big negative integer" : "too big integer");
+
+	num->int_val = negative ? (long long)(0 - int_val) : (long long)int_val;
+	return true;
 }
 
-static inline void set_json_bool(json_t *json, const char *name, obs_data_item_t *item)
+static bool json_parse_literal(struct json_parser *parser, const char *literal, size_t len)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	char *p = parser->p;
+
+	if (strncmp(p, literal, len) != 0 || (p[len] >= 'a' && p[len] <= 'z') || (p[len] >= 'A' && p[len] <= 'Z'))
+		return json_error(parser, "invalid token");
+
+	parser->p = p + len;
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults);
+static void json_add_item(obs_data_t *data, const char *key, const void *ptr, size_t size, enum obs_data_type type)
+{
+	struct obs_data_item *item;
 
-static inline void set_json_obj(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+	if (!data)
+		return;
+
+	item = obs_data_item_create(key, ptr, size, type, false, false);
+	item->parent = data;
+	HASH_ADD_STR(data->items, name, item);
+}
+
+static bool json_parse_object(struct json_parser *parser, obs_data_t *data)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj, with_defaults));
-	obs_data_release(obj);
+	struct obs_data_item *existing;
+
+	if (++parser->depth > JSON_MAX_DEPTH)
+		return json_error(parser, "maximum parsing depth reached");
+
+	parser->p++;
+	json_skip_whitespace(parser);
+
+	if (*parser->p == '}') {
+		parser->p++;
+		parser->depth--;
+		return true;
+	}
+
+	for (;;) {
+		char *key;
+		size_t key_len;
+
+		if (*parser->p != '"')
+			return json_error(parser, "string or '}' expected");
+		if (!json_parse_string(parser, &key, &key_len))
+			return false;
+
+		HASH_FIND(hh, data->items, key, key_len, existing);
+		if (existing)
+			return json_error(parser, "duplicate object key");
+
+		json_skip_whitespace(parser);
+		if (*parser->p != ':')
+			return json_error(parser, "':' expected");
+
+		parser->p++;
+		json_skip_whitespace(parser);
+
+		if (!json_parse_value(parser, data, key))
+			return false;
+
+		json_skip_whitespace(parser);
+
+		if (*parser->p == '}')
+			break;
+		if (*parser->p != ',')
+			return json_error(parser, "'}' expected");
+
+		parser->p++;
+		json_skip_whitespace(parser);
+	}
+
+	parser->p++;
+	parser->depth--;
+	return true;
+}
+
+/* only objects are kept, array can be NULL to discard everything */
+static bool json_parse_array(struct json_parser *parser, obs_data_array_t *array)
+{
+	if (++parser->depth > JSON_MAX_DEPTH)
+		return json_error(parser, "maximum parsing depth reached");
+
+	parser->p++;
+	json_skip_whitespace(parser);
+
+	if (*parser->p == ']') {
+		parser->p++;
+		parser->depth--;
+		return true;
+	}
+
+	for (;;) {
+		if (array && *parser->p == '{') {
+			obs_data_t *obj = obs_data_create();
+			bool success = json_parse_object(parser, obj);
+
+			obs_data_array_push_back(array, obj);
+			obs_data_release(obj);
+
+			if (!success)
+				return false;
+
+		} else if (!json_parse_value(parser, NULL, NULL)) {
+			return false;
+		}
+
+		json_skip_whitespace(parser);
+
+		if (*parser->p == ']')
+			break;
+		if (*parser->p != ',')
+			return json_error(parser, "']' expected");
+
+		parser->p++;
+		json_skip_whitespace(parser);
+	}
+
+	parser->p++;
+	parser->depth--;
+	return true;
+}
+
+/* parses a value into the key item of data, data can be NULL to discard the
+ * value after checking it */
+static bool json_parse_value(struct json_parser *parser, obs_data_t *data, const char *key)
+{
+	switch (*parser->p) {
+	case '{': {
+		obs_data_t *obj = obs_data_create();
+		bool success = json_parse_object(parser, obj);
+
+		if (success)
+			json_add_item(data, key, &obj, sizeof(obs_data_t *), OBS_DATA_OBJECT);
+
+		obs_data_release(obj);
+		return success;
+	}
+	case '[': {
+		obs_data_array_t *array = data ? obs_data_array_create() : NULL;
+		bool success = json_parse_array(parser, array);
+
+		if (success)
+			json_add_item(data, key, &array, sizeof(obs_data_array_t *), OBS_DATA_ARRAY);
+
+		obs_data_array_release(array);
+		return success;
+	}
+	case '"': {
+		char *str;
+		size_t len;
+
+		if (!json_parse_string(parser, &str, &len))
+			return false;
+
+		json_add_item(data, key, str, len + 1, OBS_DATA_STRING);
+		return true;
+	}
+	case 't':
+	case 'f': {
+		bool val = *parser->p == 't';
+
+		if (!json_parse_literal(parser, val ? "true" : "false", val ? 4 : 5))
+			return false;
+
+		json_add_item(data, key, &val, sizeof(bool), OBS_DATA_BOOLEAN);
+		return true;
+	}
+	case 'n': {
+		obs_data_t *obj = NULL;
+
+		if (!json_parse_literal(parser, "null", 4))
+			return false;
+
+		json_add_item(data, key, &obj, sizeof(obs_data_t *), OBS_DATA_OBJECT);
+		return true;
+	}
+	case '\0':
+		if (parser->p == parser->end)
+			return json_error(parser, "premature end of input");
+		return json_error(parser, "invalid token");
+	default: {
+		struct obs_data_number num;
+
+		if (!json_parse_number(parser, &num))
+			return false;
+
+		json_add_item(data, key, &num, sizeof(struct obs_data_number), OBS_DATA_NUMBER);
+		return true;
+	}
+	}
+}
+
+/* json has to be null terminated at json + len, and is modified */
+static bool json_parse(struct json_parser *parser, obs_data_t *data, char *json, size_t len)
+{
+	const char *decimal_point = localeconv()->decimal_point;
+
+	parser->p = json;
+	parser->end = json + len;
+	parser->line = 1;
+	parser->depth = 0;
+	parser->decimal_point = decimal_point && *decimal_point ? *decimal_point : '.';
+	parser->error[0] = 0;
+
+	json_skip_whitespace(parser);
+
+	if (*parser->p == '{') {
+		if (!json_parse_object(parser, data))
+			return false;
+
+	} else if (*parser->p == '[') {
+		/* arrays don't have keys, so there's nothing to keep */
+		if (!json_parse_array(parser, NULL))
+			return false;
+
+	} else {
+		return json_error(parser, "'[' or '{' expected");
+	}
+
+	json_skip_whitespace(parser);
+
+	if (parser->p != parser->end)
+		return json_error(parser, "end of file expected");
+
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/*
+ * JSON writing
+ *
+ *   Writes the same output jansson did with JSON_PRESERVE_ORDER and either
+ * JSON_INDENT(4) or JSON_COMPACT.  Like with jansson, items that can't be
+ * represented (strings and names that aren't valid UTF-8, NaN and infinite
+ * numbers) are left out.
+ */
+
+#define JSON_INDENT_SIZE 4
+
+struct json_writer {
+	struct dstr out;
+	bool pretty;
+	bool with_defaults;
+};
+
+static void json_write_obj(struct json_writer *writer, obs_data_t *data, size_t depth);
+
+static inline void json_write(struct json_writer *writer, const char *str, size_t len)
+{
+	struct dstr *out = &writer->out;
+
+	dstr_ensure_capacity(out, out->len + len + 1);
+	memcpy(out->array + out->len, str, len);
+	out->len += len;
+}
+
+static inline void json_write_ch(struct json_writer *writer, char ch)
+{
+	struct dstr *out = &writer->out;
+
+	dstr_ensure_capacity(out, out->len + 2);
+	out->array[out->len++] = ch;
+}
+
+static void json_write_indent(struct json_writer *writer, size_t depth)
+{
+	static const char spaces[] = "                                ";
+	size_t count = depth * JSON_INDENT_SIZE;
+
+	if (!writer->pretty)
+		return;
+
+	json_write_ch(writer, '\n');
+
+	while (count) {
+		size_t len = count < sizeof(spaces) - 1 ? count : sizeof(spaces) - 1;
+		json_write(writer, spaces, len);
+		count -= len;
+	}
 }
 
-static inline void set_json_array(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+/* returns false if str isn't valid UTF-8 */
+static bool json_write_string(struct json_writer *writer, const char *str)
+{
+	const char *end = str + strlen(str);
+	int32_t codepoint;
+
+	json_write_ch(writer, '"');
+
+	for (;;) {
+		const char *run = str;
+
+		str = json_find_special(str, end);
+		json_write(writer, run, str - run);
+
+		if (str == end)
+			break;
+
+		uint8_t c = (uint8_t)*str;
+
+		if (c >= 0x80) {
+			size_t size = json_utf8_sequence(str, &codepoint);
+			if (!size)
+				return false;
+
+			json_write(writer, str, size);
+			str += size;
+			continue;
+		}
+
+		switch (c) {
+		case '"':
+			json_write(writer, "\\\"", 2);
+			break;
+		case '\\':
+			json_write(writer, "\\\\", 2);
+			break;
+		case '\b':
+			json_write(writer, "\\b", 2);
+			break;
+		case '\f':
+			json_write(writer, "\\f", 2);
+			break;
+		case '\n':
+			json_write(writer, "\\n", 2);
+			break;
+		case '\r':
+			json_write(writer, "\\r", 2);
+			break;
+		case '\t':
+			json_write(writer, "\\t", 2);
+			break;
+		default: {
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04X", c);
+			json_write(writer, escape, 6);
+			break;
+		}
+		}
+
+		str++;
+	}
+
+	json_write_ch(writer, '"');
+	return true;
+}
+
+static void json_write_int(struct json_writer *writer, long long val)
+{
+	char buf[24];
+	char *p = buf + sizeof(buf);
+	unsigned long long abs_val = val < 0 ? 0 - (unsigned long long)val : (unsigned long long)val;
+
+	do {
+		*--p = (char)('0' + abs_val % 10);
+		abs_val /= 10;
+	} while (abs_val);
+
+	if (val < 0)
+		*--p = '-';
+
+	json_write(writer, p, buf + sizeof(buf) - p);
+}
+
+/* returns false if the number can't be represented */
+static bool json_write_number(struct json_writer *writer, obs_data_item_t *item)
+{
+	if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT) {
+		json_write_int(writer, obs_data_item_get_int(item));
+		return true;
+	}
+
+	double val = obs_data_item_get_double(item);
+	char buf[64];
+	int len;
+
+	if (!isfinite(val))
+		return false;
+
+	len = os_dtostr(val, buf, sizeof(buf));
+	if (len < 0)
+		return false;
+
+	json_write(writer, buf, len);
+	return true;
+}
+
+static void json_write_array(struct json_writer *writer, obs_data_array_t *array, size_t depth)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
 	size_t count = obs_data_array_count(array);
 
+	json_write_ch(writer, '[');
+
+	if (!count) {
+		json_write_ch(writer, ']');
+		return;
+	}
+
 	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item, with_defaults);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+		obs_data_t *obj = obs_data_array_item(array, idx);
+
+		if (idx)
+			json_write_ch(writer, ',');
+
+		json_write_indent(writer, depth + 1);
+		json_write_obj(writer, obj, depth + 1);
+		obs_data_release(obj);
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	json_write_indent(writer, depth);
+	json_write_ch(writer, ']');
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults)
+static bool json_write_item(struct json_writer *writer, obs_data_item_t *item, size_t depth)
 {
-	if (!data)
-		return json_null();
+	switch (obs_data_item_gettype(item)) {
+	case OBS_DATA_STRING:
+		return json_write_string(writer, obs_data_item_get_string(item));
+
+	case OBS_DATA_NUMBER:
+		return json_write_number(writer, item);
 
-	json_t *json = json_object();
+	case OBS_DATA_BOOLEAN:
+		if (obs_data_item_get_bool(item))
+			json_write(writer, "true", 4);
+		else
+			json_write(writer, "false", 5);
+		return true;
+
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		json_write_obj(writer, obj, depth);
+		obs_data_release(obj);
+		return true;
+	}
+
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		json_write_array(writer, array, depth);
+		obs_data_array_release(array);
+		return true;
+	}
 
+	case OBS_DATA_NULL:
+		break;
+	}
+
+	return false;
+}
+
+static void json_write_obj(struct json_writer *writer, obs_data_t *data, size_t depth)
+{
 	obs_data_item_t *item = NULL;
 	obs_data_item_t *temp = NULL;
+	bool empty = true;
+
+	if (!data) {
+		json_write(writer, "null", 4);
+		return;
+	}
+
+	json_write_ch(writer, '{');
 
 	HASH_ITER (hh, data->items, item, temp) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+		size_t start = writer->out.len;
 
-		if (!with_defaults && !obs_data_item_has_user_value(item))
+		if (!writer->with_defaults && !obs_data_item_has_user_value(item))
 			continue;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item, with_defaults);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item, with_defaults);
+		if (!empty)
+			json_write_ch(writer, ',');
+		json_write_indent(writer, depth + 1);
+
+		if (!json_write_string(writer, get_item_name(item)))
+			goto skip;
+
+		if (writer->pretty)
+			json_write(writer, ": ", 2);
+		else
+			json_write_ch(writer, ':');
+
+		if (!json_write_item(writer, item, depth + 1))
+			goto skip;
+
+		empty = false;
+		continue;
+
+	skip:
+		writer->out.len = start;
 	}
 
-	return json;
+	if (!empty)
+		json_write_indent(writer, depth);
+	json_write_ch(writer, '}');
+}
+
+static char *json_write_data(obs_data_t *data, bool pretty, bool with_defaults)
+{
+	struct json_writer writer = {.pretty = pretty, .with_defaults = with_defaults};
+
+	json_write_obj(&writer, data, 0);
+	writer.out.array[writer.out.len] = 0;
+
+	return writer.out.array;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -603,21 +1343,17 @@ obs_data_t *obs_data_create()
 	return data;
 }
 
-obs_data_t *obs_data_create_from_json(const char *json_string)
+/* parses the json string in place */
+static obs_data_t *obs_data_create_from_json_internal(char *json_string)
 {
 	obs_data_t *data = obs_data_create();
+	struct json_parser parser;
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
-
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	if (!json_parse(&parser, data, json_string, strlen(json_string))) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
+		     parser.line, parser.error);
 		obs_data_release(data);
 		data = NULL;
 	}
@@ -625,13 +1361,28 @@ obs_data_t *obs_data_create_from_json(const char *json_string)
 	return data;
 }
 
+obs_data_t *obs_data_create_from_json(const char *json_string)
+{
+	if (!json_string) {
+		blog(LOG_ERROR, "obs-data.c: [obs_data_create_from_json] "
+				"Failed reading json string: NULL string");
+		return NULL;
+	}
+
+	char *json = bstrdup(json_string);
+	obs_data_t *data = obs_data_create_from_json_internal(json);
+	bfree(json);
+
+	return data;
+}
+
 obs_data_t *obs_data_create_from_json_file(const char *json_file)
 {
 	char *file_data = os_quick_read_utf8_file(json_file);
 	obs_data_t *data = NULL;
 
 	if (file_data) {
-		data = obs_data_create_from_json(file_data);
+		data = obs_data_create_from_json_internal(file_data);
 		bfree(file_data);
 	}
 
@@ -682,8 +1433,7 @@ static inline void obs_data_destroy(struct obs_data *data)
 		obs_data_item_release(&item);
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
+	bfree(data->json);
 	bfree(data);
 }
 
@@ -701,20 +1451,8 @@ static const char *obs_data_get_json_internal(obs_data_t *data, bool pretty, boo
 	if (!data)
 		return NULL;
 
-	size_t flags = JSON_PRESERVE_ORDER;
-
-	if (pretty)
-		flags |= JSON_INDENT(4);
-	else
-		flags |= JSON_COMPACT;
-
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
-
-	json_t *root = obs_data_to_json(data, with_defaults);
-	data->json = json_dumps(root, flags);
-	json_decref(root);
+	bfree(data->json);
+	data->json = json_write_data(data, pretty, with_defaults);
 
 	return data->json;
 }
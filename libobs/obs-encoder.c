@@ -25,6 +25,7 @@
 #define get_weak(encoder) ((obs_weak_encoder_t *)encoder->context.control)
 
 static void encoder_set_video(obs_encoder_t *encoder, video_t *video);
+static void free_packet_data(struct obs_encoder *encoder);
 
 struct obs_encoder_info *find_encoder(const char *id)
 {
@@ -380,7 +381,8 @@ static void add_connection(struct obs_encoder *encoder)
 		if (gpu_encode_available(encoder)) {
 			start_gpu_encode(encoder);
 		} else {
-			start_raw_video(encoder->media, &info, encoder->frame_rate_divisor, receive_video, encoder);
+			start_raw_video(encoder->media, &info, encoder->frame_rate_divisor, encoder->video_queue_size,
+					receive_video, encoder);
 		}
 	}
 
@@ -483,6 +485,7 @@ void obs_encoder_destroy(obs_encoder_t *encoder)
 		da_free(encoder->callbacks);
 		da_free(encoder->roi);
 		da_free(encoder->encoder_packet_times);
+		free_packet_data(encoder);
 		pthread_mutex_destroy(&encoder->init_mutex);
 		pthread_mutex_destroy(&encoder->callbacks_mutex);
 		pthread_mutex_destroy(&encoder->outputs_mutex);
@@ -1132,6 +1135,59 @@ uint32_t obs_encoder_get_frame_rate_divisor(const obs_encoder_t *encoder)
 	return encoder->frame_rate_divisor;
 }
 
+bool obs_encoder_set_video_queue_size(obs_encoder_t *encoder, uint32_t queue_size)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_set_video_queue_size"))
+		return false;
+
+	if (encoder->info.type != OBS_ENCODER_VIDEO) {
+		blog(LOG_WARNING,
+		     "obs_encoder_set_video_queue_size: "
+		     "encoder '%s' is not a video encoder",
+		     obs_encoder_get_name(encoder));
+		return false;
+	}
+
+	if (encoder_active(encoder)) {
+		blog(LOG_WARNING,
+		     "encoder '%s': Cannot set video queue size "
+		     "while the encoder is active",
+		     obs_encoder_get_name(encoder));
+		return false;
+	}
+
+	encoder->video_queue_size = queue_size;
+	return true;
+}
+
+uint32_t obs_encoder_get_video_queue_size(const obs_encoder_t *encoder)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_video_queue_size"))
+		return 0;
+
+	return encoder->info.type == OBS_ENCODER_VIDEO ? encoder->video_queue_size : 0;
+}
+
+uint32_t obs_encoder_get_queued_frames(const obs_encoder_t *encoder)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_queued_frames"))
+		return 0;
+	if (encoder->info.type != OBS_ENCODER_VIDEO || !encoder->media)
+		return 0;
+
+	return video_output_get_input_queued_frames(encoder->media, receive_video, (void *)encoder);
+}
+
+uint32_t obs_encoder_get_dropped_frames(const obs_encoder_t *encoder)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_get_dropped_frames"))
+		return 0;
+	if (encoder->info.type != OBS_ENCODER_VIDEO || !encoder->media)
+		return 0;
+
+	return video_output_get_input_dropped_frames(encoder->media, receive_video, (void *)encoder);
+}
+
 uint32_t obs_encoder_get_sample_rate(const obs_encoder_t *encoder)
 {
 	if (!obs_encoder_valid(encoder, "obs_encoder_get_sample_rate"))
@@ -1323,11 +1379,18 @@ static inline bool get_sei(const struct obs_encoder *encoder, uint8_t **sei, siz
 	return false;
 }
 
+static inline uint8_t *alloc_packet_data(size_t size)
+{
+	long *p_refs = bmalloc(size + sizeof(long));
+	*p_refs = 1;
+	return (uint8_t *)(p_refs + 1);
+}
+
 static void send_first_video_packet(struct obs_encoder *encoder, struct encoder_callback *cb,
 				    struct encoder_packet *packet, struct encoder_packet_time *packet_time)
 {
 	struct encoder_packet first_packet;
-	DARRAY(uint8_t) data;
+	uint8_t *prev_shared_data;
 	uint8_t *sei;
 	size_t size;
 
@@ -1335,25 +1398,28 @@ static void send_first_video_packet(struct obs_encoder *encoder, struct encoder_
 	if (!packet->keyframe)
 		return;
 
-	da_init(data);
-
 	if (!get_sei(encoder, &sei, &size) || !sei || !size) {
 		cb->new_packet(cb->param, packet, packet_time);
 		cb->sent_first_packet = true;
 		return;
 	}
 
-	da_push_back_array(data, sei, size);
-	da_push_back_array(data, packet->data, packet->size);
-
+	/* build the packet as a shared instance right away so that outputs
+	 * don't have to copy it again */
 	first_packet = *packet;
-	first_packet.data = data.array;
-	first_packet.size = data.num;
+	first_packet.size = size + packet->size;
+	first_packet.data = alloc_packet_data(first_packet.size);
+	memcpy(first_packet.data, sei, size);
+	memcpy(first_packet.data + size, packet->data, packet->size);
+
+	prev_shared_data = encoder->shared_packet_data;
+	encoder->shared_packet_data = first_packet.data;
 
 	cb->new_packet(cb->param, &first_packet, packet_time);
 	cb->sent_first_packet = true;
 
-	da_free(data);
+	encoder->shared_packet_data = prev_shared_data;
+	obs_encoder_packet_release(&first_packet);
 }
 
 static const char *send_packet_name = "send_packet";
@@ -1391,10 +1457,30 @@ void full_stop(struct obs_encoder *encoder)
 	}
 }
 
+static void free_packet_data(struct obs_encoder *encoder)
+{
+	if (encoder->packet_data) {
+		struct encoder_packet pkt = {.data = encoder->packet_data};
+		obs_encoder_packet_release(&pkt);
+		encoder->packet_data = NULL;
+	}
+}
+
+uint8_t *obs_encoder_alloc_packet_data(obs_encoder_t *encoder, size_t size)
+{
+	if (!obs_encoder_valid(encoder, "obs_encoder_alloc_packet_data"))
+		return NULL;
+
+	free_packet_data(encoder);
+	encoder->packet_data = alloc_packet_data(size);
+	return encoder->packet_data;
+}
+
 void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received, struct encoder_packet *pkt)
 {
 	if (!success) {
 		blog(LOG_ERROR, "Error encoding with encoder '%s'", encoder->context.name);
+		free_packet_data(encoder);
 		full_stop(encoder);
 		return;
 	}
@@ -1436,6 +1522,11 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 				     pkt->pts);
 		}
 
+		/* the encoder wrote the packet into data libobs allocated for it,
+		 * so outputs can share it */
+		if (encoder->packet_data && pkt->data == encoder->packet_data)
+			encoder->shared_packet_data = pkt->data;
+
 		pthread_mutex_lock(&encoder->callbacks_mutex);
 
 		for (size_t i = encoder->callbacks.num; i > 0; i--) {
@@ -1446,10 +1537,14 @@ void send_off_encoder_packet(obs_encoder_t *encoder, bool success, bool received
 
 		pthread_mutex_unlock(&encoder->callbacks_mutex);
 
+		encoder->shared_packet_data = NULL;
+
 		// Count number of video frames successfully encoded
 		if (pkt->type == OBS_ENCODER_VIDEO)
 			encoder->encoded_frames++;
 	}
+
+	free_packet_data(encoder);
 }
 
 static const char *do_encode_name = "do_encode";
@@ -1887,12 +1982,16 @@ void obs_encoder_remove_output(struct obs_encoder *encoder, struct obs_output *o
 
 void obs_encoder_packet_create_instance(struct encoder_packet *dst, const struct encoder_packet *src)
 {
-	long *p_refs;
-
 	*dst = *src;
-	p_refs = bmalloc(src->size + sizeof(long));
-	dst->data = (void *)(p_refs + 1);
-	*p_refs = 1;
+
+	/* packets whose data libobs allocated are already refcounted */
+	if (src->encoder && src->data && src->data == src->encoder->shared_packet_data) {
+		long *p_refs = ((long *)src->data) - 1;
+		os_atomic_inc_long(p_refs);
+		return;
+	}
+
+	dst->data = alloc_packet_data(src->size);
 	memcpy(dst->data, src->data, src->size);
 }
 
@@ -464,6 +464,8 @@ static inline void create_binding(obs_hotkey_t *hotkey, obs_key_combination_t co
 	binding->key = combo;
 	binding->hotkey_id = hotkey->id;
 	binding->hotkey = hotkey;
+
+	obs->hotkeys.key_index_dirty = true;
 }
 
 static inline void load_binding(obs_hotkey_t *hotkey, obs_data_t *data)
@@ -814,6 +816,9 @@ static inline bool remove_bindings(obs_hotkey_id id)
 		removed = true;
 	}
 
+	if (removed)
+		obs->hotkeys.key_index_dirty = true;
+
 	return removed;
 }
 
@@ -958,6 +963,7 @@ void obs_hotkeys_free(void)
 	}
 
 	da_free(obs->hotkeys.bindings);
+	da_free(obs->hotkeys.key_index);
 
 	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++) {
 		if (obs->hotkeys.translations[i]) {
@@ -1073,6 +1079,8 @@ struct obs_hotkey_internal_inject {
 	bool strict_modifiers;
 };
 
+static void dispatch_key(obs_key_t key);
+
 static inline bool inject_hotkey(void *data, size_t idx, obs_hotkey_binding_t *binding)
 {
 	UNUSED_PARAMETER(idx);
@@ -1104,6 +1112,12 @@ void obs_hotkey_inject_event(obs_key_combination_t hotkey, bool pressed)
 		obs->hotkeys.strict_modifiers,
 	};
 	enum_bindings(inject_hotkey, &event);
+
+	/* the polling thread would release injected presses on its next
+	 * iteration, event-driven backends have to do it right away */
+	if (obs->hotkeys.event_driven && !pressed)
+		dispatch_key(hotkey.key);
+
 	unlock();
 }
 
@@ -1152,6 +1166,130 @@ static inline void query_hotkeys()
 	enum_bindings(query_hotkey, &param);
 }
 
+/* ------------------------------------------------------------------------- */
+/* event-driven backends                                                     */
+
+static inline bool is_modifier_key(obs_key_t key)
+{
+	return key == OBS_KEY_SHIFT || key == OBS_KEY_CONTROL || key == OBS_KEY_ALT || key == OBS_KEY_META;
+}
+
+static inline uint32_t key_state_modifiers(void)
+{
+	const bool *state = obs->hotkeys.key_state;
+	uint32_t modifiers = 0;
+
+	if (state[OBS_KEY_SHIFT])
+		modifiers |= INTERACT_SHIFT_KEY;
+	if (state[OBS_KEY_CONTROL])
+		modifiers |= INTERACT_CONTROL_KEY;
+	if (state[OBS_KEY_ALT])
+		modifiers |= INTERACT_ALT_KEY;
+	if (state[OBS_KEY_META])
+		modifiers |= INTERACT_COMMAND_KEY;
+
+	return modifiers;
+}
+
+static int cmp_binding_key(const void *a, const void *b)
+{
+	const obs_hotkey_binding_t *bindings = obs->hotkeys.bindings.array;
+	obs_key_t key_a = bindings[*(const size_t *)a].key.key;
+	obs_key_t key_b = bindings[*(const size_t *)b].key.key;
+
+	return (key_a > key_b) - (key_a < key_b);
+}
+
+static void rebuild_key_index(void)
+{
+	struct obs_core_hotkeys *hotkeys = &obs->hotkeys;
+
+	da_resize(hotkeys->key_index, hotkeys->bindings.num);
+	for (size_t i = 0; i < hotkeys->bindings.num; i++)
+		hotkeys->key_index.array[i] = i;
+
+	if (hotkeys->key_index.num)
+		qsort(hotkeys->key_index.array, hotkeys->key_index.num, sizeof(size_t), cmp_binding_key);
+
+	hotkeys->key_index_dirty = false;
+}
+
+/* returns the position of the first binding for the key in key_index */
+static size_t key_index_find(obs_key_t key)
+{
+	const obs_hotkey_binding_t *bindings = obs->hotkeys.bindings.array;
+	const size_t *index = obs->hotkeys.key_index.array;
+	size_t lo = 0;
+	size_t hi = obs->hotkeys.key_index.num;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (bindings[index[mid]].key.key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static inline void dispatch_binding(obs_hotkey_binding_t *binding, struct obs_query_hotkeys_helper *param)
+{
+	bool pressed = obs->hotkeys.key_state[binding->key.key];
+	handle_binding(binding, param->modifiers, param->no_press, param->strict_modifiers, &pressed);
+}
+
+static inline bool dispatch_hotkey(void *data, size_t idx, obs_hotkey_binding_t *binding)
+{
+	UNUSED_PARAMETER(idx);
+
+	dispatch_binding(binding, data);
+	return true;
+}
+
+/* updates the bindings affected by a change of the state of the key: a
+ * modifier change affects every binding, any other key only its own */
+static void dispatch_key(obs_key_t key)
+{
+	struct obs_core_hotkeys *hotkeys = &obs->hotkeys;
+	struct obs_query_hotkeys_helper param = {
+		key_state_modifiers(),
+		hotkeys->thread_disable_press,
+		hotkeys->strict_modifiers,
+	};
+
+	if (key == OBS_KEY_NONE || is_modifier_key(key)) {
+		enum_bindings(dispatch_hotkey, &param);
+		return;
+	}
+
+	if (hotkeys->key_index_dirty)
+		rebuild_key_index();
+
+	for (size_t i = key_index_find(key); i < hotkeys->key_index.num; i++) {
+		obs_hotkey_binding_t *binding = &hotkeys->bindings.array[hotkeys->key_index.array[i]];
+		if (binding->key.key != key)
+			break;
+
+		dispatch_binding(binding, &param);
+	}
+}
+
+void obs_hotkeys_key_event(obs_key_t key, bool pressed)
+{
+	if (key <= OBS_KEY_NONE || key >= OBS_KEY_LAST_VALUE)
+		return;
+	if (!lock())
+		return;
+
+	if (obs->hotkeys.key_state[key] != pressed) {
+		obs->hotkeys.key_state[key] = pressed;
+		dispatch_key(key);
+	}
+
+	unlock();
+}
+
 #define NBSP "\xC2\xA0"
 
 void *obs_hotkey_thread(void *arg)
@@ -1160,6 +1298,24 @@ void *obs_hotkey_thread(void *arg)
 
 	os_set_thread_name("libobs: hotkey thread");
 
+	/* set by the platform backend when it can deliver key events */
+	if (obs->hotkeys.event_driven) {
+		while (os_event_try(obs->hotkeys.stop_event) == EAGAIN) {
+			if (!obs_hotkeys_platform_wait_events(obs->hotkeys.platform_context))
+				break;
+		}
+
+		if (os_event_try(obs->hotkeys.stop_event) != EAGAIN)
+			return NULL;
+
+		blog(LOG_WARNING, "Hotkey events are no longer available, falling back to polling");
+
+		if (lock()) {
+			obs->hotkeys.event_driven = false;
+			unlock();
+		}
+	}
+
 	const char *hotkey_thread_name =
 		profile_store_name(obs_get_profiler_name_store(), "obs_hotkey_thread(%g" NBSP "ms)", 25.);
 	profile_register_root(hotkey_thread_name, (uint64_t)25000000);
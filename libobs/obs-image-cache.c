@@ -0,0 +1,346 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#include "util/platform.h"
+#include "util/dstr.h"
+#include "obs-internal.h"
+
+#define DEFAULT_LIMIT (512ULL * 1024 * 1024)
+
+struct obs_cached_image {
+	UT_hash_handle hh;
+	char *key;
+	long refs;
+
+	uint8_t *data;
+	gs_texture_t *texture;
+	enum gs_color_format format;
+	enum gs_color_space space;
+	uint32_t cx;
+	uint32_t cy;
+	uint64_t size;
+
+	/* only valid while unreferenced */
+	struct obs_cached_image *prev_unused;
+	struct obs_cached_image *next_unused;
+};
+
+static inline struct obs_image_cache *get_cache(void)
+{
+	return obs ? &obs->data.image_cache : NULL;
+}
+
+bool obs_image_cache_init(struct obs_image_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->limit = DEFAULT_LIMIT;
+	return pthread_mutex_init(&cache->mutex, NULL) == 0;
+}
+
+static void destroy_image(struct obs_cached_image *image)
+{
+	if (image->texture) {
+		obs_enter_graphics();
+		gs_texture_destroy(image->texture);
+		obs_leave_graphics();
+	}
+
+	bfree(image->data);
+	bfree(image->key);
+	bfree(image);
+}
+
+void obs_image_cache_free(struct obs_image_cache *cache)
+{
+	struct obs_cached_image *image, *tmp;
+	size_t leaked = 0;
+
+	HASH_ITER (hh, cache->images, image, tmp) {
+		HASH_DEL(cache->images, image);
+		if (image->refs)
+			leaked++;
+		destroy_image(image);
+	}
+
+	if (leaked)
+		blog(LOG_WARNING, "Image cache: %zu images still referenced on shutdown", leaked);
+
+	blog(LOG_INFO, "Image cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions", cache->hits,
+	     cache->misses, cache->evictions);
+
+	pthread_mutex_destroy(&cache->mutex);
+}
+
+static void unused_push(struct obs_image_cache *cache, struct obs_cached_image *image)
+{
+	image->prev_unused = cache->last_unused;
+	image->next_unused = NULL;
+
+	if (cache->last_unused)
+		cache->last_unused->next_unused = image;
+	else
+		cache->first_unused = image;
+
+	cache->last_unused = image;
+	cache->num_unused++;
+}
+
+static void unused_remove(struct obs_image_cache *cache, struct obs_cached_image *image)
+{
+	if (image->prev_unused)
+		image->prev_unused->next_unused = image->next_unused;
+	else
+		cache->first_unused = image->next_unused;
+
+	if (image->next_unused)
+		image->next_unused->prev_unused = image->prev_unused;
+	else
+		cache->last_unused = image->prev_unused;
+
+	image->prev_unused = NULL;
+	image->next_unused = NULL;
+	cache->num_unused--;
+}
+
+/* Removes least recently used images until the cache fits its limit, and
+ * returns them as a list linked through next_unused.  They have to be
+ * destroyed after unlocking, as destroying textures requires the graphics
+ * context and the graphics thread may be waiting on the cache mutex. */
+static struct obs_cached_image *trim_cache(struct obs_image_cache *cache)
+{
+	struct obs_cached_image *evicted = NULL;
+
+	while (cache->size > cache->limit && cache->first_unused) {
+		struct obs_cached_image *image = cache->first_unused;
+
+		unused_remove(cache, image);
+		HASH_DEL(cache->images, image);
+		cache->size -= image->size;
+		cache->evictions++;
+
+		image->next_unused = evicted;
+		evicted = image;
+	}
+
+	return evicted;
+}
+
+static void destroy_images(struct obs_cached_image *list)
+{
+	while (list) {
+		struct obs_cached_image *next = list->next_unused;
+		destroy_image(list);
+		list = next;
+	}
+}
+
+static inline int64_t get_modified_time(const char *file)
+{
+	struct stat stats;
+	if (os_stat(file, &stats) != 0)
+		return -1;
+	return (int64_t)stats.st_mtime;
+}
+
+static struct obs_cached_image *decode_image(const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	struct obs_cached_image *image = bzalloc(sizeof(*image));
+
+	image->data = gs_create_texture_file_data3(file, alpha_mode, &image->format, &image->cx, &image->cy,
+						   &image->space);
+	if (!image->data) {
+		blog(LOG_WARNING, "Image cache: Failed to load file '%s'", file);
+		bfree(image);
+		return NULL;
+	}
+
+	image->size = (uint64_t)image->cx * image->cy * gs_get_format_bpp(image->format) / 8;
+	return image;
+}
+
+obs_cached_image_t *obs_image_cache_get(const char *file, enum gs_image_alpha_mode alpha_mode)
+{
+	struct obs_image_cache *cache = get_cache();
+	struct obs_cached_image *image, *decoded, *evicted;
+	struct dstr key = {0};
+
+	if (!cache || !file || !*file)
+		return NULL;
+
+	dstr_printf(&key, "%d|%" PRId64 "|%s", (int)alpha_mode, get_modified_time(file), file);
+
+	pthread_mutex_lock(&cache->mutex);
+
+	HASH_FIND_STR(cache->images, key.array, image);
+	if (image) {
+		if (!image->refs++)
+			unused_remove(cache, image);
+		cache->hits++;
+	} else {
+		cache->misses++;
+	}
+
+	pthread_mutex_unlock(&cache->mutex);
+
+	if (image) {
+		dstr_free(&key);
+		return image;
+	}
+
+	/* decode without holding the lock, images can take a while */
+	decoded = decode_image(file, alpha_mode);
+	if (!decoded) {
+		dstr_free(&key);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&cache->mutex);
+
+	/* someone else may have decoded the same image in the meantime */
+	HASH_FIND_STR(cache->images, key.array, image);
+	if (image) {
+		if (!image->refs++)
+			unused_remove(cache, image);
+	} else {
+		image = decoded;
+		image->key = key.array;
+		image->refs = 1;
+		key.array = NULL;
+
+		HASH_ADD_KEYPTR(hh, cache->images, image->key, strlen(image->key), image);
+		cache->size += image->size;
+		decoded = NULL;
+	}
+
+	evicted = trim_cache(cache);
+
+	pthread_mutex_unlock(&cache->mutex);
+
+	if (decoded)
+		destroy_image(decoded);
+	destroy_images(evicted);
+	dstr_free(&key);
+	return image;
+}
+
+void obs_cached_image_release(obs_cached_image_t *image)
+{
+	struct obs_image_cache *cache = get_cache();
+	struct obs_cached_image *evicted;
+
+	if (!image || !cache)
+		return;
+
+	pthread_mutex_lock(&cache->mutex);
+
+	if (--image->refs == 0)
+		unused_push(cache, image);
+
+	evicted = trim_cache(cache);
+
+	pthread_mutex_unlock(&cache->mutex);
+
+	destroy_images(evicted);
+}
+
+gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image)
+{
+	struct obs_image_cache *cache = get_cache();
+	gs_texture_t *texture;
+
+	if (!image || !cache)
+		return NULL;
+
+	pthread_mutex_lock(&cache->mutex);
+
+	if (!image->texture && image->data) {
+		image->texture =
+			gs_texture_create(image->cx, image->cy, image->format, 1, (const uint8_t **)&image->data, 0);
+
+		/* the texture holds the only copy from now on */
+		if (image->texture) {
+			bfree(image->data);
+			image->data = NULL;
+		}
+	}
+
+	texture = image->texture;
+
+	pthread_mutex_unlock(&cache->mutex);
+	return texture;
+}
+
+uint32_t obs_cached_image_get_width(const obs_cached_image_t *image)
+{
+	return image ? image->cx : 0;
+}
+
+uint32_t obs_cached_image_get_height(const obs_cached_image_t *image)
+{
+	return image ? image->cy : 0;
+}
+
+enum gs_color_space obs_cached_image_get_color_space(const obs_cached_image_t *image)
+{
+	return image ? image->space : GS_CS_SRGB;
+}
+
+uint64_t obs_cached_image_get_size(const obs_cached_image_t *image)
+{
+	return image ? image->size : 0;
+}
+
+void obs_image_cache_set_limit(uint64_t limit)
+{
+	struct obs_image_cache *cache = get_cache();
+	struct obs_cached_image *evicted;
+
+	if (!cache)
+		return;
+
+	pthread_mutex_lock(&cache->mutex);
+	cache->limit = limit;
+	evicted = trim_cache(cache);
+	pthread_mutex_unlock(&cache->mutex);
+
+	destroy_images(evicted);
+}
+
+void obs_image_cache_get_stats(struct obs_image_cache_stats *stats)
+{
+	struct obs_image_cache *cache = get_cache();
+
+	if (!stats)
+		return;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!cache)
+		return;
+
+	pthread_mutex_lock(&cache->mutex);
+	stats->hits = cache->hits;
+	stats->misses = cache->misses;
+	stats->evictions = cache->evictions;
+	stats->size = cache->size;
+	stats->limit = cache->limit;
+	stats->num_images = HASH_COUNT(cache->images);
+	stats->num_unused = cache->num_unused;
+	pthread_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,273 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "util/darray.h"
+#include "obs.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encoded packet interleaver used by outputs.
+ *
+ *   Packets are queued per track, and the tracks are merged with a min-heap
+ * on their first packet.  Packets are ordered by DTS; on equal DTS video
+ * comes before audio and video tracks are ordered by track index, otherwise
+ * packets stay in the order they were pushed.  This is the same order the
+ * old single sorted array produced, without the insertion and removal cost
+ * growing with the number of queued packets.
+ *
+ *   Pointers to queued packets are only valid until the next push or pop.
+ */
+
+#define INTERLEAVE_MAX_TRACKS (MAX_OUTPUT_VIDEO_ENCODERS + MAX_OUTPUT_AUDIO_ENCODERS)
+
+struct interleaved_packet {
+	struct encoder_packet packet;
+	uint64_t seq;
+};
+
+struct interleave_track {
+	DARRAY(struct interleaved_packet) packets;
+	size_t head;
+};
+
+struct packet_interleaver {
+	struct interleave_track tracks[INTERLEAVE_MAX_TRACKS];
+
+	/* non-empty tracks, ordered by their first packet */
+	uint8_t heap[INTERLEAVE_MAX_TRACKS];
+	size_t heap_size;
+
+	size_t num_packets;
+	uint64_t next_seq;
+};
+
+static inline bool interleaved_packet_before(const struct interleaved_packet *a, const struct interleaved_packet *b)
+{
+	if (a->packet.dts_usec != b->packet.dts_usec)
+		return a->packet.dts_usec < b->packet.dts_usec;
+	if (a->packet.type != b->packet.type)
+		return a->packet.type == OBS_ENCODER_VIDEO;
+	if (a->packet.type == OBS_ENCODER_VIDEO && a->packet.track_idx != b->packet.track_idx)
+		return a->packet.track_idx < b->packet.track_idx;
+	return a->seq < b->seq;
+}
+
+static inline size_t interleave_track_slot(enum obs_encoder_type type, size_t track_idx)
+{
+	return type == OBS_ENCODER_VIDEO ? track_idx : MAX_OUTPUT_VIDEO_ENCODERS + track_idx;
+}
+
+static inline size_t interleave_track_size(const struct interleave_track *track)
+{
+	return track->packets.num - track->head;
+}
+
+static inline struct interleaved_packet *interleave_track_get(struct interleave_track *track, size_t idx)
+{
+	return idx < interleave_track_size(track) ? &track->packets.array[track->head + idx] : NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static inline bool packet_interleaver_track_before(struct packet_interleaver *il, size_t a, size_t b)
+{
+	return interleaved_packet_before(interleave_track_get(&il->tracks[il->heap[a]], 0),
+					 interleave_track_get(&il->tracks[il->heap[b]], 0));
+}
+
+static inline void packet_interleaver_swap(struct packet_interleaver *il, size_t a, size_t b)
+{
+	uint8_t slot = il->heap[a];
+	il->heap[a] = il->heap[b];
+	il->heap[b] = slot;
+}
+
+static inline void packet_interleaver_sift_up(struct packet_interleaver *il, size_t idx)
+{
+	while (idx) {
+		size_t parent = (idx - 1) / 2;
+		if (!packet_interleaver_track_before(il, idx, parent))
+			break;
+
+		packet_interleaver_swap(il, idx, parent);
+		idx = parent;
+	}
+}
+
+static inline void packet_interleaver_sift_down(struct packet_interleaver *il, size_t idx)
+{
+	for (;;) {
+		size_t left = idx * 2 + 1;
+		size_t right = left + 1;
+		size_t min = idx;
+
+		if (left < il->heap_size && packet_interleaver_track_before(il, left, min))
+			min = left;
+		if (right < il->heap_size && packet_interleaver_track_before(il, right, min))
+			min = right;
+		if (min == idx)
+			break;
+
+		packet_interleaver_swap(il, idx, min);
+		idx = min;
+	}
+}
+
+static inline void packet_interleaver_rebuild_heap(struct packet_interleaver *il)
+{
+	il->heap_size = 0;
+	for (size_t i = 0; i < INTERLEAVE_MAX_TRACKS; i++) {
+		if (interleave_track_size(&il->tracks[i]))
+			il->heap[il->heap_size++] = (uint8_t)i;
+	}
+
+	for (size_t i = il->heap_size / 2; i > 0; i--)
+		packet_interleaver_sift_down(il, i - 1);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* frees the queue storage, packets have to be released by the caller first */
+static inline void packet_interleaver_free(struct packet_interleaver *il)
+{
+	for (size_t i = 0; i < INTERLEAVE_MAX_TRACKS; i++)
+		da_free(il->tracks[i].packets);
+
+	memset(il, 0, sizeof(*il));
+}
+
+static inline size_t packet_interleaver_track_size(struct packet_interleaver *il, enum obs_encoder_type type,
+						   size_t track_idx)
+{
+	return interleave_track_size(&il->tracks[interleave_track_slot(type, track_idx)]);
+}
+
+static inline struct interleaved_packet *packet_interleaver_track_get(struct packet_interleaver *il,
+								      enum obs_encoder_type type, size_t track_idx,
+								      size_t idx)
+{
+	return interleave_track_get(&il->tracks[interleave_track_slot(type, track_idx)], idx);
+}
+
+static inline struct interleaved_packet *packet_interleaver_first(struct packet_interleaver *il,
+								  enum obs_encoder_type type, size_t track_idx)
+{
+	return packet_interleaver_track_get(il, type, track_idx, 0);
+}
+
+static inline struct interleaved_packet *packet_interleaver_last(struct packet_interleaver *il,
+								 enum obs_encoder_type type, size_t track_idx)
+{
+	size_t size = packet_interleaver_track_size(il, type, track_idx);
+	return size ? packet_interleaver_track_get(il, type, track_idx, size - 1) : NULL;
+}
+
+static inline void packet_interleaver_push(struct packet_interleaver *il, const struct encoder_packet *packet)
+{
+	size_t slot = interleave_track_slot(packet->type, packet->track_idx);
+	struct interleave_track *track = &il->tracks[slot];
+	struct interleaved_packet *entry;
+	size_t idx = track->packets.num;
+	bool was_empty = !interleave_track_size(track);
+
+	entry = da_push_back_new(track->packets);
+	entry->packet = *packet;
+	entry->seq = il->next_seq++;
+	il->num_packets++;
+
+	if (was_empty) {
+		il->heap[il->heap_size] = (uint8_t)slot;
+		packet_interleaver_sift_up(il, il->heap_size++);
+		return;
+	}
+
+	/* encoders output packets in DTS order, so this is normally already
+	 * the right place, but keep the track sorted if that doesn't hold */
+	while (idx > track->head &&
+	       interleaved_packet_before(&track->packets.array[idx], &track->packets.array[idx - 1])) {
+		struct interleaved_packet tmp = track->packets.array[idx];
+		track->packets.array[idx] = track->packets.array[idx - 1];
+		track->packets.array[idx - 1] = tmp;
+		idx--;
+	}
+
+	if (idx == track->head)
+		packet_interleaver_rebuild_heap(il);
+}
+
+/* returns the next packet in interleaved order */
+static inline struct interleaved_packet *packet_interleaver_peek(struct packet_interleaver *il)
+{
+	return il->heap_size ? interleave_track_get(&il->tracks[il->heap[0]], 0) : NULL;
+}
+
+static inline bool packet_interleaver_pop(struct packet_interleaver *il, struct encoder_packet *packet)
+{
+	if (!il->heap_size)
+		return false;
+
+	struct interleave_track *track = &il->tracks[il->heap[0]];
+	*packet = track->packets.array[track->head++].packet;
+	il->num_packets--;
+
+	if (track->head == track->packets.num) {
+		track->packets.num = 0;
+		track->head = 0;
+
+		il->heap[0] = il->heap[--il->heap_size];
+	} else if (track->head >= 64 && track->head * 2 >= track->packets.num) {
+		da_erase_range(track->packets, 0, track->head);
+		track->head = 0;
+	}
+
+	packet_interleaver_sift_down(il, 0);
+	return true;
+}
+
+/* returns the number of packets that come before limit in interleaved order */
+static inline size_t packet_interleaver_count_before(struct packet_interleaver *il,
+						     const struct interleaved_packet *limit)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < il->heap_size; i++) {
+		struct interleave_track *track = &il->tracks[il->heap[i]];
+		size_t low = 0;
+		size_t high = interleave_track_size(track);
+
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (interleaved_packet_before(interleave_track_get(track, mid), limit))
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		count += low;
+	}
+
+	return count;
+}
+
+#ifdef __cplusplus
+}
+#endif
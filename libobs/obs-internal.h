@@ -38,6 +38,7 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleave.h"
 
 #include <obsversion.h>
 #include <caption/caption.h>
@@ -247,6 +248,17 @@ bool obs_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys);
 void obs_hotkeys_platform_free(struct obs_core_hotkeys *hotkeys);
 bool obs_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *context, obs_key_t key);
 
+/* Event-driven backends set obs_core_hotkeys::event_driven on init.  The
+ * hotkey thread then calls obs_hotkeys_platform_wait_events, which blocks
+ * until key events have been passed to obs_hotkeys_key_event or until
+ * obs_hotkeys_platform_wake is called, instead of polling
+ * obs_hotkeys_platform_is_pressed.  Returns false if the platform can't
+ * deliver key events anymore, in which case the thread falls back to
+ * polling. */
+bool obs_hotkeys_platform_wait_events(obs_hotkeys_platform_t *context);
+void obs_hotkeys_platform_wake(obs_hotkeys_platform_t *context);
+void obs_hotkeys_key_event(obs_key_t key, bool pressed);
+
 const char *obs_get_hotkey_translation(obs_key_t key, const char *def);
 
 struct obs_context_data;
@@ -464,6 +476,51 @@ struct obs_core_audio {
 };
 
 /* user sources, output channels, and displays */
+struct obs_cached_image;
+
+struct obs_image_cache {
+	pthread_mutex_t mutex;
+	struct obs_cached_image *images; /* uthash, by key */
+
+	/* unreferenced images, least recently used first */
+	struct obs_cached_image *first_unused;
+	struct obs_cached_image *last_unused;
+
+	uint64_t size;
+	uint64_t limit;
+	size_t num_unused;
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
+extern bool obs_image_cache_init(struct obs_image_cache *cache);
+extern void obs_image_cache_free(struct obs_image_cache *cache);
+
+struct obs_source_tick {
+	obs_source_t *source;
+	uint64_t time;
+	bool ticked;
+};
+
+/* worker threads for sources with OBS_SOURCE_THREADSAFE_TICK */
+struct obs_tick_pool {
+	bool initialized;
+	pthread_t *threads;
+	size_t num_threads;
+	os_sem_t *start_sem;
+	os_event_t *done_event;
+	volatile bool exit;
+
+	DARRAY(struct obs_source_tick *) jobs;
+	float seconds;
+	bool profiling;
+	volatile long next;
+	volatile long pending;
+};
+
+extern void obs_tick_pool_free(struct obs_tick_pool *pool);
+
 struct obs_core_data {
 	/* Hash tables (uthash) */
 	struct obs_source *sources;        /* Lookup by UUID (hh_uuid) */
@@ -501,7 +558,11 @@ struct obs_core_data {
 	volatile bool valid;
 
 	DARRAY(char *) protocols;
-	DARRAY(obs_source_t *) sources_to_tick;
+	DARRAY(struct obs_source_tick) sources_to_tick;
+	DARRAY(struct obs_source_tick *) serial_ticks;
+	struct obs_tick_pool tick_pool;
+
+	struct obs_image_cache image_cache;
 };
 
 /* user hotkeys */
@@ -520,6 +581,12 @@ struct obs_core_hotkeys {
 	bool reroute_hotkeys;
 	DARRAY(obs_hotkey_binding_t) bindings;
 
+	/* event-driven backends only */
+	bool event_driven;
+	bool key_state[OBS_KEY_LAST_VALUE];
+	DARRAY(size_t) key_index; /* binding indices, sorted by key */
+	bool key_index_dirty;
+
 	obs_hotkey_callback_router_func router_func;
 	void *router_func_data;
 
@@ -604,7 +671,7 @@ extern bool audio_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in
 extern struct obs_core_video_mix *get_mix_for_video(video_t *video);
 
 extern void start_raw_video(video_t *video, const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
-			    void (*callback)(void *param, struct video_data *frame), void *param);
+			    uint32_t queue_size, void (*callback)(void *param, struct video_data *frame), void *param);
 extern void stop_raw_video(video_t *video, void (*callback)(void *param, struct video_data *frame), void *param);
 
 /* ------------------------------------------------------------------------- */
@@ -1120,7 +1187,8 @@ static inline enum gs_color_space convert_video_space(enum video_format format,
 extern void obs_source_set_texcoords_centered(obs_source_t *source, bool centered);
 extern void obs_source_activate(obs_source_t *source, enum view_type type);
 extern void obs_source_deactivate(obs_source_t *source, enum view_type type);
-extern void obs_source_video_tick(obs_source_t *source, float seconds);
+extern bool obs_source_video_tick_begin(obs_source_t *source, float seconds);
+extern void obs_source_video_tick_end(obs_source_t *source);
 extern float obs_source_get_target_volume(obs_source_t *source, obs_source_t *target);
 extern uint64_t obs_source_get_last_async_ts(const obs_source_t *source);
 
@@ -1159,6 +1227,11 @@ struct delay_data {
 	struct encoder_packet_time packet_time;
 };
 
+struct delivery_packet {
+	struct encoder_packet packet;
+	uint64_t ts;
+};
+
 typedef void (*encoded_callback_t)(void *data, struct encoder_packet *packet, struct encoder_packet_time *frame_time);
 
 struct obs_weak_output {
@@ -1227,7 +1300,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct packet_interleaver interleaver;
 	size_t interleaver_max_batch_size;
 	int stop_code;
 
@@ -1298,6 +1371,23 @@ struct obs_output {
 	volatile bool delay_active;
 	volatile bool delay_capturing;
 
+	size_t delivery_max_packets;
+	size_t delivery_cur_max_packets;
+	enum obs_output_delivery_overflow delivery_overflow;
+	enum obs_output_delivery_overflow delivery_cur_overflow;
+	bool delivery_active;
+	pthread_t delivery_thread;
+	struct deque delivery_queue; /* struct delivery_packet */
+	pthread_mutex_t delivery_mutex;
+	os_sem_t *delivery_sem;
+	os_event_t *delivery_space_event;
+	volatile bool delivery_stopping;
+	volatile bool delivery_failed;
+	bool delivery_wait_keyframe[MAX_OUTPUT_VIDEO_ENCODERS];
+	struct obs_output_delivery_stats delivery_stats;
+	uint64_t delivery_total_latency_ns;
+	volatile long delivery_dropped_frames;
+
 	char *last_error_message;
 
 	float audio_data[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES];
@@ -1315,8 +1405,12 @@ extern void process_delay(void *data, struct encoder_packet *packet, struct enco
 extern void obs_output_cleanup_delay(obs_output_t *output);
 extern bool obs_output_delay_start(obs_output_t *output);
 extern void obs_output_delay_stop(obs_output_t *output);
+extern bool obs_output_delivery_start(obs_output_t *output);
+extern void obs_output_delivery_stop(obs_output_t *output);
+extern void obs_output_deliver_packet(obs_output_t *output, struct encoder_packet *packet);
 extern bool obs_output_actual_start(obs_output_t *output);
 extern void obs_output_actual_stop(obs_output_t *output, bool force, uint64_t ts);
+extern void obs_output_error_stop(obs_output_t *output, int code, const char *message);
 
 extern const struct obs_output_info *find_output(const char *id);
 
@@ -1406,6 +1500,10 @@ struct obs_encoder {
 	uint32_t frame_rate_divisor_counter; // only used for GPU encoders
 	video_t *fps_override;
 
+	/* if non-zero, raw frames are passed to the encoder on its own thread
+	 * through a queue of this many frames */
+	uint32_t video_queue_size;
+
 	// Number of frames successfully encoded
 	uint32_t encoded_frames;
 
@@ -1446,6 +1544,13 @@ struct obs_encoder {
 
 	DARRAY(struct encoder_packet_time) encoder_packet_times;
 
+	/* packet data handed out by obs_encoder_alloc_packet_data during the
+	 * current encode call, and the data of the packet currently being sent
+	 * that outputs can reference instead of copying.  only used on the
+	 * encoding thread. */
+	uint8_t *packet_data;
+	uint8_t *shared_packet_data;
+
 	struct pause_data pause;
 
 	const char *profile_encoder_encode_name;
@@ -1523,8 +1628,9 @@ extern void source_profiler_async_frame_received(obs_source_t *source);
 
 /* Get timestamp for start of tick */
 extern uint64_t source_profiler_source_tick_start(void);
-/* Submit start timestamp for source */
-extern void source_profiler_source_tick_end(obs_source_t *source, uint64_t start);
+/* Submit total time spent ticking source this frame, must be called once per
+ * frame from the graphics thread */
+extern void source_profiler_source_tick_time(obs_source_t *source, uint64_t delta);
 
 /* Obtain GPU timer and start timestamp for render start of a source. */
 extern uint64_t source_profiler_source_render_begin(gs_timer_t **timer);
@@ -24,6 +24,10 @@
 #include <xcb/xcb.h>
 #if defined(XCB_XINPUT_FOUND)
 #include <xcb/xinput.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #endif
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -96,6 +100,12 @@ struct obs_hotkeys_platform {
 	bool pressed[XINPUT_MOUSE_LEN];
 	bool update[XINPUT_MOUSE_LEN];
 	bool button_pressed[XINPUT_MOUSE_LEN];
+
+	/* raw key events, used instead of polling when available */
+	bool key_events;
+	int wake_fds[2];
+	obs_key_t code_to_key[256];
+	uint8_t codes_down[256 / 8];
 #endif
 };
 
@@ -838,6 +848,79 @@ static inline void registerMouseEvents(struct obs_core_hotkeys *hotkeys)
 	xcb_input_xi_select_events(connection, window, 1, &mask.head);
 	xcb_flush(connection);
 }
+
+static bool open_wake_pipe(obs_hotkeys_platform_t *context)
+{
+	if (pipe(context->wake_fds) != 0)
+		return false;
+
+	for (size_t i = 0; i < 2; i++) {
+		fcntl(context->wake_fds[i], F_SETFD, FD_CLOEXEC);
+		fcntl(context->wake_fds[i], F_SETFL, O_NONBLOCK);
+	}
+
+	return true;
+}
+
+static inline void map_keycode(obs_hotkeys_platform_t *context, xcb_keycode_t code, obs_key_t key)
+{
+	if (code && context->code_to_key[code] == OBS_KEY_NONE)
+		context->code_to_key[code] = key;
+}
+
+/* Selects raw key events in addition to raw button events, so that hotkeys
+ * can be dispatched as keys change state rather than by polling the keymap */
+static bool register_key_events(struct obs_core_hotkeys *hotkeys)
+{
+	obs_hotkeys_platform_t *context = hotkeys->platform_context;
+	xcb_connection_t *connection = XGetXCBConnection(context->display);
+	xcb_window_t window = root_window(context, connection);
+	xcb_input_xi_query_version_cookie_t cookie;
+	xcb_input_xi_query_version_reply_t *reply;
+	xcb_generic_error_t *error = NULL;
+	bool xi2;
+
+	cookie = xcb_input_xi_query_version(connection, 2, 2);
+	reply = xcb_input_xi_query_version_reply(connection, cookie, &error);
+	xi2 = !error && reply && reply->major_version >= 2;
+	free(reply);
+	free(error);
+
+	if (!xi2) {
+		blog(LOG_INFO, "XInput 2 is not available, hotkeys will be polled");
+		return false;
+	}
+
+	if (!open_wake_pipe(context)) {
+		blog(LOG_WARNING, "Failed to create hotkey wake pipe, hotkeys will be polled");
+		return false;
+	}
+
+	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++) {
+		struct keycode_list *codes = &context->keycodes[i];
+
+		for (size_t j = 0; j < codes->list.num; j++)
+			map_keycode(context, codes->list.array[j], (obs_key_t)i);
+	}
+
+	map_keycode(context, context->super_l_code, OBS_KEY_META);
+	map_keycode(context, context->super_r_code, OBS_KEY_META);
+
+	struct {
+		xcb_input_event_mask_t head;
+		xcb_input_xi_event_mask_t mask;
+	} mask;
+	mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
+	mask.head.mask_len = sizeof(mask.mask) / sizeof(uint32_t);
+	mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_KEY_PRESS | XCB_INPUT_XI_EVENT_MASK_RAW_KEY_RELEASE |
+		    XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_PRESS | XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_RELEASE;
+
+	xcb_input_xi_select_events(connection, window, 1, &mask.head);
+	xcb_flush(connection);
+
+	context->key_events = true;
+	return true;
+}
 #endif
 
 static bool obs_nix_x11_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys)
@@ -850,11 +933,14 @@ static bool obs_nix_x11_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys)
 	hotkeys->platform_context = bzalloc(sizeof(obs_hotkeys_platform_t));
 	hotkeys->platform_context->display = display;
 
-#if defined(XCB_XINPUT_FOUND)
-	registerMouseEvents(hotkeys);
-#endif
 	fill_base_keysyms(hotkeys);
 	fill_keycodes(hotkeys);
+#if defined(XCB_XINPUT_FOUND)
+	if (register_key_events(hotkeys))
+		hotkeys->event_driven = true;
+	else
+		registerMouseEvents(hotkeys);
+#endif
 	return true;
 }
 
@@ -868,6 +954,12 @@ static void obs_nix_x11_hotkeys_platform_free(struct obs_core_hotkeys *hotkeys)
 		da_free(context->keycodes[i].list);
 
 	bfree(context->keysyms);
+#if defined(XCB_XINPUT_FOUND)
+	if (context->key_events) {
+		close(context->wake_fds[0]);
+		close(context->wake_fds[1]);
+	}
+#endif
 	XCloseDisplay(context->display);
 	bfree(context);
 
@@ -1088,6 +1180,135 @@ static bool obs_nix_x11_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *cont
 	}
 }
 
+#if defined(XCB_XINPUT_FOUND)
+static inline bool keycode_down(obs_hotkeys_platform_t *context, xcb_keycode_t code)
+{
+	return code && (context->codes_down[code / 8] & (1 << (code % 8))) != 0;
+}
+
+/* several keycodes can map to the same key, e.g. left and right shift */
+static bool any_keycode_down(obs_hotkeys_platform_t *context, obs_key_t key)
+{
+	struct keycode_list *codes = &context->keycodes[key];
+
+	if (key == OBS_KEY_META)
+		return keycode_down(context, context->super_l_code) || keycode_down(context, context->super_r_code);
+
+	for (size_t i = 0; i < codes->list.num; i++) {
+		if (keycode_down(context, codes->list.array[i]))
+			return true;
+	}
+
+	return false;
+}
+
+static void handle_raw_key(obs_hotkeys_platform_t *context, uint32_t detail, bool pressed)
+{
+	if (detail >= 256)
+		return;
+
+	xcb_keycode_t code = (xcb_keycode_t)detail;
+	obs_key_t key = context->code_to_key[code];
+	if (key == OBS_KEY_NONE)
+		return;
+
+	if (pressed)
+		context->codes_down[code / 8] |= (uint8_t)(1 << (code % 8));
+	else
+		context->codes_down[code / 8] &= (uint8_t)~(1 << (code % 8));
+
+	obs_hotkeys_key_event(key, any_keycode_down(context, key));
+}
+
+static void handle_raw_button(uint32_t detail, bool pressed)
+{
+	obs_key_t key = OBS_KEY_NONE;
+
+	// Mouse 2 for OBS is Right Click and Mouse 3 is Wheel Click.
+	// Mouse Wheel axis clicks (xinput detail 4 5 6 7) are ignored.
+	if (detail == 1)
+		key = OBS_KEY_MOUSE1;
+	else if (detail == 2)
+		key = OBS_KEY_MOUSE3;
+	else if (detail == 3)
+		key = OBS_KEY_MOUSE2;
+	else if (detail >= 8 && detail - 8 <= (uint32_t)(OBS_KEY_MOUSE29 - OBS_KEY_MOUSE4))
+		key = (obs_key_t)(OBS_KEY_MOUSE4 + (detail - 8));
+
+	if (key != OBS_KEY_NONE)
+		obs_hotkeys_key_event(key, pressed);
+}
+
+static void handle_input_event(obs_hotkeys_platform_t *context, xcb_generic_event_t *ev)
+{
+	if ((ev->response_type & ~0x80) != XCB_GE_GENERIC)
+		return;
+
+	switch (((xcb_ge_event_t *)ev)->event_type) {
+	case XCB_INPUT_RAW_KEY_PRESS:
+		handle_raw_key(context, ((xcb_input_raw_key_press_event_t *)ev)->detail, true);
+		break;
+	case XCB_INPUT_RAW_KEY_RELEASE:
+		handle_raw_key(context, ((xcb_input_raw_key_release_event_t *)ev)->detail, false);
+		break;
+	case XCB_INPUT_RAW_BUTTON_PRESS:
+		handle_raw_button(((xcb_input_raw_button_press_event_t *)ev)->detail, true);
+		break;
+	case XCB_INPUT_RAW_BUTTON_RELEASE:
+		handle_raw_button(((xcb_input_raw_button_release_event_t *)ev)->detail, false);
+		break;
+	default:
+		break;
+	}
+}
+
+static bool obs_nix_x11_hotkeys_platform_wait_events(obs_hotkeys_platform_t *context)
+{
+	xcb_connection_t *connection = XGetXCBConnection(context->display);
+	xcb_generic_event_t *ev;
+
+	if (!context->key_events)
+		return false;
+
+	while ((ev = xcb_poll_for_event(connection))) {
+		handle_input_event(context, ev);
+		free(ev);
+	}
+
+	if (xcb_connection_has_error(connection)) {
+		blog(LOG_WARNING, "X connection of the hotkey thread was lost");
+		return false;
+	}
+
+	struct pollfd fds[2] = {
+		{.fd = xcb_get_file_descriptor(connection), .events = POLLIN},
+		{.fd = context->wake_fds[0], .events = POLLIN},
+	};
+
+	if (poll(fds, 2, -1) == -1 && errno != EINTR) {
+		blog(LOG_WARNING, "Failed to wait for hotkey events, errno %d", errno);
+		return false;
+	}
+
+	if (fds[1].revents & POLLIN) {
+		char buf[16];
+		while (read(context->wake_fds[0], buf, sizeof(buf)) > 0)
+			;
+	}
+
+	return true;
+}
+
+static void obs_nix_x11_hotkeys_platform_wake(obs_hotkeys_platform_t *context)
+{
+	if (!context->key_events)
+		return;
+
+	if (write(context->wake_fds[1], "", 1) != 1)
+		blog(LOG_DEBUG, "Failed to wake hotkey thread, errno %d", errno);
+}
+#endif
+
 static bool get_key_translation(struct dstr *dstr, xcb_keycode_t keycode)
 {
 	xcb_connection_t *connection;
@@ -1272,6 +1493,10 @@ static const struct obs_nix_hotkeys_vtable x11_hotkeys_vtable = {
 	.key_to_str = obs_nix_x11_key_to_str,
 	.key_from_virtual_key = obs_nix_x11_key_from_virtual_key,
 	.key_to_virtual_key = obs_nix_x11_key_to_virtual_key,
+#if defined(XCB_XINPUT_FOUND)
+	.wait_events = obs_nix_x11_hotkeys_platform_wait_events,
+	.wake = obs_nix_x11_hotkeys_platform_wake,
+#endif
 };
 
 const struct obs_nix_hotkeys_vtable *obs_nix_x11_get_hotkeys_vtable(void)
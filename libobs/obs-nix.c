@@ -448,6 +448,20 @@ bool obs_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *context, obs_key_t
 	return hotkeys_vtable->is_pressed(context, key);
 }
 
+bool obs_hotkeys_platform_wait_events(obs_hotkeys_platform_t *context)
+{
+	if (!hotkeys_vtable->wait_events)
+		return false;
+
+	return hotkeys_vtable->wait_events(context);
+}
+
+void obs_hotkeys_platform_wake(obs_hotkeys_platform_t *context)
+{
+	if (hotkeys_vtable->wake)
+		hotkeys_vtable->wake(context);
+}
+
 void obs_key_to_str(obs_key_t key, struct dstr *dstr)
 {
 	return hotkeys_vtable->key_to_str(key, dstr);
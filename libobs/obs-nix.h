@@ -35,6 +35,11 @@ struct obs_nix_hotkeys_vtable {
 	obs_key_t (*key_from_virtual_key)(int sym);
 
 	int (*key_to_virtual_key)(obs_key_t key);
+
+	/* optional, for backends that can deliver key events */
+	bool (*wait_events)(obs_hotkeys_platform_t *context);
+
+	void (*wake)(obs_hotkeys_platform_t *context);
 };
 
 #ifdef __cplusplus
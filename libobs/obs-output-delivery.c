@@ -0,0 +1,306 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <inttypes.h>
+#include "obs-internal.h"
+
+/* with OBS_OUTPUT_DELIVERY_DROP_NON_KEY, audio and keyframes can still be
+ * queued past the limit, up to this factor */
+#define DROP_NON_KEY_HARD_LIMIT 2
+
+static inline size_t num_queued(const struct obs_output *output)
+{
+	return output->delivery_queue.size / sizeof(struct delivery_packet);
+}
+
+/* dropped video packets are added to obs_output_get_frames_dropped, the
+ * output itself never sees them */
+static inline void count_dropped_frame(struct obs_output *output, const struct encoder_packet *packet)
+{
+	if (packet->type == OBS_ENCODER_VIDEO)
+		os_atomic_inc_long(&output->delivery_dropped_frames);
+}
+
+static inline void drop_packet(struct obs_output *output, struct encoder_packet *packet)
+{
+	count_dropped_frame(output, packet);
+	obs_encoder_packet_release(packet);
+
+	pthread_mutex_lock(&output->delivery_mutex);
+	output->delivery_stats.dropped++;
+	pthread_mutex_unlock(&output->delivery_mutex);
+}
+
+static inline void update_stats(struct obs_output *output, uint64_t latency)
+{
+	struct obs_output_delivery_stats *stats = &output->delivery_stats;
+
+	stats->delivered++;
+	output->delivery_total_latency_ns += latency;
+	if (latency > stats->max_latency_ns)
+		stats->max_latency_ns = latency;
+}
+
+static void *delivery_thread(void *data)
+{
+	struct obs_output *output = data;
+	bool signaled_error = false;
+
+	os_set_thread_name("libobs: output delivery thread");
+
+	/* the stop flag is checked again after delivering, because the
+	 * output may have stopped itself from within encoded_packet */
+	while (!os_atomic_load_bool(&output->delivery_stopping)) {
+		struct delivery_packet dp;
+		bool popped = false;
+
+		os_sem_wait(output->delivery_sem);
+		if (os_atomic_load_bool(&output->delivery_stopping))
+			break;
+
+		bool failed = os_atomic_load_bool(&output->delivery_failed);
+
+		pthread_mutex_lock(&output->delivery_mutex);
+		if (output->delivery_queue.size) {
+			deque_pop_front(&output->delivery_queue, &dp, sizeof(dp));
+			if (failed) {
+				output->delivery_stats.dropped++;
+				count_dropped_frame(output, &dp.packet);
+			} else
+				update_stats(output, os_gettime_ns() - dp.ts);
+			popped = true;
+		}
+		pthread_mutex_unlock(&output->delivery_mutex);
+
+		if (popped) {
+			os_event_signal(output->delivery_space_event);
+
+			if (!failed)
+				output->info.encoded_packet(output->context.data, &dp.packet);
+			obs_encoder_packet_release(&dp.packet);
+		}
+
+		/* stop the output from this thread rather than the encoder
+		 * thread.  the output's stop callback has to be called so it
+		 * closes its connection or finalizes its file, and stopping it
+		 * ends data capture on another thread, which then joins this
+		 * one once it gets back to the top of the loop. */
+		if (failed && !signaled_error) {
+			signaled_error = true;
+
+			blog(LOG_ERROR, "Output '%s': Delivery queue full, stopping output", output->context.name);
+			obs_output_error_stop(output, OBS_OUTPUT_ERROR,
+					      "The output could not keep up with the encoders.");
+
+			/* as with any forced stop, an output may only finish
+			 * stopping once it receives another packet (ffmpeg-mux
+			 * finalizes its file that way), so resume delivering */
+			os_atomic_set_bool(&output->delivery_failed, false);
+		}
+	}
+
+	return NULL;
+}
+
+static void free_delivery_queue(struct obs_output *output)
+{
+	struct delivery_packet dp;
+
+	pthread_mutex_lock(&output->delivery_mutex);
+	while (output->delivery_queue.size) {
+		deque_pop_front(&output->delivery_queue, &dp, sizeof(dp));
+		obs_encoder_packet_release(&dp.packet);
+	}
+
+	pthread_mutex_unlock(&output->delivery_mutex);
+
+	os_sem_destroy(output->delivery_sem);
+	os_event_destroy(output->delivery_space_event);
+	output->delivery_sem = NULL;
+	output->delivery_space_event = NULL;
+}
+
+bool obs_output_delivery_start(obs_output_t *output)
+{
+	output->delivery_active = false;
+
+	if (!output->delivery_max_packets)
+		return false;
+
+	output->delivery_cur_max_packets = output->delivery_max_packets;
+	output->delivery_cur_overflow = output->delivery_overflow;
+
+	if (os_sem_init(&output->delivery_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&output->delivery_space_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	pthread_mutex_lock(&output->delivery_mutex);
+	memset(&output->delivery_stats, 0, sizeof(output->delivery_stats));
+	output->delivery_total_latency_ns = 0;
+	pthread_mutex_unlock(&output->delivery_mutex);
+
+	memset(output->delivery_wait_keyframe, 0, sizeof(output->delivery_wait_keyframe));
+	os_atomic_set_long(&output->delivery_dropped_frames, 0);
+	os_atomic_set_bool(&output->delivery_stopping, false);
+	os_atomic_set_bool(&output->delivery_failed, false);
+
+	if (pthread_create(&output->delivery_thread, NULL, delivery_thread, output) != 0)
+		goto fail;
+
+	output->delivery_active = true;
+	blog(LOG_INFO, "Output '%s': Delivering packets from a separate thread (queue size: %zu)",
+	     output->context.name, output->delivery_cur_max_packets);
+	return true;
+
+fail:
+	blog(LOG_WARNING, "Output '%s': Failed to start delivery thread", output->context.name);
+	free_delivery_queue(output);
+	return false;
+}
+
+void obs_output_delivery_stop(obs_output_t *output)
+{
+	if (!output->delivery_active)
+		return;
+
+	os_atomic_set_bool(&output->delivery_stopping, true);
+	os_sem_post(output->delivery_sem);
+
+	/* the output can stop itself from within encoded_packet, in which
+	 * case this may end up being called on the delivery thread */
+	if (pthread_equal(pthread_self(), output->delivery_thread))
+		pthread_detach(output->delivery_thread);
+	else
+		pthread_join(output->delivery_thread, NULL);
+
+	output->delivery_active = false;
+
+	struct obs_output_delivery_stats *stats = &output->delivery_stats;
+	blog(LOG_INFO,
+	     "Output '%s': Delivery queue: %" PRIu64 " packets delivered, %" PRIu64 " dropped, "
+	     "peak depth %zu, average latency %" PRIu64 " us, max latency %" PRIu64 " us",
+	     output->context.name, stats->delivered, stats->dropped, stats->peak_queued,
+	     stats->delivered ? output->delivery_total_latency_ns / stats->delivered / 1000 : 0,
+	     stats->max_latency_ns / 1000);
+
+	free_delivery_queue(output);
+}
+
+/* video packets can't be dropped by themselves, once one is dropped the rest
+ * of the track has to be dropped up to the next keyframe */
+static inline bool waiting_for_keyframe(struct obs_output *output, struct encoder_packet *packet)
+{
+	if (packet->type != OBS_ENCODER_VIDEO || !output->delivery_wait_keyframe[packet->track_idx])
+		return false;
+
+	if (packet->keyframe) {
+		output->delivery_wait_keyframe[packet->track_idx] = false;
+		return false;
+	}
+
+	return true;
+}
+
+/* takes ownership of the packet */
+void obs_output_deliver_packet(obs_output_t *output, struct encoder_packet *packet)
+{
+	struct delivery_packet dp;
+
+	if (!output->delivery_active) {
+		output->info.encoded_packet(output->context.data, packet);
+		obs_encoder_packet_release(packet);
+		return;
+	}
+
+	if (os_atomic_load_bool(&output->delivery_failed) || waiting_for_keyframe(output, packet)) {
+		drop_packet(output, packet);
+		return;
+	}
+
+	dp.packet = *packet;
+	dp.ts = os_gettime_ns();
+
+	pthread_mutex_lock(&output->delivery_mutex);
+
+	while (num_queued(output) >= output->delivery_cur_max_packets) {
+		enum obs_output_delivery_overflow overflow = output->delivery_cur_overflow;
+
+		if (overflow == OBS_OUTPUT_DELIVERY_DROP_NON_KEY) {
+			bool droppable = packet->type == OBS_ENCODER_VIDEO && !packet->keyframe;
+
+			if (droppable) {
+				output->delivery_wait_keyframe[packet->track_idx] = true;
+				pthread_mutex_unlock(&output->delivery_mutex);
+				drop_packet(output, packet);
+				return;
+			}
+
+			if (num_queued(output) < output->delivery_cur_max_packets * DROP_NON_KEY_HARD_LIMIT)
+				break;
+
+		} else if (overflow == OBS_OUTPUT_DELIVERY_ERROR) {
+			os_atomic_set_bool(&output->delivery_failed, true);
+			pthread_mutex_unlock(&output->delivery_mutex);
+			drop_packet(output, packet);
+			os_sem_post(output->delivery_sem);
+			return;
+		}
+
+		pthread_mutex_unlock(&output->delivery_mutex);
+		os_event_wait(output->delivery_space_event);
+		pthread_mutex_lock(&output->delivery_mutex);
+	}
+
+	deque_push_back(&output->delivery_queue, &dp, sizeof(dp));
+
+	size_t queued = num_queued(output);
+	if (queued > output->delivery_stats.peak_queued)
+		output->delivery_stats.peak_queued = queued;
+
+	pthread_mutex_unlock(&output->delivery_mutex);
+
+	os_sem_post(output->delivery_sem);
+}
+
+void obs_output_set_delivery_queue(obs_output_t *output, size_t max_packets,
+				   enum obs_output_delivery_overflow overflow)
+{
+	if (!obs_output_valid(output, "obs_output_set_delivery_queue"))
+		return;
+
+	output->delivery_max_packets = max_packets;
+	output->delivery_overflow = overflow;
+}
+
+bool obs_output_get_delivery_stats(const obs_output_t *output, struct obs_output_delivery_stats *stats)
+{
+	struct obs_output *out = (struct obs_output *)output;
+
+	if (!obs_output_valid(output, "obs_output_get_delivery_stats") || !stats)
+		return false;
+	if (!output->delivery_max_packets)
+		return false;
+
+	pthread_mutex_lock(&out->delivery_mutex);
+	*stats = out->delivery_stats;
+	stats->queued = num_queued(out);
+	stats->avg_latency_ns = stats->delivered ? out->delivery_total_latency_ns / stats->delivered : 0;
+	pthread_mutex_unlock(&out->delivery_mutex);
+
+	return true;
+}
@@ -202,6 +202,7 @@ obs_output_t *obs_output_create(const char *id, const char *name, obs_data_t *se
 	output = bzalloc(sizeof(struct obs_output));
 	pthread_mutex_init_value(&output->interleaved_mutex);
 	pthread_mutex_init_value(&output->delay_mutex);
+	pthread_mutex_init_value(&output->delivery_mutex);
 	pthread_mutex_init_value(&output->pause.mutex);
 	pthread_mutex_init_value(&output->pkt_callbacks_mutex);
 
@@ -209,6 +210,8 @@ obs_output_t *obs_output_create(const char *id, const char *name, obs_data_t *se
 		goto fail;
 	if (pthread_mutex_init(&output->delay_mutex, NULL) != 0)
 		goto fail;
+	if (pthread_mutex_init(&output->delivery_mutex, NULL) != 0)
+		goto fail;
 	if (pthread_mutex_init(&output->pause.mutex, NULL) != 0)
 		goto fail;
 	if (pthread_mutex_init(&output->pkt_callbacks_mutex, NULL) != 0)
@@ -262,9 +265,11 @@ fail:
 
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array + i);
-	da_free(output->interleaved_packets);
+	struct encoder_packet packet;
+
+	while (packet_interleaver_pop(&output->interleaver, &packet))
+		obs_encoder_packet_release(&packet);
+	packet_interleaver_free(&output->interleaver);
 }
 
 static inline void clear_raw_audio_buffers(obs_output_t *output)
@@ -339,10 +344,12 @@ void obs_output_destroy(obs_output_t *output)
 		pthread_mutex_destroy(&output->pause.mutex);
 		pthread_mutex_destroy(&output->interleaved_mutex);
 		pthread_mutex_destroy(&output->delay_mutex);
+		pthread_mutex_destroy(&output->delivery_mutex);
 		pthread_mutex_destroy(&output->pkt_callbacks_mutex);
 		os_event_destroy(output->reconnect_stop_event);
 		obs_context_data_free(&output->context);
 		deque_free(&output->delay_data);
+		deque_free(&output->delivery_queue);
 		if (output->owns_info_id)
 			bfree((void *)output->info.id);
 		if (output->last_error_message)
@@ -560,6 +567,18 @@ void obs_output_force_stop(obs_output_t *output)
 	obs_output_actual_stop(output, true, 0);
 }
 
+/* forced stop on behalf of libobs itself, reporting an error to the stop
+ * signal instead of success */
+void obs_output_error_stop(obs_output_t *output, int code, const char *message)
+{
+	if (!stopping(output))
+		do_output_signal(output, "stopping");
+
+	obs_output_set_last_error(output, message);
+	output->stop_code = code;
+	obs_output_actual_stop(output, true, 0);
+}
+
 bool obs_output_active(const obs_output_t *output)
 {
 	return (output != NULL) ? (active(output) || reconnecting(output)) : false;
@@ -1190,10 +1209,14 @@ int obs_output_get_frames_dropped(const obs_output_t *output)
 {
 	if (!obs_output_valid(output, "obs_output_get_frames_dropped"))
 		return 0;
-	if (!output->info.get_dropped_frames)
-		return 0;
 
-	return output->info.get_dropped_frames(output->context.data);
+	/* video packets dropped by the delivery queue never reach the output */
+	int dropped = (int)os_atomic_load_long(&output->delivery_dropped_frames);
+
+	if (output->info.get_dropped_frames)
+		dropped += output->info.get_dropped_frames(output->context.data);
+
+	return dropped;
 }
 
 int obs_output_get_total_frames(const obs_output_t *output)
@@ -1680,11 +1703,12 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out;
 	struct encoder_packet_time ept_local = {0};
 	bool found_ept = false;
 
-	da_erase(output->interleaved_packets, 0);
+	if (!packet_interleaver_pop(&output->interleaver, &out))
+		return;
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1753,8 +1777,7 @@ static inline void send_interleaved(struct obs_output *output)
 	}
 	pthread_mutex_unlock(&output->pkt_callbacks_mutex);
 
-	output->info.encoded_packet(output->context.data, &out);
-	obs_encoder_packet_release(&out);
+	obs_output_deliver_packet(output, &out);
 }
 
 static inline void set_higher_ts(struct obs_output *output, struct encoder_packet *packet)
@@ -1769,51 +1792,75 @@ static inline void set_higher_ts(struct obs_output *output, struct encoder_packe
 }
 
 static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							    size_t audio_idx);
-static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t audio_idx);
+							    size_t idx)
+{
+	struct interleaved_packet *packet = packet_interleaver_first(&output->interleaver, type, idx);
+	return packet ? &packet->packet : NULL;
+}
+
+static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
+							   size_t idx)
+{
+	struct interleaved_packet *packet = packet_interleaver_last(&output->interleaver, type, idx);
+	return packet ? &packet->packet : NULL;
+}
 
 /* gets the point where audio and video are closest together */
-static size_t get_interleaved_start_idx(struct obs_output *output)
+static struct interleaved_packet get_interleaved_start(struct obs_output *output)
 {
+	struct packet_interleaver *il = &output->interleaver;
 	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
-	struct encoder_packet *first_video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
-	size_t video_idx = DARRAY_INVALID;
-	size_t idx = 0;
+	struct interleaved_packet *first_video = packet_interleaver_first(il, OBS_ENCODER_VIDEO, 0);
+	struct interleaved_packet *first_audio = NULL;
+	struct interleaved_packet *start = NULL;
 
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		int64_t diff;
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		size_t size = packet_interleaver_track_size(il, OBS_ENCODER_AUDIO, i);
 
-		if (packet->type != OBS_ENCODER_AUDIO) {
-			if (packet == first_video)
-				video_idx = i;
-			continue;
-		}
+		for (size_t j = 0; j < size; j++) {
+			struct interleaved_packet *packet = packet_interleaver_track_get(il, OBS_ENCODER_AUDIO, i, j);
+			int64_t diff = llabs(packet->packet.dts_usec - first_video->packet.dts_usec);
+
+			bool closer = diff < closest_diff ||
+				      (diff == closest_diff && start && interleaved_packet_before(packet, start));
 
-		diff = llabs(packet->dts_usec - first_video->dts_usec);
-		if (diff < closest_diff) {
-			closest_diff = diff;
-			idx = i;
+			if (closer) {
+				closest_diff = diff;
+				start = packet;
+			}
 		}
 	}
 
-	idx = video_idx < idx ? video_idx : idx;
+	if (!start)
+		return *packet_interleaver_peek(il);
+	if (interleaved_packet_before(first_video, start))
+		start = first_video;
 
 	/* Early AAC/Opus audio packets will be for "priming" the encoder and contain silence, but they should not be
-	 * discarded. Set the idx to the first audio packet if closest PTS was <= 0. */
-	size_t first_audio_idx = idx;
-	while (output->interleaved_packets.array[first_audio_idx].type != OBS_ENCODER_AUDIO)
-		first_audio_idx++;
+	 * discarded. Set the start to the first audio packet if closest PTS was <= 0. */
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		size_t size = packet_interleaver_track_size(il, OBS_ENCODER_AUDIO, i);
+
+		for (size_t j = 0; j < size; j++) {
+			struct interleaved_packet *packet = packet_interleaver_track_get(il, OBS_ENCODER_AUDIO, i, j);
+			if (interleaved_packet_before(packet, start))
+				continue;
 
-	if (output->interleaved_packets.array[first_audio_idx].pts <= 0) {
+			if (!first_audio || interleaved_packet_before(packet, first_audio))
+				first_audio = packet;
+			break;
+		}
+	}
+
+	if (first_audio->packet.pts <= 0) {
 		for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
-			int audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
-			if (audio_idx >= 0 && (size_t)audio_idx < idx)
-				idx = audio_idx;
+			struct interleaved_packet *audio = packet_interleaver_first(il, OBS_ENCODER_AUDIO, i);
+			if (audio && interleaved_packet_before(audio, start))
+				start = audio;
 		}
 	}
 
-	return idx;
+	return *start;
 }
 
 static int64_t get_encoder_duration(struct obs_encoder *encoder)
@@ -1821,44 +1868,44 @@ static int64_t get_encoder_duration(struct obs_encoder *encoder)
 	return (encoder->timebase_num * 1000000LL / encoder->timebase_den) * encoder->framesize;
 }
 
-static int prune_premature_packets(struct obs_output *output)
+/* returns 1 and the last packet to prune if the first video packet is too far
+ * away from audio, 0 if nothing needs to be pruned, and -1 if packets of a
+ * track are still missing */
+static int prune_premature_packets(struct obs_output *output, struct interleaved_packet *prune_to)
 {
-	struct encoder_packet *video;
-	int video_idx;
-	int max_idx;
+	struct packet_interleaver *il = &output->interleaver;
+	struct interleaved_packet *video;
+	struct interleaved_packet *last;
 	int64_t duration_usec, max_audio_duration_usec = 0;
 	int64_t max_diff = 0;
 	int64_t diff = 0;
 	int audio_encoders = 0;
 
-	video_idx = find_first_packet_type_idx(output, OBS_ENCODER_VIDEO, 0);
-	if (video_idx == -1)
+	video = packet_interleaver_first(il, OBS_ENCODER_VIDEO, 0);
+	if (!video)
 		return -1;
 
-	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
-	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
+	last = video;
+	duration_usec = video->packet.timebase_num * 1000000LL / video->packet.timebase_den;
 
 	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
-		struct encoder_packet *audio;
-		int audio_idx;
+		struct interleaved_packet *audio;
 		int64_t audio_duration_usec = 0;
 
 		if (!output->audio_encoders[i])
 			continue;
 		audio_encoders++;
 
-		audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
-		if (audio_idx == -1) {
+		audio = packet_interleaver_first(il, OBS_ENCODER_AUDIO, i);
+		if (!audio) {
 			output->received_audio = false;
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
-		if (audio_idx > max_idx)
-			max_idx = audio_idx;
+		if (interleaved_packet_before(last, audio))
+			last = audio;
 
-		diff = audio->dts_usec - video->dts_usec;
+		diff = audio->packet.dts_usec - video->packet.dts_usec;
 		if (diff > max_diff)
 			max_diff = diff;
 
@@ -1877,93 +1924,80 @@ static int prune_premature_packets(struct obs_output *output)
 		duration_usec = max_audio_duration_usec;
 	}
 
-	return diff > duration_usec ? max_idx + 1 : 0;
+	if (diff <= duration_usec)
+		return 0;
+
+	*prune_to = *last;
+	return 1;
 }
 
 #define DEBUG_STARTING_PACKETS 0
 
-static void discard_to_idx(struct obs_output *output, size_t idx)
+static void discard_next_packet(struct obs_output *output)
 {
-	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-#if DEBUG_STARTING_PACKETS == 1
-		blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
-		     packet->type == OBS_ENCODER_VIDEO ? "video" : "audio", packet->dts, packet->pts);
-#endif
-		if (packet->type == OBS_ENCODER_VIDEO) {
-			da_pop_front(output->encoder_packet_times[packet->track_idx]);
-		}
-		obs_encoder_packet_release(packet);
-	}
-
-	da_erase_range(output->interleaved_packets, 0, idx);
-}
+	struct encoder_packet packet;
 
-static bool prune_interleaved_packets(struct obs_output *output)
-{
-	size_t start_idx = 0;
-	int prune_start = prune_premature_packets(output);
+	if (!packet_interleaver_pop(&output->interleaver, &packet))
+		return;
 
 #if DEBUG_STARTING_PACKETS == 1
-	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
-		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)packet->track_idx, packet->dts_usec,
-		     (int)i < prune_start ? "true" : "false");
-	}
+	blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
+	     packet.type == OBS_ENCODER_VIDEO ? "video" : "audio", packet.dts, packet.pts);
 #endif
-
-	/* prunes the first video packet if it's too far away from audio */
-	if (prune_start == -1)
-		return false;
-	else if (prune_start != 0)
-		start_idx = (size_t)prune_start;
-	else
-		start_idx = get_interleaved_start_idx(output);
-
-	if (start_idx)
-		discard_to_idx(output, start_idx);
-
-	return true;
+	if (packet.type == OBS_ENCODER_VIDEO) {
+		da_pop_front(output->encoder_packet_times[packet.track_idx]);
+	}
+	obs_encoder_packet_release(&packet);
 }
 
-static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
+/* discards all packets that come before limit, and limit itself if inclusive */
+static size_t discard_to_packet(struct obs_output *output, const struct interleaved_packet *limit, bool inclusive)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	struct interleaved_packet *next;
+	size_t count = 0;
+
+	while ((next = packet_interleaver_peek(&output->interleaver)) != NULL) {
+		if (!interleaved_packet_before(next, limit) && !(inclusive && next->seq == limit->seq))
+			break;
 
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)i;
+		discard_next_packet(output);
+		count++;
 	}
 
-	return -1;
+	return count;
 }
 
-static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
+static bool prune_interleaved_packets(struct obs_output *output)
 {
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i - 1];
+	struct interleaved_packet start;
+	int prune = prune_premature_packets(output, &start);
 
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)(i - 1);
-	}
+#if DEBUG_STARTING_PACKETS == 1
+	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune);
+	for (size_t i = 0; i < INTERLEAVE_MAX_TRACKS; i++) {
+		struct interleave_track *track = &output->interleaver.tracks[i];
 
-	return -1;
-}
+		for (size_t j = 0; j < interleave_track_size(track); j++) {
+			struct interleaved_packet *packet = interleave_track_get(track, j);
+			blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
+			     packet->packet.type == OBS_ENCODER_AUDIO ? "audio" : "video",
+			     (int)packet->packet.track_idx, packet->packet.dts_usec,
+			     prune == 1 && !interleaved_packet_before(&start, packet) ? "true" : "false");
+		}
+	}
+#endif
 
-static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							    size_t audio_idx)
-{
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
-}
+	/* prunes the first video packet if it's too far away from audio */
+	if (prune == -1)
+		return false;
+	else if (prune == 1)
+		discard_to_packet(output, &start, true);
+	else {
+		start = get_interleaved_start(output);
+		discard_to_packet(output, &start, false);
+	}
 
-static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
-							   size_t audio_idx)
-{
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return true;
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output, struct encoder_packet **video,
@@ -2000,7 +2034,7 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	struct encoder_packet *video[MAX_OUTPUT_VIDEO_ENCODERS] = {0};
 	struct encoder_packet *audio[MAX_OUTPUT_AUDIO_ENCODERS] = {0};
 	struct encoder_packet *last_audio[MAX_OUTPUT_AUDIO_ENCODERS] = {0};
-	size_t start_idx;
+	struct interleaved_packet start;
 	size_t first_audio_idx;
 	size_t first_video_idx;
 
@@ -2029,9 +2063,8 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	}
 
 	/* clear out excess starting audio if it hasn't been already */
-	start_idx = get_interleaved_start_idx(output);
-	if (start_idx) {
-		discard_to_idx(output, start_idx);
+	start = get_interleaved_start(output);
+	if (discard_to_packet(output, &start, false)) {
 		if (!get_audio_and_video_packets(output, video, audio))
 			return false;
 	}
@@ -2060,51 +2093,27 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 
 	/* subtract offsets from highest TS offset variables */
 	output->highest_audio_ts -= audio[first_audio_idx]->dts_usec;
-
-	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-		apply_interleaved_packet_offset(output, packet, NULL);
-	}
-
 	return true;
 }
 
-static inline void insert_interleaved_packet(struct obs_output *output, struct encoder_packet *out)
-{
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		// sort video packets with same DTS by track index,
-		// to prevent the pruning logic from removing additional
-		// video tracks
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
-		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
-			continue;
-
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
-}
-
+/* applies the new offsets to all existing packet DTS/PTS values, and queues
+ * the packets again in the order they were queued in before */
 static void resort_interleaved_packets(struct obs_output *output)
 {
 	DARRAY(struct encoder_packet) old_array;
+	struct encoder_packet packet;
 
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0, sizeof(output->interleaved_packets));
+	da_init(old_array);
+	da_reserve(old_array, output->interleaver.num_packets);
+
+	while (packet_interleaver_pop(&output->interleaver, &packet))
+		da_push_back(old_array, &packet);
 
 	for (size_t i = 0; i < old_array.num; i++) {
+		apply_interleaved_packet_offset(output, &old_array.array[i], NULL);
 		set_higher_ts(output, &old_array.array[i]);
 
-		insert_interleaved_packet(output, &old_array.array[i]);
+		packet_interleaver_push(&output->interleaver, &old_array.array[i]);
 	}
 
 	da_free(old_array);
@@ -2112,17 +2121,10 @@ static void resort_interleaved_packets(struct obs_output *output)
 
 static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_usec)
 {
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p = &output->interleaved_packets.array[idx];
+	struct interleaved_packet *next;
 
-		if (p->dts_usec >= dts_usec)
-			break;
-	}
-
-	if (idx)
-		discard_to_idx(output, idx);
+	while ((next = packet_interleaver_peek(&output->interleaver)) != NULL && next->packet.dts_usec < dts_usec)
+		discard_next_packet(output);
 }
 
 static bool purge_encoder_group_keyframe_data(obs_output_t *output, size_t idx)
@@ -2201,22 +2203,44 @@ static void apply_ept_offsets(struct obs_output *output)
 	}
 }
 
-static inline size_t count_streamable_frames(struct obs_output *output)
+/* packets of a track are queued in DTS order, so the streamable packets of a
+ * track all come before the ones that aren't */
+static struct interleaved_packet *find_first_unstreamable(struct obs_output *output, enum obs_encoder_type type,
+							  size_t track_idx)
 {
-	size_t eligible = 0;
+	struct packet_interleaver *il = &output->interleaver;
+	size_t low = 0;
+	size_t high = packet_interleaver_track_size(il, type, track_idx);
 
-	for (size_t idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *pkt = &output->interleaved_packets.array[idx];
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (has_higher_opposing_ts(output, &packet_interleaver_track_get(il, type, track_idx, mid)->packet))
+			low = mid + 1;
+		else
+			high = mid;
+	}
 
-		/* Only count an interleaved packet as streamable if there are packets of the opposing type and of a
-		 * higher timestamp in the interleave buffer. This ensures that the timestamps are monotonic. */
-		if (!has_higher_opposing_ts(output, pkt))
-			break;
+	return packet_interleaver_track_get(il, type, track_idx, low);
+}
 
-		eligible++;
-	}
+static inline void get_earlier_packet(struct interleaved_packet **limit, struct interleaved_packet *packet)
+{
+	if (packet && (!*limit || interleaved_packet_before(packet, *limit)))
+		*limit = packet;
+}
+
+static inline size_t count_streamable_frames(struct obs_output *output)
+{
+	struct interleaved_packet *limit = NULL;
 
-	return eligible;
+	/* Only count an interleaved packet as streamable if there are packets of the opposing type and of a
+	 * higher timestamp in the interleave buffer. This ensures that the timestamps are monotonic. */
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++)
+		get_earlier_packet(&limit, find_first_unstreamable(output, OBS_ENCODER_VIDEO, i));
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++)
+		get_earlier_packet(&limit, find_first_unstreamable(output, OBS_ENCODER_AUDIO, i));
+
+	return limit ? packet_interleaver_count_before(&output->interleaver, limit) : output->interleaver.num_packets;
 }
 
 static void interleave_packets(void *data, struct encoder_packet *packet, struct encoder_packet_time *packet_time)
@@ -2269,7 +2293,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 	else
 		check_received(output, packet);
 
-	insert_interleaved_packet(output, &out);
+	packet_interleaver_push(&output->interleaver, &out);
 
 	received_video = true;
 	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
@@ -2511,13 +2535,16 @@ static void hook_data_capture(struct obs_output *output)
 			     output->context.name, output->delay_sec, preserve_active(output) ? "on" : "off");
 		}
 
+		if (has_video && has_audio)
+			obs_output_delivery_start(output);
+
 		if (has_audio)
 			start_audio_encoders(output, encoded_callback);
 		if (has_video)
 			start_video_encoders(output, encoded_callback);
 	} else {
 		if (has_video)
-			start_raw_video(output->video, obs_output_get_video_conversion(output), 1,
+			start_raw_video(output->video, obs_output_get_video_conversion(output), 1, 0,
 					default_raw_video_callback, output);
 		if (has_audio)
 			start_raw_audio(output);
@@ -2710,8 +2737,6 @@ static void reset_raw_output(obs_output_t *output)
 
 static void calculate_batch_size(struct obs_output *output)
 {
-	struct obs_video_info ovi;
-	obs_get_video_info(&ovi);
 	DARRAY(uint64_t) intervals;
 	da_init(intervals);
 
@@ -2722,8 +2747,14 @@ static void calculate_batch_size(struct obs_output *output)
 		if (!output->video_encoders[i])
 			continue;
 
-		uint32_t den = ovi.fps_den * obs_encoder_get_frame_rate_divisor(output->video_encoders[i]);
-		uint64_t encoder_interval = util_mul_div64(1000000000ULL, den, ovi.fps_num);
+		/* the encoder's own video, which need not be the main canvas */
+		video_t *video = obs_encoder_parent_video(output->video_encoders[i]);
+		const struct video_output_info *voi = video_output_get_info(video);
+		if (!voi)
+			continue;
+
+		uint32_t den = voi->fps_den * obs_encoder_get_frame_rate_divisor(output->video_encoders[i]);
+		uint64_t encoder_interval = util_mul_div64(1000000000ULL, den, voi->fps_num);
 		da_push_back(intervals, &encoder_interval);
 
 		largest_interval = encoder_interval > largest_interval ? encoder_interval : largest_interval;
@@ -2864,6 +2895,8 @@ static void *end_data_capture_thread(void *data)
 	if (output->active_delay_ns)
 		obs_output_cleanup_delay(output);
 
+	obs_output_delivery_stop(output);
+
 	do_output_signal(output, "deactivate");
 	os_atomic_set_bool(&output->active, false);
 	os_event_signal(output->stopping_event);
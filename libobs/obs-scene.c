@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/util_uint64.h"
 #include "graphics/math-defs.h"
+#include "media-io/audio-mix.h"
 #include "obs-scene.h"
 #include "obs-internal.h"
 
@@ -27,6 +28,10 @@ const struct obs_source_info group_info;
 static void resize_group(obs_sceneitem_t *group, bool scene_resize);
 static void resize_scene(obs_scene_t *scene);
 static void signal_parent(obs_scene_t *parent, const char *name, calldata_t *params);
+static void signal_parent_id(obs_scene_t *parent, signal_id_t id, calldata_t *params);
+
+/* emitted whenever an item is moved, e.g. for every step of a drag */
+static signal_id_t item_transform_signal = NULL;
 static void get_ungrouped_transform(obs_sceneitem_t *group, obs_sceneitem_t *item, struct vec2 *pos, struct vec2 *scale,
 				    float *rot);
 static inline bool crop_enabled(const struct obs_sceneitem_crop *crop);
@@ -697,7 +702,7 @@ static void update_item_transform(struct obs_scene_item *item, bool update_tex)
 
 	calldata_init_fixed(&params, stack, sizeof(stack));
 	calldata_set_ptr(&params, "item", item);
-	signal_parent(item->parent, "item_transform", &params);
+	signal_parent_id(item->parent, signal_get_id_cached(&item_transform_signal, "item_transform"), &params);
 
 	if (!update_tex)
 		return;
@@ -1589,27 +1594,6 @@ static void process_all_audio_actions(struct obs_scene_item *item, size_t sample
 		;
 }
 
-static void mix_audio_with_buf(float *p_out, float *p_in, float *buf_in, size_t pos, size_t count)
-{
-	register float *out = p_out + pos;
-	register float *buf = buf_in;
-	register float *in = p_in;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++) * *(buf++);
-}
-
-static inline void mix_audio(float *p_out, float *p_in, size_t pos, size_t count)
-{
-	register float *out = p_out + pos;
-	register float *in = p_in;
-	register float *end = in + count;
-
-	while (in < end)
-		*(out++) += *(in++);
-}
-
 static bool scene_audio_render(void *data, uint64_t *ts_out, struct obs_source_audio_mix *audio_output, uint32_t mixers,
 			       size_t channels, size_t sample_rate)
 {
@@ -1618,6 +1602,7 @@ static bool scene_audio_render(void *data, uint64_t *ts_out, struct obs_source_a
 	struct obs_source_audio_mix child_audio;
 	struct obs_scene *scene = data;
 	struct obs_scene_item *item;
+	const struct audio_mix_kernels *kernels = audio_mix_get_kernels();
 
 	audio_lock(scene);
 
@@ -1704,12 +1689,12 @@ static bool scene_audio_render(void *data, uint64_t *ts_out, struct obs_source_a
 					continue;
 
 				for (size_t ch = 0; ch < channels; ch++) {
-					float *out = audio_output->output[mix].data[ch];
+					float *out = audio_output->output[mix].data[ch] + pos;
 					float *in = child_audio.output[mix].data[ch];
 					if (apply_buf)
-						mix_audio_with_buf(out, in, buf, pos, count);
+						kernels->add_gain_ramp(out, in, buf, count);
 					else
-						mix_audio(out, in, pos, count);
+						kernels->add(out, in, count);
 				}
 			}
 		}
@@ -2472,6 +2457,12 @@ static void signal_parent(obs_scene_t *parent, const char *command, calldata_t *
 	signal_handler_signal(parent->source->context.signals, command, params);
 }
 
+static void signal_parent_id(obs_scene_t *parent, signal_id_t id, calldata_t *params)
+{
+	calldata_set_ptr(params, "scene", parent);
+	signal_handler_signal_id(parent->source->context.signals, id, params);
+}
+
 struct passthrough {
 	obs_data_array_t *ids;
 	obs_data_array_t *scenes_and_groups;
@@ -21,6 +21,7 @@
 #include "media-io/format-conversion.h"
 #include "media-io/video-frame.h"
 #include "media-io/audio-io.h"
+#include "media-io/audio-mix.h"
 #include "util/threading.h"
 #include "util/platform.h"
 #include "util/util_uint64.h"
@@ -697,14 +698,34 @@ void obs_source_frame_init(struct obs_source_frame *frame, enum video_format for
 	}
 }
 
+struct obs_borrowed_frame {
+	struct obs_source_frame frame;
+	void (*release)(void *param);
+	void *param;
+};
+
+/* borrowed frames hand their data back to the producer instead of freeing it */
+static void async_frame_destroy(struct obs_source_frame *frame)
+{
+	if (frame && frame->borrowed) {
+		struct obs_borrowed_frame *borrowed = (struct obs_borrowed_frame *)frame;
+		borrowed->release(borrowed->param);
+		bfree(borrowed);
+		return;
+	}
+
+	obs_source_frame_destroy(frame);
+}
+
 static inline void obs_source_frame_decref(struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(frame);
 }
 
 static bool obs_source_filter_remove_refless(obs_source_t *source, obs_source_t *filter);
 static void obs_source_destroy_defer(struct obs_source *source);
+static inline void free_async_cache(struct obs_source *source);
 
 void obs_source_destroy(struct obs_source *source)
 {
@@ -772,6 +793,11 @@ static void obs_source_destroy_defer(struct obs_source *source)
 
 	obs_source_dosignal(source, "source_destroy", "destroy");
 
+	/* borrowed frames must be handed back while the producer still exists */
+	pthread_mutex_lock(&source->async_mutex);
+	free_async_cache(source);
+	pthread_mutex_unlock(&source->async_mutex);
+
 	if (source->context.data) {
 		source->info.destroy(source->context.data);
 		source->context.data = NULL;
@@ -1261,6 +1287,7 @@ void obs_source_deactivate(obs_source_t *source, enum view_type type)
 }
 
 static inline struct obs_source_frame *get_closest_frame(obs_source_t *source, uint64_t sys_time);
+static void release_borrowed_frames(obs_source_t *source);
 
 static void filter_frame(obs_source_t *source, struct obs_source_frame **ref_frame)
 {
@@ -1351,15 +1378,37 @@ static void async_tick(obs_source_t *source)
 	if (source->cur_async_frame)
 		source->async_update_texture = set_async_texture_size(source, source->cur_async_frame);
 
+	release_borrowed_frames(source);
+
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
-void obs_source_video_tick(obs_source_t *source, float seconds)
+static inline bool video_tick_live(const obs_source_t *source)
+{
+	/* filters don't get show/activate references of their own */
+	if (source->info.type == OBS_SOURCE_TYPE_FILTER) {
+		source = source->filter_parent;
+		if (!source)
+			return false;
+	}
+
+	return source->showing || source->active || os_atomic_load_long(&source->show_refs) > 0 ||
+	       os_atomic_load_long(&source->activate_refs) > 0;
+}
+
+/* updates the per-frame state of the source, and returns whether its
+ * video_tick callback should be called this frame */
+bool obs_source_video_tick_begin(obs_source_t *source, float seconds)
 {
 	bool now_showing, now_active;
+	bool was_live;
 
-	if (!obs_source_valid(source, "obs_source_video_tick"))
-		return;
+	if (!obs_source_valid(source, "obs_source_video_tick_begin"))
+		return false;
+
+	/* the source still gets ticked on the frame it stops being live so
+	 * that it can react to being hidden/deactivated */
+	was_live = video_tick_live(source);
 
 	if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
 		obs_transition_tick(source, seconds);
@@ -1423,9 +1472,16 @@ void obs_source_video_tick(obs_source_t *source, float seconds)
 		source->active = now_active;
 	}
 
-	if (source->context.data && source->info.video_tick)
-		source->info.video_tick(source->context.data, seconds);
+	if (!source->context.data || !source->info.video_tick)
+		return false;
+	if ((source->info.output_flags & OBS_SOURCE_TICK_WHEN_INACTIVE) != 0)
+		return true;
+
+	return was_live || video_tick_live(source);
+}
 
+void obs_source_video_tick_end(obs_source_t *source)
+{
 	source->async_rendered = false;
 	source->deinterlace_rendered = false;
 }
@@ -3485,15 +3541,31 @@ static inline void free_async_cache(struct obs_source *source)
 
 #define MAX_UNUSED_FRAME_DURATION 5
 
+/* borrowed frames are never recycled, so hand them back to the producer as
+ * soon as they're no longer in use */
+static void release_borrowed_frames(obs_source_t *source)
+{
+	for (size_t i = source->async_cache.num; i > 0; i--) {
+		struct async_frame *af = &source->async_cache.array[i - 1];
+		if (!af->used && af->frame->borrowed) {
+			struct obs_source_frame *frame = af->frame;
+			da_erase(source->async_cache, i - 1);
+			obs_source_frame_decref(frame);
+		}
+	}
+}
+
 /* frees frame allocations if they haven't been used for a specific period
  * of time */
 static void clean_cache(obs_source_t *source)
 {
+	release_borrowed_frames(source);
+
 	for (size_t i = source->async_cache.num; i > 0; i--) {
 		struct async_frame *af = &source->async_cache.array[i - 1];
 		if (!af->used) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
-				obs_source_frame_destroy(af->frame);
+				async_frame_destroy(af->frame);
 				da_erase(source->async_cache, i - 1);
 			}
 		}
@@ -3501,18 +3573,15 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
-{
-	struct obs_source_frame *new_frame = NULL;
-
-	pthread_mutex_lock(&source->async_mutex);
 
+/* must be called with async_mutex locked, returns false if the frame should
+ * be dropped */
+static bool prepare_async_cache(struct obs_source *source, const struct obs_source_frame *frame)
+{
 	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
 		free_async_cache(source);
 		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
+		return false;
 	}
 
 	if (async_texture_changed(source, frame)) {
@@ -3521,14 +3590,29 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 		source->async_cache_height = frame->height;
 	}
 
-	const enum video_format format = frame->format;
-	source->async_cache_format = format;
+	source->async_cache_format = frame->format;
 	source->async_cache_full_range = frame->full_range;
 	source->async_cache_trc = frame->trc;
+	return true;
+}
+
+//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && async_frame_destroy(output)
+static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (!prepare_async_cache(source, frame)) {
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	const enum video_format format = frame->format;
 
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
-		if (!af->used) {
+		if (!af->used && !af->frame->borrowed) {
 			new_frame = af->frame;
 			new_frame->format = format;
 			af->used = true;
@@ -3560,6 +3644,57 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 	return new_frame;
 }
 
+/* same as cache_video, but the frame data is referenced rather than copied,
+ * and the cache entry is dropped (rather than recycled) once it's unused */
+static struct obs_source_frame *cache_borrowed_video(struct obs_source *source, const struct obs_source_frame *frame,
+						      void (*release)(void *param), void *param)
+{
+	struct obs_borrowed_frame *borrowed;
+	struct async_frame new_af;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (!prepare_async_cache(source, frame)) {
+		pthread_mutex_unlock(&source->async_mutex);
+		release(param);
+		return NULL;
+	}
+
+	clean_cache(source);
+
+	borrowed = bzalloc(sizeof(*borrowed));
+	borrowed->frame = *frame;
+	borrowed->frame.refs = 2;
+	borrowed->frame.prev_frame = false;
+	borrowed->frame.borrowed = true;
+	borrowed->release = release;
+	borrowed->param = param;
+
+	new_af.frame = &borrowed->frame;
+	new_af.used = true;
+	new_af.unused_count = 0;
+	da_push_back(source->async_cache, &new_af);
+
+	pthread_mutex_unlock(&source->async_mutex);
+
+	return &borrowed->frame;
+}
+
+static void push_async_frame(obs_source_t *source, struct obs_source_frame *output)
+{
+	pthread_mutex_lock(&source->async_mutex);
+	if (output) {
+		if (os_atomic_dec_long(&output->refs) == 0) {
+			async_frame_destroy(output);
+			output = NULL;
+		} else {
+			da_push_back(source->async_frames, &output);
+			source->async_active = true;
+		}
+	}
+	pthread_mutex_unlock(&source->async_mutex);
+}
+
 static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame)
 {
 	if (!obs_source_valid(source, "obs_source_output_video"))
@@ -3579,17 +3714,7 @@ static void obs_source_output_video_internal(obs_source_t *source, const struct
 	struct obs_source_frame *output = cache_video(source, frame);
 
 	/* ------------------------------------------- */
-	pthread_mutex_lock(&source->async_mutex);
-	if (output) {
-		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			da_push_back(source->async_frames, &output);
-			source->async_active = true;
-		}
-	}
-	pthread_mutex_unlock(&source->async_mutex);
+	push_async_frame(source, output);
 }
 
 void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame)
@@ -3607,6 +3732,27 @@ void obs_source_output_video(obs_source_t *source, const struct obs_source_frame
 	obs_source_output_video_internal(source, &new_frame);
 }
 
+void obs_source_output_video_borrowed(obs_source_t *source, const struct obs_source_frame *frame,
+				      void (*release)(void *param), void *param)
+{
+	if (!release) {
+		obs_source_output_video(source, frame);
+		return;
+	}
+	if (!frame || destroying(source) || !obs_source_valid(source, "obs_source_output_video_borrowed")) {
+		release(param);
+		return;
+	}
+
+	struct obs_source_frame new_frame = *frame;
+	new_frame.full_range = format_is_yuv(frame->format) ? new_frame.full_range : true;
+
+	source_profiler_async_frame_received(source);
+
+	struct obs_source_frame *output = cache_borrowed_video(source, &new_frame, release, param);
+	push_async_frame(source, output);
+}
+
 void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame)
 {
 	if (destroying(source))
@@ -4223,14 +4369,16 @@ void obs_source_release_frame(obs_source_t *source, struct obs_source_frame *fra
 		return;
 
 	if (!source) {
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(frame);
 	} else {
 		pthread_mutex_lock(&source->async_mutex);
 
-		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
-		else
+		if (os_atomic_dec_long(&frame->refs) == 0) {
+			async_frame_destroy(frame);
+		} else {
 			remove_async_frame(source, frame);
+			release_borrowed_frames(source);
+		}
 
 		pthread_mutex_unlock(&source->async_mutex);
 	}
@@ -4512,6 +4660,9 @@ proc_handler_t *obs_source_get_proc_handler(const obs_source_t *source)
 	return obs_source_valid(source, "obs_source_get_proc_handler") ? source->context.procs : NULL;
 }
 
+static signal_id_t volume_signal = NULL;
+static signal_id_t source_volume_signal = NULL;
+
 void obs_source_set_volume(obs_source_t *source, float volume)
 {
 	if (obs_source_valid(source, "obs_source_set_volume")) {
@@ -4524,9 +4675,11 @@ void obs_source_set_volume(obs_source_t *source, float volume)
 		calldata_set_ptr(&data, "source", source);
 		calldata_set_float(&data, "volume", volume);
 
-		signal_handler_signal(source->context.signals, "volume", &data);
+		signal_handler_signal_id(source->context.signals, signal_get_id_cached(&volume_signal, "volume"),
+					 &data);
 		if (!source->context.private)
-			signal_handler_signal(obs->signals, "source_volume", &data);
+			signal_handler_signal_id(obs->signals,
+						 signal_get_id_cached(&source_volume_signal, "source_volume"), &data);
 
 		volume = (float)calldata_float(&data, "volume");
 
@@ -5214,23 +5367,15 @@ static float get_source_volume(obs_source_t *source, uint64_t os_time)
 
 static inline void multiply_output_audio(obs_source_t *source, size_t mix, size_t channels, float vol)
 {
-	register float *out = source->audio_output_buf[mix][0];
-	register float *end = out + AUDIO_OUTPUT_FRAMES * channels;
-
-	while (out < end)
-		*(out++) *= vol;
+	audio_mix_get_kernels()->mul(source->audio_output_buf[mix][0], vol, AUDIO_OUTPUT_FRAMES * channels);
 }
 
 static inline void multiply_vol_data(obs_source_t *source, size_t mix, size_t channels, float *vol_data)
 {
-	for (size_t ch = 0; ch < channels; ch++) {
-		register float *out = source->audio_output_buf[mix][ch];
-		register float *end = out + AUDIO_OUTPUT_FRAMES;
-		register float *vol = vol_data;
+	const struct audio_mix_kernels *kernels = audio_mix_get_kernels();
 
-		while (out < end)
-			*(out++) *= *(vol++);
-	}
+	for (size_t ch = 0; ch < channels; ch++)
+		kernels->mul_ramp(source->audio_output_buf[mix][ch], vol_data, AUDIO_OUTPUT_FRAMES);
 }
 
 static inline void apply_audio_action(obs_source_t *source, const struct audio_action *action)
@@ -208,6 +208,19 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_REQUIRES_CANVAS (1 << 17)
 
+/**
+ * Source's video_tick callback should be called even while the source is
+ * neither showing nor active.  By default, ticks of such sources are skipped.
+ */
+#define OBS_SOURCE_TICK_WHEN_INACTIVE (1 << 18)
+
+/**
+ * Source's video_tick callback is thread-safe and does not use the graphics
+ * subsystem, and may be called from a worker thread in parallel with the
+ * video_tick callbacks of other sources.
+ */
+#define OBS_SOURCE_THREADSAFE_TICK (1 << 19)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent, obs_source_t *child, void *param);
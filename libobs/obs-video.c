@@ -29,12 +29,140 @@
 #include <windows.h>
 #endif
 
+#define MAX_TICK_THREADS 4
+
+static void tick_pool_run(struct obs_tick_pool *pool)
+{
+	const size_t num = pool->jobs.num;
+
+	for (;;) {
+		size_t idx = (size_t)os_atomic_inc_long(&pool->next) - 1;
+		if (idx >= num)
+			break;
+
+		struct obs_source_tick *tick = pool->jobs.array[idx];
+		obs_source_t *s = tick->source;
+		const uint64_t start = pool->profiling ? os_gettime_ns() : 0;
+
+		s->info.video_tick(s->context.data, pool->seconds);
+
+		if (pool->profiling)
+			tick->time += os_gettime_ns() - start;
+	}
+}
+
+static void *tick_pool_thread(void *param)
+{
+	struct obs_tick_pool *pool = param;
+
+	os_set_thread_name("libobs: tick worker");
+
+	while (os_sem_wait(pool->start_sem) == 0) {
+		if (os_atomic_load_bool(&pool->exit))
+			break;
+
+		tick_pool_run(pool);
+
+		if (os_atomic_dec_long(&pool->pending) == 0)
+			os_event_signal(pool->done_event);
+	}
+
+	return NULL;
+}
+
+static void tick_pool_init(struct obs_tick_pool *pool)
+{
+	int cores = os_get_logical_cores();
+	size_t num = cores > 1 ? (size_t)cores - 1 : 0;
+
+	pool->initialized = true;
+
+	if (num > MAX_TICK_THREADS)
+		num = MAX_TICK_THREADS;
+	if (!num)
+		return;
+
+	if (os_sem_init(&pool->start_sem, 0) != 0)
+		goto fail;
+	if (os_event_init(&pool->done_event, OS_EVENT_TYPE_AUTO) != 0)
+		goto fail;
+
+	pool->threads = bzalloc(sizeof(pthread_t) * num);
+
+	for (size_t i = 0; i < num; i++) {
+		if (pthread_create(&pool->threads[i], NULL, tick_pool_thread, pool) != 0) {
+			blog(LOG_WARNING, "Failed to create tick worker thread");
+			break;
+		}
+		pool->num_threads++;
+	}
+
+	blog(LOG_DEBUG, "Created %zu tick worker threads", pool->num_threads);
+	return;
+
+fail:
+	blog(LOG_WARNING, "Failed to create tick worker threads");
+}
+
+void obs_tick_pool_free(struct obs_tick_pool *pool)
+{
+	os_atomic_set_bool(&pool->exit, true);
+
+	for (size_t i = 0; i < pool->num_threads; i++)
+		os_sem_post(pool->start_sem);
+	for (size_t i = 0; i < pool->num_threads; i++)
+		pthread_join(pool->threads[i], NULL);
+
+	os_sem_destroy(pool->start_sem);
+	os_event_destroy(pool->done_event);
+	bfree(pool->threads);
+	da_free(pool->jobs);
+	memset(pool, 0, sizeof(*pool));
+}
+
+/* ticks the queued sources on the worker threads, with the calling thread
+ * taking part, and returns once all of them have been ticked */
+static void tick_pool_dispatch(struct obs_tick_pool *pool, float seconds, bool profiling)
+{
+	size_t workers;
+
+	if (!pool->jobs.num)
+		return;
+	if (pool->jobs.num > 1 && !pool->initialized)
+		tick_pool_init(pool);
+
+	workers = pool->jobs.num - 1;
+	if (workers > pool->num_threads)
+		workers = pool->num_threads;
+
+	pool->seconds = seconds;
+	pool->profiling = profiling;
+	os_atomic_set_long(&pool->next, 0);
+	os_atomic_set_long(&pool->pending, (long)workers + 1);
+
+	for (size_t i = 0; i < workers; i++)
+		os_sem_post(pool->start_sem);
+
+	tick_pool_run(pool);
+
+	/* workers that found no work left still have to check in before
+	 * the next batch can be set up */
+	if (os_atomic_dec_long(&pool->pending) > 0)
+		os_event_wait(pool->done_event);
+}
+
+static const char *tick_sources_state_name = "update_state";
+static const char *tick_sources_threaded_name = "tick_threaded";
+static const char *tick_sources_serial_name = "tick_serial";
+
 static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 {
 	struct obs_core_data *data = &obs->data;
+	struct obs_tick_pool *pool = &data->tick_pool;
 	struct obs_source *source;
 	uint64_t delta_time;
 	float seconds;
+	bool profiling;
 
 	if (!last_time)
 		last_time = cur_time - obs->video.video_frame_interval_ns;
@@ -65,24 +193,87 @@ static uint64_t tick_sources(uint64_t cur_time, uint64_t last_time)
 	source = data->sources;
 	while (source) {
 		obs_source_t *s = obs_source_removed(source) ? NULL : obs_source_get_ref(source);
-		if (s)
-			da_push_back(data->sources_to_tick, &s);
+		if (s) {
+			struct obs_source_tick *tick = da_push_back_new(data->sources_to_tick);
+			tick->source = s;
+		}
 		source = (struct obs_source *)source->context.hh_uuid.next;
 	}
 
 	pthread_mutex_unlock(&data->sources_mutex);
 
 	/* ------------------------------------- */
-	/* call the tick function of each source */
+	/* update the state of each source, and  */
+	/* sort out which ones need to be ticked */
+
+	profiling = source_profiler_source_tick_start() != 0;
+
+	profile_start(tick_sources_state_name);
+
+	da_clear(pool->jobs);
+	da_clear(data->serial_ticks);
 
 	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
-		obs_source_t *s = data->sources_to_tick.array[i];
-		if (!obs_source_removed(s)) {
-			const uint64_t start = source_profiler_source_tick_start();
-			obs_source_video_tick(s, seconds);
-			source_profiler_source_tick_end(s, start);
+		struct obs_source_tick *tick = &data->sources_to_tick.array[i];
+		obs_source_t *s = tick->source;
+
+		if (obs_source_removed(s))
+			continue;
+
+		const uint64_t start = profiling ? os_gettime_ns() : 0;
+
+		if (obs_source_video_tick_begin(s, seconds)) {
+			if ((s->info.output_flags & OBS_SOURCE_THREADSAFE_TICK) != 0)
+				da_push_back(pool->jobs, &tick);
+			else
+				da_push_back(data->serial_ticks, &tick);
+		}
+
+		tick->ticked = true;
+		if (profiling)
+			tick->time = os_gettime_ns() - start;
+	}
+
+	profile_end(tick_sources_state_name);
+
+	/* ------------------------------------- */
+	/* call the tick function of sources     */
+	/* that can be ticked in parallel        */
+
+	profile_start(tick_sources_threaded_name);
+	tick_pool_dispatch(pool, seconds, profiling);
+	profile_end(tick_sources_threaded_name);
+
+	/* ------------------------------------- */
+	/* call the tick function of the rest    */
+
+	profile_start(tick_sources_serial_name);
+
+	for (size_t i = 0; i < data->serial_ticks.num; i++) {
+		struct obs_source_tick *tick = data->serial_ticks.array[i];
+		obs_source_t *s = tick->source;
+
+		if (obs_source_removed(s))
+			continue;
+
+		const uint64_t start = profiling ? os_gettime_ns() : 0;
+
+		s->info.video_tick(s->context.data, seconds);
+
+		if (profiling)
+			tick->time += os_gettime_ns() - start;
+	}
+
+	profile_end(tick_sources_serial_name);
+
+	for (size_t i = 0; i < data->sources_to_tick.num; i++) {
+		struct obs_source_tick *tick = &data->sources_to_tick.array[i];
+
+		if (tick->ticked) {
+			obs_source_video_tick_end(tick->source);
+			source_profiler_source_tick_time(tick->source, tick->time);
 		}
-		obs_source_release(s);
+		obs_source_release(tick->source);
 	}
 
 	return cur_time;
@@ -1001,6 +1001,17 @@ bool obs_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *context, obs_key_t
 	return vk_down(obs_key_to_virtual_key(key));
 }
 
+bool obs_hotkeys_platform_wait_events(obs_hotkeys_platform_t *context)
+{
+	UNUSED_PARAMETER(context);
+	return false;
+}
+
+void obs_hotkeys_platform_wake(obs_hotkeys_platform_t *context)
+{
+	UNUSED_PARAMETER(context);
+}
+
 void obs_key_to_str(obs_key_t key, struct dstr *str)
 {
 	wchar_t name[128] = L"";
@@ -988,6 +988,8 @@ static bool obs_init_data(void)
 		goto fail;
 	if (pthread_mutex_init_recursive(&obs->data.canvases_mutex) != 0)
 		goto fail;
+	if (!obs_image_cache_init(&data->image_cache))
+		goto fail;
 
 	data->sources = NULL;
 	data->public_sources = NULL;
@@ -1058,6 +1060,8 @@ static void obs_free_data(void)
 
 	os_task_queue_wait(obs->destruction_task_thread);
 
+	obs_image_cache_free(&data->image_cache);
+
 	pthread_mutex_destroy(&data->sources_mutex);
 	pthread_mutex_destroy(&data->audio_sources_mutex);
 	pthread_mutex_destroy(&data->displays_mutex);
@@ -1075,6 +1079,8 @@ static void obs_free_data(void)
 		bfree(data->protocols.array[i]);
 	da_free(data->protocols);
 	da_free(data->sources_to_tick);
+	da_free(data->serial_ticks);
+	obs_tick_pool_free(&data->tick_pool);
 }
 
 static const char *obs_signals[] = {
@@ -1177,6 +1183,7 @@ static inline void stop_hotkeys(void)
 
 	if (hotkeys->hotkey_thread_initialized) {
 		os_event_signal(hotkeys->stop_event);
+		obs_hotkeys_platform_wake(hotkeys->platform_context);
 		pthread_join(hotkeys->hotkey_thread, &thread_ret);
 		hotkeys->hotkey_thread_initialized = false;
 	}
@@ -3101,14 +3108,14 @@ struct obs_core_video_mix *get_mix_for_video(video_t *v)
 }
 
 void start_raw_video(video_t *v, const struct video_scale_info *conversion, uint32_t frame_rate_divisor,
-		     void (*callback)(void *param, struct video_data *frame), void *param)
+		     uint32_t queue_size, void (*callback)(void *param, struct video_data *frame), void *param)
 {
 	struct obs_core_video_mix *video = get_mix_for_video(v);
 
 	// TODO: Make affected outputs use views/canvasses, and revert this later.
 	// https://github.com/obsproject/obs-studio/pull/12379
 	// https://github.com/obsproject/obs-studio/issues/12366
-	if (video_output_connect2(v, conversion, frame_rate_divisor, callback, param) && video)
+	if (video_output_connect_threaded(v, conversion, frame_rate_divisor, queue_size, callback, param) && video)
 		os_atomic_inc_long(&video->raw_active);
 }
 
@@ -3133,7 +3140,7 @@ void obs_add_raw_video_callback2(const struct video_scale_info *conversion, uint
 				 void (*callback)(void *param, struct video_data *frame), void *param)
 {
 	struct obs_core_video_mix *video = obs->data.main_canvas->mix;
-	start_raw_video(video->video, conversion, frame_rate_divisor, callback, param);
+	start_raw_video(video->video, conversion, frame_rate_divisor, 0, callback, param);
 }
 
 void obs_remove_raw_video_callback(void (*callback)(void *param, struct video_data *frame), void *param)
@@ -69,6 +69,7 @@ typedef struct obs_module_metadata obs_module_metadata_t;
 typedef struct obs_fader obs_fader_t;
 typedef struct obs_volmeter obs_volmeter_t;
 typedef struct obs_canvas obs_canvas_t;
+typedef struct obs_cached_image obs_cached_image_t;
 
 typedef struct obs_weak_object obs_weak_object_t;
 typedef struct obs_weak_source obs_weak_source_t;
@@ -300,6 +301,7 @@ struct obs_source_frame {
 	/* used internally by libobs */
 	volatile long refs;
 	bool prev_frame;
+	bool borrowed;
 };
 
 struct obs_source_frame2 {
@@ -1025,6 +1027,54 @@ EXPORT void obs_display_set_background_color(obs_display_t *display, uint32_t co
 
 EXPORT void obs_display_size(obs_display_t *display, uint32_t *width, uint32_t *height);
 
+/* ------------------------------------------------------------------------- */
+/* Image cache */
+
+struct obs_image_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	uint64_t size;
+	uint64_t limit;
+	size_t num_images;
+	size_t num_unused;
+};
+
+/**
+ * Gets a reference to the decoded image of a file, decoding it if it isn't
+ * in the image cache yet.  Images are shared between all users of the same
+ * file, modification time and alpha mode.  Animated images are not animated,
+ * only their first frame is decoded.
+ *
+ * @return  The image, or NULL if the file could not be decoded.  Release it
+ *          with obs_cached_image_release.
+ */
+EXPORT obs_cached_image_t *obs_image_cache_get(const char *file, enum gs_image_alpha_mode alpha_mode);
+
+/**
+ * Releases a reference to a cached image.  Unused images are kept until the
+ * cache exceeds its size limit, least recently used first.
+ */
+EXPORT void obs_cached_image_release(obs_cached_image_t *image);
+
+/**
+ * Gets the texture of a cached image, uploading it on first use.  Must be
+ * called within the graphics context.
+ */
+EXPORT gs_texture_t *obs_cached_image_get_texture(obs_cached_image_t *image);
+
+EXPORT uint32_t obs_cached_image_get_width(const obs_cached_image_t *image);
+EXPORT uint32_t obs_cached_image_get_height(const obs_cached_image_t *image);
+EXPORT enum gs_color_space obs_cached_image_get_color_space(const obs_cached_image_t *image);
+
+/** Returns the size of the image data in bytes */
+EXPORT uint64_t obs_cached_image_get_size(const obs_cached_image_t *image);
+
+/** Sets the size in bytes the cache may hold before unused images are freed */
+EXPORT void obs_image_cache_set_limit(uint64_t limit);
+
+EXPORT void obs_image_cache_get_stats(struct obs_image_cache_stats *stats);
+
 /* ------------------------------------------------------------------------- */
 /* Sources */
 
@@ -1416,6 +1466,16 @@ EXPORT void obs_source_draw(gs_texture_t *image, int x, int y, uint32_t cx, uint
 EXPORT void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame);
 EXPORT void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame);
 
+/**
+ * Outputs asynchronous video data without copying it.  The frame data is
+ * referenced directly until libobs no longer needs it, at which point release
+ * is called with param.  The release callback is always called exactly once,
+ * even if the frame is dropped, and may be called from any thread while
+ * libobs internal locks are held, so it must not call back in to the source.
+ */
+EXPORT void obs_source_output_video_borrowed(obs_source_t *source, const struct obs_source_frame *frame,
+					     void (*release)(void *param), void *param);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source, const struct obs_source_cea_708 *captions);
@@ -1941,6 +2001,45 @@ EXPORT uint32_t obs_output_get_delay(const obs_output_t *output);
 /** If delay is active, gets the currently active delay value, in seconds. */
 EXPORT uint32_t obs_output_get_active_delay(const obs_output_t *output);
 
+/** What to do when the delivery queue of an output is full */
+enum obs_output_delivery_overflow {
+	/** Wait for the output to catch up (blocks the encoder) */
+	OBS_OUTPUT_DELIVERY_BLOCK,
+	/** Drop video packets up to the next keyframe */
+	OBS_OUTPUT_DELIVERY_DROP_NON_KEY,
+	/** Stop the output with OBS_OUTPUT_ERROR */
+	OBS_OUTPUT_DELIVERY_ERROR,
+};
+
+struct obs_output_delivery_stats {
+	size_t queued;
+	size_t peak_queued;
+	uint64_t delivered;
+	uint64_t dropped;
+
+	/* time packets spent in the queue */
+	uint64_t avg_latency_ns;
+	uint64_t max_latency_ns;
+};
+
+/**
+ * Delivers interleaved packets to the output from a separate thread, with a
+ * queue of up to max_packets packets, so an output that blocks doesn't hold
+ * up the encoders.  A max_packets value of 0 disables the delivery thread,
+ * which is the default.  Video packets dropped by the queue are counted in
+ * obs_output_get_frames_dropped.
+ *
+ * Takes effect the next time the output is activated.
+ */
+EXPORT void obs_output_set_delivery_queue(obs_output_t *output, size_t max_packets,
+					  enum obs_output_delivery_overflow overflow);
+
+/**
+ * Gets statistics of the current or last delivery queue session, returns
+ * false if the queue is disabled.
+ */
+EXPORT bool obs_output_get_delivery_stats(const obs_output_t *output, struct obs_output_delivery_stats *stats);
+
 /** Forces the output to stop.  Usually only used with delay. */
 EXPORT void obs_output_force_stop(obs_output_t *output);
 
@@ -2303,6 +2402,16 @@ EXPORT void obs_encoder_set_gpu_scale_type(obs_encoder_t *encoder, enum obs_scal
  */
 EXPORT bool obs_encoder_set_frame_rate_divisor(obs_encoder_t *encoder, uint32_t divisor);
 
+/**
+ * Makes a raw video encoder receive its frames on a dedicated thread through
+ * a queue of up to queue_size frames, so that it does not stall other
+ * encoders sharing the same video output.  0 encodes on the video thread
+ * (default).  Has no effect for GPU encoders.
+ *
+ * Can only be called on stopped encoders, changing this on the fly is not supported
+ */
+EXPORT bool obs_encoder_set_video_queue_size(obs_encoder_t *encoder, uint32_t queue_size);
+
 /**
  * Adds region of interest (ROI) for an encoder. This allows prioritizing
  * quality of regions of the frame.
@@ -2342,6 +2451,15 @@ EXPORT uint32_t obs_encoder_get_frame_rate_divisor(const obs_encoder_t *encoder)
 /** For video encoders, returns the number of frames encoded */
 EXPORT uint32_t obs_encoder_get_encoded_frames(const obs_encoder_t *encoder);
 
+/** For video encoders, returns the video queue size (default is 0) */
+EXPORT uint32_t obs_encoder_get_video_queue_size(const obs_encoder_t *encoder);
+
+/** For threaded video encoders, returns the number of frames waiting to be encoded */
+EXPORT uint32_t obs_encoder_get_queued_frames(const obs_encoder_t *encoder);
+
+/** For threaded video encoders, returns the number of frames dropped because the queue was full */
+EXPORT uint32_t obs_encoder_get_dropped_frames(const obs_encoder_t *encoder);
+
 /** For audio encoders, returns the sample rate of the audio */
 EXPORT uint32_t obs_encoder_get_sample_rate(const obs_encoder_t *encoder);
 
@@ -2450,6 +2568,14 @@ EXPORT uint32_t obs_encoder_get_caps(const obs_encoder_t *encoder);
 EXPORT void obs_encoder_packet_ref(struct encoder_packet *dst, struct encoder_packet *src);
 EXPORT void obs_encoder_packet_release(struct encoder_packet *packet);
 
+/**
+ * Allocates data for an encoded packet.  When called from the encode callback
+ * and the packet's data is set to the returned buffer, libobs takes ownership
+ * of it and passes it on to outputs without copying it.  Otherwise the
+ * buffer is freed once the encode callback returns.
+ */
+EXPORT uint8_t *obs_encoder_alloc_packet_data(obs_encoder_t *encoder, size_t size);
+
 EXPORT void *obs_encoder_create_rerouted(obs_encoder_t *encoder, const char *reroute_id);
 
 /** Returns whether encoder is paused */
@@ -21,6 +21,13 @@
 #include "platform.h"
 #include "threading.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 /*
  * NOTE: totally jacked the mem alignment trick from ffmpeg, credit to them:
  *   http://www.ffmpeg.org/
@@ -96,16 +103,424 @@ static void a_free(void *ptr)
 #endif
 }
 
+/* ------------------------------------------------------------------------- */
+/* size class pool
+ *
+ *   Small allocations can optionally be served from a pool of size classes.
+ * Each thread keeps a magazine of free chunks per size class, and hands half
+ * of it to (or takes it from) the global depot of that class when it runs
+ * full (or empty).  New chunks are carved from slabs of one reserved address
+ * range, which is also how bfree/brealloc tell pool chunks apart from other
+ * allocations, no matter when the pool was enabled.  Pool memory is never
+ * given back to the system, it stays cached for its size class. */
+
+#define POOL_MAX_SIZE (256 * 1024)
+#define POOL_NUM_CLASSES 48
+#define POOL_SLAB_SHIFT 20
+#define POOL_SLAB_SIZE ((size_t)1 << POOL_SLAB_SHIFT)
+#define POOL_NUM_SLABS 512
+#define POOL_ARENA_SIZE (POOL_SLAB_SIZE * POOL_NUM_SLABS)
+#define POOL_MAGAZINE_BYTES (256 * 1024)
+#define POOL_MAGAZINE_MAX 64
+
+struct pool_chunk {
+	struct pool_chunk *next;
+};
+
+struct magazine {
+	struct pool_chunk *chunks;
+	size_t count;
+};
+
+struct thread_cache {
+	struct magazine magazines[POOL_NUM_CLASSES];
+
+	uint64_t hits;
+	uint64_t misses;
+	int64_t used_bytes;
+
+	struct thread_cache *next;
+	struct thread_cache **prev_next;
+};
+
+struct size_class {
+	pthread_mutex_t mutex;
+	struct pool_chunk *depot;
+	size_t depot_count;
+
+	uint8_t *slab_pos;
+	uint8_t *slab_end;
+	uint64_t carved_bytes;
+};
+
+static volatile bool pool_enabled = false;
+static uint8_t *pool_arena = NULL;
+static uint8_t slab_classes[POOL_NUM_SLABS];
+static size_t num_slabs = 0;
+
+static size_t class_sizes[POOL_NUM_CLASSES];
+static size_t magazine_sizes[POOL_NUM_CLASSES];
+static struct size_class classes[POOL_NUM_CLASSES];
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t cache_key;
+static struct thread_cache *first_cache = NULL;
+static uint64_t dead_hits = 0;
+static uint64_t dead_misses = 0;
+static int64_t dead_used_bytes = 0;
+
+static THREAD_LOCAL struct thread_cache *thread_cache = NULL;
+
+/* 32 byte steps up to 128 bytes, then four classes per power of two */
+static inline size_t get_size_class(size_t size)
+{
+	if (size <= 128)
+		return (size - 1) / 32;
+
+	size_t s = size - 1;
+	size_t bit = 7;
+	while (s >> (bit + 1))
+		bit++;
+
+	return 4 + (bit - 7) * 4 + ((s >> (bit - 2)) & 3);
+}
+
+static inline bool is_pool_ptr(const void *ptr)
+{
+	return pool_arena && (size_t)((const uint8_t *)ptr - pool_arena) < POOL_ARENA_SIZE;
+}
+
+static inline size_t get_ptr_class(const void *ptr)
+{
+	return slab_classes[((const uint8_t *)ptr - pool_arena) >> POOL_SLAB_SHIFT];
+}
+
+static void flush_thread_cache(void *data)
+{
+	struct thread_cache *cache = data;
+
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		struct magazine *mag = &cache->magazines[i];
+		struct size_class *sc = &classes[i];
+
+		if (!mag->count)
+			continue;
+
+		struct pool_chunk *last = mag->chunks;
+		while (last->next)
+			last = last->next;
+
+		pthread_mutex_lock(&sc->mutex);
+		last->next = sc->depot;
+		sc->depot = mag->chunks;
+		sc->depot_count += mag->count;
+		pthread_mutex_unlock(&sc->mutex);
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	*cache->prev_next = cache->next;
+	if (cache->next)
+		cache->next->prev_next = cache->prev_next;
+	dead_hits += cache->hits;
+	dead_misses += cache->misses;
+	dead_used_bytes += cache->used_bytes;
+	pthread_mutex_unlock(&pool_mutex);
+
+	if (thread_cache == cache)
+		thread_cache = NULL;
+	free(cache);
+}
+
+static struct thread_cache *get_thread_cache(void)
+{
+	struct thread_cache *cache = thread_cache;
+	if (cache)
+		return cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	pthread_mutex_lock(&pool_mutex);
+	cache->next = first_cache;
+	cache->prev_next = &first_cache;
+	if (first_cache)
+		first_cache->prev_next = &cache->next;
+	first_cache = cache;
+	pthread_mutex_unlock(&pool_mutex);
+
+	pthread_setspecific(cache_key, cache);
+	thread_cache = cache;
+	return cache;
+}
+
+static bool reserve_arena(void)
+{
+#ifdef _WIN32
+	pool_arena = VirtualAlloc(NULL, POOL_ARENA_SIZE, MEM_RESERVE, PAGE_NOACCESS);
+	return pool_arena != NULL;
+#else
+	void *arena = mmap(NULL, POOL_ARENA_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (arena == MAP_FAILED)
+		return false;
+
+	pool_arena = arena;
+	return true;
+#endif
+}
+
+static uint8_t *new_slab(size_t class_idx)
+{
+	uint8_t *slab;
+
+	pthread_mutex_lock(&pool_mutex);
+	if (num_slabs == POOL_NUM_SLABS) {
+		pthread_mutex_unlock(&pool_mutex);
+		return NULL;
+	}
+
+	slab = pool_arena + num_slabs * POOL_SLAB_SIZE;
+
+#ifdef _WIN32
+	bool success = VirtualAlloc(slab, POOL_SLAB_SIZE, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	bool success = mprotect(slab, POOL_SLAB_SIZE, PROT_READ | PROT_WRITE) == 0;
+#endif
+	if (success)
+		slab_classes[num_slabs++] = (uint8_t)class_idx;
+	pthread_mutex_unlock(&pool_mutex);
+
+	return success ? slab : NULL;
+}
+
+/* moves up to half a magazine worth of chunks from the depot, or new chunks
+ * if the depot is empty, into a thread's magazine */
+static bool refill_magazine(struct thread_cache *cache, size_t class_idx)
+{
+	struct magazine *mag = &cache->magazines[class_idx];
+	struct size_class *sc = &classes[class_idx];
+	size_t size = class_sizes[class_idx];
+	size_t want = magazine_sizes[class_idx] / 2;
+	bool carved = false;
+
+	pthread_mutex_lock(&sc->mutex);
+
+	while (sc->depot && mag->count < want) {
+		struct pool_chunk *chunk = sc->depot;
+		sc->depot = chunk->next;
+		sc->depot_count--;
+
+		chunk->next = mag->chunks;
+		mag->chunks = chunk;
+		mag->count++;
+	}
+
+	if (!mag->count) {
+		if (sc->slab_pos == sc->slab_end) {
+			uint8_t *slab = new_slab(class_idx);
+			if (slab) {
+				sc->slab_pos = slab;
+				sc->slab_end = slab + POOL_SLAB_SIZE / size * size;
+			}
+		}
+
+		while (sc->slab_pos != sc->slab_end && mag->count < want) {
+			struct pool_chunk *chunk = (struct pool_chunk *)sc->slab_pos;
+			sc->slab_pos += size;
+			sc->carved_bytes += size;
+
+			chunk->next = mag->chunks;
+			mag->chunks = chunk;
+			mag->count++;
+		}
+
+		carved = true;
+	}
+
+	pthread_mutex_unlock(&sc->mutex);
+
+	if (carved)
+		cache->misses++;
+	else
+		cache->hits++;
+	return mag->count != 0;
+}
+
+static void *pool_alloc(size_t size)
+{
+	size_t class_idx = get_size_class(size);
+	struct thread_cache *cache = get_thread_cache();
+	if (!cache)
+		return NULL;
+
+	struct magazine *mag = &cache->magazines[class_idx];
+	if (mag->count) {
+		cache->hits++;
+	} else if (!refill_magazine(cache, class_idx)) {
+		return NULL;
+	}
+
+	struct pool_chunk *chunk = mag->chunks;
+	mag->chunks = chunk->next;
+	mag->count--;
+
+	cache->used_bytes += (int64_t)class_sizes[class_idx];
+	return chunk;
+}
+
+static void pool_free(void *ptr)
+{
+	size_t class_idx = get_ptr_class(ptr);
+	struct pool_chunk *chunk = ptr;
+	struct thread_cache *cache = get_thread_cache();
+	struct size_class *sc = &classes[class_idx];
+
+	if (!cache) {
+		pthread_mutex_lock(&sc->mutex);
+		chunk->next = sc->depot;
+		sc->depot = chunk;
+		sc->depot_count++;
+		pthread_mutex_unlock(&sc->mutex);
+		return;
+	}
+
+	struct magazine *mag = &cache->magazines[class_idx];
+	chunk->next = mag->chunks;
+	mag->chunks = chunk;
+	mag->count++;
+	cache->used_bytes -= (int64_t)class_sizes[class_idx];
+
+	if (mag->count <= magazine_sizes[class_idx])
+		return;
+
+	/* full, give the older half to the depot */
+	size_t keep = magazine_sizes[class_idx] / 2;
+	struct pool_chunk *last = mag->chunks;
+	for (size_t i = 1; i < keep; i++)
+		last = last->next;
+
+	struct pool_chunk *excess = last->next;
+	struct pool_chunk *excess_last = excess;
+	size_t excess_count = mag->count - keep;
+	while (excess_last->next)
+		excess_last = excess_last->next;
+
+	last->next = NULL;
+	mag->count = keep;
+
+	pthread_mutex_lock(&sc->mutex);
+	excess_last->next = sc->depot;
+	sc->depot = excess;
+	sc->depot_count += excess_count;
+	pthread_mutex_unlock(&sc->mutex);
+}
+
+static bool init_pool(void)
+{
+	if (pool_arena)
+		return true;
+
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		size_t size;
+		if (i < 4) {
+			size = (i + 1) * 32;
+		} else {
+			size_t bit = 7 + (i - 4) / 4;
+			size = ((size_t)1 << bit) + ((i - 4) % 4 + 1) * ((size_t)1 << (bit - 2));
+		}
+
+		size_t mag_size = POOL_MAGAZINE_BYTES / size;
+		if (mag_size > POOL_MAGAZINE_MAX)
+			mag_size = POOL_MAGAZINE_MAX;
+		if (mag_size < 2)
+			mag_size = 2;
+
+		class_sizes[i] = size;
+		magazine_sizes[i] = mag_size;
+		pthread_mutex_init(&classes[i].mutex, NULL);
+	}
+
+	if (pthread_key_create(&cache_key, flush_thread_cache) != 0)
+		return false;
+
+	if (!reserve_arena()) {
+		pthread_key_delete(cache_key);
+		return false;
+	}
+
+	return true;
+}
+
+void bmem_set_pool_enabled(bool enable)
+{
+	pthread_mutex_lock(&pool_mutex);
+	if (enable && !init_pool())
+		enable = false;
+	os_atomic_set_bool(&pool_enabled, enable);
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+void bmem_get_stats(struct bmem_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->pool_enabled = os_atomic_load_bool(&pool_enabled);
+
+	if (!pool_arena)
+		return;
+
+	int64_t used_bytes;
+	uint64_t carved_bytes = 0;
+
+	for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+		pthread_mutex_lock(&classes[i].mutex);
+		carved_bytes += classes[i].carved_bytes;
+		pthread_mutex_unlock(&classes[i].mutex);
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	stats->pool_hits = dead_hits;
+	stats->pool_misses = dead_misses;
+	used_bytes = dead_used_bytes;
+
+	for (struct thread_cache *cache = first_cache; cache; cache = cache->next) {
+		stats->pool_hits += cache->hits;
+		stats->pool_misses += cache->misses;
+		used_bytes += cache->used_bytes;
+	}
+
+	stats->reserved_bytes = (uint64_t)num_slabs * POOL_SLAB_SIZE;
+	pthread_mutex_unlock(&pool_mutex);
+
+	/* the per-thread counters aren't read atomically, so keep the numbers
+	 * consistent with each other */
+	if (used_bytes < 0)
+		used_bytes = 0;
+	if ((uint64_t)used_bytes > carved_bytes)
+		used_bytes = (int64_t)carved_bytes;
+
+	stats->used_bytes = (uint64_t)used_bytes;
+	stats->cached_bytes = carved_bytes - stats->used_bytes;
+	if (stats->reserved_bytes)
+		stats->fragmentation = 1.0 - (double)stats->used_bytes / (double)stats->reserved_bytes;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static long num_allocs = 0;
 
 void *bmalloc(size_t size)
 {
+	void *ptr = NULL;
+
 	if (!size) {
 		os_breakpoint();
 		bcrash("bmalloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	void *ptr = a_malloc(size);
+	if (size <= POOL_MAX_SIZE && os_atomic_load_bool(&pool_enabled))
+		ptr = pool_alloc(size);
+	if (!ptr)
+		ptr = a_malloc(size);
 
 	if (!ptr) {
 		os_oom();
@@ -126,7 +541,22 @@ void *brealloc(void *ptr, size_t size)
 		bcrash("brealloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	ptr = a_realloc(ptr, size);
+	/* memory that gets reallocated tends to keep growing, so it leaves the
+	 * pool instead of moving through the size classes */
+	if (ptr && is_pool_ptr(ptr)) {
+		size_t old_size = class_sizes[get_ptr_class(ptr)];
+		if (size <= old_size)
+			return ptr;
+
+		void *new_ptr = a_malloc(size);
+		if (new_ptr) {
+			memcpy(new_ptr, ptr, old_size);
+			pool_free(ptr);
+		}
+		ptr = new_ptr;
+	} else {
+		ptr = a_realloc(ptr, size);
+	}
 
 	if (!ptr) {
 		os_oom();
@@ -140,7 +570,10 @@ void bfree(void *ptr)
 {
 	if (ptr) {
 		os_atomic_dec_long(&num_allocs);
-		a_free(ptr);
+		if (is_pool_ptr(ptr))
+			pool_free(ptr);
+		else
+			a_free(ptr);
 	}
 }
 
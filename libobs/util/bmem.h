@@ -41,6 +41,28 @@ EXPORT long bnum_allocs(void);
 
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
+struct bmem_stats {
+	bool pool_enabled;
+
+	/* pool allocations served from cached chunks / from new chunks */
+	uint64_t pool_hits;
+	uint64_t pool_misses;
+
+	/* pool memory taken from the system, memory of chunks currently
+	 * allocated, and of chunks cached for reuse */
+	uint64_t reserved_bytes;
+	uint64_t used_bytes;
+	uint64_t cached_bytes;
+
+	/* share of the reserved memory that isn't allocated */
+	double fragmentation;
+};
+
+/* Serves small allocations from per-thread caches of size classes, meant to be
+ * set at startup.  Disabling it again only stops new pool allocations. */
+EXPORT void bmem_set_pool_enabled(bool enable);
+EXPORT void bmem_get_stats(struct bmem_stats *stats);
+
 static inline void *bzalloc(size_t size)
 {
 	void *mem = bmalloc(size);
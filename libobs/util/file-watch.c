@@ -0,0 +1,404 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "file-watch.h"
+#include "threading.h"
+#include "platform.h"
+#include "darray.h"
+#include "dstr.h"
+#include "bmem.h"
+#include "base.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+#define WATCH_MASK                                                                                        \
+	(IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE | \
+	 IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+#endif
+
+/* how often files are checked when they can't be watched by the OS */
+#define POLL_INTERVAL_MS 1000
+
+/* changes that happen in quick succession (e.g. a file written to in
+ * several chunks) are reported together */
+#define COALESCE_MS 50
+
+struct os_file_watch {
+	char *path;
+	const char *name;
+	os_file_watch_cb_t callback;
+	void *param;
+
+	bool exists;
+	time_t mtime;
+	int64_t size;
+	bool changed;
+
+	/* watch descriptor of the parent directory, -1 if polled */
+	int wd;
+};
+
+static pthread_mutex_t lifecycle_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t watch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t callback_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static DARRAY(struct os_file_watch *) watches;
+static pthread_t watch_thread;
+static bool watch_thread_active = false;
+static os_event_t *stop_event = NULL;
+
+#ifdef __linux__
+static int inotify_fd = -1;
+static int wake_fd = -1;
+#endif
+
+/* returns whether the file changed since it was last checked */
+static bool update_file_state(struct os_file_watch *watch)
+{
+	struct stat st;
+	bool exists = os_stat(watch->path, &st) == 0;
+	time_t mtime = exists ? st.st_mtime : 0;
+	int64_t size = exists ? (int64_t)st.st_size : 0;
+
+	bool changed = exists != watch->exists || mtime != watch->mtime || size != watch->size;
+
+	watch->exists = exists;
+	watch->mtime = mtime;
+	watch->size = size;
+	return changed;
+}
+
+static void poll_files(void)
+{
+	pthread_mutex_lock(&watch_mutex);
+
+	for (size_t i = 0; i < watches.num; i++) {
+		struct os_file_watch *watch = watches.array[i];
+		if (watch->wd == -1 && update_file_state(watch))
+			watch->changed = true;
+	}
+
+	pthread_mutex_unlock(&watch_mutex);
+}
+
+#ifdef __linux__
+static void add_os_watch(struct os_file_watch *watch)
+{
+	struct dstr dir = {0};
+	const char *slash = strrchr(watch->path, '/');
+
+	watch->name = slash ? slash + 1 : watch->path;
+	watch->wd = -1;
+
+	if (inotify_fd == -1 || !*watch->name)
+		return;
+
+	if (slash == watch->path)
+		dstr_copy(&dir, "/");
+	else if (slash)
+		dstr_ncopy(&dir, watch->path, slash - watch->path);
+	else
+		dstr_copy(&dir, ".");
+
+	watch->wd = inotify_add_watch(inotify_fd, dir.array, WATCH_MASK);
+	if (watch->wd == -1)
+		blog(LOG_DEBUG, "os_file_watch: Couldn't watch '%s' (errno %d), polling '%s' instead", dir.array, errno,
+		     watch->path);
+
+	dstr_free(&dir);
+}
+
+static void remove_os_watch(struct os_file_watch *watch)
+{
+	if (watch->wd == -1)
+		return;
+
+	/* files in the same directory share the same watch */
+	for (size_t i = 0; i < watches.num; i++) {
+		if (watches.array[i]->wd == watch->wd)
+			return;
+	}
+
+	inotify_rm_watch(inotify_fd, watch->wd);
+}
+
+static void handle_event(const struct inotify_event *event)
+{
+	for (size_t i = 0; i < watches.num; i++) {
+		struct os_file_watch *watch = watches.array[i];
+		if (watch->wd != event->wd)
+			continue;
+
+		if (event->mask & IN_IGNORED) {
+			/* the directory is gone, so poll the file from now on
+			 * until it (and the directory) might come back */
+			watch->wd = -1;
+			watch->changed = true;
+		} else if (!event->len || strcmp(event->name, watch->name) == 0) {
+			watch->changed = true;
+		}
+	}
+}
+
+static bool read_events(void)
+{
+	char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	bool received = false;
+
+	for (;;) {
+		ssize_t len = read(inotify_fd, buf, sizeof(buf));
+		if (len <= 0)
+			break;
+
+		pthread_mutex_lock(&watch_mutex);
+		for (char *ptr = buf; ptr < buf + len;) {
+			const struct inotify_event *event = (const struct inotify_event *)ptr;
+			handle_event(event);
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+		pthread_mutex_unlock(&watch_mutex);
+
+		received = true;
+	}
+
+	return received;
+}
+
+static void wait_for_changes(void)
+{
+	if (inotify_fd == -1) {
+		os_event_timedwait(stop_event, POLL_INTERVAL_MS);
+		return;
+	}
+
+	struct pollfd fds[2] = {{.fd = inotify_fd, .events = POLLIN}, {.fd = wake_fd, .events = POLLIN}};
+	if (poll(fds, 2, POLL_INTERVAL_MS) > 0 && (fds[0].revents & POLLIN)) {
+		if (read_events() && os_event_timedwait(stop_event, COALESCE_MS) == ETIMEDOUT)
+			read_events();
+	}
+}
+
+static bool init_os_watcher(void)
+{
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotify_fd == -1) {
+		blog(LOG_WARNING, "os_file_watch: inotify_init1 failed (errno %d), polling files instead", errno);
+		return true;
+	}
+
+	wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wake_fd == -1) {
+		close(inotify_fd);
+		inotify_fd = -1;
+		return false;
+	}
+
+	return true;
+}
+
+static void free_os_watcher(void)
+{
+	if (inotify_fd != -1)
+		close(inotify_fd);
+	if (wake_fd != -1)
+		close(wake_fd);
+	inotify_fd = -1;
+	wake_fd = -1;
+}
+
+static void wake_os_watcher(void)
+{
+	if (wake_fd != -1)
+		eventfd_write(wake_fd, 1);
+}
+#else
+static void add_os_watch(struct os_file_watch *watch)
+{
+	watch->wd = -1;
+}
+
+static void remove_os_watch(struct os_file_watch *watch)
+{
+	UNUSED_PARAMETER(watch);
+}
+
+static void wait_for_changes(void)
+{
+	os_event_timedwait(stop_event, POLL_INTERVAL_MS);
+}
+
+static bool init_os_watcher(void)
+{
+	return true;
+}
+
+static void free_os_watcher(void) {}
+
+static void wake_os_watcher(void) {}
+#endif
+
+static void dispatch_changes(void)
+{
+	DARRAY(struct os_file_watch *) changed;
+	da_init(changed);
+
+	/* callbacks are called outside of the watch mutex so the list can
+	 * still be changed, but os_file_watch_destroy waits for them */
+	pthread_mutex_lock(&callback_mutex);
+
+	pthread_mutex_lock(&watch_mutex);
+	for (size_t i = 0; i < watches.num; i++) {
+		struct os_file_watch *watch = watches.array[i];
+		if (watch->changed) {
+			watch->changed = false;
+			da_push_back(changed, &watch);
+		}
+	}
+	pthread_mutex_unlock(&watch_mutex);
+
+	for (size_t i = 0; i < changed.num; i++) {
+		struct os_file_watch *watch = changed.array[i];
+		watch->callback(watch->param, watch->path);
+	}
+
+	pthread_mutex_unlock(&callback_mutex);
+
+	da_free(changed);
+}
+
+static void *file_watch_thread(void *unused)
+{
+	uint64_t last_poll = os_gettime_ns();
+
+	os_set_thread_name("file watch thread");
+
+	for (;;) {
+		wait_for_changes();
+
+		if (os_event_try(stop_event) != EAGAIN)
+			break;
+
+		uint64_t now = os_gettime_ns();
+		if (now - last_poll >= POLL_INTERVAL_MS * 1000000ULL) {
+			poll_files();
+			last_poll = now;
+		}
+
+		dispatch_changes();
+	}
+
+	UNUSED_PARAMETER(unused);
+	return NULL;
+}
+
+static bool start_watch_thread(void)
+{
+	if (os_event_init(&stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+	if (!init_os_watcher())
+		goto fail;
+	if (pthread_create(&watch_thread, NULL, file_watch_thread, NULL) != 0)
+		goto fail;
+
+	watch_thread_active = true;
+	return true;
+
+fail:
+	free_os_watcher();
+	os_event_destroy(stop_event);
+	stop_event = NULL;
+	return false;
+}
+
+static void stop_watch_thread(void)
+{
+	os_event_signal(stop_event);
+	wake_os_watcher();
+	pthread_join(watch_thread, NULL);
+
+	free_os_watcher();
+	os_event_destroy(stop_event);
+	stop_event = NULL;
+	da_free(watches);
+	watch_thread_active = false;
+}
+
+os_file_watch_t *os_file_watch_create(const char *path, os_file_watch_cb_t callback, void *param)
+{
+	struct os_file_watch *watch;
+
+	if (!path || !*path || !callback)
+		return NULL;
+
+	watch = bzalloc(sizeof(*watch));
+	watch->path = bstrdup(path);
+	watch->callback = callback;
+	watch->param = param;
+	update_file_state(watch);
+
+	pthread_mutex_lock(&lifecycle_mutex);
+
+	if (!watch_thread_active && !start_watch_thread()) {
+		pthread_mutex_unlock(&lifecycle_mutex);
+		blog(LOG_WARNING, "os_file_watch: Failed to start watch thread");
+		bfree(watch->path);
+		bfree(watch);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&watch_mutex);
+	add_os_watch(watch);
+	da_push_back(watches, &watch);
+	pthread_mutex_unlock(&watch_mutex);
+
+	pthread_mutex_unlock(&lifecycle_mutex);
+	return watch;
+}
+
+void os_file_watch_destroy(os_file_watch_t *watch)
+{
+	if (!watch)
+		return;
+
+	pthread_mutex_lock(&lifecycle_mutex);
+
+	pthread_mutex_lock(&watch_mutex);
+	da_erase_item(watches, &watch);
+	remove_os_watch(watch);
+	bool last = watches.num == 0;
+	pthread_mutex_unlock(&watch_mutex);
+
+	/* wait for the callback in case it's currently being called */
+	pthread_mutex_lock(&callback_mutex);
+	pthread_mutex_unlock(&callback_mutex);
+
+	if (last)
+		stop_watch_thread();
+
+	pthread_mutex_unlock(&lifecycle_mutex);
+
+	bfree(watch->path);
+	bfree(watch);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ * File change notifications
+ *
+ *   Notifies about changes to files without having to poll them from the
+ * caller's thread.  Uses inotify where available, and checks modification
+ * times and sizes once a second otherwise, or if a file's directory cannot be
+ * watched.  Callbacks are called from a shared watcher thread, and a watched
+ * file does not have to exist.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_file_watch;
+typedef struct os_file_watch os_file_watch_t;
+
+typedef void (*os_file_watch_cb_t)(void *param, const char *path);
+
+EXPORT os_file_watch_t *os_file_watch_create(const char *path, os_file_watch_cb_t callback, void *param);
+
+/* Once this returns the callback is guaranteed not to be running anymore.
+ * Watches must not be created or destroyed from within a callback. */
+EXPORT void os_file_watch_destroy(os_file_watch_t *watch);
+
+#ifdef __cplusplus
+}
+#endif
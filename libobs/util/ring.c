@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "ring.h"
+#include "bmem.h"
+
+/* producer and consumer state are kept on separate cache lines so that the
+ * two sides don't keep invalidating each other's cache */
+#define CACHE_LINE_SIZE 64
+#define PAD(size) char pad_##size[CACHE_LINE_SIZE - sizeof(long)]
+
+/* indices count up forever and wrap around, so they are always compared by
+ * their difference */
+static inline long index_diff(long a, long b)
+{
+	return (long)((unsigned long)a - (unsigned long)b);
+}
+
+static inline long index_add(long a, size_t b)
+{
+	return (long)((unsigned long)a + (unsigned long)b);
+}
+
+static inline size_t round_capacity(size_t capacity)
+{
+	size_t size = 2;
+	while (size < capacity)
+		size <<= 1;
+	return size;
+}
+
+/* ------------------------------------------------------------------------- */
+/* single producer, single consumer                                          */
+
+struct os_spsc_ring {
+	/* written by the producer */
+	volatile long tail;
+	PAD(tail);
+
+	/* written by the consumer */
+	volatile long head;
+	PAD(head);
+
+	/* each side's last known position of the other side, to avoid reading
+	 * the other side's cache line on every push/pop */
+	long cached_head;
+	PAD(cached_head);
+	long cached_tail;
+	PAD(cached_tail);
+
+	size_t element_size;
+	size_t mask;
+	uint8_t *data;
+};
+
+os_spsc_ring_t *os_spsc_ring_create(size_t element_size, size_t capacity)
+{
+	struct os_spsc_ring *ring;
+
+	if (!element_size || !capacity)
+		return NULL;
+
+	ring = bzalloc(sizeof(*ring));
+	ring->element_size = element_size;
+	ring->mask = round_capacity(capacity) - 1;
+	ring->data = bmalloc(element_size * (ring->mask + 1));
+	return ring;
+}
+
+void os_spsc_ring_destroy(os_spsc_ring_t *ring)
+{
+	if (!ring)
+		return;
+
+	bfree(ring->data);
+	bfree(ring);
+}
+
+bool os_spsc_ring_push(os_spsc_ring_t *ring, const void *data)
+{
+	const long tail = ring->tail;
+
+	if ((size_t)index_diff(tail, ring->cached_head) > ring->mask) {
+		ring->cached_head = os_atomic_load_long(&ring->head);
+		if ((size_t)index_diff(tail, ring->cached_head) > ring->mask)
+			return false;
+	}
+
+	memcpy(ring->data + ((unsigned long)tail & ring->mask) * ring->element_size, data, ring->element_size);
+	os_atomic_set_long(&ring->tail, index_add(tail, 1));
+	return true;
+}
+
+bool os_spsc_ring_pop(os_spsc_ring_t *ring, void *data)
+{
+	const long head = ring->head;
+
+	if (head == ring->cached_tail) {
+		ring->cached_tail = os_atomic_load_long(&ring->tail);
+		if (head == ring->cached_tail)
+			return false;
+	}
+
+	memcpy(data, ring->data + ((unsigned long)head & ring->mask) * ring->element_size, ring->element_size);
+	os_atomic_set_long(&ring->head, index_add(head, 1));
+	return true;
+}
+
+size_t os_spsc_ring_size(os_spsc_ring_t *ring)
+{
+	long head = os_atomic_load_long(&ring->head);
+	long tail = os_atomic_load_long(&ring->tail);
+	return (size_t)index_diff(tail, head);
+}
+
+size_t os_spsc_ring_capacity(os_spsc_ring_t *ring)
+{
+	return ring->mask + 1;
+}
+
+/* ------------------------------------------------------------------------- */
+/* multiple producers, single consumer                                       */
+
+/* Each slot has a sequence number that tells whether it's free to be written
+ * for a given position (seq == pos) or ready to be read (seq == pos + 1).
+ * Producers claim positions by advancing the tail with a compare-and-swap. */
+
+struct os_mpsc_ring {
+	/* claimed by producers */
+	volatile long tail;
+	PAD(tail);
+
+	/* owned by the consumer */
+	volatile long head;
+	PAD(head);
+
+	size_t element_size;
+	size_t slot_size;
+	size_t mask;
+	uint8_t *slots;
+};
+
+static inline volatile long *slot_seq(struct os_mpsc_ring *ring, long pos)
+{
+	return (volatile long *)(ring->slots + ((unsigned long)pos & ring->mask) * ring->slot_size);
+}
+
+static inline uint8_t *slot_data(struct os_mpsc_ring *ring, long pos)
+{
+	return (uint8_t *)slot_seq(ring, pos) + sizeof(long);
+}
+
+os_mpsc_ring_t *os_mpsc_ring_create(size_t element_size, size_t capacity)
+{
+	struct os_mpsc_ring *ring;
+
+	if (!element_size || !capacity)
+		return NULL;
+
+	ring = bzalloc(sizeof(*ring));
+	ring->element_size = element_size;
+	ring->slot_size = (sizeof(long) + element_size + sizeof(long) - 1) & ~(sizeof(long) - 1);
+	ring->mask = round_capacity(capacity) - 1;
+	ring->slots = bmalloc(ring->slot_size * (ring->mask + 1));
+
+	for (size_t i = 0; i <= ring->mask; i++)
+		*slot_seq(ring, (long)i) = (long)i;
+
+	return ring;
+}
+
+void os_mpsc_ring_destroy(os_mpsc_ring_t *ring)
+{
+	if (!ring)
+		return;
+
+	bfree(ring->slots);
+	bfree(ring);
+}
+
+bool os_mpsc_ring_push(os_mpsc_ring_t *ring, const void *data)
+{
+	long pos = os_atomic_load_long(&ring->tail);
+
+	for (;;) {
+		long seq = os_atomic_load_long(slot_seq(ring, pos));
+		long diff = index_diff(seq, pos);
+
+		if (diff == 0) {
+			if (os_atomic_compare_exchange_long(&ring->tail, &pos, index_add(pos, 1)))
+				break;
+		} else if (diff < 0) {
+			/* the slot from one lap ago hasn't been read yet */
+			return false;
+		} else {
+			pos = os_atomic_load_long(&ring->tail);
+		}
+	}
+
+	memcpy(slot_data(ring, pos), data, ring->element_size);
+	os_atomic_set_long(slot_seq(ring, pos), index_add(pos, 1));
+	return true;
+}
+
+bool os_mpsc_ring_pop(os_mpsc_ring_t *ring, void *data)
+{
+	const long head = ring->head;
+	long seq = os_atomic_load_long(slot_seq(ring, head));
+
+	/* not written yet, either empty or a producer is still copying */
+	if (seq != index_add(head, 1))
+		return false;
+
+	memcpy(data, slot_data(ring, head), ring->element_size);
+	os_atomic_set_long(slot_seq(ring, head), index_add(head, ring->mask + 1));
+	os_atomic_set_long(&ring->head, index_add(head, 1));
+	return true;
+}
+
+size_t os_mpsc_ring_size(os_mpsc_ring_t *ring)
+{
+	long head = os_atomic_load_long(&ring->head);
+	long tail = os_atomic_load_long(&ring->tail);
+	long size = index_diff(tail, head);
+	return size > 0 ? (size_t)size : 0;
+}
+
+size_t os_mpsc_ring_capacity(os_mpsc_ring_t *ring)
+{
+	return ring->mask + 1;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int os_ring_waiter_init(struct os_ring_waiter *waiter)
+{
+	waiter->sleeping = 0;
+	return os_event_init(&waiter->event, OS_EVENT_TYPE_AUTO);
+}
+
+void os_ring_waiter_free(struct os_ring_waiter *waiter)
+{
+	os_event_destroy(waiter->event);
+	waiter->event = NULL;
+}
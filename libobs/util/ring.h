@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+
+#pragma once
+
+#include "c99defs.h"
+#include "threading.h"
+
+/*
+ * Lock-free ring buffers
+ *
+ *   Bounded, fixed element size queues for handing data between threads
+ * without a mutex.  os_spsc_ring_t allows one producer and one consumer
+ * thread, os_mpsc_ring_t allows any number of producers and one consumer.
+ * Pushing fails if the ring is full, popping fails if it is empty.
+ *
+ *   A consumer that needs to sleep while a ring is empty can use
+ * struct os_ring_waiter: producers call os_ring_waiter_notify after pushing,
+ * which only signals when the consumer is actually waiting.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct os_spsc_ring;
+typedef struct os_spsc_ring os_spsc_ring_t;
+
+struct os_mpsc_ring;
+typedef struct os_mpsc_ring os_mpsc_ring_t;
+
+/* capacity is rounded up to a power of two */
+EXPORT os_spsc_ring_t *os_spsc_ring_create(size_t element_size, size_t capacity);
+EXPORT void os_spsc_ring_destroy(os_spsc_ring_t *ring);
+EXPORT bool os_spsc_ring_push(os_spsc_ring_t *ring, const void *data);
+EXPORT bool os_spsc_ring_pop(os_spsc_ring_t *ring, void *data);
+EXPORT size_t os_spsc_ring_size(os_spsc_ring_t *ring);
+EXPORT size_t os_spsc_ring_capacity(os_spsc_ring_t *ring);
+
+EXPORT os_mpsc_ring_t *os_mpsc_ring_create(size_t element_size, size_t capacity);
+EXPORT void os_mpsc_ring_destroy(os_mpsc_ring_t *ring);
+EXPORT bool os_mpsc_ring_push(os_mpsc_ring_t *ring, const void *data);
+EXPORT bool os_mpsc_ring_pop(os_mpsc_ring_t *ring, void *data);
+EXPORT size_t os_mpsc_ring_size(os_mpsc_ring_t *ring);
+EXPORT size_t os_mpsc_ring_capacity(os_mpsc_ring_t *ring);
+
+/* ------------------------------------------------------------------------- */
+
+struct os_ring_waiter {
+	volatile long sleeping;
+	os_event_t *event;
+};
+
+EXPORT int os_ring_waiter_init(struct os_ring_waiter *waiter);
+EXPORT void os_ring_waiter_free(struct os_ring_waiter *waiter);
+
+/* The consumer announces that it's about to sleep, then checks everything it
+ * waits for once more, and either cancels or waits:
+ *
+ *   while (!os_spsc_ring_pop(ring, &item)) {
+ *           os_ring_waiter_prepare(&waiter);
+ *           if (os_spsc_ring_size(ring)) {
+ *                   os_ring_waiter_cancel(&waiter);
+ *                   continue;
+ *           }
+ *           os_ring_waiter_wait(&waiter);
+ *   }
+ */
+static inline void os_ring_waiter_prepare(struct os_ring_waiter *waiter)
+{
+	os_atomic_set_long(&waiter->sleeping, 1);
+}
+
+static inline void os_ring_waiter_cancel(struct os_ring_waiter *waiter)
+{
+	os_atomic_set_long(&waiter->sleeping, 0);
+}
+
+static inline void os_ring_waiter_wait(struct os_ring_waiter *waiter)
+{
+	os_event_wait(waiter->event);
+	os_atomic_set_long(&waiter->sleeping, 0);
+}
+
+/* called by producers after pushing, cheap if the consumer isn't asleep */
+static inline void os_ring_waiter_notify(struct os_ring_waiter *waiter)
+{
+	if (os_atomic_load_long(&waiter->sleeping) && os_atomic_compare_swap_long(&waiter->sleeping, 1, 0))
+		os_event_signal(waiter->event);
+}
+
+/* wakes the consumer regardless, e.g. to make it check for a stop request */
+static inline void os_ring_waiter_wake(struct os_ring_waiter *waiter)
+{
+	os_event_signal(waiter->event);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -69,6 +69,9 @@ struct profiler_entry {
 	struct ucirclebuf async_frame_ts;
 	/* Timestamps of last N async frames rendered */
 	struct ucirclebuf async_rendered_ts;
+	/* Timestamps of last N async frames the source dropped or delivered late */
+	struct ucirclebuf async_dropped_ts;
+	struct ucirclebuf async_late_ts;
 
 	UT_hash_handle hh;
 };
@@ -174,6 +177,8 @@ static struct profiler_entry *entry_create(const uintptr_t key)
 	ucirclebuf_init(&ent->render_gpu_sum, profiler_samples);
 	ucirclebuf_init(&ent->async_frame_ts, profiler_samples);
 	ucirclebuf_init(&ent->async_rendered_ts, profiler_samples);
+	ucirclebuf_init(&ent->async_dropped_ts, profiler_samples);
+	ucirclebuf_init(&ent->async_late_ts, profiler_samples);
 	return ent;
 }
 
@@ -186,6 +191,8 @@ static void entry_destroy(struct profiler_entry *entry)
 	ucirclebuf_free(&entry->render_gpu_sum);
 	ucirclebuf_free(&entry->async_frame_ts);
 	ucirclebuf_free(&entry->async_rendered_ts);
+	ucirclebuf_free(&entry->async_dropped_ts);
+	ucirclebuf_free(&entry->async_late_ts);
 	bfree(entry);
 }
 
@@ -412,6 +419,33 @@ void source_profiler_async_frame_received(obs_source_t *source)
 	pthread_rwlock_unlock(&hm_rwlock);
 }
 
+static void async_frame_event(obs_source_t *source, bool late)
+{
+	if (!enabled)
+		return;
+
+	uint64_t ts = os_gettime_ns();
+
+	pthread_rwlock_wrlock(&hm_rwlock);
+
+	struct profiler_entry *ent;
+	HASH_FIND_PTR(hm_entries, &source, ent);
+	if (ent)
+		ucirclebuf_push(late ? &ent->async_late_ts : &ent->async_dropped_ts, ts);
+
+	pthread_rwlock_unlock(&hm_rwlock);
+}
+
+void source_profiler_async_frame_dropped(obs_source_t *source)
+{
+	async_frame_event(source, false);
+}
+
+void source_profiler_async_frame_late(obs_source_t *source)
+{
+	async_frame_event(source, true);
+}
+
 uint64_t source_profiler_source_tick_start(void)
 {
 	if (!enabled)
@@ -420,13 +454,11 @@ uint64_t source_profiler_source_tick_start(void)
 	return os_gettime_ns();
 }
 
-void source_profiler_source_tick_end(obs_source_t *source, uint64_t start)
+void source_profiler_source_tick_time(obs_source_t *source, uint64_t delta)
 {
 	if (!enabled)
 		return;
 
-	const uint64_t delta = os_gettime_ns() - start;
-
 	struct source_samples *smp = NULL;
 	HASH_FIND_PTR(hm_samples, &source, smp);
 	if (!smp) {
@@ -591,6 +623,21 @@ static inline void calculate_fps(const struct ucirclebuf *frames, double *avg, u
 	}
 }
 
+/* Number of events within the sampled timeframe */
+static inline uint64_t count_events(const struct ucirclebuf *events, uint64_t now)
+{
+	const uint64_t timeframe = 5000000000ULL;
+	uint64_t count = 0;
+
+	for (size_t idx = 0; idx < events->num; idx++) {
+		const uint64_t ts = events->array[idx];
+		if (ts && now - ts <= timeframe)
+			count++;
+	}
+
+	return count;
+}
+
 bool source_profiler_fill_result(obs_source_t *source, struct profiler_result *result)
 {
 	if (!enabled || !result)
@@ -619,6 +666,33 @@ bool source_profiler_fill_result(obs_source_t *source, struct profiler_result *r
 	return !!ent;
 }
 
+bool source_profiler_get_async_drops(obs_source_t *source, uint64_t *dropped, uint64_t *late)
+{
+	if (dropped)
+		*dropped = 0;
+	if (late)
+		*late = 0;
+
+	if (!enabled || !source || !is_async_video_source(source))
+		return false;
+
+	pthread_rwlock_rdlock(&hm_rwlock);
+
+	struct profiler_entry *ent = NULL;
+	HASH_FIND_PTR(hm_entries, &source, ent);
+	if (ent) {
+		const uint64_t now = os_gettime_ns();
+		if (dropped)
+			*dropped = count_events(&ent->async_dropped_ts, now);
+		if (late)
+			*late = count_events(&ent->async_late_ts, now);
+	}
+
+	pthread_rwlock_unlock(&hm_rwlock);
+
+	return !!ent;
+}
+
 profiler_result_t *source_profiler_get_result(obs_source_t *source)
 {
 	profiler_result_t *ret = bmalloc(sizeof(profiler_result_t));
@@ -56,10 +56,17 @@ EXPORT void source_profiler_enable(bool enable);
 /* Enable/disable GPU profiling (applied on next frame) */
 EXPORT void source_profiler_gpu_enable(bool enable);
 
+/* Report async frames the source had to drop or delivered late, for
+ * sources that process frames before outputting them */
+EXPORT void source_profiler_async_frame_dropped(obs_source_t *source);
+EXPORT void source_profiler_async_frame_late(obs_source_t *source);
+
 /* Get latest profiling results for source (must be freed by user) */
 EXPORT profiler_result_t *source_profiler_get_result(obs_source_t *source);
 /* Update existing profiler results object for source */
 EXPORT bool source_profiler_fill_result(obs_source_t *source, profiler_result_t *result);
+/* Get async frames dropped or delivered late by the source itself */
+EXPORT bool source_profiler_get_async_drops(obs_source_t *source, uint64_t *dropped, uint64_t *late);
 
 #ifdef __cplusplus
 }
@@ -2,18 +2,26 @@
 #include "bmem.h"
 #include "threading.h"
 #include "deque.h"
+#include "ring.h"
+
+#define TASK_RING_SIZE 1024
 
 struct os_task_queue {
 	pthread_t thread;
-	os_sem_t *sem;
+	struct os_ring_waiter waiter;
 	long id;
 
-	bool waiting;
-	bool tasks_processed;
+	volatile bool waiting;
+	volatile bool tasks_processed;
 	os_event_t *wait_event;
 
-	pthread_mutex_t mutex;
-	struct deque tasks;
+	os_mpsc_ring_t *tasks;
+
+	/* tasks that didn't fit into the ring, they are queued here until the
+	 * thread has caught up so that tasks stay in order */
+	pthread_mutex_t overflow_mutex;
+	volatile bool overflowing;
+	struct deque overflow;
 };
 
 struct os_task_info {
@@ -32,9 +40,11 @@ os_task_queue_t *os_task_queue_create(void)
 	struct os_task_queue *tq = bzalloc(sizeof(*tq));
 	tq->id = os_atomic_inc_long(&thread_id_counter);
 
-	if (pthread_mutex_init(&tq->mutex, NULL) != 0)
+	tq->tasks = os_mpsc_ring_create(sizeof(struct os_task_info), TASK_RING_SIZE);
+
+	if (pthread_mutex_init(&tq->overflow_mutex, NULL) != 0)
 		goto fail1;
-	if (os_sem_init(&tq->sem, 0) != 0)
+	if (os_ring_waiter_init(&tq->waiter) != 0)
 		goto fail2;
 	if (os_event_init(&tq->wait_event, OS_EVENT_TYPE_AUTO) != 0)
 		goto fail3;
@@ -46,14 +56,68 @@ os_task_queue_t *os_task_queue_create(void)
 fail4:
 	os_event_destroy(tq->wait_event);
 fail3:
-	os_sem_destroy(tq->sem);
+	os_ring_waiter_free(&tq->waiter);
 fail2:
-	pthread_mutex_destroy(&tq->mutex);
+	pthread_mutex_destroy(&tq->overflow_mutex);
 fail1:
+	os_mpsc_ring_destroy(tq->tasks);
 	bfree(tq);
 	return NULL;
 }
 
+static void push_task(os_task_queue_t *tq, struct os_task_info *ti)
+{
+	if (os_atomic_load_bool(&tq->overflowing) || !os_mpsc_ring_push(tq->tasks, ti)) {
+		pthread_mutex_lock(&tq->overflow_mutex);
+		deque_push_back(&tq->overflow, ti, sizeof(*ti));
+		os_atomic_set_bool(&tq->overflowing, true);
+		pthread_mutex_unlock(&tq->overflow_mutex);
+	}
+
+	os_ring_waiter_notify(&tq->waiter);
+}
+
+static bool pop_task(os_task_queue_t *tq, struct os_task_info *ti)
+{
+	bool success = false;
+
+	if (os_mpsc_ring_pop(tq->tasks, ti))
+		return true;
+	if (!os_atomic_load_bool(&tq->overflowing))
+		return false;
+
+	/* tasks only go to the overflow queue while it's in use, so once the
+	 * ring is empty it holds the oldest tasks */
+	pthread_mutex_lock(&tq->overflow_mutex);
+	if (tq->overflow.size) {
+		deque_pop_front(&tq->overflow, ti, sizeof(*ti));
+		success = true;
+	}
+	if (!tq->overflow.size)
+		os_atomic_set_bool(&tq->overflowing, false);
+	pthread_mutex_unlock(&tq->overflow_mutex);
+
+	return success;
+}
+
+static inline bool has_tasks(os_task_queue_t *tq)
+{
+	return os_mpsc_ring_size(tq->tasks) || os_atomic_load_bool(&tq->overflowing);
+}
+
+static void wait_for_task(os_task_queue_t *tq, struct os_task_info *ti)
+{
+	while (!pop_task(tq, ti)) {
+		os_ring_waiter_prepare(&tq->waiter);
+		if (has_tasks(tq)) {
+			os_ring_waiter_cancel(&tq->waiter);
+			continue;
+		}
+
+		os_ring_waiter_wait(&tq->waiter);
+	}
+}
+
 bool os_task_queue_queue_task(os_task_queue_t *tq, os_task_t task, void *param)
 {
 	struct os_task_info ti = {
@@ -64,10 +128,7 @@ bool os_task_queue_queue_task(os_task_queue_t *tq, os_task_t task, void *param)
 	if (!tq)
 		return false;
 
-	pthread_mutex_lock(&tq->mutex);
-	deque_push_back(&tq->tasks, &ti, sizeof(ti));
-	pthread_mutex_unlock(&tq->mutex);
-	os_sem_post(tq->sem);
+	push_task(tq, &ti);
 	return true;
 }
 
@@ -91,9 +152,10 @@ void os_task_queue_destroy(os_task_queue_t *tq)
 	os_task_queue_queue_task(tq, stop_thread, NULL);
 	pthread_join(tq->thread, NULL);
 	os_event_destroy(tq->wait_event);
-	os_sem_destroy(tq->sem);
-	pthread_mutex_destroy(&tq->mutex);
-	deque_free(&tq->tasks);
+	os_ring_waiter_free(&tq->waiter);
+	pthread_mutex_destroy(&tq->overflow_mutex);
+	os_mpsc_ring_destroy(tq->tasks);
+	deque_free(&tq->overflow);
 	bfree(tq);
 }
 
@@ -107,20 +169,13 @@ bool os_task_queue_wait(os_task_queue_t *tq)
 		tq,
 	};
 
-	pthread_mutex_lock(&tq->mutex);
-	tq->waiting = true;
-	tq->tasks_processed = false;
-	deque_push_back(&tq->tasks, &ti, sizeof(ti));
-	pthread_mutex_unlock(&tq->mutex);
+	os_atomic_set_bool(&tq->tasks_processed, false);
+	os_atomic_set_bool(&tq->waiting, true);
+	push_task(tq, &ti);
 
-	os_sem_post(tq->sem);
 	os_event_wait(tq->wait_event);
 
-	pthread_mutex_lock(&tq->mutex);
-	bool tasks_processed = tq->tasks_processed;
-	pthread_mutex_unlock(&tq->mutex);
-
-	return tasks_processed;
+	return os_atomic_load_bool(&tq->tasks_processed);
 }
 
 bool os_task_queue_inside(os_task_queue_t *tq)
@@ -135,27 +190,24 @@ static void *tiny_tubular_task_thread(void *param)
 
 	os_set_thread_name(__FUNCTION__);
 
-	while (!exit_thread && os_sem_wait(tq->sem) == 0) {
+	while (!exit_thread) {
 		struct os_task_info ti;
 
-		pthread_mutex_lock(&tq->mutex);
-		deque_pop_front(&tq->tasks, &ti, sizeof(ti));
-		if (tq->tasks.size && ti.task == wait_for_thread) {
-			deque_push_back(&tq->tasks, &ti, sizeof(ti));
-			deque_pop_front(&tq->tasks, &ti, sizeof(ti));
-		}
-		if (tq->tasks.size && ti.task == stop_thread) {
-			deque_push_back(&tq->tasks, &ti, sizeof(ti));
-			deque_pop_front(&tq->tasks, &ti, sizeof(ti));
+		wait_for_task(tq, &ti);
+
+		/* waits and stops go behind tasks that were queued after them */
+		if ((ti.task == wait_for_thread || ti.task == stop_thread) && has_tasks(tq)) {
+			push_task(tq, &ti);
+			continue;
 		}
-		if (tq->waiting) {
+
+		if (os_atomic_load_bool(&tq->waiting)) {
 			if (ti.task == wait_for_thread) {
-				tq->waiting = false;
+				os_atomic_set_bool(&tq->waiting, false);
 			} else {
-				tq->tasks_processed = true;
+				os_atomic_set_bool(&tq->tasks_processed, true);
 			}
 		}
-		pthread_mutex_unlock(&tq->mutex);
 
 		ti.task(ti.param);
 	}
@@ -3,7 +3,7 @@
 #include <util/threading.h>
 #include <util/platform.h>
 #include <util/dstr.h>
-#include <sys/stat.h>
+#include <util/file-watch.h>
 
 #define blog(log_level, format, ...) \
 	blog(log_level, "[image_source: '%s'] " format, obs_source_get_name(context->source), ##__VA_ARGS__)
@@ -19,23 +19,30 @@ struct image_source {
 	bool persistent;
 	bool is_slide;
 	bool linear_alpha;
-	time_t file_timestamp;
-	float update_time_elapsed;
+	os_file_watch_t *file_watch;
+	volatile bool file_changed;
 	uint64_t last_time;
 	bool active;
 	bool restart_gif;
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
 
-	gs_image_file4_t if4;
+	/* still images are shared through the image cache, GIFs are decoded
+	 * by each source as they might be animated */
+	obs_cached_image_t *image;
+	gs_texture_t *cached_texture;
+	gs_image_file5_t if5;
 };
 
-static time_t get_modified_timestamp(const char *filename)
+static inline bool is_gif(const char *file)
 {
-	struct stat stats;
-	if (os_stat(filename, &stats) != 0)
-		return -1;
-	return stats.st_mtime;
+	size_t len = strlen(file);
+	return len > 4 && astrcmpi(file + len - 4, ".gif") == 0;
+}
+
+static inline gs_texture_t *get_texture(struct image_source *context)
+{
+	return context->image ? context->cached_texture : context->if5.image4.image3.image2.image.texture;
 }
 
 static const char *image_source_get_name(void *unused)
@@ -50,9 +57,13 @@ void image_source_preload_image(void *data)
 	if (os_atomic_load_bool(&context->file_decoded))
 		return;
 
-	context->file_timestamp = get_modified_timestamp(context->file);
-	gs_image_file4_init(&context->if4, context->file,
-			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
+	const enum gs_image_alpha_mode alpha_mode = context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB
+									  : GS_IMAGE_ALPHA_PREMULTIPLY;
+
+	if (context->file && !is_gif(context->file))
+		context->image = obs_image_cache_get(context->file, alpha_mode);
+	else
+		gs_image_file5_init(&context->if5, context->file, alpha_mode);
 	os_atomic_set_bool(&context->file_decoded, true);
 }
 
@@ -65,12 +76,14 @@ static void image_source_load_texture(void *data)
 	debug("loading texture '%s'", context->file);
 
 	obs_enter_graphics();
-	gs_image_file4_init_texture(&context->if4);
+	if (context->image)
+		context->cached_texture = obs_cached_image_get_texture(context->image);
+	else
+		gs_image_file5_init_texture(&context->if5);
 	obs_leave_graphics();
 
-	if (!context->if4.image3.image2.image.loaded)
+	if (!get_texture(context))
 		warn("failed to load texture '%s'", context->file);
-	context->update_time_elapsed = 0;
 	os_atomic_set_bool(&context->texture_loaded, true);
 }
 
@@ -80,8 +93,12 @@ static void image_source_unload(void *data)
 	os_atomic_set_bool(&context->file_decoded, false);
 	os_atomic_set_bool(&context->texture_loaded, false);
 
+	obs_cached_image_release(context->image);
+	context->image = NULL;
+	context->cached_texture = NULL;
+
 	obs_enter_graphics();
-	gs_image_file4_free(&context->if4);
+	gs_image_file5_free(&context->if5);
 	obs_leave_graphics();
 }
 
@@ -95,6 +112,14 @@ static void image_source_load(struct image_source *context)
 	}
 }
 
+static void image_file_changed(void *data, const char *path)
+{
+	struct image_source *context = data;
+	os_atomic_set_bool(&context->file_changed, true);
+
+	UNUSED_PARAMETER(path);
+}
+
 static void image_source_update(void *data, obs_data_t *settings)
 {
 	struct image_source *context = data;
@@ -103,6 +128,12 @@ static void image_source_update(void *data, obs_data_t *settings)
 	const bool linear_alpha = obs_data_get_bool(settings, "linear_alpha");
 	const bool is_slide = obs_data_get_bool(settings, "is_slide");
 
+	if (!context->file || strcmp(context->file, file) != 0) {
+		os_file_watch_destroy(context->file_watch);
+		context->file_watch = os_file_watch_create(file, image_file_changed, context);
+	}
+	os_atomic_set_bool(&context->file_changed, false);
+
 	if (context->file)
 		bfree(context->file);
 	context->file = bstrdup(file);
@@ -146,13 +177,13 @@ static void restart_gif(void *data)
 {
 	struct image_source *context = data;
 
-	if (context->if4.image3.image2.image.is_animated_gif) {
-		context->if4.image3.image2.image.cur_frame = 0;
-		context->if4.image3.image2.image.cur_loop = 0;
-		context->if4.image3.image2.image.cur_time = 0;
+	if (context->if5.image4.image3.image2.image.is_animated_gif) {
+		context->if5.image4.image3.image2.image.cur_frame = 0;
+		context->if5.image4.image3.image2.image.cur_loop = 0;
+		context->if5.image4.image3.image2.image.cur_time = 0;
 
 		obs_enter_graphics();
-		gs_image_file4_update_texture(&context->if4);
+		gs_image_file5_update_texture(&context->if5);
 		obs_leave_graphics();
 
 		context->restart_gif = false;
@@ -178,6 +209,7 @@ static void image_source_destroy(void *data)
 {
 	struct image_source *context = data;
 
+	os_file_watch_destroy(context->file_watch);
 	image_source_unload(context);
 
 	if (context->file)
@@ -188,13 +220,14 @@ static void image_source_destroy(void *data)
 static uint32_t image_source_getwidth(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cx;
+	return context->image ? obs_cached_image_get_width(context->image) : context->if5.image4.image3.image2.image.cx;
 }
 
 static uint32_t image_source_getheight(void *data)
 {
 	struct image_source *context = data;
-	return context->if4.image3.image2.image.cy;
+	return context->image ? obs_cached_image_get_height(context->image)
+			      : context->if5.image4.image3.image2.image.cy;
 }
 
 static void image_source_render(void *data, gs_effect_t *effect)
@@ -203,8 +236,7 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	if (!os_atomic_load_bool(&context->texture_loaded))
 		return;
 
-	struct gs_image_file *const image = &context->if4.image3.image2.image;
-	gs_texture_t *const texture = image->texture;
+	gs_texture_t *const texture = get_texture(context);
 	if (!texture)
 		return;
 
@@ -217,7 +249,7 @@ static void image_source_render(void *data, gs_effect_t *effect)
 	gs_eparam_t *const param = gs_effect_get_param_by_name(effect, "image");
 	gs_effect_set_texture_srgb(param, texture);
 
-	gs_draw_sprite(texture, 0, image->cx, image->cy);
+	gs_draw_sprite(texture, 0, image_source_getwidth(context), image_source_getheight(context));
 
 	gs_blend_state_pop();
 
@@ -236,22 +268,13 @@ static void image_source_tick(void *data, float seconds)
 
 	uint64_t frame_time = obs_get_video_frame_time();
 
-	context->update_time_elapsed += seconds;
-
-	if (obs_source_showing(context->source)) {
-		if (context->update_time_elapsed >= 1.0f) {
-			time_t t = get_modified_timestamp(context->file);
-			context->update_time_elapsed = 0.0f;
-
-			if (context->file_timestamp != t) {
-				image_source_load(context);
-			}
-		}
-	}
+	/* reload once shown if the file changed in the meantime */
+	if (obs_source_showing(context->source) && os_atomic_set_bool(&context->file_changed, false))
+		image_source_load(context);
 
 	if (obs_source_showing(context->source)) {
 		if (!context->active) {
-			if (context->if4.image3.image2.image.is_animated_gif)
+			if (context->if5.image4.image3.image2.image.is_animated_gif)
 				context->last_time = frame_time;
 			context->active = true;
 		}
@@ -268,18 +291,20 @@ static void image_source_tick(void *data, float seconds)
 		return;
 	}
 
-	if (context->last_time && context->if4.image3.image2.image.is_animated_gif) {
+	if (context->last_time && context->if5.image4.image3.image2.image.is_animated_gif) {
 		uint64_t elapsed = frame_time - context->last_time;
-		bool updated = gs_image_file4_tick(&context->if4, elapsed);
+		bool updated = gs_image_file5_tick(&context->if5, elapsed);
 
 		if (updated) {
 			obs_enter_graphics();
-			gs_image_file4_update_texture(&context->if4);
+			gs_image_file5_update_texture(&context->if5);
 			obs_leave_graphics();
 		}
 	}
 
 	context->last_time = frame_time;
+
+	UNUSED_PARAMETER(seconds);
 }
 
 static const char *image_filter =
@@ -316,7 +341,7 @@ static obs_properties_t *image_source_properties(void *data)
 uint64_t image_source_get_memory_usage(void *data)
 {
 	struct image_source *s = data;
-	return s->if4.image3.image2.mem_usage;
+	return s->image ? obs_cached_image_get_size(s->image) : s->if5.image4.image3.image2.mem_usage;
 }
 
 static void missing_file_callback(void *src, const char *new_path, void *data)
@@ -356,7 +381,9 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 	UNUSED_PARAMETER(preferred_spaces);
 
 	struct image_source *const s = data;
-	gs_image_file4_t *const if4 = &s->if4;
+	gs_image_file4_t *const if4 = &s->if5.image4;
+	if (s->image)
+		return s->cached_texture ? obs_cached_image_get_color_space(s->image) : GS_CS_SRGB;
 	return if4->image3.image2.image.texture ? if4->space : GS_CS_SRGB;
 }
 
@@ -15,7 +15,11 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
+
 #include <obs-module.h>
+#include <obs-avc.h>
+#include <util/source-profiler.h>
 #include <linux/videodev2.h>
 #include <libavutil/error.h>
 
@@ -25,6 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
 {
+	decoder->drop_oldest = pixfmt == V4L2_PIX_FMT_MJPEG;
+
 	if (pixfmt == V4L2_PIX_FMT_MJPEG) {
 		decoder->codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
 	} else if (pixfmt == V4L2_PIX_FMT_H264) {
@@ -56,6 +62,11 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
 
 	decoder->context->flags2 |= AV_CODEC_FLAG2_FAST;
 
+	/* decoding runs on its own thread, so frame threading only adds a
+	 * few frames of latency there instead of stalling the capture */
+	decoder->context->thread_count = V4L2_DECODE_THREADS;
+	decoder->context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
 	if (avcodec_open2(decoder->context, decoder->codec, NULL) < 0) {
 		blog(LOG_ERROR, "failed to open codec");
 		return -1;
@@ -68,6 +79,8 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
 
 void v4l2_destroy_decoder(struct v4l2_decoder *decoder)
 {
+	v4l2_stop_decode_thread(decoder);
+
 	blog(LOG_DEBUG, "destroying avcodec");
 	if (decoder->frame) {
 		av_frame_free(&decoder->frame);
@@ -85,23 +98,9 @@ void v4l2_destroy_decoder(struct v4l2_decoder *decoder)
 	}
 }
 
-int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length, struct v4l2_decoder *decoder)
+static void v4l2_output_frame(struct v4l2_decoder *decoder)
 {
-	int r;
-	decoder->packet->data = data;
-	decoder->packet->size = length;
-	if (avcodec_send_packet(decoder->context, decoder->packet) < 0) {
-		blog(LOG_ERROR, "failed to send frame to codec");
-		return -1;
-	}
-	r = avcodec_receive_frame(decoder->context, decoder->frame);
-	if (r == AVERROR(EAGAIN)) {
-		blog(LOG_DEBUG, "failed to receive frame in this state, try to send new frame to codec");
-		return 0;
-	} else if (r < 0) {
-		blog(LOG_ERROR, "failed to receive frame from codec");
-		return -1;
-	}
+	struct obs_source_frame *out = &decoder->out;
 
 	for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i) {
 		out->data[i] = decoder->frame->data[i];
@@ -128,5 +127,238 @@ int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length
 		break;
 	}
 
+	int64_t pts = decoder->frame->pts;
+	if (pts == AV_NOPTS_VALUE)
+		pts = decoder->frame->best_effort_timestamp;
+
+	out->timestamp = (uint64_t)pts;
+	obs_source_output_video(decoder->source, out);
+}
+
+static void v4l2_decode_packet(struct v4l2_decoder *decoder, AVPacket *packet)
+{
+	int r;
+
+	if (avcodec_send_packet(decoder->context, packet) < 0) {
+		if (!decoder->failed)
+			blog(LOG_ERROR, "failed to send frame to codec");
+		decoder->failed = true;
+		return;
+	}
+
+	/* with frame threading a packet can produce no frame or several */
+	for (;;) {
+		r = avcodec_receive_frame(decoder->context, decoder->frame);
+		if (r == AVERROR(EAGAIN))
+			break;
+		if (r < 0) {
+			if (!decoder->failed)
+				blog(LOG_ERROR, "failed to receive frame from codec");
+			decoder->failed = true;
+			break;
+		}
+
+		decoder->failed = false;
+		decoder->decoded++;
+
+		/* a newer frame was captured while this one was decoding */
+		pthread_mutex_lock(&decoder->mutex);
+		bool late = decoder->queue_count > 0;
+		pthread_mutex_unlock(&decoder->mutex);
+
+		if (late) {
+			decoder->late++;
+			source_profiler_async_frame_late(decoder->source);
+		}
+
+		v4l2_output_frame(decoder);
+	}
+}
+
+static void *v4l2_decode_thread(void *vptr)
+{
+	struct v4l2_decoder *decoder = vptr;
+
+	os_set_thread_name("v4l2: decode");
+
+	while (os_sem_wait(decoder->sem) == 0) {
+		bool have_packet = false;
+
+		pthread_mutex_lock(&decoder->mutex);
+		if (decoder->stop) {
+			pthread_mutex_unlock(&decoder->mutex);
+			break;
+		}
+
+		/* the semaphore is not taken back when frames are dropped */
+		if (decoder->queue_count) {
+			av_packet_move_ref(decoder->packet, decoder->queue[decoder->queue_start]);
+			decoder->queue_start = (decoder->queue_start + 1) % V4L2_DECODE_QUEUE_SIZE;
+			decoder->queue_count--;
+			have_packet = true;
+		}
+		pthread_mutex_unlock(&decoder->mutex);
+
+		if (have_packet) {
+			v4l2_decode_packet(decoder, decoder->packet);
+			av_packet_unref(decoder->packet);
+		}
+	}
+
+	return NULL;
+}
+
+int v4l2_start_decode_thread(struct v4l2_decoder *decoder, obs_source_t *source,
+			     const struct obs_source_frame *frame, size_t max_size)
+{
+	decoder->source = source;
+	decoder->out = *frame;
+	decoder->stop = false;
+	decoder->failed = false;
+	decoder->queue_start = 0;
+	decoder->queue_count = 0;
+	decoder->wait_keyframe = false;
+	decoder->decoded = 0;
+	decoder->dropped = 0;
+	decoder->late = 0;
+
+	decoder->pool_size = max_size;
+	decoder->pool = av_buffer_pool_init(max_size + AV_INPUT_BUFFER_PADDING_SIZE, NULL);
+	if (!decoder->pool)
+		return -1;
+
+	for (size_t i = 0; i < V4L2_DECODE_QUEUE_SIZE; i++) {
+		decoder->queue[i] = av_packet_alloc();
+		if (!decoder->queue[i])
+			goto fail;
+	}
+
+	if (pthread_mutex_init(&decoder->mutex, NULL) != 0)
+		goto fail;
+	if (os_sem_init(&decoder->sem, 0) != 0)
+		goto fail_mutex;
+	if (pthread_create(&decoder->thread, NULL, v4l2_decode_thread, decoder) != 0)
+		goto fail_sem;
+
+	decoder->thread_active = true;
+	return 0;
+
+fail_sem:
+	os_sem_destroy(decoder->sem);
+	decoder->sem = NULL;
+fail_mutex:
+	pthread_mutex_destroy(&decoder->mutex);
+fail:
+	for (size_t i = 0; i < V4L2_DECODE_QUEUE_SIZE; i++)
+		av_packet_free(&decoder->queue[i]);
+	av_buffer_pool_uninit(&decoder->pool);
+	return -1;
+}
+
+void v4l2_stop_decode_thread(struct v4l2_decoder *decoder)
+{
+	if (!decoder->thread_active)
+		return;
+
+	pthread_mutex_lock(&decoder->mutex);
+	decoder->stop = true;
+	pthread_mutex_unlock(&decoder->mutex);
+	os_sem_post(decoder->sem);
+
+	pthread_join(decoder->thread, NULL);
+	decoder->thread_active = false;
+
+	blog(LOG_INFO, "decoded %" PRIu64 " frames, %" PRIu64 " dropped, %" PRIu64 " late", decoder->decoded,
+	     decoder->dropped, decoder->late);
+
+	for (size_t i = 0; i < V4L2_DECODE_QUEUE_SIZE; i++)
+		av_packet_free(&decoder->queue[i]);
+
+	/* the pool is only freed once the decoder has let go of all its
+	 * buffers, so this is safe while frames are still in flight */
+	av_buffer_pool_uninit(&decoder->pool);
+	os_sem_destroy(decoder->sem);
+	decoder->sem = NULL;
+	pthread_mutex_destroy(&decoder->mutex);
+}
+
+static inline void v4l2_count_dropped(struct v4l2_decoder *decoder)
+{
+	decoder->dropped++;
+	source_profiler_async_frame_dropped(decoder->source);
+}
+
+int v4l2_queue_frame(struct v4l2_decoder *decoder, const uint8_t *data, size_t length, uint64_t timestamp)
+{
+	AVBufferRef *buf;
+	AVPacket *packet;
+	bool keyframe = false;
+
+	if (length > decoder->pool_size) {
+		blog(LOG_ERROR, "frame of %zu bytes exceeds the buffer size", length);
+		return -1;
+	}
+
+	if (!decoder->drop_oldest) {
+		keyframe = obs_avc_keyframe(data, length);
+
+		/* everything up to the next keyframe references a dropped
+		 * frame and would only decode to garbage */
+		if (decoder->wait_keyframe && !keyframe) {
+			pthread_mutex_lock(&decoder->mutex);
+			v4l2_count_dropped(decoder);
+			pthread_mutex_unlock(&decoder->mutex);
+			return 0;
+		}
+		decoder->wait_keyframe = false;
+	}
+
+	/* copy outside of the lock, the capture buffer is requeued right
+	 * after this returns */
+	buf = av_buffer_pool_get(decoder->pool);
+	if (!buf)
+		return -1;
+
+	memcpy(buf->data, data, length);
+	memset(buf->data + length, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+	pthread_mutex_lock(&decoder->mutex);
+
+	if (decoder->queue_count == V4L2_DECODE_QUEUE_SIZE) {
+		if (decoder->drop_oldest) {
+			/* the decoder is falling behind, drop the oldest frame */
+			av_packet_unref(decoder->queue[decoder->queue_start]);
+			decoder->queue_start = (decoder->queue_start + 1) % V4L2_DECODE_QUEUE_SIZE;
+			decoder->queue_count--;
+			v4l2_count_dropped(decoder);
+		} else if (keyframe) {
+			/* nothing after a keyframe needs the queued frames */
+			while (decoder->queue_count) {
+				av_packet_unref(decoder->queue[decoder->queue_start]);
+				decoder->queue_start = (decoder->queue_start + 1) % V4L2_DECODE_QUEUE_SIZE;
+				decoder->queue_count--;
+				v4l2_count_dropped(decoder);
+			}
+		} else {
+			v4l2_count_dropped(decoder);
+			pthread_mutex_unlock(&decoder->mutex);
+
+			av_buffer_unref(&buf);
+			decoder->wait_keyframe = true;
+			return 0;
+		}
+	}
+
+	packet = decoder->queue[(decoder->queue_start + decoder->queue_count) % V4L2_DECODE_QUEUE_SIZE];
+	packet->buf = buf;
+	packet->data = buf->data;
+	packet->size = (int)length;
+	packet->pts = (int64_t)timestamp;
+	packet->dts = (int64_t)timestamp;
+	decoder->queue_count++;
+
+	pthread_mutex_unlock(&decoder->mutex);
+
+	os_sem_post(decoder->sem);
 	return 0;
 }
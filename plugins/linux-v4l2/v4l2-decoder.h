@@ -24,6 +24,14 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/pixfmt.h>
+#include <util/threading.h>
+#include <obs.h>
+
+/** maximum number of compressed frames waiting for the decode thread */
+#define V4L2_DECODE_QUEUE_SIZE 3
+
+/** number of frames decoded in parallel */
+#define V4L2_DECODE_THREADS 3
 
 /**
  * Data structure for decoder
@@ -33,6 +41,32 @@ struct v4l2_decoder {
 	AVCodecContext *context;
 	AVPacket *packet;
 	AVFrame *frame;
+
+	/* decode thread */
+	obs_source_t *source;
+	struct obs_source_frame out;
+	pthread_t thread;
+	bool thread_active;
+	pthread_mutex_t mutex;
+	os_sem_t *sem;
+	bool stop;
+	bool failed;
+
+	/* compressed frames copied out of the capture buffers */
+	AVBufferPool *pool;
+	size_t pool_size;
+	AVPacket *queue[V4L2_DECODE_QUEUE_SIZE];
+	size_t queue_start;
+	size_t queue_count;
+
+	/* H264 frames depend on the previous ones, so after a drop the capture
+	 * side skips ahead to the next keyframe instead */
+	bool drop_oldest;
+	bool wait_keyframe;
+
+	uint64_t decoded;
+	uint64_t dropped;
+	uint64_t late;
 };
 
 /**
@@ -53,15 +87,41 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt);
 void v4l2_destroy_decoder(struct v4l2_decoder *decoder);
 
 /**
- * Decode a jpeg or h264 frame into an obs frame
+ * Start the decode thread.
+ *
+ * Decoded frames are output to the source by the decode thread, using
+ * frame as template for everything but the data and the format.
+ *
+ * @param decoder the decoder as initialized by v4l2_init_decoder
+ * @param source the source to output the decoded frames to
+ * @param frame the prepared obs frame
+ * @param max_size maximum size of a compressed frame
+ * @return non-zero on failure
+ */
+int v4l2_start_decode_thread(struct v4l2_decoder *decoder, obs_source_t *source,
+			     const struct obs_source_frame *frame, size_t max_size);
+
+/**
+ * Stop the decode thread and drop all frames that have not been decoded.
+ *
+ * @param decoder the decoder structure
+ */
+void v4l2_stop_decode_thread(struct v4l2_decoder *decoder);
+
+/**
+ * Queue a jpeg or h264 frame for decoding.
  *
- * @param out the obs frame to decode into
+ * The data is copied, so the capture buffer can be requeued as soon as
+ * this returns. If the decode thread is falling behind, the oldest queued
+ * frame is dropped.
+ *
+ * @param decoder the decoder with a running decode thread
  * @param data the codec data
  * @param length length of the data
- * @param decoder the decoder as initialized by v4l2_init_decoder
+ * @param timestamp timestamp of the frame
  * @return non-zero on failure
  */
-int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length, struct v4l2_decoder *decoder);
+int v4l2_queue_frame(struct v4l2_decoder *decoder, const uint8_t *data, size_t length, uint64_t timestamp);
 
 #ifdef __cplusplus
 }
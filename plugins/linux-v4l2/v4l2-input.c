@@ -63,6 +63,40 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define blog(level, msg, ...) blog(level, "v4l2-input: " msg, ##__VA_ARGS__)
 
+/* how long to wait for obs to hand back borrowed buffers before the capture
+ * is torn down, buffers that are still in use after that are released later */
+#define BORROWED_BUFFER_TIMEOUT_MS 1000
+
+struct v4l2_borrowed_buffers;
+
+/**
+ * Mapped buffer that has been handed to obs without copying
+ */
+struct v4l2_borrowed_buffer {
+	struct v4l2_borrowed_buffers *owner;
+	uint32_t index;
+	bool in_use;
+};
+
+/**
+ * State shared with the frames handed to obs without copying
+ *
+ * This is not owned by the source: if capture is torn down while obs still
+ * holds some of the buffers, the mapping and the device handle are handed
+ * over to it, and the last buffer to be returned releases everything.
+ */
+struct v4l2_borrowed_buffers {
+	pthread_mutex_t mutex;
+	char *device_id;
+	int_fast32_t dev;
+	long count;
+	bool requeue;
+	bool detached;
+	struct v4l2_buffer_data buffers;
+	struct v4l2_borrowed_buffer *array;
+	uint_fast32_t num;
+};
+
 /**
  * Data structure for the v4l2 source
  */
@@ -90,6 +124,7 @@ struct v4l2_data {
 	int height;
 	int linesize;
 	struct v4l2_buffer_data buffers;
+	struct v4l2_borrowed_buffers *borrowed;
 
 	bool auto_reset;
 	int timeout_frames;
@@ -154,6 +189,232 @@ static void v4l2_prep_obs_frame(struct v4l2_data *data, struct obs_source_frame
 	}
 }
 
+static struct v4l2_borrowed_buffers *v4l2_borrowed_create(struct v4l2_data *data)
+{
+	struct v4l2_borrowed_buffers *borrowed = bzalloc(sizeof(struct v4l2_borrowed_buffers));
+
+	if (pthread_mutex_init(&borrowed->mutex, NULL) != 0) {
+		bfree(borrowed);
+		return NULL;
+	}
+
+	borrowed->device_id = bstrdup(data->device_id);
+	borrowed->dev = data->dev;
+	borrowed->num = data->buffers.count;
+	borrowed->array = bzalloc(borrowed->num * sizeof(struct v4l2_borrowed_buffer));
+
+	for (uint_fast32_t i = 0; i < borrowed->num; i++) {
+		borrowed->array[i].owner = borrowed;
+		borrowed->array[i].index = i;
+	}
+
+	return borrowed;
+}
+
+/*
+ * Unmaps the buffers and closes the device if they were handed over by
+ * v4l2_borrowed_detach
+ */
+static void v4l2_borrowed_destroy(struct v4l2_borrowed_buffers *borrowed)
+{
+	if (borrowed->detached) {
+		v4l2_destroy_mmap(&borrowed->buffers);
+		v4l2_close(borrowed->dev);
+		blog(LOG_DEBUG, "%s: released buffers returned after capture stopped", borrowed->device_id);
+	}
+
+	pthread_mutex_destroy(&borrowed->mutex);
+	bfree(borrowed->device_id);
+	bfree(borrowed->array);
+	bfree(borrowed);
+}
+
+/*
+ * Requeue a borrowed buffer once obs is done with it
+ */
+static void v4l2_release_buffer(void *vptr)
+{
+	struct v4l2_borrowed_buffer *buffer = vptr;
+	struct v4l2_borrowed_buffers *borrowed = buffer->owner;
+	struct v4l2_buffer buf;
+	bool last;
+
+	pthread_mutex_lock(&borrowed->mutex);
+
+	buffer->in_use = false;
+	borrowed->count--;
+
+	if (borrowed->requeue) {
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = buffer->index;
+
+		if (v4l2_ioctl(borrowed->dev, VIDIOC_QBUF, &buf) < 0)
+			blog(LOG_ERROR, "%s: failed to enqueue borrowed buffer", borrowed->device_id);
+	}
+
+	last = borrowed->detached && !borrowed->count;
+	pthread_mutex_unlock(&borrowed->mutex);
+
+	if (last)
+		v4l2_borrowed_destroy(borrowed);
+}
+
+/*
+ * Pass a raw frame to obs without copying it, the buffer is requeued by
+ * v4l2_release_buffer. One buffer is always left with the driver so capture
+ * can't stall while obs holds on to frames, the caller has to fall back to
+ * the copying path when this returns false.
+ */
+static bool v4l2_output_borrowed(struct v4l2_data *data, struct obs_source_frame *out, uint32_t index)
+{
+	struct v4l2_borrowed_buffers *borrowed = data->borrowed;
+	struct v4l2_borrowed_buffer *buffer;
+
+	if (!borrowed || index >= borrowed->num)
+		return false;
+
+	pthread_mutex_lock(&borrowed->mutex);
+	if (borrowed->count >= (long)borrowed->num - 1) {
+		pthread_mutex_unlock(&borrowed->mutex);
+		return false;
+	}
+
+	buffer = &borrowed->array[index];
+	buffer->in_use = true;
+	borrowed->count++;
+	pthread_mutex_unlock(&borrowed->mutex);
+
+	obs_source_output_video_borrowed(data->source, out, v4l2_release_buffer, buffer);
+	return true;
+}
+
+static void v4l2_borrowed_set_requeue(struct v4l2_data *data, bool requeue)
+{
+	if (!data->borrowed)
+		return;
+
+	pthread_mutex_lock(&data->borrowed->mutex);
+	data->borrowed->requeue = requeue;
+	pthread_mutex_unlock(&data->borrowed->mutex);
+}
+
+static long v4l2_borrowed_count(struct v4l2_data *data)
+{
+	long count;
+
+	pthread_mutex_lock(&data->borrowed->mutex);
+	count = data->borrowed->count;
+	pthread_mutex_unlock(&data->borrowed->mutex);
+
+	return count;
+}
+
+/*
+ * Start capturing, buffers that obs still holds are left out and queued by
+ * v4l2_release_buffer once they are returned
+ */
+static int_fast32_t v4l2_start_borrowed_capture(struct v4l2_data *data)
+{
+	struct v4l2_borrowed_buffers *borrowed = data->borrowed;
+	enum v4l2_buf_type type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	struct v4l2_buffer enq;
+	int_fast32_t ret = -1;
+
+	if (!borrowed)
+		return v4l2_start_capture(data->dev, &data->buffers);
+
+	memset(&enq, 0, sizeof(enq));
+	enq.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	enq.memory = V4L2_MEMORY_MMAP;
+
+	pthread_mutex_lock(&borrowed->mutex);
+
+	for (enq.index = 0; enq.index < borrowed->num; ++enq.index) {
+		if (borrowed->array[enq.index].in_use)
+			continue;
+
+		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &enq) < 0) {
+			blog(LOG_ERROR, "%s: unable to queue buffer", data->device_id);
+			goto fail;
+		}
+	}
+
+	if (v4l2_ioctl(data->dev, VIDIOC_STREAMON, &type) < 0) {
+		blog(LOG_ERROR, "%s: unable to start stream", data->device_id);
+		goto fail;
+	}
+
+	borrowed->requeue = true;
+	ret = 0;
+
+fail:
+	pthread_mutex_unlock(&borrowed->mutex);
+	return ret;
+}
+
+static int_fast32_t v4l2_reset_borrowed_capture(struct v4l2_data *data)
+{
+	if (!data->borrowed)
+		return v4l2_reset_capture(data->dev, &data->buffers);
+
+	/* stopping the stream takes every buffer away from the driver, buffers
+	 * obs holds must not be requeued until they are returned */
+	v4l2_borrowed_set_requeue(data, false);
+	if (v4l2_stop_capture(data->dev) < 0)
+		return -1;
+
+	return v4l2_start_borrowed_capture(data);
+}
+
+/*
+ * Make obs drop its queued frames and give it some time to return the
+ * borrowed buffers. Whatever is still in use afterwards is handed over to
+ * the borrowed state together with the mapping and the device, which are
+ * then released once the last buffer comes back.
+ *
+ * Returns true if the mapping and the device were handed over, in which case
+ * the source must not touch or free them anymore.
+ */
+static bool v4l2_borrowed_detach(struct v4l2_data *data)
+{
+	struct v4l2_borrowed_buffers *borrowed = data->borrowed;
+	bool detached = false;
+
+	if (!borrowed)
+		return false;
+
+	if (v4l2_borrowed_count(data)) {
+		obs_source_output_video(data->source, NULL);
+
+		for (int i = 0; i < BORROWED_BUFFER_TIMEOUT_MS; i++) {
+			if (!v4l2_borrowed_count(data))
+				break;
+			os_sleep_ms(1);
+		}
+	}
+
+	data->borrowed = NULL;
+
+	pthread_mutex_lock(&borrowed->mutex);
+	if (borrowed->count) {
+		blog(LOG_WARNING, "%s: %ld buffers still in use, releasing them once they are returned",
+		     data->device_id, borrowed->count);
+
+		borrowed->buffers = data->buffers;
+		borrowed->dev = data->dev;
+		borrowed->detached = true;
+		detached = true;
+	}
+	pthread_mutex_unlock(&borrowed->mutex);
+
+	if (!detached)
+		v4l2_borrowed_destroy(borrowed);
+
+	return detached;
+}
+
 /*
  * Worker thread to get video data
  */
@@ -185,7 +446,7 @@ static void *v4l2_thread(void *vptr)
 	blog(LOG_INFO, "%s: select timeout set to %" PRIu64 " (%dx frame periods)", data->device_id, timeout_usec,
 	     data->timeout_frames);
 
-	if (v4l2_start_capture(data->dev, &data->buffers) < 0)
+	if (v4l2_start_borrowed_capture(data) < 0)
 		goto exit;
 
 	blog(LOG_DEBUG, "%s: new capture started", data->device_id);
@@ -196,6 +457,15 @@ static void *v4l2_thread(void *vptr)
 
 	blog(LOG_DEBUG, "%s: obs frame prepared", data->device_id);
 
+	/* compressed frames are decoded on their own thread, so the capture
+	 * buffer can be requeued as soon as the bitstream is copied out */
+	if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
+		if (v4l2_start_decode_thread(&data->decoder, data->source, &out, data->buffers.info[0].length) < 0) {
+			blog(LOG_ERROR, "%s: failed to start decode thread", data->device_id);
+			goto exit;
+		}
+	}
+
 	while (os_event_try(data->event) == EAGAIN) {
 		FD_ZERO(&fds);
 		FD_SET(data->dev, &fds);
@@ -222,7 +492,7 @@ static void *v4l2_thread(void *vptr)
 			}
 
 			if (data->auto_reset) {
-				if (v4l2_reset_capture(data->dev, &data->buffers) == 0)
+				if (v4l2_reset_borrowed_capture(data) == 0)
 					blog(LOG_INFO, "%s: stream reset successful", data->device_id);
 				else
 					blog(LOG_ERROR, "%s: failed to reset", data->device_id);
@@ -259,15 +529,21 @@ static void *v4l2_thread(void *vptr)
 		start = (uint8_t *)data->buffers.info[buf.index].start;
 
 		if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
-			if (v4l2_decode_frame(&out, start, buf.bytesused, &data->decoder) < 0) {
-				blog(LOG_ERROR, "failed to unpack jpeg or h264");
+			if (v4l2_queue_frame(&data->decoder, start, buf.bytesused, out.timestamp) < 0) {
+				blog(LOG_ERROR, "failed to queue jpeg or h264");
 				break;
 			}
 		} else {
 			for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i)
 				out.data[i] = start + plane_offsets[i];
+
+			if (v4l2_output_borrowed(data, &out, buf.index)) {
+				frames++;
+				continue;
+			}
+
+			obs_source_output_video(data->source, &out);
 		}
-		obs_source_output_video(data->source, &out);
 
 	continue_queue_buffer:
 		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &buf) < 0) {
@@ -281,6 +557,8 @@ static void *v4l2_thread(void *vptr)
 	blog(LOG_INFO, "%s: Stopped capture after %" PRIu64 " frames", data->device_id, frames);
 
 exit:
+	v4l2_stop_decode_thread(&data->decoder);
+	v4l2_borrowed_set_requeue(data, false);
 	v4l2_stop_capture(data->dev);
 	return NULL;
 }
@@ -841,6 +1119,10 @@ static void v4l2_terminate(struct v4l2_data *data)
 	if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
 		v4l2_destroy_decoder(&data->decoder);
 	}
+	if (v4l2_borrowed_detach(data)) {
+		memset(&data->buffers, 0, sizeof(data->buffers));
+		data->dev = -1;
+	}
 	v4l2_destroy_mmap(&data->buffers);
 
 	if (data->dev != -1) {
@@ -963,6 +1245,9 @@ static void v4l2_init(struct v4l2_data *data)
 			blog(LOG_ERROR, "Failed to initialize decoder");
 			goto fail;
 		}
+	} else {
+		/* raw frames are passed to obs without copying them */
+		data->borrowed = v4l2_borrowed_create(data);
 	}
 
 	/* start the capture thread */
@@ -825,7 +825,7 @@ static void packet_put_startcode(struct darray *packet, int size)
 	packet_put(packet, &annexb_startcode[4 - size], size);
 }
 
-static bool handle_prores_packet(struct vt_encoder *enc, CMSampleBufferRef buffer)
+static bool handle_prores_packet(struct vt_encoder *enc, CMSampleBufferRef buffer, struct encoder_packet *packet)
 {
 	OSStatus err = 0;
 	size_t block_size = 0;
@@ -842,7 +842,11 @@ static bool handle_prores_packet(struct vt_encoder *enc, CMSampleBufferRef buffe
 		return false;
 	}
 
-	packet_put(&enc->packet_data.da, block_buf, block_size);
+	/* ProRes frames are large, so they go straight into libobs' packet data
+	 * which outputs can share instead of copying */
+	packet->data = obs_encoder_alloc_packet_data(enc->encoder, block_size);
+	packet->size = block_size;
+	memcpy(packet->data, block_buf, block_size);
 
 	return true;
 }
@@ -1009,16 +1013,17 @@ static bool parse_sample(struct vt_encoder *enc, CMSampleBufferRef buffer, struc
 	if (has_annexb) {
 		if (!convert_sample_to_annexb(enc, &enc->packet_data.da, extra_data, buffer, keyframe))
 			goto fail;
+
+		packet->data = enc->packet_data.array;
+		packet->size = enc->packet_data.num;
 	} else {
-		if (!handle_prores_packet(enc, buffer))
+		if (!handle_prores_packet(enc, buffer, packet))
 			goto fail;
 	}
 
 	packet->type = OBS_ENCODER_VIDEO;
 	packet->pts = (int64_t)(CMTimeGetSeconds(pts));
 	packet->dts = (int64_t)(CMTimeGetSeconds(dts));
-	packet->data = enc->packet_data.array;
-	packet->size = enc->packet_data.num;
 	packet->keyframe = keyframe;
 
 	if (is_avc) {
@@ -53,10 +53,12 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	}
 
 	deque_free(&stream->packets);
+	replay_spill_clear(&stream->spill);
 	stream->cur_size = 0;
 	stream->cur_time = 0;
 	stream->max_size = 0;
 	stream->max_time = 0;
+	stream->ram_size = 0;
 	stream->save_ts = 0;
 	stream->keyframes = 0;
 }
@@ -72,6 +74,7 @@ static void ffmpeg_mux_destroy(void *data)
 		obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	da_free(stream->mux_packets);
 	deque_free(&stream->packets);
+	replay_spill_free(&stream->spill);
 
 	os_process_pipe_destroy(stream->pipe);
 	dstr_free(&stream->path);
@@ -407,6 +410,14 @@ static inline bool ffmpeg_mux_start_internal(struct ffmpeg_muxer *stream, obs_da
 
 	ts_offset_clear(stream);
 
+	/* pipe writes block whenever ffmpeg-mux falls behind, optionally
+	 * move them off of the encoder threads.  a recording must not lose
+	 * packets, a stream can skip ahead to the next keyframe instead. */
+	int64_t queue_size = obs_data_get_int(settings, "delivery_queue_size");
+	obs_output_set_delivery_queue(stream->output, queue_size > 0 ? (size_t)queue_size : 0,
+				      stream->is_network ? OBS_OUTPUT_DELIVERY_DROP_NON_KEY
+							 : OBS_OUTPUT_DELIVERY_BLOCK);
+
 	if (!stream->is_network) {
 		/* ensure output path is writable to avoid generic error
 		 * message.
@@ -962,7 +973,7 @@ static void *replay_buffer_create(obs_data_t *settings, obs_output_t *output)
 	proc_handler_add(ph, "void get_last_replay(out string path)", get_last_replay, stream);
 
 	signal_handler_t *sh = obs_output_get_signal_handler(output);
-	signal_handler_add(sh, "void saved()");
+	signal_handler_add(sh, "void saved(int bytes, int duration_ms, int latency_ms)");
 
 	return stream;
 }
@@ -975,6 +986,37 @@ static void replay_buffer_destroy(void *data)
 	ffmpeg_mux_destroy(data);
 }
 
+static void replay_buffer_init_spill(struct ffmpeg_muxer *stream, obs_data_t *settings)
+{
+	int64_t max_ram_size = obs_data_get_int(settings, "max_ram_mb") * (1024 * 1024);
+	int64_t max_disk_size = obs_data_get_int(settings, "max_disk_mb") * (1024 * 1024);
+	const char *dir = obs_data_get_string(settings, "disk_cache_directory");
+
+	/* a previous save may still be reading from the old ring file */
+	if (stream->mux_thread_joinable) {
+		pthread_join(stream->mux_thread, NULL);
+		stream->mux_thread_joinable = false;
+	}
+
+	replay_spill_free(&stream->spill);
+	stream->max_ram_size = 0;
+
+	if (max_ram_size <= 0 || max_disk_size <= 0)
+		return;
+
+	if (!dir || !*dir)
+		dir = obs_data_get_string(settings, "directory");
+
+	if (!replay_spill_init(&stream->spill, dir, (size_t)max_disk_size)) {
+		warn("Failed to create disk cache in '%s', keeping the whole buffer in memory", dir);
+		return;
+	}
+
+	stream->max_ram_size = max_ram_size;
+	info("Keeping up to %d MB in memory, spilling up to %d MB to '%s'", (int)(max_ram_size / (1024 * 1024)),
+	     (int)(max_disk_size / (1024 * 1024)), dir);
+}
+
 static bool replay_buffer_start(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
@@ -987,6 +1029,7 @@ static bool replay_buffer_start(void *data)
 	obs_data_t *s = obs_output_get_settings(stream->output);
 	stream->max_time = obs_data_get_int(s, "max_time_sec") * 1000000LL;
 	stream->max_size = obs_data_get_int(s, "max_size_mb") * (1024 * 1024);
+	replay_buffer_init_spill(stream, s);
 	obs_data_release(s);
 
 	os_atomic_set_bool(&stream->active, true);
@@ -997,32 +1040,55 @@ static bool replay_buffer_start(void *data)
 	return true;
 }
 
+static inline bool replay_buffer_empty(struct ffmpeg_muxer *stream)
+{
+	return !stream->packets.size && !stream->spill.packets.size;
+}
+
+/* spilled packets are always older than the ones still in memory */
+static inline void replay_buffer_peek_front(struct ffmpeg_muxer *stream, struct encoder_packet *pkt)
+{
+	if (stream->spill.packets.size)
+		deque_peek_front(&stream->spill.packets, pkt, sizeof(*pkt));
+	else
+		deque_peek_front(&stream->packets, pkt, sizeof(*pkt));
+}
+
 static bool purge_front(struct ffmpeg_muxer *stream)
 {
 	struct encoder_packet pkt;
+	bool spilled;
 	bool keyframe;
 
-	if (!stream->packets.size)
+	if (replay_buffer_empty(stream))
 		return false;
 
-	deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
+	spilled = stream->spill.packets.size != 0;
+	if (spilled) {
+		replay_spill_pop(&stream->spill, &pkt);
+	} else {
+		deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
+		stream->ram_size -= (int64_t)pkt.size;
+	}
 
 	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
 
 	if (keyframe)
 		stream->keyframes--;
 
-	if (!stream->packets.size) {
+	if (replay_buffer_empty(stream)) {
 		stream->cur_size = 0;
 		stream->cur_time = 0;
 	} else {
 		struct encoder_packet first;
-		deque_peek_front(&stream->packets, &first, sizeof(first));
+		replay_buffer_peek_front(stream, &first);
 		stream->cur_time = first.dts_usec;
 		stream->cur_size -= (int64_t)pkt.size;
 	}
 
-	obs_encoder_packet_release(&pkt);
+	/* spilled packets belong to the ring file */
+	if (!spilled)
+		obs_encoder_packet_release(&pkt);
 	return keyframe;
 }
 
@@ -1032,9 +1098,9 @@ static inline void purge(struct ffmpeg_muxer *stream)
 		struct encoder_packet pkt;
 
 		for (;;) {
-			if (!stream->packets.size)
+			if (replay_buffer_empty(stream))
 				return;
-			deque_peek_front(&stream->packets, &pkt, sizeof(pkt));
+			replay_buffer_peek_front(stream, &pkt);
 			if (pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe)
 				return;
 
@@ -1046,14 +1112,14 @@ static inline void purge(struct ffmpeg_muxer *stream)
 static inline void replay_buffer_purge(struct ffmpeg_muxer *stream, struct encoder_packet *pkt)
 {
 	if (stream->max_size) {
-		if (!stream->packets.size || stream->keyframes <= 2)
+		if (replay_buffer_empty(stream) || stream->keyframes <= 2)
 			return;
 
 		while ((stream->cur_size + (int64_t)pkt->size) > stream->max_size)
 			purge(stream);
 	}
 
-	if (!stream->packets.size || stream->keyframes <= 2)
+	if (replay_buffer_empty(stream) || stream->keyframes <= 2)
 		return;
 
 	while ((pkt->dts_usec - stream->cur_time) > stream->max_time)
@@ -1087,11 +1153,51 @@ static void insert_packet(mux_packets_t *packets, struct encoder_packet *packet,
 	da_insert(*packets, idx, &pkt);
 }
 
+/* MP4/MOV replays without custom muxer settings are written in-process by the
+ * native muxer in obs-outputs, which avoids piping the whole buffer through an
+ * ffmpeg-mux process.  returns false if the save has to fall back to
+ * ffmpeg-mux. */
+static bool replay_buffer_write_native(struct ffmpeg_muxer *stream, bool *error)
+{
+	obs_data_t *settings = obs_output_get_settings(stream->output);
+	const char *muxer_settings = obs_data_get_string(settings, "muxer_settings");
+	const char *ext = strrchr(stream->path.array, '.');
+	bool native = ext && (astrcmpi(ext, ".mp4") == 0 || astrcmpi(ext, ".mov") == 0) &&
+		      dstr_is_empty(&stream->muxer_settings) && !*muxer_settings;
+	obs_data_release(settings);
+
+	if (!native)
+		return false;
+
+	calldata_t cd = {0};
+	calldata_set_ptr(&cd, "output", stream->output);
+	calldata_set_ptr(&cd, "packets", stream->mux_packets.array);
+	calldata_set_int(&cd, "num_packets", (long long)stream->mux_packets.num);
+	calldata_set_string(&cd, "path", stream->path.array);
+
+	proc_handler_t *ph = obs_get_proc_handler();
+	native = proc_handler_call(ph, "mp4_write_packets", &cd) && calldata_bool(&cd, "supported");
+	*error = native && !calldata_bool(&cd, "success");
+
+	calldata_free(&cd);
+	return native;
+}
+
 static void *replay_buffer_mux_thread(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
+	uint64_t start_time = os_gettime_ns();
 	bool error = false;
 
+	if (replay_buffer_write_native(stream, &error)) {
+		for (size_t i = 0; i < stream->mux_packets.num; i++)
+			obs_encoder_packet_release(&stream->mux_packets.array[i]);
+
+		if (error)
+			warn("Could not write replay buffer to '%s'", stream->path.array);
+		goto finish;
+	}
+
 	start_pipe(stream, stream->path.array);
 
 	if (!stream->pipe) {
@@ -1116,8 +1222,6 @@ static void *replay_buffer_mux_thread(void *data)
 		obs_encoder_packet_release(pkt);
 	}
 
-	info("Wrote replay buffer to '%s'", stream->path.array);
-
 error:
 	os_process_pipe_destroy(stream->pipe);
 	stream->pipe = NULL;
@@ -1125,13 +1229,29 @@ error:
 		for (size_t i = 0; i < stream->mux_packets.num; i++)
 			obs_encoder_packet_release(&stream->mux_packets.array[i]);
 	}
+
+finish:
 	da_free(stream->mux_packets);
 	os_atomic_set_bool(&stream->muxing, false);
 
 	if (!error) {
+		uint64_t end_time = os_gettime_ns();
+		int64_t bytes = os_get_file_size(stream->path.array);
+		int duration_ms = (int)((end_time - start_time) / 1000000);
+		int latency_ms = (int)(((int64_t)(end_time / 1000) - stream->save_request_ts) / 1000);
+		double mb = (double)bytes / (1024.0 * 1024.0);
+
+		info("Wrote replay buffer to '%s' (%.1f MB in %d ms, %.1f MB/s, %d ms after the save request)",
+		     stream->path.array, mb, duration_ms, duration_ms ? mb * 1000.0 / duration_ms : 0.0, latency_ms);
+
 		calldata_t cd = {0};
+		calldata_set_int(&cd, "bytes", bytes);
+		calldata_set_int(&cd, "duration_ms", duration_ms);
+		calldata_set_int(&cd, "latency_ms", latency_ms);
+
 		signal_handler_t *sh = obs_output_get_signal_handler(stream->output);
 		signal_handler_signal(sh, "saved", &cd);
+		calldata_free(&cd);
 	}
 
 	return NULL;
@@ -1140,7 +1260,8 @@ error:
 static void replay_buffer_save(struct ffmpeg_muxer *stream)
 {
 	const size_t size = sizeof(struct encoder_packet);
-	size_t num_packets = stream->packets.size / size;
+	size_t num_spilled = stream->spill.packets.size / size;
+	size_t num_packets = num_spilled + stream->packets.size / size;
 
 	da_reserve(stream->mux_packets, num_packets);
 
@@ -1156,7 +1277,10 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 
 	for (size_t i = 0; i < num_packets; i++) {
 		struct encoder_packet *pkt;
-		pkt = deque_data(&stream->packets, i * size);
+		if (i < num_spilled)
+			pkt = deque_data(&stream->spill.packets, i * size);
+		else
+			pkt = deque_data(&stream->packets, (i - num_spilled) * size);
 
 		if (pkt->type == OBS_ENCODER_VIDEO) {
 			if (!found_video) {
@@ -1186,6 +1310,34 @@ static void replay_buffer_save(struct ffmpeg_muxer *stream)
 	}
 }
 
+/* moves the oldest packets out of memory once the RAM window is exceeded */
+static void spill_packets(struct ffmpeg_muxer *stream)
+{
+	/* a save may still be reading from the disk tier, so the ring can't be
+	 * written to until it's done, memory just grows a bit meanwhile */
+	if (os_atomic_load_bool(&stream->muxing))
+		return;
+
+	while (stream->ram_size > stream->max_ram_size && stream->packets.size) {
+		struct encoder_packet pkt;
+		deque_peek_front(&stream->packets, &pkt, sizeof(pkt));
+
+		if (!replay_spill_push(&stream->spill, &pkt)) {
+			/* disk tier is full, drop the oldest group of pictures
+			 * to make room */
+			if (!stream->spill.packets.size)
+				break;
+
+			purge(stream);
+			continue;
+		}
+
+		deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
+		stream->ram_size -= (int64_t)pkt.size;
+		obs_encoder_packet_release(&pkt);
+	}
+}
+
 static void deactivate_replay_buffer(struct ffmpeg_muxer *stream, int code)
 {
 	if (code) {
@@ -1224,15 +1376,19 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 	obs_encoder_packet_ref(&pkt, packet);
 	replay_buffer_purge(stream, &pkt);
 
-	if (!stream->packets.size)
+	if (replay_buffer_empty(stream))
 		stream->cur_time = pkt.dts_usec;
 	stream->cur_size += pkt.size;
+	stream->ram_size += pkt.size;
 
 	deque_push_back(&stream->packets, packet, sizeof(*packet));
 
 	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
 		stream->keyframes++;
 
+	if (replay_spill_active(&stream->spill))
+		spill_packets(stream);
+
 	if (stream->save_ts && packet->sys_dts_usec >= stream->save_ts) {
 		if (os_atomic_load_bool(&stream->muxing))
 			return;
@@ -1242,6 +1398,7 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 			stream->mux_thread_joinable = false;
 		}
 
+		stream->save_request_ts = stream->save_ts;
 		stream->save_ts = 0;
 		replay_buffer_save(stream);
 	}
@@ -1251,6 +1408,8 @@ static void replay_buffer_defaults(obs_data_t *s)
 {
 	obs_data_set_default_int(s, "max_time_sec", 15);
 	obs_data_set_default_int(s, "max_size_mb", 500);
+	obs_data_set_default_int(s, "max_ram_mb", 0);
+	obs_data_set_default_int(s, "max_disk_mb", 0);
 	obs_data_set_default_string(s, "format", "%CCYY-%MM-%DD %hh-%mm-%ss");
 	obs_data_set_default_string(s, "extension", "mp4");
 	obs_data_set_default_bool(s, "allow_spaces", true);
@@ -9,6 +9,8 @@
 #include <util/platform.h>
 #include <util/threading.h>
 
+#include "replay-spill.h"
+
 typedef DARRAY(struct encoder_packet) mux_packets_t;
 
 struct ffmpeg_muxer {
@@ -33,10 +35,14 @@ struct ffmpeg_muxer {
 
 	/* replay buffer */
 	int64_t save_ts;
+	int64_t save_request_ts;
 	int keyframes;
 	obs_hotkey_id hotkey;
 	volatile bool muxing;
 	mux_packets_t mux_packets;
+	int64_t ram_size;
+	int64_t max_ram_size;
+	struct replay_spill spill;
 
 	/* split file */
 	bool found_video;
@@ -41,6 +41,7 @@ struct ffmpeg_source {
 	char *input_format;
 	char *ffmpeg_options;
 	int buffering_mb;
+	int cache_budget_mb;
 	int speed_percent;
 	bool is_looping;
 	bool is_local_file;
@@ -230,11 +231,13 @@ static void dump_source_info(struct ffmpeg_source *s, const char *input, const c
 		"\trestart_on_activate:     %s\n"
 		"\tclose_when_inactive:     %s\n"
 		"\tfull_decode:             %s\n"
+		"\tcache_budget_mb:         %d\n"
 		"\tffmpeg_options:          %s",
 		input ? input : "(null)", input_format ? input_format : "(null)", s->speed_percent,
 		s->is_looping ? "yes" : "no", s->is_linear_alpha ? "yes" : "no", s->is_hw_decoding ? "yes" : "no",
 		s->is_clear_on_media_end ? "yes" : "no", s->restart_on_activate ? "yes" : "no",
-		s->close_when_inactive ? "yes" : "no", s->full_decode ? "yes" : "no", s->ffmpeg_options);
+		s->close_when_inactive ? "yes" : "no", s->full_decode ? "yes" : "no", s->cache_budget_mb,
+		s->ffmpeg_options);
 }
 
 static void get_frame(void *opaque, struct obs_source_frame *f)
@@ -301,6 +304,7 @@ static void ffmpeg_source_open(struct ffmpeg_source *s)
 			.format = s->input_format,
 			.buffering = s->buffering_mb * 1024 * 1024,
 			.speed = s->speed_percent,
+			.cache_budget = s->cache_budget_mb > 0 ? (size_t)s->cache_budget_mb * 1024 * 1024 : 0,
 			.force_range = s->range,
 			.is_linear_alpha = s->is_linear_alpha,
 			.hardware_decoding = s->is_hw_decoding,
@@ -456,6 +460,7 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 	s->input_format = input_format ? bstrdup(input_format) : NULL;
 	s->is_hw_decoding = is_hw_decoding;
 	s->full_decode = obs_data_get_bool(settings, "full_decode");
+	s->cache_budget_mb = (int)obs_data_get_int(settings, "cache_budget_mb");
 	s->is_clear_on_media_end = obs_data_get_bool(settings, "clear_on_media_end");
 	s->restart_on_activate = !astrcmpi_n(input, RIST_PROTO, sizeof(RIST_PROTO) - 1)
 					 ? false
@@ -785,7 +790,7 @@ struct obs_source_info ffmpeg_source = {
 	.id = "ffmpeg_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
 	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE |
-			OBS_SOURCE_CONTROLLABLE_MEDIA,
+			OBS_SOURCE_CONTROLLABLE_MEDIA | OBS_SOURCE_TICK_WHEN_INACTIVE | OBS_SOURCE_THREADSAFE_TICK,
 	.get_name = ffmpeg_source_getname,
 	.create = ffmpeg_source_create,
 	.destroy = ffmpeg_source_destroy,
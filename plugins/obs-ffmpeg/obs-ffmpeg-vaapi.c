@@ -678,14 +678,18 @@ static bool vaapi_encode_internal(struct vaapi_encoder *enc, AVFrame *frame, str
 
 			da_copy_array(enc->buffer, new_packet, size);
 			bfree(new_packet);
+
+			packet->data = enc->buffer.array;
+			packet->size = enc->buffer.num;
 		} else {
-			da_copy_array(enc->buffer, enc->packet->data, enc->packet->size);
+			/* libobs passes this buffer on to outputs as is */
+			packet->data = obs_encoder_alloc_packet_data(enc->encoder, enc->packet->size);
+			packet->size = enc->packet->size;
+			memcpy(packet->data, enc->packet->data, enc->packet->size);
 		}
 
 		packet->pts = enc->packet->pts;
 		packet->dts = enc->packet->dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
 		packet->type = OBS_ENCODER_VIDEO;
 #ifdef ENABLE_HEVC
 		if (enc->codec == CODEC_HEVC) {
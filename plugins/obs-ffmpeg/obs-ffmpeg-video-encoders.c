@@ -234,14 +234,18 @@ bool ffmpeg_video_encode(struct ffmpeg_video_encoder *enc, struct encoder_frame
 		if (enc->on_first_packet && enc->first_packet) {
 			enc->on_first_packet(enc->parent, &av_pkt, &enc->buffer.da);
 			enc->first_packet = false;
+
+			packet->data = enc->buffer.array;
+			packet->size = enc->buffer.num;
 		} else {
-			da_copy_array(enc->buffer, av_pkt.data, av_pkt.size);
+			/* libobs passes this buffer on to outputs as is */
+			packet->data = obs_encoder_alloc_packet_data(enc->encoder, av_pkt.size);
+			packet->size = av_pkt.size;
+			memcpy(packet->data, av_pkt.data, av_pkt.size);
 		}
 
 		packet->pts = av_pkt.pts;
 		packet->dts = av_pkt.dts;
-		packet->data = enc->buffer.array;
-		packet->size = enc->buffer.num;
 		packet->type = OBS_ENCODER_VIDEO;
 		packet->keyframe = !!(av_pkt.flags & AV_PKT_FLAG_KEY);
 		*received_packet = true;
@@ -0,0 +1,228 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "replay-spill.h"
+
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define RECORD_ALIGN 16
+#define RECORD_HEADER RECORD_ALIGN
+
+#ifdef _WIN32
+static bool map_file(struct replay_spill *spill, const char *dir)
+{
+	struct dstr path = {0};
+	wchar_t *wpath = NULL;
+	char *uuid = os_generate_uuid();
+
+	dstr_printf(&path, "%s/.obs-replay-%s.tmp", dir, uuid);
+	os_utf8_to_wcs_ptr(path.array, 0, &wpath);
+	bfree(uuid);
+
+	/* deleted as soon as the last handle is gone, including on crashes */
+	spill->file = CreateFileW(wpath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_NEW,
+				  FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	bfree(wpath);
+
+	if (spill->file == INVALID_HANDLE_VALUE) {
+		blog(LOG_WARNING, "replay_spill: Failed to create '%s': %lu", path.array, GetLastError());
+		spill->file = NULL;
+		dstr_free(&path);
+		return false;
+	}
+	dstr_free(&path);
+
+	ULARGE_INTEGER size = {.QuadPart = spill->size};
+	spill->mapping = CreateFileMappingW(spill->file, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+	if (!spill->mapping) {
+		blog(LOG_WARNING, "replay_spill: Failed to create file mapping: %lu", GetLastError());
+		return false;
+	}
+
+	spill->data = MapViewOfFile(spill->mapping, FILE_MAP_ALL_ACCESS, 0, 0, spill->size);
+	if (!spill->data) {
+		blog(LOG_WARNING, "replay_spill: Failed to map file: %lu", GetLastError());
+		return false;
+	}
+
+	return true;
+}
+
+static void unmap_file(struct replay_spill *spill)
+{
+	if (spill->data)
+		UnmapViewOfFile(spill->data);
+	if (spill->mapping)
+		CloseHandle(spill->mapping);
+	if (spill->file)
+		CloseHandle(spill->file);
+}
+#else
+static bool map_file(struct replay_spill *spill, const char *dir)
+{
+	struct dstr path = {0};
+	void *data;
+	int fd;
+	int err;
+
+	dstr_printf(&path, "%s/.obs-replay-XXXXXX", dir);
+
+	fd = mkstemp(path.array);
+	if (fd == -1) {
+		blog(LOG_WARNING, "replay_spill: Failed to create '%s': %d", path.array, errno);
+		dstr_free(&path);
+		return false;
+	}
+
+	/* the file only lives on through the mapping, so nothing is left
+	 * behind if the program goes away */
+	unlink(path.array);
+	dstr_free(&path);
+
+#ifdef __APPLE__
+	err = ftruncate(fd, (off_t)spill->size) == 0 ? 0 : errno;
+#else
+	err = posix_fallocate(fd, 0, (off_t)spill->size);
+#endif
+	if (err != 0) {
+		blog(LOG_WARNING, "replay_spill: Failed to allocate %zu bytes: %d", spill->size, err);
+		close(fd);
+		return false;
+	}
+
+	data = mmap(NULL, spill->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		blog(LOG_WARNING, "replay_spill: Failed to map file: %d", errno);
+		return false;
+	}
+
+	spill->data = data;
+	return true;
+}
+
+static void unmap_file(struct replay_spill *spill)
+{
+	if (spill->data)
+		munmap(spill->data, spill->size);
+}
+#endif
+
+bool replay_spill_init(struct replay_spill *spill, const char *dir, size_t size)
+{
+	memset(spill, 0, sizeof(*spill));
+
+	spill->size = size & ~(size_t)(RECORD_ALIGN - 1);
+	if (!spill->size || !dir || !*dir)
+		return false;
+
+	if (!map_file(spill, dir)) {
+		replay_spill_free(spill);
+		return false;
+	}
+
+	return true;
+}
+
+void replay_spill_free(struct replay_spill *spill)
+{
+	unmap_file(spill);
+	deque_free(&spill->packets);
+	memset(spill, 0, sizeof(*spill));
+}
+
+void replay_spill_clear(struct replay_spill *spill)
+{
+	deque_free(&spill->packets);
+	spill->head = 0;
+	spill->tail = 0;
+}
+
+static inline size_t record_offset(const struct replay_spill *spill, const struct encoder_packet *packet)
+{
+	return (size_t)((const uint8_t *)packet->data - spill->data) - RECORD_HEADER;
+}
+
+static bool alloc_record(struct replay_spill *spill, size_t size, size_t *offset)
+{
+	bool wrapped;
+
+	if (!spill->packets.size) {
+		spill->head = 0;
+		spill->tail = 0;
+	}
+
+	wrapped = spill->head < spill->tail || (spill->head == spill->tail && spill->packets.size);
+
+	if (wrapped) {
+		if (spill->head + size > spill->tail)
+			return false;
+
+	} else if (spill->head + size > spill->size) {
+		/* doesn't fit before the end of the file, so start over at
+		 * the beginning, the rest of the file is simply skipped */
+		if (size > spill->tail)
+			return false;
+
+		spill->head = 0;
+	}
+
+	*offset = spill->head;
+	spill->head += size;
+	return true;
+}
+
+bool replay_spill_push(struct replay_spill *spill, const struct encoder_packet *packet)
+{
+	struct encoder_packet spilled = *packet;
+	size_t size = (RECORD_HEADER + packet->size + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1);
+	size_t offset;
+	long *refs;
+
+	if (!alloc_record(spill, size, &offset))
+		return false;
+
+	spilled.data = spill->data + offset + RECORD_HEADER;
+	refs = ((long *)spilled.data) - 1;
+	*refs = 1;
+	memcpy(spilled.data, packet->data, packet->size);
+
+	deque_push_back(&spill->packets, &spilled, sizeof(spilled));
+	return true;
+}
+
+void replay_spill_pop(struct replay_spill *spill, struct encoder_packet *packet)
+{
+	deque_pop_front(&spill->packets, packet, sizeof(*packet));
+
+	if (spill->packets.size) {
+		struct encoder_packet *next = deque_data(&spill->packets, 0);
+		spill->tail = record_offset(spill, next);
+	} else {
+		spill->head = 0;
+		spill->tail = 0;
+	}
+}
@@ -0,0 +1,69 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs-module.h>
+#include <util/deque.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/* disk tier of the replay buffer.  packets that fall out of the RAM window
+ * are copied in to a preallocated, memory mapped ring file.  each record is
+ * laid out like an encoder packet allocation (a reference count followed by
+ * the payload), so spilled packets can be referenced and released by the
+ * muxer like any other packet.  the ring always keeps one reference of its
+ * own, so a release never frees file memory.
+ *
+ * records are allocated in the same order as they appear in the index, so
+ * the oldest indexed packet is always the tail of the ring. */
+struct replay_spill {
+	uint8_t *data;
+	size_t size;
+	size_t head;
+	size_t tail;
+
+	/* spilled packets, oldest first */
+	struct deque packets;
+
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+static inline bool replay_spill_active(const struct replay_spill *spill)
+{
+	return spill->data != NULL;
+}
+
+bool replay_spill_init(struct replay_spill *spill, const char *dir, size_t size);
+void replay_spill_free(struct replay_spill *spill);
+
+/* drops all indexed packets */
+void replay_spill_clear(struct replay_spill *spill);
+
+/* copies the packet to the end of the ring and indexes it.  returns false if
+ * there is not enough contiguous space left, in which case the caller has to
+ * pop the oldest packets first. */
+bool replay_spill_push(struct replay_spill *spill, const struct encoder_packet *packet);
+
+/* removes the oldest packet from the index.  the returned packet still points
+ * in to the ring and stays valid until the space is reused. */
+void replay_spill_pop(struct replay_spill *spill, struct encoder_packet *packet);
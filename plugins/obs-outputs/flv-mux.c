@@ -305,13 +305,13 @@ void flv_meta_data(obs_output_t *context, uint8_t **output, size_t *size, bool w
 static int32_t last_time = 0;
 #endif
 
-static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static bool flv_video_header(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
 {
 	int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
 
 	if (!packet->data || !packet->size)
-		return;
+		return false;
 
 	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
 
@@ -333,17 +333,15 @@ static void flv_video(struct serializer *s, int32_t dts_offset, struct encoder_p
 	s_w8(s, packet->keyframe ? 0x17 : 0x27);
 	s_w8(s, is_header ? 0 : 1);
 	s_wb24(s, ct_offset_ms);
-	s_write(s, packet->data, packet->size);
-
-	write_previous_tag_size(s);
+	return true;
 }
 
-static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
+static bool flv_audio_header(struct serializer *s, int32_t dts_offset, struct encoder_packet *packet, bool is_header)
 {
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
 
 	if (!packet->data || !packet->size)
-		return;
+		return false;
 
 	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
 
@@ -364,11 +362,23 @@ static void flv_audio(struct serializer *s, int32_t dts_offset, struct encoder_p
 	/* these are the two extra bytes mentioned above */
 	s_w8(s, 0xaf);
 	s_w8(s, is_header ? 0 : 1);
-	s_write(s, packet->data, packet->size);
+	return true;
+}
 
+static inline void flv_packet_payload(struct serializer *s, struct encoder_packet *packet)
+{
+	s_write(s, packet->data, packet->size);
 	write_previous_tag_size(s);
 }
 
+bool flv_packet_mux_header(struct serializer *s, struct encoder_packet *packet, int32_t dts_offset, bool is_header)
+{
+	if (packet->type == OBS_ENCODER_VIDEO)
+		return flv_video_header(s, dts_offset, packet, is_header);
+	else
+		return flv_audio_header(s, dts_offset, packet, is_header);
+}
+
 void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t **output, size_t *size, bool is_header)
 {
 	struct array_output_data data;
@@ -376,23 +386,16 @@ void flv_packet_mux(struct encoder_packet *packet, int32_t dts_offset, uint8_t *
 
 	array_output_serializer_init(&s, &data);
 
-	if (packet->type == OBS_ENCODER_VIDEO)
-		flv_video(&s, dts_offset, packet, is_header);
-	else
-		flv_audio(&s, dts_offset, packet, is_header);
+	if (flv_packet_mux_header(&s, packet, dts_offset, is_header))
+		flv_packet_payload(&s, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
-void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
-			 size_t *size, int type, size_t idx)
+static bool flv_packet_audio_ex_header(struct serializer *s, struct encoder_packet *packet, enum audio_id_t codec_id,
+				       int32_t dts_offset, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-
-	array_output_serializer_init(&s, &data);
-
 	assert(packet->type == OBS_ENCODER_AUDIO);
 
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
@@ -400,13 +403,13 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 	bool is_multitrack = idx > 0;
 
 	if (!packet->data || !packet->size)
-		return;
+		return false;
 
 	int header_metadata_size = 5; // w8+wa4cc
 	if (is_multitrack)
 		header_metadata_size += 2; // w8 + w8
 
-	s_w8(&s, RTMP_PACKET_TYPE_AUDIO);
+	s_w8(s, RTMP_PACKET_TYPE_AUDIO);
 
 #ifdef DEBUG_TIMESTAMPS
 	blog(LOG_DEBUG, "Audio: %lu", time_ms);
@@ -417,36 +420,42 @@ void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id
 	last_time = time_ms;
 #endif
 
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wb24(&s, (uint32_t)time_ms);
-	s_w8(&s, (time_ms >> 24) & 0x7F);
-	s_wb24(&s, 0);
+	s_wb24(s, (uint32_t)packet->size + header_metadata_size);
+	s_wb24(s, (uint32_t)time_ms);
+	s_w8(s, (time_ms >> 24) & 0x7F);
+	s_wb24(s, 0);
 
-	s_w8(&s, AUDIO_HEADER_EX | (is_multitrack ? AUDIO_PACKETTYPE_MULTITRACK : type));
+	s_w8(s, AUDIO_HEADER_EX | (is_multitrack ? AUDIO_PACKETTYPE_MULTITRACK : type));
 	if (is_multitrack) {
-		s_w8(&s, MULTITRACKTYPE_ONE_TRACK | type);
-		s_wa4cc(&s, codec_id);
-		s_w8(&s, (uint8_t)idx);
+		s_w8(s, MULTITRACKTYPE_ONE_TRACK | type);
+		s_wa4cc(s, codec_id);
+		s_w8(s, (uint8_t)idx);
 	} else {
-		s_wa4cc(&s, codec_id);
+		s_wa4cc(s, codec_id);
 	}
 
-	s_write(&s, packet->data, packet->size);
+	return true;
+}
 
-	write_previous_tag_size(&s);
+void flv_packet_audio_ex(struct encoder_packet *packet, enum audio_id_t codec_id, int32_t dts_offset, uint8_t **output,
+			 size_t *size, int type, size_t idx)
+{
+	struct array_output_data data;
+	struct serializer s;
+
+	array_output_serializer_init(&s, &data);
+
+	if (flv_packet_audio_ex_header(&s, packet, codec_id, dts_offset, type, idx))
+		flv_packet_payload(&s, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
 // Y2023 spec
-void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
-		   size_t *size, int type, size_t idx)
+static void flv_packet_ex_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec_id,
+				 int32_t dts_offset, int type, size_t idx)
 {
-	struct array_output_data data;
-	struct serializer s;
-	array_output_serializer_init(&s, &data);
-
 	assert(packet->type == OBS_ENCODER_VIDEO);
 
 	int32_t time_ms = get_ms_time(packet, packet->dts) - dts_offset;
@@ -462,10 +471,10 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 	if (is_multitrack)
 		header_metadata_size += 2; // w8+w8
 
-	s_w8(&s, RTMP_PACKET_TYPE_VIDEO);
-	s_wb24(&s, (uint32_t)packet->size + header_metadata_size);
-	s_wtimestamp(&s, time_ms);
-	s_wb24(&s, 0); // always 0
+	s_w8(s, RTMP_PACKET_TYPE_VIDEO);
+	s_wb24(s, (uint32_t)packet->size + header_metadata_size);
+	s_wtimestamp(s, time_ms);
+	s_wb24(s, 0); // always 0
 
 	uint8_t frame_type = packet->keyframe ? FT_KEY : FT_INTER;
 
@@ -474,32 +483,49 @@ void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int3
 	 * The default trackId is 0.
 	 */
 	if (is_multitrack) {
-		s_w8(&s, FRAME_HEADER_EX | PACKETTYPE_MULTITRACK | frame_type);
-		s_w8(&s, MULTITRACKTYPE_ONE_TRACK | type);
-		s_w4cc(&s, codec_id);
+		s_w8(s, FRAME_HEADER_EX | PACKETTYPE_MULTITRACK | frame_type);
+		s_w8(s, MULTITRACKTYPE_ONE_TRACK | type);
+		s_w4cc(s, codec_id);
 		// trackId
-		s_w8(&s, (uint8_t)idx);
+		s_w8(s, (uint8_t)idx);
 	} else {
-		s_w8(&s, FRAME_HEADER_EX | type | frame_type);
-		s_w4cc(&s, codec_id);
+		s_w8(s, FRAME_HEADER_EX | type | frame_type);
+		s_w4cc(s, codec_id);
 	}
 
 	// H.264/HEVC composition time offset
 	if ((codec_id == CODEC_H264 || codec_id == CODEC_HEVC) && type == PACKETTYPE_FRAMES) {
 		int32_t ct_offset_ms = get_ms_time(packet, packet->pts) - get_ms_time(packet, packet->dts);
-		s_wb24(&s, ct_offset_ms);
+		s_wb24(s, ct_offset_ms);
 	}
 
-	// packet data
-	s_write(&s, packet->data, packet->size);
+}
 
-	// packet tail
-	write_previous_tag_size(&s);
+void flv_packet_ex(struct encoder_packet *packet, enum video_id_t codec_id, int32_t dts_offset, uint8_t **output,
+		   size_t *size, int type, size_t idx)
+{
+	struct array_output_data data;
+	struct serializer s;
+	array_output_serializer_init(&s, &data);
+
+	flv_packet_ex_header(&s, packet, codec_id, dts_offset, type, idx);
+
+	// packet data and tail
+	flv_packet_payload(&s, packet);
 
 	*output = data.bytes.array;
 	*size = data.bytes.num;
 }
 
+static inline int get_frames_packet_type(struct encoder_packet *packet, enum video_id_t codec)
+{
+	// PACKETTYPE_FRAMESX is an optimization to avoid sending composition
+	// time offsets of 0. See Enhanced RTMP spec.
+	if ((codec == CODEC_H264 || codec == CODEC_HEVC) && packet->dts == packet->pts)
+		return PACKETTYPE_FRAMESX;
+	return PACKETTYPE_FRAMES;
+}
+
 void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
 {
 	flv_packet_ex(packet, codec, 0, output, size, PACKETTYPE_SEQ_START, idx);
@@ -508,12 +534,7 @@ void flv_packet_start(struct encoder_packet *packet, enum video_id_t codec, uint
 void flv_packet_frames(struct encoder_packet *packet, enum video_id_t codec, int32_t dts_offset, uint8_t **output,
 		       size_t *size, size_t idx)
 {
-	int packet_type = PACKETTYPE_FRAMES;
-	// PACKETTYPE_FRAMESX is an optimization to avoid sending composition
-	// time offsets of 0. See Enhanced RTMP spec.
-	if ((codec == CODEC_H264 || codec == CODEC_HEVC) && packet->dts == packet->pts)
-		packet_type = PACKETTYPE_FRAMESX;
-	flv_packet_ex(packet, codec, dts_offset, output, size, packet_type, idx);
+	flv_packet_ex(packet, codec, dts_offset, output, size, get_frames_packet_type(packet, codec), idx);
 }
 
 void flv_packet_end(struct encoder_packet *packet, enum video_id_t codec, uint8_t **output, size_t *size, size_t idx)
@@ -533,6 +554,34 @@ void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t code
 	flv_packet_audio_ex(packet, codec, dts_offset, output, size, AUDIO_PACKETTYPE_FRAMES, idx);
 }
 
+void flv_packet_start_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec, size_t idx)
+{
+	flv_packet_ex_header(s, packet, codec, 0, PACKETTYPE_SEQ_START, idx);
+}
+
+void flv_packet_frames_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec,
+			      int32_t dts_offset, size_t idx)
+{
+	flv_packet_ex_header(s, packet, codec, dts_offset, get_frames_packet_type(packet, codec), idx);
+}
+
+void flv_packet_end_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec, size_t idx)
+{
+	flv_packet_ex_header(s, packet, codec, 0, PACKETTYPE_SEQ_END, idx);
+}
+
+bool flv_packet_audio_start_header(struct serializer *s, struct encoder_packet *packet, enum audio_id_t codec,
+				   size_t idx)
+{
+	return flv_packet_audio_ex_header(s, packet, codec, 0, AUDIO_PACKETTYPE_SEQ_START, idx);
+}
+
+bool flv_packet_audio_frames_header(struct serializer *s, struct encoder_packet *packet, enum audio_id_t codec,
+				    int32_t dts_offset, size_t idx)
+{
+	return flv_packet_audio_ex_header(s, packet, codec, dts_offset, AUDIO_PACKETTYPE_FRAMES, idx);
+}
+
 void flv_packet_metadata(enum video_id_t codec_id, uint8_t **output, size_t *size, int bits_per_raw_sample,
 			 uint8_t color_primaries, int color_trc, int color_space, int min_luminance, int max_luminance,
 			 size_t idx)
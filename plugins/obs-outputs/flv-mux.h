@@ -18,6 +18,7 @@
 #pragma once
 
 #include <obs.h>
+#include <util/serializer.h>
 
 #define MILLISECOND_DEN 1000
 
@@ -77,3 +78,21 @@ extern void flv_packet_audio_start(struct encoder_packet *packet, enum audio_id_
 				   size_t idx);
 extern void flv_packet_audio_frames(struct encoder_packet *packet, enum audio_id_t codec, int32_t dts_offset,
 				    uint8_t **output, size_t *size, size_t idx);
+
+/* The *_header variants only write the FLV tag header (and the codec specific
+ * header bytes) to the serializer, so the packet payload can be sent straight
+ * from the encoder packet.  The previous tag size is not written.  Variants
+ * returning bool return false (and write nothing) for packets without a
+ * payload. */
+extern bool flv_packet_mux_header(struct serializer *s, struct encoder_packet *packet, int32_t dts_offset,
+				  bool is_header);
+extern void flv_packet_start_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec,
+				    size_t idx);
+extern void flv_packet_frames_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec,
+				     int32_t dts_offset, size_t idx);
+extern void flv_packet_end_header(struct serializer *s, struct encoder_packet *packet, enum video_id_t codec,
+				  size_t idx);
+extern bool flv_packet_audio_start_header(struct serializer *s, struct encoder_packet *packet, enum audio_id_t codec,
+					  size_t idx);
+extern bool flv_packet_audio_frames_header(struct serializer *s, struct encoder_packet *packet, enum audio_id_t codec,
+					   int32_t dts_offset, size_t idx);
@@ -1576,11 +1576,38 @@ ReadN(RTMP *r, char *buffer, int n)
     return nOriginalSize - n;
 }
 
+/* Returns TRUE if the send should be retried, otherwise the connection has
+ * been closed. */
+static int
+HandleSendError(RTMP *r, const char *func, int n)
+{
+    struct linger l;
+    int sockerr = GetSockError();
+    RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", func,
+             sockerr, n);
+
+    if (sockerr == EINTR && !RTMP_ctrlC)
+        return TRUE;
+
+    r->last_error_code = sockerr;
+
+    // Force-close the socket. Sometimes a send() error isn't fatal, so
+    // we could end up writing an unpublish message which some services
+    // treat as a clean shutdown. We need to disable lingering too so
+    // the remote side sees an abortive shutdown (RST).
+    l.l_onoff = 1;
+    l.l_linger = 0;
+    setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
+    RTMPSockBuf_Close(&r->m_sb);
+
+    RTMP_Close(r);
+    return FALSE;
+}
+
 static int
 WriteN(RTMP *r, const char *buffer, int n)
 {
     const char *ptr = buffer;
-    struct linger l;
 
     while (n > 0)
     {
@@ -1596,25 +1623,9 @@ WriteN(RTMP *r, const char *buffer, int n)
 
         if (nBytes < 0)
         {
-            int sockerr = GetSockError();
-            RTMP_Log(RTMP_LOGERROR, "%s, RTMP send error %d (%d bytes)", __FUNCTION__,
-                     sockerr, n);
-
-            if (sockerr == EINTR && !RTMP_ctrlC)
+            if (HandleSendError(r, __FUNCTION__, n))
                 continue;
 
-            r->last_error_code = sockerr;
-
-            // Force-close the socket. Sometimes a send() error isn't fatal, so
-            // we could end up writing an unpublish message which some services
-            // treat as a clean shutdown. We need to disable lingering too so
-            // the remote side sees an abortive shutdown (RST).
-            l.l_onoff = 1;
-            l.l_linger = 0;
-            setsockopt(r->m_sb.sb_socket, SOL_SOCKET, SO_LINGER, (char *)&l, sizeof(l));
-            RTMPSockBuf_Close(&r->m_sb);
-
-            RTMP_Close(r);
             n = 1;
             break;
         }
@@ -1629,6 +1640,75 @@ WriteN(RTMP *r, const char *buffer, int n)
     return n == 0;
 }
 
+/* Vectored version of WriteN, iov is modified as data is sent.  Only plain
+ * sockets send straight from the caller's buffers: custom send functions get
+ * each buffer in turn, and TLS writes are gathered in to scratch first so
+ * that small chunk headers don't end up in records of their own. */
+static int
+WriteNV(RTMP *r, RTMPIOVec *iov, int iovcnt, char *scratch)
+{
+    int i;
+
+    if (r->m_bCustomSend && r->m_customSendFunc)
+    {
+        for (i = 0; i < iovcnt; i++)
+        {
+            if (iov[i].len && !WriteN(r, iov[i].base, iov[i].len))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    if (scratch)
+    {
+        int size = 0;
+        for (i = 0; i < iovcnt; i++)
+        {
+            memcpy(scratch + size, iov[i].base, iov[i].len);
+            size += iov[i].len;
+        }
+        return WriteN(r, scratch, size);
+    }
+
+    while (iovcnt > 0)
+    {
+        int nBytes;
+
+        while (iovcnt > 0 && !iov->len)
+        {
+            iov++;
+            iovcnt--;
+        }
+        if (!iovcnt)
+            break;
+
+        nBytes = RTMPSockBuf_SendV(&r->m_sb, iov, iovcnt);
+        if (nBytes < 0)
+        {
+            if (HandleSendError(r, __FUNCTION__, iov->len))
+                continue;
+            return FALSE;
+        }
+
+        if (nBytes == 0)
+            return FALSE;
+
+        while (iovcnt > 0 && nBytes >= iov->len)
+        {
+            nBytes -= iov->len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->base += nBytes;
+            iov->len -= nBytes;
+        }
+    }
+
+    return TRUE;
+}
+
 #define SAVC(x)	static const AVal av_##x = AVC(#x)
 
 SAVC(app);
@@ -4085,18 +4165,19 @@ RTMP_SendChunk(RTMP *r, RTMPChunk *chunk)
     return wrote;
 }
 
-int
-RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+/* Encodes the basic and message header of a packet.  The header is placed
+ * directly in front of the packet body if there is one, otherwise in hbuf,
+ * which must be at least RTMP_MAX_HEADER_SIZE bytes. */
+static int
+EncodePacketHeader(RTMP *r, RTMPPacket *packet, char *hbuf, char **pheader, int *phSize,
+                   int *pcSize, uint32_t *pt, char *pc)
 {
     const RTMPPacket *prevPacket;
     uint32_t last = 0;
     int nSize;
     int hSize, cSize;
-    char *header, *hptr, *hend, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    char *header, *hptr, *hend, c;
     uint32_t t;
-    char *buffer, *tbuf = NULL, *toff = NULL;
-    int nChunkSize;
-    int tlen;
 
     if (packet->m_nChannel >= r->m_channelsAllocatedOut)
     {
@@ -4159,7 +4240,7 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     else
     {
         header = hbuf + 6;
-        hend = hbuf + sizeof(hbuf);
+        hend = hbuf + RTMP_MAX_HEADER_SIZE;
     }
 
     if (packet->m_nChannel > 319)
@@ -4217,6 +4298,51 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     if (nSize > 1 && t >= 0xffffff)
         hptr = AMF_EncodeInt32(hptr, hend, t);
 
+    *pheader = header;
+    *phSize = hSize;
+    *pcSize = cSize;
+    *pt = t;
+    *pc = c;
+    return TRUE;
+}
+
+/* Encodes the type 3 header used for every chunk of a message after the
+ * first one, returns its size. */
+static int
+EncodeContinuationHeader(const RTMPPacket *packet, char *buf, int cSize, uint32_t t, char c)
+{
+    int hSize = 0;
+
+    buf[hSize++] = (0xc0 | c);
+    if (cSize)
+    {
+        int tmp = packet->m_nChannel - 64;
+        buf[hSize++] = tmp & 0xff;
+        if (cSize == 2)
+            buf[hSize++] = tmp >> 8;
+    }
+    if (t >= 0xffffff)
+    {
+        AMF_EncodeInt32(buf + hSize, buf + hSize + 4, t);
+        hSize += 4;
+    }
+    return hSize;
+}
+
+int
+RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
+{
+    int nSize;
+    int hSize, cSize;
+    char *header, hbuf[RTMP_MAX_HEADER_SIZE], c;
+    uint32_t t;
+    char *buffer, *tbuf = NULL, *toff = NULL;
+    int nChunkSize;
+    int tlen;
+
+    if (!EncodePacketHeader(r, packet, hbuf, &header, &hSize, &cSize, &t, &c))
+        return FALSE;
+
     nSize = packet->m_nBodySize;
     buffer = packet->m_body;
     nChunkSize = r->m_outChunkSize;
@@ -4320,6 +4446,128 @@ RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue)
     return TRUE;
 }
 
+/* Sends a packet whose body is scattered over several buffers, without
+ * copying the body in to a contiguous buffer first.  Intended for audio and
+ * video messages, invokes are not tracked. */
+int
+RTMP_SendPacketV(RTMP *r, RTMPPacket *packet, const RTMPIOVec *body, int nBody)
+{
+    RTMPIOVec iov[RTMP_MAX_IOVECS + 1];
+    char hbuf[RTMP_MAX_HEADER_SIZE], chbuf[RTMP_MAX_HEADER_SIZE];
+    char *header, c;
+    char *tbuf = NULL, *toff = NULL, *scratch = NULL;
+    int hSize, cSize, nSize, nChunkSize, total = 0;
+    int bodyIdx = 0, bodyOffset = 0;
+    uint32_t t;
+    int i, ret = TRUE;
+
+    if (nBody > RTMP_MAX_IOVECS)
+        return FALSE;
+
+    for (i = 0; i < nBody; i++)
+        total += body[i].len;
+    if (total < (int)packet->m_nBodySize)
+    {
+        RTMP_Log(RTMP_LOGERROR, "%s, body is smaller than the packet size", __FUNCTION__);
+        return FALSE;
+    }
+
+    packet->m_body = NULL;
+    if (!EncodePacketHeader(r, packet, hbuf, &header, &hSize, &cSize, &t, &c))
+        return FALSE;
+
+    nSize = packet->m_nBodySize;
+    nChunkSize = r->m_outChunkSize;
+
+    RTMP_Log(RTMP_LOGDEBUG2, "%s: fd=%d, size=%d", __FUNCTION__, (int)r->m_sb.sb_socket,
+             nSize);
+    /* send all chunks in one HTTP request */
+    if (r->Link.protocol & RTMP_FEATURE_HTTP)
+    {
+        int chunks = (nSize+nChunkSize-1) / nChunkSize;
+        int extra = (t >= 0xffffff) ? 4 : 0;
+        tbuf = malloc(chunks * (cSize + 1 + extra) + nSize + hSize);
+        if (!tbuf)
+            return FALSE;
+        toff = tbuf;
+    }
+#if defined(CRYPTO) && !defined(NO_SSL)
+    else if (r->m_sb.sb_ssl && !(r->m_bCustomSend && r->m_customSendFunc))
+    {
+        scratch = malloc(RTMP_MAX_HEADER_SIZE + nChunkSize);
+        if (!scratch)
+            return FALSE;
+    }
+#endif
+
+    while (nSize + hSize)
+    {
+        int n = 0, remaining;
+
+        if (nSize < nChunkSize)
+            nChunkSize = nSize;
+
+        iov[n].base = header;
+        iov[n++].len = hSize;
+
+        remaining = nChunkSize;
+        while (remaining)
+        {
+            const RTMPIOVec *src = &body[bodyIdx];
+            int len = src->len - bodyOffset;
+            if (len > remaining)
+                len = remaining;
+
+            iov[n].base = src->base + bodyOffset;
+            iov[n++].len = len;
+            remaining -= len;
+            bodyOffset += len;
+            if (bodyOffset == src->len)
+            {
+                bodyIdx++;
+                bodyOffset = 0;
+            }
+        }
+
+        if (tbuf)
+        {
+            for (i = 0; i < n; i++)
+            {
+                memcpy(toff, iov[i].base, iov[i].len);
+                toff += iov[i].len;
+            }
+        }
+        else if (!WriteNV(r, iov, n, scratch))
+        {
+            ret = FALSE;
+            goto out;
+        }
+
+        nSize -= nChunkSize;
+        hSize = 0;
+
+        // prepare to send off remaining data in Type 3 chunks
+        if (nSize > 0)
+        {
+            header = chbuf;
+            hSize = EncodeContinuationHeader(packet, chbuf, cSize, t, c);
+        }
+    }
+    if (tbuf)
+        ret = WriteN(r, tbuf, toff-tbuf);
+
+out:
+    free(tbuf);
+    free(scratch);
+    if (!ret)
+        return FALSE;
+
+    if (!r->m_vecChannelsOut[packet->m_nChannel])
+        r->m_vecChannelsOut[packet->m_nChannel] = malloc(sizeof(RTMPPacket));
+    memcpy(r->m_vecChannelsOut[packet->m_nChannel], packet, sizeof(RTMPPacket));
+    return TRUE;
+}
+
 void
 RTMP_Close(RTMP *r)
 {
@@ -4533,6 +4781,50 @@ RTMPSockBuf_Send(RTMPSockBuf *sb, const char *buf, int len)
     return rc;
 }
 
+int
+RTMPSockBuf_SendV(RTMPSockBuf *sb, const RTMPIOVec *iov, int iovcnt)
+{
+    int rc;
+
+    if (iovcnt > RTMP_MAX_IOVECS + 1)
+        iovcnt = RTMP_MAX_IOVECS + 1;
+
+#if defined(RTMP_NETSTACK_DUMP)
+    for (int i = 0; i < iovcnt; i++)
+        fwrite(iov[i].base, 1, iov[i].len, netstackdump);
+#endif
+
+#ifdef _WIN32
+    {
+        WSABUF bufs[RTMP_MAX_IOVECS + 1];
+        DWORD sent = 0;
+
+        for (int i = 0; i < iovcnt; i++)
+        {
+            bufs[i].buf = (char *)iov[i].base;
+            bufs[i].len = (ULONG)iov[i].len;
+        }
+        rc = WSASend(sb->sb_socket, bufs, (DWORD)iovcnt, &sent, 0, NULL, NULL) == 0 ? (int)sent : -1;
+    }
+#else
+    {
+        struct iovec vecs[RTMP_MAX_IOVECS + 1];
+        struct msghdr msg;
+
+        for (int i = 0; i < iovcnt; i++)
+        {
+            vecs[i].iov_base = (void *)iov[i].base;
+            vecs[i].iov_len = (size_t)iov[i].len;
+        }
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = vecs;
+        msg.msg_iovlen = iovcnt;
+        rc = (int)sendmsg(sb->sb_socket, &msg, MSG_NOSIGNAL);
+    }
+#endif
+    return rc;
+}
+
 int
 RTMPSockBuf_Close(RTMPSockBuf *sb)
 {
@@ -5393,3 +5685,56 @@ RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx)
     }
     return size+s2;
 }
+
+/* Same as RTMP_Write, but for a single FLV tag split over several buffers.
+ * The first buffer has to hold the complete 11 byte FLV tag header, the
+ * message body follows it (bytes past the body size, such as the previous tag
+ * size, are ignored).  The body is chunked straight from the given buffers. */
+int
+RTMP_WriteV(RTMP *r, const RTMPIOVec *iov, int iovcnt, int streamIdx)
+{
+    RTMPPacket pkt = {0};
+    RTMPIOVec body[RTMP_MAX_IOVECS];
+    const char *buf;
+    int i, nBody = 0, size = 0;
+
+    if (iovcnt < 1 || iovcnt > RTMP_MAX_IOVECS || iov[0].len < 11)
+        return 0;
+
+    for (i = 0; i < iovcnt; i++)
+        size += iov[i].len;
+
+    buf = iov[0].base;
+    pkt.m_nChannel = 0x04;	/* source channel */
+    pkt.m_nInfoField2 = r->Link.streams[streamIdx].id;
+    pkt.m_packetType = *buf++;
+    pkt.m_nBodySize = AMF_DecodeInt24(buf);
+    buf += 3;
+    pkt.m_nTimeStamp = AMF_DecodeInt24(buf);
+    buf += 3;
+    pkt.m_nTimeStamp |= *buf++ << 24;
+
+    if (((pkt.m_packetType == RTMP_PACKET_TYPE_AUDIO
+            || pkt.m_packetType == RTMP_PACKET_TYPE_VIDEO) &&
+            !pkt.m_nTimeStamp) || pkt.m_packetType == RTMP_PACKET_TYPE_INFO)
+    {
+        pkt.m_headerType = RTMP_PACKET_SIZE_LARGE;
+    }
+    else
+    {
+        pkt.m_headerType = RTMP_PACKET_SIZE_MEDIUM;
+    }
+
+    if (iov[0].len > 11)
+    {
+        body[nBody].base = iov[0].base + 11;
+        body[nBody++].len = iov[0].len - 11;
+    }
+    for (i = 1; i < iovcnt; i++)
+        body[nBody++] = iov[i];
+
+    if (!RTMP_SendPacketV(r, &pkt, body, nBody))
+        return -1;
+
+    return size;
+}
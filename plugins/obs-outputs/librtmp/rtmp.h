@@ -282,6 +282,15 @@ extern "C"
 
 #define RTMPPacket_IsReady(a)	((a)->m_nBytesRead == (a)->m_nBodySize)
 
+    /* maximum number of buffers accepted by the vectored write functions */
+#define RTMP_MAX_IOVECS 8
+
+    typedef struct RTMPIOVec
+    {
+        const char *base;
+        int len;
+    } RTMPIOVec;
+
     typedef struct RTMP_Stream {
         int id;
         AVal playpath;
@@ -495,6 +504,7 @@ extern "C"
 
     int RTMP_ReadPacket(RTMP *r, RTMPPacket *packet);
     int RTMP_SendPacket(RTMP *r, RTMPPacket *packet, int queue);
+    int RTMP_SendPacketV(RTMP *r, RTMPPacket *packet, const RTMPIOVec *body, int nBody);
     int RTMP_SendChunk(RTMP *r, RTMPChunk *chunk);
     int RTMP_IsConnected(RTMP *r);
     SOCKET RTMP_Socket(RTMP *r);
@@ -534,6 +544,7 @@ extern "C"
 
     int RTMPSockBuf_Fill(RTMPSockBuf *sb);
     int RTMPSockBuf_Send(RTMPSockBuf *sb, const char *buf, int len);
+    int RTMPSockBuf_SendV(RTMPSockBuf *sb, const RTMPIOVec *iov, int iovcnt);
     int RTMPSockBuf_Close(RTMPSockBuf *sb);
 
     int RTMP_SendCreateStream(RTMP *r);
@@ -543,6 +554,7 @@ extern "C"
     void RTMP_DropRequest(RTMP *r, int i, int freeit);
     int RTMP_Read(RTMP *r, char *buf, int size);
     int RTMP_Write(RTMP *r, const char *buf, int size, int streamIdx);
+    int RTMP_WriteV(RTMP *r, const RTMPIOVec *iov, int iovcnt, int streamIdx);
 
 #ifdef USE_HASHSWF
     /* hashswf.c */
@@ -623,3 +623,86 @@ struct obs_output_info mov_output_info = {
 	.get_properties = mp4_output_properties,
 	.get_total_bytes = mp4_output_total_bytes,
 };
+
+/* ------------------------------------------------------------------------- */
+
+static bool codec_in_list(const char *list, const char *codec)
+{
+	size_t len = strlen(codec);
+
+	while (list && *list) {
+		const char *end = strchr(list, ';');
+		size_t item_len = end ? (size_t)(end - list) : strlen(list);
+
+		if (item_len == len && strncmp(list, codec, len) == 0)
+			return true;
+
+		list = end ? end + 1 : NULL;
+	}
+
+	return false;
+}
+
+static bool encoders_supported(obs_output_t *output, const struct obs_output_info *info)
+{
+	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
+		obs_encoder_t *enc = obs_output_get_video_encoder2(output, i);
+		if (enc && !codec_in_list(info->encoded_video_codecs, obs_encoder_get_codec(enc)))
+			return false;
+	}
+
+	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
+		obs_encoder_t *enc = obs_output_get_audio_encoder(output, i);
+		if (enc && !codec_in_list(info->encoded_audio_codecs, obs_encoder_get_codec(enc)))
+			return false;
+	}
+
+	return true;
+}
+
+/* Muxes an array of interleaved packets of an output straight to a file.
+ * Registered as a global procedure so the replay buffer can save to MP4/MOV
+ * in-process rather than through an ffmpeg-mux process. */
+void mp4_write_packets_proc(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+
+	obs_output_t *output = calldata_ptr(cd, "output");
+	struct encoder_packet *packets = calldata_ptr(cd, "packets");
+	size_t num_packets = (size_t)calldata_int(cd, "num_packets");
+	const char *path = calldata_string(cd, "path");
+	const char *ext = path ? strrchr(path, '.') : NULL;
+	enum mp4_flavor flavor = ext && astrcmpi(ext, ".mov") == 0 ? FLAVOR_MOV : FLAVOR_MP4;
+	const struct obs_output_info *info = flavor == FLAVOR_MOV ? &mov_output_info : &mp4_output_info;
+	struct serializer serializer;
+	struct mp4_mux *muxer;
+	bool success = true;
+
+	calldata_set_bool(cd, "supported", false);
+	calldata_set_bool(cd, "success", false);
+
+	if (!output || !packets || !path || !encoders_supported(output, info))
+		return;
+
+	calldata_set_bool(cd, "supported", true);
+
+	if (!buffered_file_serializer_init_defaults(&serializer, path)) {
+		blog(LOG_WARNING, "[mp4 mux] Unable to open file '%s'", path);
+		return;
+	}
+
+	muxer = mp4_mux_create(output, &serializer, MP4_USE_NEGATIVE_CTS, flavor);
+
+	for (size_t i = 0; success && i < num_packets; i++)
+		success = mp4_mux_submit_packet(muxer, &packets[i]);
+	if (success)
+		success = mp4_mux_finalise(muxer);
+
+	buffered_file_serializer_free(&serializer);
+
+	/* The muxer may still hold references to the caller's packets, so it
+	 * has to be gone before returning. */
+	mp4_mux_destroy(muxer);
+
+	calldata_set_bool(cd, "success", success);
+}
@@ -18,6 +18,8 @@ extern struct obs_output_info flv_output_info;
 extern struct obs_output_info mp4_output_info;
 extern struct obs_output_info mov_output_info;
 
+extern void mp4_write_packets_proc(void *data, calldata_t *cd);
+
 #if defined(_WIN32) && defined(MBEDTLS_THREADING_ALT)
 void mbed_mutex_init(mbedtls_threading_mutex_t *m)
 {
@@ -65,6 +67,12 @@ bool obs_module_load(void)
 	obs_register_output(&flv_output_info);
 	obs_register_output(&mp4_output_info);
 	obs_register_output(&mov_output_info);
+
+	proc_handler_t *ph = obs_get_proc_handler();
+	proc_handler_add(ph,
+			 "void mp4_write_packets(ptr output, ptr packets, int num_packets, string path, "
+			 "out bool supported, out bool success)",
+			 mp4_write_packets_proc, NULL);
 	return true;
 }
 
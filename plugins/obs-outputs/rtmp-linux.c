@@ -0,0 +1,319 @@
+#ifdef __linux__
+#include "rtmp-stream.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+static void fatal_sock_shutdown(struct rtmp_stream *stream)
+{
+	close(stream->rtmp.m_sb.sb_socket);
+	stream->rtmp.m_sb.sb_socket = -1;
+	stream->write_buf_len = 0;
+	os_event_signal(stream->buffer_space_available_event);
+}
+
+static bool socket_event(struct rtmp_stream *stream, uint32_t events, bool *can_write, uint64_t last_send_time)
+{
+	if (events & EPOLLERR) {
+		int err_code = 0;
+		socklen_t size = sizeof(err_code);
+
+		getsockopt(stream->rtmp.m_sb.sb_socket, SOL_SOCKET, SO_ERROR, &err_code, &size);
+
+		blog(LOG_ERROR,
+		     "socket_thread_linux: Aborting due to "
+		     "socket error %d",
+		     err_code);
+		stream->rtmp.last_error_code = err_code;
+		fatal_sock_shutdown(stream);
+		return false;
+	}
+
+	if (events & EPOLLOUT)
+		*can_write = true;
+
+	/* the socket is edge triggered, so incoming data has to be drained
+	 * until recv() would block, which is also how a remote close (recv()
+	 * returning 0) gets picked up */
+	if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)) {
+		char discard[16384];
+
+		for (;;) {
+			ssize_t ret = recv(stream->rtmp.m_sb.sb_socket, discard, sizeof(discard), 0);
+			if (ret > 0)
+				continue;
+
+			if (ret == -1) {
+				int err_code = errno;
+				if (err_code == EAGAIN || err_code == EWOULDBLOCK)
+					break;
+				if (err_code == EINTR)
+					continue;
+
+				blog(LOG_ERROR,
+				     "socket_thread_linux: "
+				     "Socket error, recv() returned "
+				     "%d, errno %d",
+				     (int)ret, err_code);
+				stream->rtmp.last_error_code = err_code;
+				fatal_sock_shutdown(stream);
+				return false;
+			}
+
+			if (last_send_time) {
+				uint32_t diff = (os_gettime_ns() / 1000000) - last_send_time;
+
+				blog(LOG_ERROR,
+				     "socket_thread_linux: Received "
+				     "connection close, %u ms since last "
+				     "send (buffer: %zu / %zu)",
+				     diff, stream->write_buf_len, stream->write_buf_size);
+			}
+
+			if (os_event_try(stream->stop_event) != EAGAIN)
+				blog(LOG_ERROR,
+				     "socket_thread_linux: Aborting due "
+				     "to connection close during shutdown, "
+				     "%zu bytes lost",
+				     stream->write_buf_len);
+			else
+				blog(LOG_ERROR, "socket_thread_linux: Aborting due "
+						"to connection close");
+
+			stream->rtmp.last_error_code = ECONNRESET;
+			fatal_sock_shutdown(stream);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+enum data_ret { RET_BREAK, RET_FATAL, RET_CONTINUE };
+
+static enum data_ret write_data(struct rtmp_stream *stream, bool *can_write, uint64_t *last_send_time,
+				size_t latency_packet_size, int delay_time)
+{
+	bool exit_loop = false;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+
+	if (!stream->write_buf_len) {
+		/* same as on windows, the buffer may already have been
+		 * emptied by a previous loop cycle */
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+		return RET_BREAK;
+	}
+
+	int ret;
+	if (stream->low_latency_mode) {
+		size_t send_len = latency_packet_size < stream->write_buf_len ? latency_packet_size
+									     : stream->write_buf_len;
+
+		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb, (const char *)stream->write_buf, (int)send_len);
+	} else {
+		ret = RTMPSockBuf_Send(&stream->rtmp.m_sb, (const char *)stream->write_buf, (int)stream->write_buf_len);
+	}
+
+	if (ret > 0) {
+		if (stream->write_buf_len - ret)
+			memmove(stream->write_buf, stream->write_buf + ret, stream->write_buf_len - ret);
+		stream->write_buf_len -= ret;
+
+		*last_send_time = os_gettime_ns() / 1000000;
+
+		os_event_signal(stream->buffer_space_available_event);
+	} else {
+		int err_code = ret == -1 ? errno : 0;
+
+		if (err_code == EINTR) {
+			pthread_mutex_unlock(&stream->write_buf_mutex);
+			return RET_CONTINUE;
+		}
+
+		if (err_code == EAGAIN || err_code == EWOULDBLOCK) {
+			*can_write = false;
+			pthread_mutex_unlock(&stream->write_buf_mutex);
+			return RET_BREAK;
+		}
+
+		/* connection closed, or connection was aborted /
+		 * socket closed / etc, that's a fatal error. */
+		blog(LOG_ERROR,
+		     "socket_thread_linux: "
+		     "Socket error, send() returned %d, "
+		     "errno %d",
+		     ret, err_code);
+
+		pthread_mutex_unlock(&stream->write_buf_mutex);
+		stream->rtmp.last_error_code = err_code;
+		fatal_sock_shutdown(stream);
+		return RET_FATAL;
+	}
+
+	/* finish writing for now */
+	if (stream->write_buf_len <= 1000)
+		exit_loop = true;
+
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	if (delay_time)
+		os_sleep_ms(delay_time);
+
+	return exit_loop ? RET_BREAK : RET_CONTINUE;
+}
+
+/* linux has no ideal send backlog notification, the kernel already sizes the
+ * send buffer by itself.  in low latency mode the amount of unsent data the
+ * kernel may hold is capped instead, so that data stays in write_buf where it
+ * counts towards congestion rather than hiding in the socket buffer. */
+static void set_send_backlog(struct rtmp_stream *stream, size_t latency_packet_size)
+{
+	if (stream->disable_send_window_optimization) {
+		blog(LOG_INFO, "socket_thread_linux: Send window "
+			       "optimization disabled by user.");
+		return;
+	}
+
+	if (!stream->low_latency_mode)
+		return;
+
+#ifdef TCP_NOTSENT_LOWAT
+	int lowat = (int)latency_packet_size;
+	if (setsockopt(stream->rtmp.m_sb.sb_socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat)) == 0)
+		blog(LOG_INFO,
+		     "socket_thread_linux: Limiting unsent "
+		     "socket data to %d bytes",
+		     lowat);
+	else
+		blog(LOG_WARNING,
+		     "socket_thread_linux: Failed to set "
+		     "TCP_NOTSENT_LOWAT, errno %d",
+		     errno);
+#else
+	UNUSED_PARAMETER(latency_packet_size);
+#endif
+}
+
+#define LATENCY_FACTOR 20
+
+static inline void socket_thread_linux_internal(struct rtmp_stream *stream)
+{
+	bool can_write = false;
+
+	int delay_time;
+	size_t latency_packet_size;
+	uint64_t last_send_time = 0;
+
+	struct epoll_event ev = {0};
+	struct epoll_event events[2];
+	int epoll_fd;
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd == -1) {
+		blog(LOG_ERROR, "socket_thread_linux: Aborting due to epoll_create1 failure, errno %d", errno);
+		fatal_sock_shutdown(stream);
+		return;
+	}
+
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.fd = stream->rtmp.m_sb.sb_socket;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stream->rtmp.m_sb.sb_socket, &ev) == -1)
+		goto fail;
+
+	ev.events = EPOLLIN;
+	ev.data.fd = stream->socket_wake_fd;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, stream->socket_wake_fd, &ev) == -1)
+		goto fail;
+
+	if (stream->low_latency_mode) {
+		delay_time = 1000 / LATENCY_FACTOR;
+		latency_packet_size = stream->write_buf_size / (LATENCY_FACTOR - 2);
+	} else {
+		latency_packet_size = stream->write_buf_size;
+		delay_time = 0;
+	}
+
+	set_send_backlog(stream, latency_packet_size);
+
+	for (;;) {
+		if (os_event_try(stream->send_thread_signaled_exit) != EAGAIN) {
+			pthread_mutex_lock(&stream->write_buf_mutex);
+			if (stream->write_buf_len == 0) {
+				pthread_mutex_unlock(&stream->write_buf_mutex);
+				os_event_reset(stream->send_thread_signaled_exit);
+				break;
+			}
+
+			pthread_mutex_unlock(&stream->write_buf_mutex);
+		}
+
+		int count = epoll_wait(epoll_fd, events, 2, -1);
+		if (count == -1) {
+			if (errno == EINTR)
+				continue;
+
+			blog(LOG_ERROR, "socket_thread_linux: Aborting due to epoll_wait failure, errno %d", errno);
+			fatal_sock_shutdown(stream);
+			close(epoll_fd);
+			return;
+		}
+
+		for (int i = 0; i < count; i++) {
+			if (events[i].data.fd == stream->socket_wake_fd) {
+				/* buffer has data, or the send thread is
+				 * exiting */
+				eventfd_t val;
+				eventfd_read(stream->socket_wake_fd, &val);
+
+			} else if (!socket_event(stream, events[i].events, &can_write, last_send_time)) {
+				close(epoll_fd);
+				return;
+			}
+		}
+
+		if (can_write) {
+			for (;;) {
+				enum data_ret ret = write_data(stream, &can_write, &last_send_time, latency_packet_size,
+							       delay_time);
+
+				switch (ret) {
+				case RET_BREAK:
+					goto exit_write_loop;
+				case RET_FATAL:
+					close(epoll_fd);
+					return;
+				case RET_CONTINUE:;
+				}
+			}
+		}
+	exit_write_loop:;
+	}
+
+	close(epoll_fd);
+	blog(LOG_INFO, "socket_thread_linux: Normal exit");
+	return;
+
+fail:
+	blog(LOG_ERROR, "socket_thread_linux: Aborting due to epoll_ctl failure, errno %d", errno);
+	close(epoll_fd);
+	fatal_sock_shutdown(stream);
+}
+
+void *socket_thread_linux(void *data)
+{
+	struct rtmp_stream *stream = data;
+
+	os_set_thread_name("rtmp-stream: socket_thread");
+	socket_thread_linux_internal(stream);
+	return NULL;
+}
+
+void socket_thread_linux_wake(struct rtmp_stream *stream)
+{
+	eventfd_write(stream->socket_wake_fd, 1);
+}
+#endif
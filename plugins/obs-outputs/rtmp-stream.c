@@ -21,11 +21,15 @@
 
 #include <obs-avc.h>
 #include <obs-hevc.h>
+#include <util/array-serializer.h>
 
 #include <jansson.h>
 
 #ifdef _WIN32
 #include <util/windows/win-version.h>
+#elif defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
 #endif
 
 #ifndef SEC_TO_NSEC
@@ -46,6 +50,8 @@
 #define MIN_ESTIMATE_DURATION_MS 1000
 #define MAX_ESTIMATE_DURATION_MS 2000
 
+#define PACKET_RING_SIZE 2048
+
 static const char *rtmp_stream_getname(void *unused)
 {
 	UNUSED_PARAMETER(unused);
@@ -64,16 +70,23 @@ static inline size_t num_buffered_packets(struct rtmp_stream *stream);
 
 static inline void free_packets(struct rtmp_stream *stream)
 {
+	struct encoder_packet packet;
 	size_t num_packets;
 
 	pthread_mutex_lock(&stream->packets_mutex);
 
 	num_packets = num_buffered_packets(stream);
+	if (stream->packet_ring) {
+		num_packets += os_spsc_ring_size(stream->packet_ring);
+		while (os_spsc_ring_pop(stream->packet_ring, &packet))
+			obs_encoder_packet_release(&packet);
+	}
+	os_atomic_set_bool(&stream->packet_ring_overflow, false);
+
 	if (num_packets)
 		info("Freeing %d remaining packets", (int)num_packets);
 
 	while (stream->packets.size) {
-		struct encoder_packet packet;
 		deque_pop_front(&stream->packets, &packet, sizeof(packet));
 		obs_encoder_packet_release(&packet);
 	}
@@ -115,7 +128,7 @@ static void rtmp_stream_destroy(void *data)
 		os_event_signal(stream->stop_event);
 
 		if (active(stream)) {
-			os_sem_post(stream->send_sem);
+			os_ring_waiter_wake(&stream->send_waiter);
 			obs_output_end_data_capture(stream->output);
 			pthread_join(stream->send_thread, NULL);
 		}
@@ -130,7 +143,8 @@ static void rtmp_stream_destroy(void *data)
 	dstr_free(&stream->encoder_name);
 	dstr_free(&stream->bind_ip);
 	os_event_destroy(stream->stop_event);
-	os_sem_destroy(stream->send_sem);
+	os_ring_waiter_free(&stream->send_waiter);
+	os_spsc_ring_destroy(stream->packet_ring);
 	pthread_mutex_destroy(&stream->packets_mutex);
 	deque_free(&stream->packets);
 #ifdef TEST_FRAMEDROPS
@@ -145,6 +159,10 @@ static void rtmp_stream_destroy(void *data)
 	os_event_destroy(stream->socket_available_event);
 	os_event_destroy(stream->send_thread_signaled_exit);
 	pthread_mutex_destroy(&stream->write_buf_mutex);
+#ifdef __linux__
+	if (stream->socket_wake_fd != -1)
+		close(stream->socket_wake_fd);
+#endif
 
 	if (stream->write_buf)
 		bfree(stream->write_buf);
@@ -156,6 +174,9 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
 	pthread_mutex_init_value(&stream->packets_mutex);
+#ifdef __linux__
+	stream->socket_wake_fd = -1;
+#endif
 
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_LogSetLevel(RTMP_LOGWARNING);
@@ -164,6 +185,10 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	if (os_event_init(&stream->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
+	if (os_ring_waiter_init(&stream->send_waiter) != 0)
+		goto fail;
+
+	stream->packet_ring = os_spsc_ring_create(sizeof(struct encoder_packet), PACKET_RING_SIZE);
 
 	if (pthread_mutex_init(&stream->write_buf_mutex, NULL) != 0) {
 		warn("Failed to initialize write buffer mutex");
@@ -191,6 +216,13 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		warn("Failed to initialize socket exit event");
 		goto fail;
 	}
+#ifdef __linux__
+	stream->socket_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (stream->socket_wake_fd == -1) {
+		warn("Failed to initialize socket wake fd");
+		goto fail;
+	}
+#endif
 
 	UNUSED_PARAMETER(settings);
 	return stream;
@@ -217,8 +249,7 @@ static void rtmp_stream_stop(void *data, uint64_t ts)
 
 	if (active(stream)) {
 		os_event_signal(stream->stop_event);
-		if (stream->stop_ts == 0)
-			os_sem_post(stream->send_sem);
+		os_ring_waiter_wake(&stream->send_waiter);
 	} else {
 		obs_output_signal_stop(stream->output, OBS_OUTPUT_SUCCESS);
 	}
@@ -231,11 +262,14 @@ static inline void set_rtmp_dstr(AVal *val, struct dstr *str)
 	val->av_len = valid ? (int)str->len : 0;
 }
 
+static void receive_packets(struct rtmp_stream *stream);
+
 static inline bool get_next_packet(struct rtmp_stream *stream, struct encoder_packet *packet)
 {
 	bool new_packet = false;
 
 	pthread_mutex_lock(&stream->packets_mutex);
+	receive_packets(stream);
 	if (stream->packets.size) {
 		deque_pop_front(&stream->packets, packet, sizeof(struct encoder_packet));
 		new_packet = true;
@@ -344,7 +378,15 @@ static void droptest_cap_data_rate(struct rtmp_stream *stream, size_t size)
 }
 #endif
 
-#ifdef _WIN32
+static inline void signal_buffer_has_data(struct rtmp_stream *stream)
+{
+	os_event_signal(stream->buffer_has_data_event);
+#ifdef __linux__
+	socket_thread_linux_wake(stream);
+#endif
+}
+
+#ifdef HAVE_SOCKET_THREAD
 static int socket_queue_data(RTMPSockBuf *sb, const char *data, int len, void *arg)
 {
 	UNUSED_PARAMETER(sb);
@@ -374,11 +416,11 @@ retry_send:
 
 	pthread_mutex_unlock(&stream->write_buf_mutex);
 
-	os_event_signal(stream->buffer_has_data_event);
+	signal_buffer_has_data(stream);
 
 	return len;
 }
-#endif // _WIN32
+#endif // HAVE_SOCKET_THREAD
 
 static int handle_socket_read(struct rtmp_stream *stream)
 {
@@ -399,23 +441,48 @@ static int handle_socket_read(struct rtmp_stream *stream)
 	return 0;
 }
 
+/* sends the FLV tag header followed by the packet payload, the payload is
+ * chunked straight from the encoder packet rather than being copied in to an
+ * FLV tag first */
+static int write_flv_packet(struct rtmp_stream *stream, struct array_output_data *header,
+			    struct encoder_packet *packet, size_t *size)
+{
+	RTMPIOVec iov[2];
+
+	*size = 0;
+	if (!header->bytes.num)
+		return 0;
+
+	iov[0].base = (const char *)header->bytes.array;
+	iov[0].len = (int)header->bytes.num;
+	iov[1].base = (const char *)packet->data;
+	iov[1].len = (int)packet->size;
+
+	/* previous tag size, which isn't sent over RTMP */
+	*size = header->bytes.num + packet->size + 4;
+
+#ifdef TEST_FRAMEDROPS
+	droptest_cap_data_rate(stream, *size);
+#endif
+
+	return RTMP_WriteV(&stream->rtmp, iov, 2, 0);
+}
+
 static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header)
 {
-	uint8_t *data;
+	struct array_output_data header;
+	struct serializer s;
 	size_t size;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
-	flv_packet_mux(packet, is_header ? 0 : stream->start_dts_offset, &data, &size, is_header);
-
-#ifdef TEST_FRAMEDROPS
-	droptest_cap_data_rate(stream, size);
-#endif
+	array_output_serializer_init(&s, &header);
+	flv_packet_mux_header(&s, packet, is_header ? 0 : stream->start_dts_offset, is_header);
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = write_flv_packet(stream, &header, packet, &size);
+	array_output_serializer_free(&header);
 
 	if (is_header)
 		bfree(packet->data);
@@ -429,27 +496,26 @@ static int send_packet(struct rtmp_stream *stream, struct encoder_packet *packet
 static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, bool is_footer,
 			  size_t idx)
 {
-	uint8_t *data;
+	struct array_output_data header;
+	struct serializer s;
 	size_t size = 0;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
+	array_output_serializer_init(&s, &header);
+
 	if (is_header) {
-		flv_packet_start(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_start_header(&s, packet, stream->video_codec[idx], idx);
 	} else if (is_footer) {
-		flv_packet_end(packet, stream->video_codec[idx], &data, &size, idx);
+		flv_packet_end_header(&s, packet, stream->video_codec[idx], idx);
 	} else {
-		flv_packet_frames(packet, stream->video_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_frames_header(&s, packet, stream->video_codec[idx], stream->start_dts_offset, idx);
 	}
 
-#ifdef TEST_FRAMEDROPS
-	droptest_cap_data_rate(stream, size);
-#endif
-
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = write_flv_packet(stream, &header, packet, &size);
+	array_output_serializer_free(&header);
 
 	if (is_header || is_footer) // manually created packets
 		bfree(packet->data);
@@ -462,21 +528,24 @@ static int send_packet_ex(struct rtmp_stream *stream, struct encoder_packet *pac
 
 static int send_audio_packet_ex(struct rtmp_stream *stream, struct encoder_packet *packet, bool is_header, size_t idx)
 {
-	uint8_t *data;
+	struct array_output_data header;
+	struct serializer s;
 	size_t size = 0;
 	int ret = 0;
 
 	if (handle_socket_read(stream))
 		return -1;
 
+	array_output_serializer_init(&s, &header);
+
 	if (is_header) {
-		flv_packet_audio_start(packet, stream->audio_codec[idx], &data, &size, idx);
+		flv_packet_audio_start_header(&s, packet, stream->audio_codec[idx], idx);
 	} else {
-		flv_packet_audio_frames(packet, stream->audio_codec[idx], stream->start_dts_offset, &data, &size, idx);
+		flv_packet_audio_frames_header(&s, packet, stream->audio_codec[idx], stream->start_dts_offset, idx);
 	}
 
-	ret = RTMP_Write(&stream->rtmp, (char *)data, (int)size, 0);
-	bfree(data);
+	ret = write_flv_packet(stream, &header, packet, &size);
+	array_output_serializer_free(&header);
 
 	if (is_header)
 		bfree(packet->data);
@@ -639,7 +708,7 @@ static void *send_thread(void *data)
 	log_sndbuf_size(stream);
 #endif
 
-	while (os_sem_wait(stream->send_sem) == 0) {
+	for (;;) {
 		struct encoder_packet packet;
 		struct dbr_frame dbr_frame;
 
@@ -647,8 +716,16 @@ static void *send_thread(void *data)
 			break;
 		}
 
-		if (!get_next_packet(stream, &packet))
+		if (!get_next_packet(stream, &packet)) {
+			os_ring_waiter_prepare(&stream->send_waiter);
+			/* a graceful stop keeps waiting for packets up to stop_ts,
+			 * so only an immediate stop may skip the wait */
+			if (os_spsc_ring_size(stream->packet_ring) || (stopping(stream) && stream->stop_ts == 0))
+				os_ring_waiter_cancel(&stream->send_waiter);
+			else
+				os_ring_waiter_wait(&stream->send_waiter);
 			continue;
+		}
 
 		if (stopping(stream)) {
 			if (can_shutdown_stream(stream, &packet)) {
@@ -712,7 +789,7 @@ static void *send_thread(void *data)
 
 	if (stream->new_socket_loop) {
 		os_event_signal(stream->send_thread_signaled_exit);
-		os_event_signal(stream->buffer_has_data_event);
+		signal_buffer_has_data(stream);
 		pthread_join(stream->socket_thread, NULL);
 		stream->socket_thread_active = false;
 		stream->rtmp.m_bCustomSend = false;
@@ -969,19 +1046,11 @@ static inline bool send_footers(struct rtmp_stream *stream)
 	return true;
 }
 
-static inline bool reset_semaphore(struct rtmp_stream *stream)
-{
-	os_sem_destroy(stream->send_sem);
-	return os_sem_init(&stream->send_sem, 0) == 0;
-}
-
 static int init_send(struct rtmp_stream *stream)
 {
 	int ret;
 	obs_output_t *context = stream->output;
 
-	reset_semaphore(stream);
-
 	ret = pthread_create(&stream->send_thread, NULL, send_thread, stream);
 	if (ret != 0) {
 		RTMP_Close(&stream->rtmp);
@@ -1058,11 +1127,15 @@ static int init_send(struct rtmp_stream *stream)
 		stream->write_buf_size = ideal_buffer_size;
 		stream->write_buf = bmalloc(ideal_buffer_size);
 
-#ifndef _WIN32
+#ifndef HAVE_SOCKET_THREAD
 		warn("New socket loop not supported on this platform");
 		return OBS_OUTPUT_ERROR;
 #else
+#ifdef _WIN32
 		ret = pthread_create(&stream->socket_thread, NULL, socket_thread_windows, stream);
+#else
+		ret = pthread_create(&stream->socket_thread, NULL, socket_thread_linux, stream);
+#endif
 
 		if (ret != 0) {
 			RTMP_Close(&stream->rtmp);
@@ -1346,6 +1419,7 @@ static bool init_connect(struct rtmp_stream *stream)
 	os_atomic_set_bool(&stream->encode_error, false);
 	stream->total_bytes_sent = 0;
 	stream->dropped_frames = 0;
+	os_atomic_set_long(&stream->ring_dropped_frames, 0);
 	stream->min_priority = 0;
 	stream->got_first_packet = false;
 
@@ -1478,7 +1552,7 @@ static bool init_connect(struct rtmp_stream *stream)
 		stream->addrlen_hint = len;
 	}
 
-#ifdef _WIN32
+#ifdef HAVE_SOCKET_THREAD
 	stream->new_socket_loop = obs_data_get_bool(settings, OPT_NEWSOCKETLOOP_ENABLED);
 	stream->low_latency_mode = obs_data_get_bool(settings, OPT_LOWLATENCY_ENABLED);
 
@@ -1835,11 +1909,34 @@ static bool add_video_packet(struct rtmp_stream *stream, struct encoder_packet *
 	return add_packet(stream, packet);
 }
 
+/* moves packets queued by rtmp_stream_data into the packet buffer, called on
+ * the send thread with packets_mutex locked */
+static void receive_packets(struct rtmp_stream *stream)
+{
+	struct encoder_packet packet;
+
+	/* the ring overflowed, so video frames were lost and everything up to
+	 * the next keyframe has to go as well */
+	if (os_atomic_set_bool(&stream->packet_ring_overflow, false))
+		stream->min_priority = OBS_NAL_PRIORITY_HIGHEST;
+
+	while (os_spsc_ring_pop(stream->packet_ring, &packet)) {
+		bool added_packet = false;
+
+		if (!disconnected(stream)) {
+			added_packet = (packet.type == OBS_ENCODER_VIDEO) ? add_video_packet(stream, &packet)
+									  : add_packet(stream, &packet);
+		}
+
+		if (!added_packet)
+			obs_encoder_packet_release(&packet);
+	}
+}
+
 static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 {
 	struct rtmp_stream *stream = data;
 	struct encoder_packet new_packet;
-	bool added_packet = false;
 
 	if (disconnected(stream) || !active(stream))
 		return;
@@ -1847,7 +1944,7 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 	/* encoder fail */
 	if (!packet) {
 		os_atomic_set_bool(&stream->encode_error, true);
-		os_sem_post(stream->send_sem);
+		os_ring_waiter_wake(&stream->send_waiter);
 		return;
 	}
 
@@ -1885,19 +1982,17 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 		obs_encoder_packet_ref(&new_packet, packet);
 	}
 
-	pthread_mutex_lock(&stream->packets_mutex);
-
-	if (!disconnected(stream)) {
-		added_packet = (packet->type == OBS_ENCODER_VIDEO) ? add_video_packet(stream, &new_packet)
-								   : add_packet(stream, &new_packet);
+	if (os_spsc_ring_push(stream->packet_ring, &new_packet)) {
+		os_ring_waiter_notify(&stream->send_waiter);
+		return;
 	}
 
-	pthread_mutex_unlock(&stream->packets_mutex);
-
-	if (added_packet)
-		os_sem_post(stream->send_sem);
-	else
-		obs_encoder_packet_release(&new_packet);
+	/* the send thread hasn't picked up packets in a long time */
+	if (new_packet.type == OBS_ENCODER_VIDEO) {
+		os_atomic_set_bool(&stream->packet_ring_overflow, true);
+		os_atomic_inc_long(&stream->ring_dropped_frames);
+	}
+	obs_encoder_packet_release(&new_packet);
 }
 
 static void rtmp_stream_defaults(obs_data_t *defaults)
@@ -1906,7 +2001,7 @@ static void rtmp_stream_defaults(obs_data_t *defaults)
 	obs_data_set_default_int(defaults, OPT_PFRAME_DROP_THRESHOLD, 900);
 	obs_data_set_default_int(defaults, OPT_MAX_SHUTDOWN_TIME_SEC, 30);
 	obs_data_set_default_string(defaults, OPT_BIND_IP, "default");
-#ifdef _WIN32
+#ifdef HAVE_SOCKET_THREAD
 	obs_data_set_default_bool(defaults, OPT_NEWSOCKETLOOP_ENABLED, false);
 	obs_data_set_default_bool(defaults, OPT_LOWLATENCY_ENABLED, false);
 #endif
@@ -1943,7 +2038,7 @@ static obs_properties_t *rtmp_stream_properties(void *unused)
 	}
 	netif_saddr_data_free(&addrs);
 
-#ifdef _WIN32
+#ifdef HAVE_SOCKET_THREAD
 	obs_properties_add_bool(props, OPT_NEWSOCKETLOOP_ENABLED, obs_module_text("RTMPStream.NewSocketLoop"));
 	obs_properties_add_bool(props, OPT_LOWLATENCY_ENABLED, obs_module_text("RTMPStream.LowLatencyMode"));
 #endif
@@ -1960,7 +2055,7 @@ static uint64_t rtmp_stream_total_bytes_sent(void *data)
 static int rtmp_stream_dropped_frames(void *data)
 {
 	struct rtmp_stream *stream = data;
-	return stream->dropped_frames;
+	return stream->dropped_frames + (int)os_atomic_load_long(&stream->ring_dropped_frames);
 }
 
 static float rtmp_stream_congestion(void *data)
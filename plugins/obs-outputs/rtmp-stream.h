@@ -1,6 +1,7 @@
 #include <obs-module.h>
 #include <util/platform.h>
 #include <util/deque.h>
+#include <util/ring.h>
 #include <util/dstr.h>
 #include <util/threading.h>
 #include <inttypes.h>
@@ -15,6 +16,10 @@
 #include <sys/ioctl.h>
 #endif
 
+#if defined(_WIN32) || defined(__linux__)
+#define HAVE_SOCKET_THREAD
+#endif
+
 #define do_log(level, format, ...) \
 	blog(level, "[rtmp stream: '%s'] " format, obs_output_get_name(stream->output), ##__VA_ARGS__)
 
@@ -60,6 +65,13 @@ struct dbr_interpolation_point {
 struct rtmp_stream {
 	obs_output_t *output;
 
+	/* encoder packets are handed to the send thread through packet_ring,
+	 * the send thread then moves them into packets, where frame dropping
+	 * happens */
+	os_spsc_ring_t *packet_ring;
+	struct os_ring_waiter send_waiter;
+	volatile bool packet_ring_overflow;
+
 	pthread_mutex_t packets_mutex;
 	struct deque packets;
 	bool sent_headers;
@@ -77,7 +89,6 @@ struct rtmp_stream {
 
 	int max_shutdown_time_sec;
 
-	os_sem_t *send_sem;
 	os_event_t *stop_event;
 	uint64_t stop_ts;
 	uint64_t shutdown_timeout_ts;
@@ -98,6 +109,7 @@ struct rtmp_stream {
 
 	uint64_t total_bytes_sent;
 	int dropped_frames;
+	volatile long ring_dropped_frames;
 
 #ifdef TEST_FRAMEDROPS
 	struct deque droptest_info;
@@ -137,10 +149,16 @@ struct rtmp_stream {
 	os_event_t *buffer_has_data_event;
 	os_event_t *socket_available_event;
 	os_event_t *send_thread_signaled_exit;
+#ifdef __linux__
+	int socket_wake_fd;
+#endif
 };
 
 #ifdef _WIN32
 void *socket_thread_windows(void *data);
+#elif defined(__linux__)
+void *socket_thread_linux(void *data);
+void socket_thread_linux_wake(struct rtmp_stream *stream);
 #endif
 
 /* Adapted from FFmpeg's libavutil/pixfmt.h
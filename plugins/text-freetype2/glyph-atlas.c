@@ -0,0 +1,286 @@
+/******************************************************************************
+    Copyright (C) 2026 by OBS Project contributors
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <obs-module.h>
+#include <util/darray.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include "text-freetype2.h"
+
+/* Atlases are shared between all sources using the same font file, face,
+ * size and render mode, so that each glyph is only rasterized and uploaded
+ * once no matter how many sources display it. */
+
+extern uint32_t texbuf_w, texbuf_h;
+
+static pthread_mutex_t atlas_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(struct glyph_atlas *) atlases;
+
+static inline FT_Render_Mode get_render_mode(struct glyph_atlas *atlas)
+{
+	return atlas->antialiasing ? FT_RENDER_MODE_NORMAL : FT_RENDER_MODE_MONO;
+}
+
+void glyph_atlas_load_glyph(struct glyph_atlas *atlas, const FT_UInt glyph_index)
+{
+	const FT_Int32 load_mode = atlas->antialiasing ? FT_LOAD_DEFAULT : FT_LOAD_TARGET_MONO;
+	FT_Load_Glyph(atlas->face, glyph_index, load_mode);
+}
+
+static struct glyph_info *init_glyph(FT_GlyphSlot slot, const uint32_t dx, const uint32_t dy, const uint32_t g_w,
+				     const uint32_t g_h)
+{
+	struct glyph_info *glyph = bzalloc(sizeof(struct glyph_info));
+	glyph->u = (float)dx / (float)texbuf_w;
+	glyph->u2 = (float)(dx + g_w) / (float)texbuf_w;
+	glyph->v = (float)dy / (float)texbuf_h;
+	glyph->v2 = (float)(dy + g_h) / (float)texbuf_h;
+	glyph->w = g_w;
+	glyph->h = g_h;
+	glyph->yoff = slot->bitmap_top;
+	glyph->xoff = slot->bitmap_left;
+	glyph->xadv = slot->advance.x >> 6;
+
+	return glyph;
+}
+
+static uint8_t get_pixel_value(const unsigned char *buf_row, FT_Render_Mode render_mode, const uint32_t x)
+{
+	if (render_mode == FT_RENDER_MODE_NORMAL) {
+		return buf_row[x];
+	}
+
+	const uint32_t byte_index = x / 8;
+	const uint8_t bit_index = x % 8;
+	const bool pixel_set = (buf_row[byte_index] >> (7 - bit_index)) & 1;
+	return pixel_set ? 255 : 0;
+}
+
+static void rasterize(struct glyph_atlas *atlas, FT_GlyphSlot slot, const FT_Render_Mode render_mode,
+		      const uint32_t dx, const uint32_t dy)
+{
+	/**
+	 * The pitch's absolute value is the number of bytes taken by one bitmap
+	 * row, including padding.
+	 *
+	 * Source: https://www.freetype.org/freetype2/docs/reference/ft2-basic_types.html
+	 */
+	const int pitch = abs(slot->bitmap.pitch);
+
+	for (uint32_t y = 0; y < slot->bitmap.rows; y++) {
+		const uint32_t row_start = y * pitch;
+		const uint32_t row = (dy + y) * texbuf_w;
+
+		for (uint32_t x = 0; x < slot->bitmap.width; x++) {
+			const uint32_t row_pixel_position = dx + x;
+			const uint8_t pixel_value = get_pixel_value(&slot->bitmap.buffer[row_start], render_mode, x);
+			atlas->texbuf[row_pixel_position + row] = pixel_value;
+		}
+	}
+}
+
+static const float occupancy_steps[] = {50.0f, 75.0f, 90.0f};
+
+static inline float get_occupancy(struct glyph_atlas *atlas)
+{
+	uint64_t used = (uint64_t)atlas->texbuf_y * texbuf_w + (uint64_t)atlas->max_h * atlas->texbuf_x;
+	return (float)used * 100.0f / ((float)texbuf_w * (float)texbuf_h);
+}
+
+/* must be called with the atlas locked */
+void glyph_atlas_cache(struct glyph_atlas *atlas, const wchar_t *text)
+{
+	if (!text)
+		return;
+
+	FT_GlyphSlot slot = atlas->face->glyph;
+
+	uint32_t dx = atlas->texbuf_x;
+	uint32_t dy = atlas->texbuf_y;
+
+	int32_t cached_glyphs = 0;
+	const size_t len = wcslen(text);
+
+	const FT_Render_Mode render_mode = get_render_mode(atlas);
+
+	for (size_t i = 0; i < len; i++) {
+		const FT_UInt glyph_index = FT_Get_Char_Index(atlas->face, text[i]);
+
+		if (atlas->glyphs[glyph_index] != NULL) {
+			continue;
+		}
+
+		glyph_atlas_load_glyph(atlas, glyph_index);
+		FT_Render_Glyph(slot, render_mode);
+
+		const uint32_t g_w = slot->bitmap.width;
+		const uint32_t g_h = slot->bitmap.rows;
+
+		if (atlas->max_h < g_h) {
+			atlas->max_h = g_h;
+		}
+
+		if (dx + g_w >= texbuf_w) {
+			dx = 0;
+			dy += atlas->max_h + 1;
+		}
+
+		if (dy + g_h >= texbuf_h) {
+			if (!atlas->full) {
+				blog(LOG_WARNING, "FT2-text: Out of space trying to render glyphs for %s (%u glyphs)",
+				     atlas->key, atlas->num_glyphs);
+				atlas->full = true;
+			}
+			break;
+		}
+
+		atlas->glyphs[glyph_index] = init_glyph(slot, dx, dy, g_w, g_h);
+		rasterize(atlas, slot, render_mode, dx, dy);
+
+		dx += (g_w + 1);
+		if (dx >= texbuf_w) {
+			dx = 0;
+			dy += atlas->max_h;
+		}
+
+		cached_glyphs++;
+	}
+
+	atlas->texbuf_x = dx;
+	atlas->texbuf_y = dy;
+	atlas->num_glyphs += cached_glyphs;
+
+	/* report when the atlas is filling up, as glyphs that don't fit will
+	 * not be displayed */
+	const float occupancy = get_occupancy(atlas);
+	while (atlas->reported_occupancy < 3 && occupancy >= occupancy_steps[atlas->reported_occupancy]) {
+		blog(LOG_INFO, "FT2-text: Glyph atlas for %s is %.1f%% full (%u glyphs)", atlas->key, occupancy,
+		     atlas->num_glyphs);
+		atlas->reported_occupancy++;
+	}
+
+	if (cached_glyphs > 0) {
+		obs_enter_graphics();
+
+		if (atlas->tex != NULL) {
+			gs_texture_t *tmp_texture = atlas->tex;
+			atlas->tex = NULL;
+			gs_texture_destroy(tmp_texture);
+		}
+
+		atlas->tex = gs_texture_create(texbuf_w, texbuf_h, GS_A8, 1, (const uint8_t **)&atlas->texbuf, 0);
+
+		obs_leave_graphics();
+	}
+}
+
+static struct glyph_atlas *glyph_atlas_create(const char *key, const char *path, FT_Long index, uint16_t size,
+					      bool antialiasing)
+{
+	struct glyph_atlas *atlas = bzalloc(sizeof(*atlas));
+
+	if (FT_New_Face(ft2_lib, path, index, &atlas->face) != 0) {
+		bfree(atlas);
+		return NULL;
+	}
+
+	FT_Set_Pixel_Sizes(atlas->face, 0, size);
+	FT_Select_Charmap(atlas->face, FT_ENCODING_UNICODE);
+
+	pthread_mutex_init(&atlas->mutex, NULL);
+	atlas->key = bstrdup(key);
+	atlas->refs = 1;
+	atlas->antialiasing = antialiasing;
+	atlas->texbuf = bzalloc((size_t)texbuf_w * (size_t)texbuf_h);
+
+	glyph_atlas_cache(atlas, L"abcdefghijklmnopqrstuvwxyz"
+				 L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890"
+				 L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
+
+	blog(LOG_DEBUG, "FT2-text: Created glyph atlas for %s", key);
+	return atlas;
+}
+
+static void glyph_atlas_destroy(struct glyph_atlas *atlas)
+{
+	blog(LOG_DEBUG, "FT2-text: Destroying glyph atlas for %s (%u glyphs, %.1f%% used)", atlas->key,
+	     atlas->num_glyphs, get_occupancy(atlas));
+
+	for (uint32_t i = 0; i < num_cache_slots; i++)
+		bfree(atlas->glyphs[i]);
+
+	obs_enter_graphics();
+	gs_texture_destroy(atlas->tex);
+	obs_leave_graphics();
+
+	FT_Done_Face(atlas->face);
+	pthread_mutex_destroy(&atlas->mutex);
+	bfree(atlas->texbuf);
+	bfree(atlas->key);
+	bfree(atlas);
+}
+
+struct glyph_atlas *glyph_atlas_get(const char *path, FT_Long index, uint16_t size, bool antialiasing)
+{
+	struct glyph_atlas *atlas = NULL;
+	struct dstr key = {0};
+
+	dstr_printf(&key, "%s:%ld:%u:%s", path, (long)index, (unsigned int)size, antialiasing ? "aa" : "mono");
+
+	pthread_mutex_lock(&atlas_mutex);
+
+	for (size_t i = 0; i < atlases.num; i++) {
+		if (strcmp(atlases.array[i]->key, key.array) == 0) {
+			atlas = atlases.array[i];
+			atlas->refs++;
+			break;
+		}
+	}
+
+	if (!atlas) {
+		atlas = glyph_atlas_create(key.array, path, index, size, antialiasing);
+		if (atlas)
+			da_push_back(atlases, &atlas);
+	}
+
+	pthread_mutex_unlock(&atlas_mutex);
+
+	dstr_free(&key);
+	return atlas;
+}
+
+void glyph_atlas_release(struct glyph_atlas *atlas)
+{
+	if (!atlas)
+		return;
+
+	pthread_mutex_lock(&atlas_mutex);
+
+	bool destroy = --atlas->refs == 0;
+	if (destroy) {
+		da_erase_item(atlases, &atlas);
+		if (!atlases.num)
+			da_free(atlases);
+	}
+
+	pthread_mutex_unlock(&atlas_mutex);
+
+	if (destroy)
+		glyph_atlas_destroy(atlas);
+}
@@ -219,17 +219,15 @@ static void ft2_source_destroy(void *data)
 {
 	struct ft2_source *srcdata = data;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
+	os_file_watch_destroy(srcdata->file_watch);
+	bfree(srcdata->file_text);
+	pthread_mutex_destroy(&srcdata->file_mutex);
 
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
+	glyph_atlas_release(srcdata->atlas);
+	srcdata->atlas = NULL;
+
+	da_free(srcdata->lines);
+	bfree(srcdata->layout_text);
 
 	if (srcdata->font_name != NULL)
 		bfree(srcdata->font_name);
@@ -237,17 +235,11 @@ static void ft2_source_destroy(void *data)
 		bfree(srcdata->font_style);
 	if (srcdata->text != NULL)
 		bfree(srcdata->text);
-	if (srcdata->texbuf != NULL)
-		bfree(srcdata->texbuf);
 	if (srcdata->text_file != NULL)
 		bfree(srcdata->text_file);
 
 	obs_enter_graphics();
 
-	if (srcdata->tex != NULL) {
-		gs_texture_destroy(srcdata->tex);
-		srcdata->tex = NULL;
-	}
 	if (srcdata->vbuf != NULL) {
 		gs_vertexbuffer_destroy(srcdata->vbuf);
 		srcdata->vbuf = NULL;
@@ -268,7 +260,7 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	if (srcdata == NULL)
 		return;
 
-	if (srcdata->tex == NULL || srcdata->vbuf == NULL)
+	if (srcdata->atlas == NULL || srcdata->atlas->tex == NULL || srcdata->vbuf == NULL)
 		return;
 	if (srcdata->text == NULL || *srcdata->text == 0)
 		return;
@@ -279,7 +271,7 @@ static void ft2_source_render(void *data, gs_effect_t *effect)
 	if (srcdata->drop_shadow)
 		draw_drop_shadow(srcdata);
 
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6, true);
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect, srcdata->num_glyphs * 6, true);
 
 	UNUSED_PARAMETER(effect);
 }
@@ -292,29 +284,37 @@ static void ft2_video_tick(void *data, float seconds)
 	if (!srcdata->from_file || !srcdata->text_file)
 		return;
 
-	if (os_gettime_ns() - srcdata->last_checked >= 1000000000) {
-		time_t t = get_modified_timestamp(srcdata->text_file);
-		srcdata->last_checked = os_gettime_ns();
-
-		if (srcdata->update_file) {
-			if (srcdata->log_mode)
-				read_from_end(srcdata, srcdata->text_file);
-			else
-				load_text_from_file(srcdata, srcdata->text_file);
-			cache_glyphs(srcdata, srcdata->text);
-			set_up_vertex_buffer(srcdata);
-			srcdata->update_file = false;
-		}
+	pthread_mutex_lock(&srcdata->file_mutex);
+	wchar_t *text = srcdata->file_text;
+	srcdata->file_text = NULL;
+	pthread_mutex_unlock(&srcdata->file_mutex);
 
-		if (srcdata->m_timestamp != t) {
-			srcdata->m_timestamp = t;
-			srcdata->update_file = true;
-		}
+	if (text) {
+		bfree(srcdata->text);
+		srcdata->text = text;
+		cache_glyphs(srcdata, srcdata->text);
+		set_up_vertex_buffer(srcdata);
 	}
 
 	UNUSED_PARAMETER(seconds);
 }
 
+/* called from the file watch thread, reads the file so that the tick only has
+ * to swap in the new text */
+static void text_file_changed(void *param, const char *path)
+{
+	struct ft2_source *srcdata = param;
+	wchar_t *text = srcdata->log_mode ? read_from_end(srcdata, path) : load_text_from_file(srcdata, path);
+
+	if (!text)
+		return;
+
+	pthread_mutex_lock(&srcdata->file_mutex);
+	bfree(srcdata->file_text);
+	srcdata->file_text = text;
+	pthread_mutex_unlock(&srcdata->file_mutex);
+}
+
 static bool init_font(struct ft2_source *srcdata)
 {
 	FT_Long index;
@@ -323,12 +323,14 @@ static bool init_font(struct ft2_source *srcdata)
 	if (!path)
 		return false;
 
-	if (srcdata->font_face != NULL) {
-		FT_Done_Face(srcdata->font_face);
-		srcdata->font_face = NULL;
-	}
+	struct glyph_atlas *atlas = glyph_atlas_get(path, index, srcdata->font_size, srcdata->antialiasing);
+	if (!atlas)
+		return false;
 
-	return FT_New_Face(ft2_lib, path, index, &srcdata->font_face) == 0;
+	glyph_atlas_release(srcdata->atlas);
+	srcdata->atlas = atlas;
+	srcdata->layout_dirty = true;
+	return true;
 }
 
 static void ft2_source_update(void *data, obs_data_t *settings)
@@ -348,10 +350,23 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (!font_obj)
 		return;
 
+	/* stop reading the file while its settings might change */
+	os_file_watch_destroy(srcdata->file_watch);
+	srcdata->file_watch = NULL;
+
+	pthread_mutex_lock(&srcdata->file_mutex);
+	bfree(srcdata->file_text);
+	srcdata->file_text = NULL;
+	pthread_mutex_unlock(&srcdata->file_mutex);
+
 	srcdata->outline_width = 0;
 
+	const bool outline_text = obs_data_get_bool(settings, "outline");
+	if (outline_text != srcdata->outline_text)
+		srcdata->layout_dirty = true;
+
 	srcdata->drop_shadow = obs_data_get_bool(settings, "drop_shadow");
-	srcdata->outline_text = obs_data_get_bool(settings, "outline");
+	srcdata->outline_text = outline_text;
 
 	if (srcdata->outline_text && srcdata->drop_shadow)
 		srcdata->outline_width = 6;
@@ -367,11 +382,14 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (custom_width >= 100) {
 		if (custom_width != srcdata->custom_width) {
 			srcdata->custom_width = custom_width;
+			srcdata->layout_dirty = true;
 			vbuf_needs_update = true;
 		}
 	} else {
-		if (srcdata->custom_width >= 100)
+		if (srcdata->custom_width >= 100) {
+			srcdata->layout_dirty = true;
 			vbuf_needs_update = true;
+		}
 		srcdata->custom_width = 0;
 	}
 
@@ -383,6 +401,7 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (color[0] != srcdata->color[0] || color[1] != srcdata->color[1]) {
 		srcdata->color[0] = color[0];
 		srcdata->color[1] = color[1];
+		srcdata->layout_dirty = true;
 		vbuf_needs_update = true;
 	}
 
@@ -402,8 +421,6 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	if (ft2_lib == NULL)
 		goto error;
 
-	const size_t texbuf_size = (size_t)texbuf_w * (size_t)texbuf_h;
-
 	if (srcdata->draw_effect == NULL) {
 		char *effect_file = NULL;
 		char *error_string = NULL;
@@ -426,27 +443,20 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 
 	const bool new_aa_setting = obs_data_get_bool(settings, "antialiasing");
 	const bool aa_changed = srcdata->antialiasing != new_aa_setting;
-	if (aa_changed) {
-		srcdata->antialiasing = new_aa_setting;
-		if (srcdata->texbuf != NULL) {
-			memset(srcdata->texbuf, 0, texbuf_size);
-		}
-		cache_standard_glyphs(srcdata);
-	}
+	srcdata->antialiasing = new_aa_setting;
 
 	srcdata->file_load_failed = false;
 	srcdata->from_file = from_file;
 
 	if (srcdata->font_name != NULL) {
 		if (strcmp(font_name, srcdata->font_name) == 0 && strcmp(font_style, srcdata->font_style) == 0 &&
-		    font_flags == srcdata->font_flags && font_size == srcdata->font_size)
+		    font_flags == srcdata->font_flags && font_size == srcdata->font_size && !aa_changed)
 			goto skip_font_load;
 
 		bfree(srcdata->font_name);
 		bfree(srcdata->font_style);
 		srcdata->font_name = NULL;
 		srcdata->font_style = NULL;
-		srcdata->max_h = 0;
 		vbuf_needs_update = true;
 	}
 
@@ -455,22 +465,10 @@ static void ft2_source_update(void *data, obs_data_t *settings)
 	srcdata->font_size = font_size;
 	srcdata->font_flags = font_flags;
 
-	if (!init_font(srcdata) || srcdata->font_face == NULL) {
+	if (!init_font(srcdata)) {
 		blog(LOG_WARNING, "FT2-text: Failed to load font %s", srcdata->font_name);
 		goto error;
-	} else {
-		FT_Set_Pixel_Sizes(srcdata->font_face, 0, srcdata->font_size);
-		FT_Select_Charmap(srcdata->font_face, FT_ENCODING_UNICODE);
-	}
-
-	if (srcdata->texbuf != NULL) {
-		bfree(srcdata->texbuf);
-		srcdata->texbuf = NULL;
 	}
-	srcdata->texbuf = bzalloc(texbuf_size);
-
-	if (srcdata->font_face)
-		cache_standard_glyphs(srcdata);
 
 skip_font_load:
 	if (from_file) {
@@ -494,11 +492,12 @@ skip_font_load:
 			bfree(srcdata->text_file);
 
 			srcdata->text_file = bstrdup(tmp);
-			if (chat_log_mode)
-				read_from_end(srcdata, tmp);
-			else
-				load_text_from_file(srcdata, tmp);
-			srcdata->last_checked = os_gettime_ns();
+
+			wchar_t *text = chat_log_mode ? read_from_end(srcdata, tmp) : load_text_from_file(srcdata, tmp);
+			if (text) {
+				bfree(srcdata->text);
+				srcdata->text = text;
+			}
 		}
 	} else {
 		const char *tmp = obs_data_get_string(settings, "text");
@@ -513,12 +512,15 @@ skip_font_load:
 		os_utf8_to_wcs_ptr(tmp, strlen(tmp), &srcdata->text);
 	}
 
-	if (srcdata->font_face) {
+	if (srcdata->atlas) {
 		cache_glyphs(srcdata, srcdata->text);
 		set_up_vertex_buffer(srcdata);
 	}
 
 error:
+	if (srcdata->from_file && srcdata->text_file)
+		srcdata->file_watch = os_file_watch_create(srcdata->text_file, text_file_changed, srcdata);
+
 	obs_data_release(font_obj);
 }
 
@@ -534,6 +536,7 @@ static void *ft2_source_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct ft2_source *srcdata = bzalloc(sizeof(struct ft2_source));
 	srcdata->src = source;
+	pthread_mutex_init(&srcdata->file_mutex, NULL);
 
 	init_plugin();
 
@@ -18,10 +18,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include <obs-module.h>
+#include <util/darray.h>
+#include <util/threading.h>
+#include <util/file-watch.h>
 #include <ft2build.h>
 
 #define num_cache_slots 65535
-#define src_glyph srcdata->cacheglyphs[glyph_index]
+#define src_glyph srcdata->atlas->glyphs[glyph_index]
 
 struct glyph_info {
 	float u, v, u2, v2;
@@ -29,6 +32,34 @@ struct glyph_info {
 	FT_Pos xadv;
 };
 
+/* glyph atlas shared by all sources with the same font and render mode,
+ * glyphs are only ever added to it while it's in use */
+struct glyph_atlas {
+	char *key;
+	long refs;
+
+	pthread_mutex_t mutex;
+	FT_Face face;
+	bool antialiasing;
+
+	uint8_t *texbuf;
+	gs_texture_t *tex;
+	uint32_t texbuf_x, texbuf_y, max_h;
+
+	uint32_t num_glyphs;
+	bool full;
+	int reported_occupancy;
+
+	struct glyph_info *glyphs[num_cache_slots];
+};
+
+/* a line of the last laid out text and the vertices it was given */
+struct ft2_line {
+	size_t start, len;
+	uint32_t first_glyph, num_glyphs;
+	uint32_t dy, end_dy, max_y;
+};
+
 struct ft2_source {
 	char *font_name;
 	char *font_style;
@@ -40,25 +71,27 @@ struct ft2_source {
 	bool antialiasing;
 	char *text_file;
 	wchar_t *text;
-	time_t m_timestamp;
-	bool update_file;
-	uint64_t last_checked;
+
+	/* text read from the file by the file watch thread, picked up on the
+	 * next tick */
+	os_file_watch_t *file_watch;
+	pthread_mutex_t file_mutex;
+	wchar_t *file_text;
 
 	uint32_t cx, cy, max_h, custom_width;
 	uint32_t outline_width;
-	uint32_t texbuf_x, texbuf_y;
 	uint32_t color[2];
 
 	int32_t cur_scroll, scroll_speed;
 
-	gs_texture_t *tex;
-
-	struct glyph_info *cacheglyphs[num_cache_slots];
+	struct glyph_atlas *atlas;
 
-	FT_Face font_face;
-
-	uint8_t *texbuf;
 	gs_vertbuffer_t *vbuf;
+	uint32_t vbuf_capacity, num_glyphs;
+
+	DARRAY(struct ft2_line) lines;
+	wchar_t *layout_text;
+	bool layout_dirty;
 
 	gs_effect_t *draw_effect;
 	bool outline_text, drop_shadow;
@@ -70,16 +103,19 @@ struct ft2_source {
 
 extern FT_Library ft2_lib;
 
+struct glyph_atlas *glyph_atlas_get(const char *path, FT_Long index, uint16_t size, bool antialiasing);
+void glyph_atlas_release(struct glyph_atlas *atlas);
+void glyph_atlas_cache(struct glyph_atlas *atlas, const wchar_t *text);
+void glyph_atlas_load_glyph(struct glyph_atlas *atlas, const FT_UInt glyph_index);
+
 void draw_outlines(struct ft2_source *srcdata);
 void draw_drop_shadow(struct ft2_source *srcdata);
 
 uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata);
 
-time_t get_modified_timestamp(char *filename);
-void load_text_from_file(struct ft2_source *srcdata, const char *filename);
-void read_from_end(struct ft2_source *srcdata, const char *filename);
+wchar_t *load_text_from_file(struct ft2_source *srcdata, const char *filename);
+wchar_t *read_from_end(struct ft2_source *srcdata, const char *filename);
 
-void cache_standard_glyphs(struct ft2_source *srcdata);
 void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs);
 
 void set_up_vertex_buffer(struct ft2_source *srcdata);
@@ -19,15 +19,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <util/platform.h>
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include <sys/stat.h>
 #include "text-freetype2.h"
 #include "obs-convenience.h"
 
 float offsets[16] = {-2.0f, 0.0f, 0.0f, -2.0f, 2.0f,  0.0f, 2.0f,  0.0f,
 		     0.0f,  2.0f, 0.0f, 2.0f,  -2.0f, 0.0f, -2.0f, 0.0f};
 
-extern uint32_t texbuf_w, texbuf_h;
-
 void draw_outlines(struct ft2_source *srcdata)
 {
 	if (!srcdata->text)
@@ -36,7 +33,7 @@ void draw_outlines(struct ft2_source *srcdata)
 	gs_matrix_push();
 	for (int32_t i = 0; i < 8; i++) {
 		gs_matrix_translate3f(offsets[i * 2], offsets[(i * 2) + 1], 0.0f);
-		draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6,
+		draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect, srcdata->num_glyphs * 6,
 				false);
 	}
 	gs_matrix_identity();
@@ -50,49 +47,49 @@ void draw_drop_shadow(struct ft2_source *srcdata)
 
 	gs_matrix_push();
 	gs_matrix_translate3f(4.0f, 4.0f, 0.0f);
-	draw_uv_vbuffer(srcdata->vbuf, srcdata->tex, srcdata->draw_effect, (uint32_t)wcslen(srcdata->text) * 6, false);
+	draw_uv_vbuffer(srcdata->vbuf, srcdata->atlas->tex, srcdata->draw_effect, srcdata->num_glyphs * 6, false);
 	gs_matrix_identity();
 	gs_matrix_pop();
 }
 
+static void clear_layout(struct ft2_source *srcdata)
+{
+	da_free(srcdata->lines);
+	bfree(srcdata->layout_text);
+	srcdata->layout_text = NULL;
+	srcdata->num_glyphs = 0;
+}
+
 void set_up_vertex_buffer(struct ft2_source *srcdata)
 {
 	FT_UInt glyph_index = 0;
 	uint32_t x = 0, space_pos = 0, word_width = 0;
 	size_t len;
 
-	if (!srcdata->text)
+	if (!srcdata->text || !srcdata->atlas)
 		return;
 
+	/* the atlas is locked first, it enters the graphics context itself
+	 * when glyphs are added */
+	pthread_mutex_lock(&srcdata->atlas->mutex);
+
+	srcdata->max_h = srcdata->atlas->max_h;
+
 	if (srcdata->custom_width >= 100)
 		srcdata->cx = srcdata->custom_width;
 	else
 		srcdata->cx = get_ft2_text_width(srcdata->text, srcdata);
 	srcdata->cy = srcdata->max_h;
 
-	obs_enter_graphics();
-	if (srcdata->vbuf != NULL) {
-		gs_vertbuffer_t *tmpvbuf = srcdata->vbuf;
-		srcdata->vbuf = NULL;
-		gs_vertexbuffer_destroy(tmpvbuf);
-	}
-
-	if (*srcdata->text == 0) {
-		obs_leave_graphics();
-		return;
-	}
-
-	srcdata->vbuf = create_uv_vbuffer((uint32_t)wcslen(srcdata->text) * 6, true);
+	len = wcslen(srcdata->text);
 
 	if (srcdata->custom_width <= 100)
 		goto skip_word_wrap;
 	if (!srcdata->word_wrap)
 		goto skip_word_wrap;
 
-	len = wcslen(srcdata->text);
-
 	for (uint32_t i = 0; i <= len; i++) {
-		if (i == wcslen(srcdata->text))
+		if (i == len)
 			goto eos_check;
 
 		if (srcdata->text[i] != L' ' && srcdata->text[i] != L'\n')
@@ -104,7 +101,7 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 				srcdata->text[space_pos] = L'\n';
 			x = 0;
 		}
-		if (i == wcslen(srcdata->text))
+		if (i == len)
 			goto eos_skip;
 
 		x += word_width;
@@ -114,69 +111,77 @@ void set_up_vertex_buffer(struct ft2_source *srcdata)
 		if (srcdata->text[i] == L' ')
 			space_pos = i;
 	next_char:;
-		glyph_index = FT_Get_Char_Index(srcdata->font_face, srcdata->text[i]);
+		glyph_index = FT_Get_Char_Index(srcdata->atlas->face, srcdata->text[i]);
 		if (src_glyph)
 			word_width += src_glyph->xadv;
 	eos_skip:;
 	}
 
 skip_word_wrap:;
+	obs_enter_graphics();
+
+	/* the vertex buffer is kept as long as the text fits and doesn't
+	 * shrink by too much, so unchanged lines don't have to be redone */
+	if (srcdata->vbuf != NULL && (len > srcdata->vbuf_capacity || len * 4 < srcdata->vbuf_capacity)) {
+		gs_vertbuffer_t *tmpvbuf = srcdata->vbuf;
+		srcdata->vbuf = NULL;
+		gs_vertexbuffer_destroy(tmpvbuf);
+	}
+
+	if (len == 0) {
+		clear_layout(srcdata);
+		goto finish;
+	}
+
+	if (srcdata->vbuf == NULL) {
+		srcdata->vbuf = create_uv_vbuffer((uint32_t)len * 6, true);
+		srcdata->vbuf_capacity = (uint32_t)len;
+		srcdata->layout_dirty = true;
+	}
+
 	fill_vertex_buffer(srcdata);
 	gs_vertexbuffer_flush(srcdata->vbuf);
+
+finish:
 	obs_leave_graphics();
+	pthread_mutex_unlock(&srcdata->atlas->mutex);
 }
 
-void fill_vertex_buffer(struct ft2_source *srcdata)
+static bool line_unchanged(struct ft2_source *srcdata, size_t idx, const wchar_t *text, struct ft2_line *line)
 {
-	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(srcdata->vbuf);
-	if (vdata == NULL || !srcdata->text)
-		return;
+	if (srcdata->layout_dirty || idx >= srcdata->lines.num)
+		return false;
 
+	struct ft2_line *old = srcdata->lines.array + idx;
+	return old->len == line->len && old->first_glyph == line->first_glyph && old->dy == line->dy &&
+	       wmemcmp(srcdata->layout_text + old->start, text + line->start, line->len) == 0;
+}
+
+static void fill_line(struct ft2_source *srcdata, struct gs_vb_data *vdata, const wchar_t *text,
+		      struct ft2_line *line, uint32_t offset)
+{
 	struct vec2 *tvarray = (struct vec2 *)vdata->tvarray[0].array;
 	uint32_t *col = (uint32_t *)vdata->colors;
 
 	FT_UInt glyph_index = 0;
 
-	uint32_t dx = 0, dy = srcdata->max_h, max_y = dy;
-	uint32_t cur_glyph = 0;
-	uint32_t offset = 0;
-	size_t len = wcslen(srcdata->text);
+	uint32_t dx = offset, dy = line->dy, max_y = 0;
+	uint32_t cur_glyph = line->first_glyph;
 
-	if (srcdata->outline_text) {
-		offset = 2;
-		dx = offset;
-	}
-
-	for (size_t i = 0; i < len; i++) {
-	add_linebreak:;
-		if (srcdata->text[i] != L'\n')
-			goto draw_glyph;
-		dx = offset;
-		i++;
-		dy += srcdata->max_h + 4;
-		if (i == wcslen(srcdata->text))
-			goto skip_glyph;
-		if (srcdata->text[i] == L'\n')
-			goto add_linebreak;
-	draw_glyph:;
+	for (size_t i = line->start; i < line->start + line->len; i++) {
 		// Skip filthy dual byte Windows line breaks
-		if (srcdata->text[i] == L'\r')
-			goto skip_glyph;
+		if (text[i] == L'\r')
+			continue;
 
-		glyph_index = FT_Get_Char_Index(srcdata->font_face, srcdata->text[i]);
+		glyph_index = FT_Get_Char_Index(srcdata->atlas->face, text[i]);
 		if (src_glyph == NULL)
-			goto skip_glyph;
-
-		if (srcdata->custom_width < 100)
-			goto skip_custom_width;
+			continue;
 
-		if (dx + src_glyph->xadv > srcdata->custom_width) {
+		if (srcdata->custom_width >= 100 && dx + src_glyph->xadv > srcdata->custom_width) {
 			dx = offset;
 			dy += srcdata->max_h + 4;
 		}
 
-	skip_custom_width:;
-
 		set_v3_rect(vdata->points + (cur_glyph * 6), (float)dx + (float)src_glyph->xoff,
 			    (float)dy - (float)src_glyph->yoff, (float)src_glyph->w, (float)src_glyph->h);
 		set_v2_uv(tvarray + (cur_glyph * 6), src_glyph->u, src_glyph->v, src_glyph->u2, src_glyph->v2);
@@ -185,175 +190,74 @@ void fill_vertex_buffer(struct ft2_source *srcdata)
 		if (dy - (float)src_glyph->yoff + src_glyph->h > max_y)
 			max_y = dy - src_glyph->yoff + src_glyph->h;
 		cur_glyph++;
-	skip_glyph:;
-	}
-
-	srcdata->cy = max_y;
-}
-
-void cache_standard_glyphs(struct ft2_source *srcdata)
-{
-	for (uint32_t i = 0; i < num_cache_slots; i++) {
-		if (srcdata->cacheglyphs[i] != NULL) {
-			bfree(srcdata->cacheglyphs[i]);
-			srcdata->cacheglyphs[i] = NULL;
-		}
-	}
-
-	srcdata->texbuf_x = 0;
-	srcdata->texbuf_y = 0;
-
-	cache_glyphs(srcdata, L"abcdefghijklmnopqrstuvwxyz"
-			      L"ABCDEFGHIJKLMNOPQRSTUVWXYZ1234567890"
-			      L"!@#$%^&*()-_=+,<.>/?\\|[]{}`~ \'\"\0");
-}
-
-FT_Render_Mode get_render_mode(struct ft2_source *srcdata)
-{
-	return srcdata->antialiasing ? FT_RENDER_MODE_NORMAL : FT_RENDER_MODE_MONO;
-}
-
-void load_glyph(struct ft2_source *srcdata, const FT_UInt glyph_index, const FT_Render_Mode render_mode)
-{
-	const FT_Int32 load_mode = render_mode == FT_RENDER_MODE_MONO ? FT_LOAD_TARGET_MONO : FT_LOAD_DEFAULT;
-	FT_Load_Glyph(srcdata->font_face, glyph_index, load_mode);
-}
-
-struct glyph_info *init_glyph(FT_GlyphSlot slot, const uint32_t dx, const uint32_t dy, const uint32_t g_w,
-			      const uint32_t g_h)
-{
-	struct glyph_info *glyph = bzalloc(sizeof(struct glyph_info));
-	glyph->u = (float)dx / (float)texbuf_w;
-	glyph->u2 = (float)(dx + g_w) / (float)texbuf_w;
-	glyph->v = (float)dy / (float)texbuf_h;
-	glyph->v2 = (float)(dy + g_h) / (float)texbuf_h;
-	glyph->w = g_w;
-	glyph->h = g_h;
-	glyph->yoff = slot->bitmap_top;
-	glyph->xoff = slot->bitmap_left;
-	glyph->xadv = slot->advance.x >> 6;
-
-	return glyph;
-}
-
-uint8_t get_pixel_value(const unsigned char *buf_row, FT_Render_Mode render_mode, const uint32_t x)
-{
-	if (render_mode == FT_RENDER_MODE_NORMAL) {
-		return buf_row[x];
 	}
 
-	const uint32_t byte_index = x / 8;
-	const uint8_t bit_index = x % 8;
-	const bool pixel_set = (buf_row[byte_index] >> (7 - bit_index)) & 1;
-	return pixel_set ? 255 : 0;
+	line->num_glyphs = cur_glyph - line->first_glyph;
+	line->end_dy = dy;
+	line->max_y = max_y;
 }
 
-void rasterize(struct ft2_source *srcdata, FT_GlyphSlot slot, const FT_Render_Mode render_mode, const uint32_t dx,
-	       const uint32_t dy)
-{
-	/**
-	 * The pitch's absolute value is the number of bytes taken by one bitmap
-	 * row, including padding.
-	 *
-	 * Source: https://www.freetype.org/freetype2/docs/reference/ft2-basic_types.html
-	 */
-	const int pitch = abs(slot->bitmap.pitch);
-
-	for (uint32_t y = 0; y < slot->bitmap.rows; y++) {
-		const uint32_t row_start = y * pitch;
-		const uint32_t row = (dy + y) * texbuf_w;
-
-		for (uint32_t x = 0; x < slot->bitmap.width; x++) {
-			const uint32_t row_pixel_position = dx + x;
-			const uint8_t pixel_value = get_pixel_value(&slot->bitmap.buffer[row_start], render_mode, x);
-			srcdata->texbuf[row_pixel_position + row] = pixel_value;
-		}
-	}
-}
-
-void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
+void fill_vertex_buffer(struct ft2_source *srcdata)
 {
-	if (!srcdata->font_face || !cache_glyphs)
+	struct gs_vb_data *vdata = gs_vertexbuffer_get_data(srcdata->vbuf);
+	if (vdata == NULL || !srcdata->text)
 		return;
 
-	FT_GlyphSlot slot = srcdata->font_face->glyph;
-
-	uint32_t dx = srcdata->texbuf_x;
-	uint32_t dy = srcdata->texbuf_y;
-
-	int32_t cached_glyphs = 0;
-	const size_t len = wcslen(cache_glyphs);
-
-	const FT_Render_Mode render_mode = get_render_mode(srcdata);
-
-	for (size_t i = 0; i < len; i++) {
-		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->font_face, cache_glyphs[i]);
-
-		if (src_glyph != NULL) {
-			continue;
-		}
-
-		load_glyph(srcdata, glyph_index, render_mode);
-		FT_Render_Glyph(slot, render_mode);
+	DARRAY(struct ft2_line) lines;
+	const wchar_t *text = srcdata->text;
+	const wchar_t *end;
 
-		const uint32_t g_w = slot->bitmap.width;
-		const uint32_t g_h = slot->bitmap.rows;
-
-		if (srcdata->max_h < g_h) {
-			srcdata->max_h = g_h;
-		}
-
-		if (dx + g_w >= texbuf_w) {
-			dx = 0;
-			dy += srcdata->max_h + 1;
-		}
-
-		if (dy + g_h >= texbuf_h) {
-			blog(LOG_WARNING, "Out of space trying to render glyphs");
-			break;
-		}
-
-		src_glyph = init_glyph(slot, dx, dy, g_w, g_h);
-		rasterize(srcdata, slot, render_mode, dx, dy);
-
-		dx += (g_w + 1);
-		if (dx >= texbuf_w) {
-			dx = 0;
-			dy += srcdata->max_h;
+	uint32_t dy = srcdata->max_h, max_y = dy;
+	uint32_t cur_glyph = 0;
+	uint32_t offset = srcdata->outline_text ? 2 : 0;
+	size_t start = 0;
+
+	da_init(lines);
+
+	/* only lines that changed, or moved to different vertices, have to be
+	 * laid out again */
+	do {
+		struct ft2_line *line = da_push_back_new(lines);
+
+		end = wcschr(text + start, L'\n');
+		line->start = start;
+		line->len = end ? (size_t)(end - text) - start : wcslen(text + start);
+		line->first_glyph = cur_glyph;
+		line->dy = dy;
+
+		if (line_unchanged(srcdata, lines.num - 1, text, line)) {
+			struct ft2_line *old = srcdata->lines.array + (lines.num - 1);
+			line->num_glyphs = old->num_glyphs;
+			line->end_dy = old->end_dy;
+			line->max_y = old->max_y;
+		} else {
+			fill_line(srcdata, vdata, text, line, offset);
 		}
 
-		cached_glyphs++;
-	}
-
-	srcdata->texbuf_x = dx;
-	srcdata->texbuf_y = dy;
-
-	if (cached_glyphs > 0) {
-
-		obs_enter_graphics();
-
-		if (srcdata->tex != NULL) {
-			gs_texture_t *tmp_texture = srcdata->tex;
-			srcdata->tex = NULL;
-			gs_texture_destroy(tmp_texture);
-		}
+		cur_glyph += line->num_glyphs;
+		if (line->max_y > max_y)
+			max_y = line->max_y;
 
-		srcdata->tex = gs_texture_create(texbuf_w, texbuf_h, GS_A8, 1, (const uint8_t **)&srcdata->texbuf, 0);
+		dy = line->end_dy + srcdata->max_h + 4;
+		start += line->len + 1;
+	} while (end);
 
-		obs_leave_graphics();
-	}
+	clear_layout(srcdata);
+	da_move(srcdata->lines, lines);
+	srcdata->layout_text = bwstrdup(text);
+	srcdata->layout_dirty = false;
+	srcdata->num_glyphs = cur_glyph;
+	srcdata->cy = max_y;
 }
 
-time_t get_modified_timestamp(char *filename)
+void cache_glyphs(struct ft2_source *srcdata, wchar_t *cache_glyphs)
 {
-	struct stat stats;
-
-	// stat is apparently terrifying and horrible, but we only call it once
-	// every second at most.
-	if (os_stat(filename, &stats) != 0)
-		return -1;
+	if (!srcdata->atlas || !cache_glyphs)
+		return;
 
-	return stats.st_mtime;
+	pthread_mutex_lock(&srcdata->atlas->mutex);
+	glyph_atlas_cache(srcdata->atlas, cache_glyphs);
+	pthread_mutex_unlock(&srcdata->atlas->mutex);
 }
 
 static void remove_cr(wchar_t *source)
@@ -367,11 +271,12 @@ static void remove_cr(wchar_t *source)
 	source[j] = '\0';
 }
 
-void load_text_from_file(struct ft2_source *srcdata, const char *filename)
+wchar_t *load_text_from_file(struct ft2_source *srcdata, const char *filename)
 {
 	FILE *tmp_file = NULL;
 	uint32_t filesize = 0;
 	char *tmp_read = NULL;
+	wchar_t *text = NULL;
 	uint16_t header = 0;
 	size_t bytes_read;
 
@@ -381,7 +286,7 @@ void load_text_from_file(struct ft2_source *srcdata, const char *filename)
 			blog(LOG_WARNING, "Failed to open file %s", filename);
 			srcdata->file_load_failed = true;
 		}
-		return;
+		return NULL;
 	}
 	fseek(tmp_file, 0, SEEK_END);
 	filesize = (uint32_t)ftell(tmp_file);
@@ -390,17 +295,11 @@ void load_text_from_file(struct ft2_source *srcdata, const char *filename)
 
 	if (bytes_read == 2 && header == 0xFEFF) {
 		// File is already in UTF-16 format
-		if (srcdata->text != NULL) {
-			bfree(srcdata->text);
-			srcdata->text = NULL;
-		}
-		srcdata->text = bzalloc(filesize);
-		bytes_read = fread(srcdata->text, filesize - 2, 1, tmp_file);
+		text = bzalloc(filesize);
+		bytes_read = fread(text, filesize - 2, 1, tmp_file);
 
-		bfree(tmp_read);
 		fclose(tmp_file);
-
-		return;
+		return text;
 	}
 
 	fseek(tmp_file, 0, SEEK_SET);
@@ -409,25 +308,67 @@ void load_text_from_file(struct ft2_source *srcdata, const char *filename)
 	bytes_read = fread(tmp_read, filesize, 1, tmp_file);
 	fclose(tmp_file);
 
-	if (srcdata->text != NULL) {
-		bfree(srcdata->text);
-		srcdata->text = NULL;
-	}
-	srcdata->text = bzalloc((strlen(tmp_read) + 1) * sizeof(wchar_t));
-	os_utf8_to_wcs(tmp_read, strlen(tmp_read), srcdata->text, (strlen(tmp_read) + 1));
+	text = bzalloc((strlen(tmp_read) + 1) * sizeof(wchar_t));
+	os_utf8_to_wcs(tmp_read, strlen(tmp_read), text, (strlen(tmp_read) + 1));
 
-	remove_cr(srcdata->text);
+	remove_cr(text);
 	bfree(tmp_read);
+	return text;
+}
+
+#define READ_BLOCK_SIZE 65536
+
+/* Finds the start of the last log_lines lines by scanning backwards from the
+ * end of the file one block at a time, rather than seeking for every byte */
+static uint32_t find_last_lines(FILE *file, uint32_t filesize, uint32_t log_lines, bool utf16)
+{
+	const uint32_t unit = utf16 ? 2 : 1;
+	uint8_t *block = bmalloc(READ_BLOCK_SIZE);
+	uint32_t cur_pos = filesize;
+	uint32_t line_breaks = 0;
+	uint32_t start = 0;
+
+	while (cur_pos >= unit) {
+		uint32_t size = cur_pos < READ_BLOCK_SIZE ? cur_pos : READ_BLOCK_SIZE;
+		size -= size % unit;
+
+		fseek(file, cur_pos - size, SEEK_SET);
+		if (fread(block, 1, size, file) != size)
+			break;
+
+		for (uint32_t i = size; i >= unit; i -= unit) {
+			bool line_break;
+
+			if (utf16) {
+				uint16_t value;
+				memcpy(&value, block + i - 2, sizeof(value));
+				line_break = value == L'\n';
+			} else {
+				line_break = block[i - 1] == '\n';
+			}
+
+			if (line_break && ++line_breaks > log_lines) {
+				start = cur_pos - size + i;
+				goto done;
+			}
+		}
+
+		cur_pos -= size;
+	}
+
+done:
+	bfree(block);
+	return start;
 }
 
-void read_from_end(struct ft2_source *srcdata, const char *filename)
+wchar_t *read_from_end(struct ft2_source *srcdata, const char *filename)
 {
 	FILE *tmp_file = NULL;
-	uint32_t filesize = 0, cur_pos = 0, log_lines = 0;
+	uint32_t filesize = 0, cur_pos = 0;
 	char *tmp_read = NULL;
-	uint16_t value = 0, line_breaks = 0;
+	wchar_t *text = NULL;
+	uint16_t value = 0;
 	size_t bytes_read;
-	char bvalue;
 
 	bool utf16 = false;
 
@@ -437,7 +378,7 @@ void read_from_end(struct ft2_source *srcdata, const char *filename)
 			blog(LOG_WARNING, "Failed to open file %s", filename);
 			srcdata->file_load_failed = true;
 		}
-		return;
+		return NULL;
 	}
 	bytes_read = fread(&value, 1, 2, tmp_file);
 
@@ -446,60 +387,29 @@ void read_from_end(struct ft2_source *srcdata, const char *filename)
 
 	fseek(tmp_file, 0, SEEK_END);
 	filesize = (uint32_t)ftell(tmp_file);
-	cur_pos = filesize;
-	log_lines = srcdata->log_lines;
-
-	while (line_breaks <= log_lines && cur_pos != 0) {
-		if (!utf16)
-			cur_pos--;
-		else
-			cur_pos -= 2;
-		fseek(tmp_file, cur_pos, SEEK_SET);
-
-		if (!utf16) {
-			bytes_read = fread(&bvalue, 1, 1, tmp_file);
-			if (bytes_read == 1 && bvalue == '\n')
-				line_breaks++;
-		} else {
-			bytes_read = fread(&value, 1, 2, tmp_file);
-			if (bytes_read == 2 && value == L'\n')
-				line_breaks++;
-		}
-	}
-
-	if (cur_pos != 0)
-		cur_pos += (utf16) ? 2 : 1;
+	cur_pos = find_last_lines(tmp_file, filesize, srcdata->log_lines, utf16);
 
 	fseek(tmp_file, cur_pos, SEEK_SET);
 
 	if (utf16) {
-		if (srcdata->text != NULL) {
-			bfree(srcdata->text);
-			srcdata->text = NULL;
-		}
-		srcdata->text = bzalloc(filesize - cur_pos);
-		bytes_read = fread(srcdata->text, (filesize - cur_pos), 1, tmp_file);
+		text = bzalloc(filesize - cur_pos + sizeof(wchar_t));
+		bytes_read = fread(text, (filesize - cur_pos), 1, tmp_file);
 
-		remove_cr(srcdata->text);
-		bfree(tmp_read);
+		remove_cr(text);
 		fclose(tmp_file);
-
-		return;
+		return text;
 	}
 
 	tmp_read = bzalloc((filesize - cur_pos) + 1);
 	bytes_read = fread(tmp_read, filesize - cur_pos, 1, tmp_file);
 	fclose(tmp_file);
 
-	if (srcdata->text != NULL) {
-		bfree(srcdata->text);
-		srcdata->text = NULL;
-	}
-	srcdata->text = bzalloc((strlen(tmp_read) + 1) * sizeof(wchar_t));
-	os_utf8_to_wcs(tmp_read, strlen(tmp_read), srcdata->text, (strlen(tmp_read) + 1));
+	text = bzalloc((strlen(tmp_read) + 1) * sizeof(wchar_t));
+	os_utf8_to_wcs(tmp_read, strlen(tmp_read), text, (strlen(tmp_read) + 1));
 
-	remove_cr(srcdata->text);
+	remove_cr(text);
 	bfree(tmp_read);
+	return text;
 }
 
 uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
@@ -508,11 +418,11 @@ uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
 		return 0;
 	}
 
-	FT_GlyphSlot slot = srcdata->font_face->glyph;
+	FT_GlyphSlot slot = srcdata->atlas->face->glyph;
 	uint32_t w = 0, max_w = 0;
 	const size_t len = wcslen(text);
 	for (size_t i = 0; i < len; i++) {
-		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->font_face, text[i]);
+		const FT_UInt glyph_index = FT_Get_Char_Index(srcdata->atlas->face, text[i]);
 
 		if (text[i] == L'\n')
 			w = 0;
@@ -521,7 +431,7 @@ uint32_t get_ft2_text_width(wchar_t *text, struct ft2_source *srcdata)
 				// Use the cached values.
 				w += src_glyph->xadv;
 			} else {
-				load_glyph(srcdata, glyph_index, get_render_mode(srcdata));
+				glyph_atlas_load_glyph(srcdata->atlas, glyph_index);
 				w += slot->advance.x >> 6;
 			}
 			if (w > max_w)
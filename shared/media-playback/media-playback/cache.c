@@ -16,6 +16,7 @@
 
 #include <media-io/audio-io.h>
 #include <util/platform.h>
+#include <inttypes.h>
 
 #include "media-playback.h"
 #include "cache.h"
@@ -131,6 +132,16 @@ bool mp_cache_decode(mp_cache_t *c)
 
 	success = true;
 
+	if (c->budget) {
+		blog(LOG_INFO, "MP: Cached %zu frames of '%s', %zu MB resident, %zu MB compressed", c->video_frames.num,
+		     c->path, c->resident_size / 1048576, c->compressed_size / 1048576);
+
+		pthread_mutex_lock(&c->mutex);
+		c->stats.resident_size = c->resident_size;
+		c->stats.compressed_size = c->compressed_size;
+		pthread_mutex_unlock(&c->mutex);
+	}
+
 	c->start_time = c->m.fmt->start_time;
 	if (c->start_time == AV_NOPTS_VALUE)
 		c->start_time = 0;
@@ -231,6 +242,143 @@ static inline void calc_next_a_ts(mp_cache_t *c, struct obs_source_audio *audio)
 	c->next_a_ts += offset;
 }
 
+static inline uint32_t get_plane_height(enum video_format format, size_t plane, uint32_t height)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_I40A:
+	case VIDEO_FORMAT_I010:
+	case VIDEO_FORMAT_P010:
+		return (plane == 1 || plane == 2) ? (height + 1) / 2 : height;
+	default:
+		return height;
+	}
+}
+
+static size_t get_frame_size(const struct obs_source_frame *frame)
+{
+	size_t size = 0;
+
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (frame->data[i])
+			size += (size_t)frame->linesize[i] * get_plane_height(frame->format, i, frame->height);
+	}
+
+	return size;
+}
+
+static inline size_t get_cache_size(mp_cache_t *c)
+{
+	return c->resident_size + c->compressed_size + c->audio_size;
+}
+
+static void update_stats(mp_cache_t *c, bool hit, uint64_t decode_time)
+{
+	pthread_mutex_lock(&c->mutex);
+	if (hit) {
+		c->stats.hits++;
+	} else {
+		c->stats.misses++;
+		c->stats.decode_time_ns += decode_time;
+	}
+	c->stats.resident_size = c->resident_size;
+	c->stats.compressed_size = c->compressed_size;
+	pthread_mutex_unlock(&c->mutex);
+}
+
+static void lru_touch(mp_cache_t *c, size_t idx)
+{
+	/* recently used frames are at the back, so search from there */
+	for (size_t i = c->lru.num; i > 0; i--) {
+		if (c->lru.array[i - 1] == idx) {
+			if (i == c->lru.num)
+				return;
+
+			da_erase(c->lru, i - 1);
+			break;
+		}
+	}
+
+	da_push_back(c->lru, &idx);
+}
+
+static bool evict_frame(mp_cache_t *c, size_t idx)
+{
+	struct obs_source_frame *frame = &c->video_frames.array[idx];
+	struct mp_packed_frame *packed = &c->packed_frames.array[idx];
+
+	/* frames are lossless, so a frame only ever has to be compressed
+	 * once and can be dropped again for free after that */
+	if (!packed->data) {
+		if (!mp_pack_compress(&c->pack, frame, packed))
+			return false;
+
+		c->compressed_size += packed->size;
+	}
+
+	c->resident_size -= get_frame_size(frame);
+	bfree(frame->data[0]);
+	memset(frame->data, 0, sizeof(frame->data));
+	return true;
+}
+
+static void trim_cache(mp_cache_t *c)
+{
+	/* never evict the most recently used frame, it is the one that is
+	 * about to be output */
+	while (c->lru.num > 1 && get_cache_size(c) > c->budget) {
+		size_t idx = c->lru.array[0];
+
+		/* a frame that cannot be compressed stays resident */
+		if (!evict_frame(c, idx) && !c->budget_warned) {
+			blog(LOG_WARNING, "MP: Failed to compress frame %zu of '%s'", idx, c->path);
+			c->budget_warned = true;
+		}
+
+		da_erase(c->lru, 0);
+	}
+
+	if (!c->budget_warned && get_cache_size(c) > c->budget) {
+		blog(LOG_WARNING, "MP: '%s' does not fit in its cache budget of %zu MB", c->path, c->budget / 1048576);
+		c->budget_warned = true;
+	}
+}
+
+static bool load_video_frame(mp_cache_t *c, size_t idx, struct obs_source_frame *out)
+{
+	struct obs_source_frame *frame = &c->video_frames.array[idx];
+	uint64_t decode_time = 0;
+	bool hit = !!frame->data[0];
+
+	if (!hit) {
+		struct obs_source_frame data;
+		uint64_t start = os_gettime_ns();
+
+		obs_source_frame_init(&data, frame->format, frame->width, frame->height);
+		if (!mp_pack_decompress(&c->pack, &c->packed_frames.array[idx], &data)) {
+			blog(LOG_WARNING, "MP: Failed to decompress frame %zu of '%s'", idx, c->path);
+			bfree(data.data[0]);
+			return false;
+		}
+
+		memcpy(frame->data, data.data, sizeof(frame->data));
+		memcpy(frame->linesize, data.linesize, sizeof(frame->linesize));
+		c->resident_size += get_frame_size(frame);
+		decode_time = os_gettime_ns() - start;
+	}
+
+	if (c->budget && mp_pack_matches(&c->pack, frame)) {
+		lru_touch(c, idx);
+		trim_cache(c);
+	}
+
+	update_stats(c, hit, decode_time);
+
+	*out = *frame;
+	return true;
+}
+
 static void mp_cache_next_video(mp_cache_t *c, bool preload)
 {
 	/* eof check */
@@ -241,27 +389,35 @@ static void mp_cache_next_video(mp_cache_t *c, bool preload)
 	}
 
 	struct obs_source_frame *frame = &c->video_frames.array[c->next_v_idx];
-	struct obs_source_frame dup = *frame;
-
-	dup.timestamp = c->base_ts + dup.timestamp - c->start_ts + c->play_sys_ts - base_sys_ts;
+	struct obs_source_frame dup;
 
 	if (!preload) {
 		if (!mp_media_can_play_video(c))
 			return;
 
-		if (c->v_cb)
+		if (c->v_cb && load_video_frame(c, c->next_v_idx, &dup)) {
+			dup.timestamp = c->base_ts + dup.timestamp - c->start_ts + c->play_sys_ts - base_sys_ts;
 			c->v_cb(c->opaque, &dup);
+		}
 
 		if (c->cur_v_idx < c->next_v_idx)
 			++c->cur_v_idx;
 		++c->next_v_idx;
 		calc_next_v_ts(c, frame);
 	} else {
-		if (c->seek_next_ts && c->v_seek_cb) {
+		bool seek = c->seek_next_ts && c->v_seek_cb;
+
+		if (!seek && c->request_preload)
+			return;
+		if (!load_video_frame(c, c->next_v_idx, &dup))
+			return;
+
+		dup.timestamp = c->base_ts + dup.timestamp - c->start_ts + c->play_sys_ts - base_sys_ts;
+
+		if (seek)
 			c->v_seek_cb(c->opaque, &dup);
-		} else if (!c->request_preload) {
+		else
 			c->v_preload_cb(c->opaque, &dup);
-		}
 	}
 }
 
@@ -432,8 +588,11 @@ static inline bool mp_cache_thread(mp_cache_t *c)
 		if (pause)
 			continue;
 
-		if (preload_frame)
-			c->v_preload_cb(c->opaque, &c->video_frames.array[0]);
+		if (preload_frame) {
+			struct obs_source_frame frame;
+			if (load_video_frame(c, 0, &frame))
+				c->v_preload_cb(c->opaque, &frame);
+		}
 
 		/* frames are ready */
 		if (is_active && !timeout) {
@@ -477,7 +636,23 @@ static void fill_video(void *data, struct obs_source_frame *frame)
 
 	c->final_v_duration = c->m.v.last_duration;
 
+	if (c->budget && !c->video_frames.num && !mp_pack_init(&c->pack, frame->format, frame->width, frame->height))
+		blog(LOG_WARNING, "MP: Cannot compress %s frames, cache budget of '%s' will not be enforced",
+		     get_video_format_name(frame->format), c->path);
+
 	da_push_back(c->video_frames, &dup);
+	c->resident_size += get_frame_size(&dup);
+
+	if (c->budget) {
+		struct mp_packed_frame packed = {0};
+		da_push_back(c->packed_frames, &packed);
+
+		if (mp_pack_matches(&c->pack, &dup)) {
+			size_t idx = c->video_frames.num - 1;
+			da_push_back(c->lru, &idx);
+			trim_cache(c);
+		}
+	}
 }
 
 static void fill_audio(void *data, struct obs_source_audio *audio)
@@ -505,6 +680,7 @@ static void fill_audio(void *data, struct obs_source_audio *audio)
 	}
 
 	c->final_a_duration = c->m.a.last_duration;
+	c->audio_size += get_total_audio_size(dup.format, dup.speakers, dup.frames);
 
 	da_push_back(c->audio_segments, &dup);
 }
@@ -566,6 +742,7 @@ bool mp_cache_init(mp_cache_t *c, const struct mp_media_info *info)
 	c->v_preload_cb = info->v_preload_cb;
 	c->request_preload = info->request_preload;
 	c->speed = info->speed;
+	c->budget = info->cache_budget;
 	c->media_duration = m->fmt->duration;
 
 	c->has_video = m->has_video;
@@ -605,16 +782,32 @@ void mp_cache_free(mp_cache_t *c)
 	if (c->m.fmt)
 		mp_media_free(&c->m);
 
+	if (c->budget && (c->stats.hits || c->stats.misses)) {
+		uint64_t loads = c->stats.hits + c->stats.misses;
+		double avg_ms = c->stats.misses ? (double)c->stats.decode_time_ns / (double)c->stats.misses / 1000000.0
+						: 0.0;
+
+		blog(LOG_INFO,
+		     "MP: Cache stats for '%s': %" PRIu64 " hits, %" PRIu64 " misses (%.1f%% hit rate), "
+		     "%.2f ms average decompression time",
+		     c->path, c->stats.hits, c->stats.misses, (double)c->stats.hits * 100.0 / (double)loads, avg_ms);
+	}
+
 	for (size_t i = 0; i < c->video_frames.num; i++) {
 		struct obs_source_frame *f = &c->video_frames.array[i];
 		obs_source_frame_free(f);
 	}
+	for (size_t i = 0; i < c->packed_frames.num; i++)
+		bfree(c->packed_frames.array[i].data);
 	for (size_t i = 0; i < c->audio_segments.num; i++) {
 		struct obs_source_audio *a = &c->audio_segments.array[i];
 		bfree((void *)a->data[0]);
 	}
 	da_free(c->video_frames);
 	da_free(c->audio_segments);
+	da_free(c->packed_frames);
+	da_free(c->lru);
+	mp_pack_free(&c->pack);
 
 	bfree(c->path);
 	bfree(c->format_name);
@@ -699,3 +892,10 @@ int64_t mp_cache_get_duration(mp_cache_t *c)
 {
 	return c->media_duration;
 }
+
+void mp_cache_get_stats(mp_cache_t *c, struct mp_cache_stats *stats)
+{
+	pthread_mutex_lock(&c->mutex);
+	*stats = c->stats;
+	pthread_mutex_unlock(&c->mutex);
+}
@@ -21,6 +21,7 @@
 #include <obs.h>
 
 #include "media.h"
+#include "pack.h"
 
 struct mp_cache {
 	mp_video_cb v_preload_cb;
@@ -54,6 +55,19 @@ struct mp_cache {
 	DARRAY(struct obs_source_frame) video_frames;
 	DARRAY(struct obs_source_audio) audio_segments;
 
+	/* with a memory budget, frames that do not fit are kept compressed
+	 * and decompressed on demand; resident frames are tracked in least
+	 * recently used order */
+	size_t budget;
+	size_t resident_size;
+	size_t compressed_size;
+	size_t audio_size;
+	bool budget_warned;
+	struct mp_pack pack;
+	DARRAY(struct mp_packed_frame) packed_frames;
+	DARRAY(size_t) lru;
+	struct mp_cache_stats stats;
+
 	size_t cur_v_idx;
 	size_t cur_a_idx;
 	size_t next_v_idx;
@@ -95,3 +109,4 @@ extern int64_t mp_cache_get_current_time(mp_cache_t *c);
 extern void mp_cache_seek(mp_cache_t *c, int64_t pos);
 extern int64_t mp_cache_get_frames(mp_cache_t *c);
 extern int64_t mp_cache_get_duration(mp_cache_t *c);
+extern void mp_cache_get_stats(mp_cache_t *c, struct mp_cache_stats *stats);
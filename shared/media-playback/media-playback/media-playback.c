@@ -174,3 +174,12 @@ bool media_playback_has_audio(media_playback_t *mp)
 	else
 		return mp->media.has_audio;
 }
+
+bool media_playback_get_cache_stats(media_playback_t *mp, struct mp_cache_stats *stats)
+{
+	if (!mp || !mp->is_cached)
+		return false;
+
+	mp_cache_get_stats(&mp->cache, stats);
+	return true;
+}
@@ -25,6 +25,14 @@ typedef void (*mp_video_cb)(void *opaque, struct obs_source_frame *frame);
 typedef void (*mp_audio_cb)(void *opaque, struct obs_source_audio *audio);
 typedef void (*mp_stop_cb)(void *opaque);
 
+struct mp_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t decode_time_ns;
+	size_t resident_size;
+	size_t compressed_size;
+};
+
 struct mp_media_info {
 	void *opaque;
 
@@ -39,6 +47,7 @@ struct mp_media_info {
 	char *ffmpeg_options;
 	int buffering;
 	int speed;
+	size_t cache_budget;
 	enum video_range_type force_range;
 	bool is_linear_alpha;
 	bool hardware_decoding;
@@ -63,3 +72,4 @@ extern int64_t media_playback_get_frames(media_playback_t *mp);
 extern int64_t media_playback_get_duration(media_playback_t *mp);
 extern bool media_playback_has_video(media_playback_t *mp);
 extern bool media_playback_has_audio(media_playback_t *mp);
+extern bool media_playback_get_cache_stats(media_playback_t *mp, struct mp_cache_stats *stats);
@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <libavutil/imgutils.h>
+#include <util/bmem.h>
+
+#include "pack.h"
+
+static enum AVPixelFormat get_pack_format(enum video_format format)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+		return AV_PIX_FMT_YUV420P;
+	case VIDEO_FORMAT_I422:
+		return AV_PIX_FMT_YUV422P;
+	case VIDEO_FORMAT_I444:
+		return AV_PIX_FMT_YUV444P;
+	case VIDEO_FORMAT_I40A:
+		return AV_PIX_FMT_YUVA420P;
+	case VIDEO_FORMAT_I42A:
+		return AV_PIX_FMT_YUVA422P;
+	case VIDEO_FORMAT_YUVA:
+		return AV_PIX_FMT_YUVA444P;
+	case VIDEO_FORMAT_I010:
+		return AV_PIX_FMT_YUV420P10LE;
+	case VIDEO_FORMAT_I210:
+		return AV_PIX_FMT_YUV422P10LE;
+	case VIDEO_FORMAT_I412:
+		return AV_PIX_FMT_YUV444P12LE;
+	case VIDEO_FORMAT_Y800:
+		return AV_PIX_FMT_GRAY8;
+
+	/* the data only has to survive the round trip, so the channel order
+	 * of 32-bit packed formats does not matter to the codec */
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+	case VIDEO_FORMAT_AYUV:
+		return AV_PIX_FMT_RGB32;
+
+	default:
+		return AV_PIX_FMT_NONE;
+	}
+}
+
+static AVCodecContext *open_context(const AVCodec *codec, enum AVPixelFormat pix_fmt, uint32_t width, uint32_t height,
+				    const AVCodecContext *encoder)
+{
+	AVCodecContext *c = avcodec_alloc_context3(codec);
+	if (!c)
+		return NULL;
+
+	c->width = (int)width;
+	c->height = (int)height;
+	c->pix_fmt = pix_fmt;
+	c->time_base = (AVRational){1, 1};
+
+	/* frames are packed and unpacked one at a time, frame threading
+	 * would only add delay */
+	c->thread_count = 1;
+
+	if (encoder && encoder->extradata_size) {
+		c->extradata = av_mallocz(encoder->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+		if (!c->extradata)
+			goto fail;
+
+		memcpy(c->extradata, encoder->extradata, encoder->extradata_size);
+		c->extradata_size = encoder->extradata_size;
+	}
+
+	if (avcodec_open2(c, codec, NULL) < 0)
+		goto fail;
+
+	return c;
+
+fail:
+	avcodec_free_context(&c);
+	return NULL;
+}
+
+bool mp_pack_init(struct mp_pack *pack, enum video_format format, uint32_t width, uint32_t height)
+{
+	enum AVPixelFormat pix_fmt = get_pack_format(format);
+	const AVCodec *encoder;
+	const AVCodec *decoder;
+
+	memset(pack, 0, sizeof(*pack));
+
+	if (pix_fmt == AV_PIX_FMT_NONE)
+		return false;
+
+	encoder = avcodec_find_encoder(AV_CODEC_ID_FFVHUFF);
+	decoder = avcodec_find_decoder(AV_CODEC_ID_FFVHUFF);
+	if (!encoder || !decoder)
+		return false;
+
+	pack->encoder = open_context(encoder, pix_fmt, width, height, NULL);
+	if (!pack->encoder)
+		goto fail;
+
+	pack->decoder = open_context(decoder, pix_fmt, width, height, pack->encoder);
+	if (!pack->decoder)
+		goto fail;
+
+	pack->in_frame = av_frame_alloc();
+	pack->out_frame = av_frame_alloc();
+	pack->pkt = av_packet_alloc();
+	if (!pack->in_frame || !pack->out_frame || !pack->pkt)
+		goto fail;
+
+	if (format == VIDEO_FORMAT_NV12) {
+		pack->planar_frame = av_frame_alloc();
+		if (!pack->planar_frame)
+			goto fail;
+
+		pack->planar_frame->format = pix_fmt;
+		pack->planar_frame->width = (int)width;
+		pack->planar_frame->height = (int)height;
+		if (av_frame_get_buffer(pack->planar_frame, 0) < 0)
+			goto fail;
+	}
+
+	pack->format = format;
+	pack->width = width;
+	pack->height = height;
+	return true;
+
+fail:
+	mp_pack_free(pack);
+	return false;
+}
+
+void mp_pack_free(struct mp_pack *pack)
+{
+	avcodec_free_context(&pack->encoder);
+	avcodec_free_context(&pack->decoder);
+	av_frame_free(&pack->in_frame);
+	av_frame_free(&pack->planar_frame);
+	av_frame_free(&pack->out_frame);
+	av_packet_free(&pack->pkt);
+	memset(pack, 0, sizeof(*pack));
+}
+
+static void split_chroma(AVFrame *dst, const struct obs_source_frame *src)
+{
+	const uint32_t cx = (src->width + 1) / 2;
+	const uint32_t cy = (src->height + 1) / 2;
+
+	for (uint32_t y = 0; y < src->height; y++)
+		memcpy(dst->data[0] + y * dst->linesize[0], src->data[0] + y * src->linesize[0], src->width);
+
+	for (uint32_t y = 0; y < cy; y++) {
+		const uint8_t *uv = src->data[1] + y * src->linesize[1];
+		uint8_t *u = dst->data[1] + y * dst->linesize[1];
+		uint8_t *v = dst->data[2] + y * dst->linesize[2];
+
+		for (uint32_t x = 0; x < cx; x++) {
+			u[x] = uv[x * 2];
+			v[x] = uv[x * 2 + 1];
+		}
+	}
+}
+
+static void merge_chroma(struct obs_source_frame *dst, const AVFrame *src)
+{
+	const uint32_t cx = (dst->width + 1) / 2;
+	const uint32_t cy = (dst->height + 1) / 2;
+
+	for (uint32_t y = 0; y < dst->height; y++)
+		memcpy(dst->data[0] + y * dst->linesize[0], src->data[0] + y * src->linesize[0], dst->width);
+
+	for (uint32_t y = 0; y < cy; y++) {
+		const uint8_t *u = src->data[1] + y * src->linesize[1];
+		const uint8_t *v = src->data[2] + y * src->linesize[2];
+		uint8_t *uv = dst->data[1] + y * dst->linesize[1];
+
+		for (uint32_t x = 0; x < cx; x++) {
+			uv[x * 2] = u[x];
+			uv[x * 2 + 1] = v[x];
+		}
+	}
+}
+
+bool mp_pack_compress(struct mp_pack *pack, const struct obs_source_frame *frame, struct mp_packed_frame *packed)
+{
+	AVFrame *in = pack->in_frame;
+	bool success = false;
+
+	if (!mp_pack_matches(pack, frame))
+		return false;
+
+	if (pack->planar_frame) {
+		if (av_frame_make_writable(pack->planar_frame) < 0)
+			return false;
+
+		split_chroma(pack->planar_frame, frame);
+		in = pack->planar_frame;
+	} else {
+		in->format = pack->encoder->pix_fmt;
+		in->width = (int)frame->width;
+		in->height = (int)frame->height;
+
+		for (size_t i = 0; i < AV_NUM_DATA_POINTERS && i < MAX_AV_PLANES; i++) {
+			in->data[i] = frame->data[i];
+			in->linesize[i] = (int)frame->linesize[i];
+		}
+	}
+
+	if (avcodec_send_frame(pack->encoder, in) < 0)
+		goto finish;
+	if (avcodec_receive_packet(pack->encoder, pack->pkt) < 0)
+		goto finish;
+
+	packed->size = (size_t)pack->pkt->size;
+	packed->data = bmalloc(packed->size + AV_INPUT_BUFFER_PADDING_SIZE);
+	memcpy(packed->data, pack->pkt->data, packed->size);
+	memset(packed->data + packed->size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+	av_packet_unref(pack->pkt);
+	success = true;
+
+finish:
+	if (in == pack->in_frame)
+		memset(in->data, 0, sizeof(in->data));
+	return success;
+}
+
+bool mp_pack_decompress(struct mp_pack *pack, const struct mp_packed_frame *packed, struct obs_source_frame *frame)
+{
+	AVFrame *out = pack->out_frame;
+	int ret;
+
+	if (!mp_pack_matches(pack, frame))
+		return false;
+
+	/* the packet has no buffer reference, so the decoder takes a copy
+	 * and the packed data stays owned by the cache */
+	pack->pkt->data = packed->data;
+	pack->pkt->size = (int)packed->size;
+	pack->pkt->flags = AV_PKT_FLAG_KEY;
+
+	ret = avcodec_send_packet(pack->decoder, pack->pkt);
+	pack->pkt->data = NULL;
+	pack->pkt->size = 0;
+	if (ret < 0)
+		return false;
+
+	if (avcodec_receive_frame(pack->decoder, out) < 0)
+		return false;
+
+	if (frame->format == VIDEO_FORMAT_NV12) {
+		merge_chroma(frame, out);
+	} else {
+		uint8_t *dst[4] = {0};
+		int dst_linesize[4] = {0};
+
+		for (size_t i = 0; i < 4; i++) {
+			dst[i] = frame->data[i];
+			dst_linesize[i] = (int)frame->linesize[i];
+		}
+
+		av_image_copy(dst, dst_linesize, (const uint8_t **)out->data, out->linesize, pack->decoder->pix_fmt,
+			      out->width, out->height);
+	}
+
+	av_frame_unref(out);
+	return true;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 OBS Project contributors
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#pragma warning(disable : 4204)
+#endif
+
+#include <libavcodec/avcodec.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include <obs.h>
+
+/* Lossless intra compression for cached video frames.  Frames are stored
+ * with FFVHuff, which decodes fast enough to be done in the playback path
+ * and round-trips the frame data exactly. */
+
+struct mp_packed_frame {
+	uint8_t *data;
+	size_t size;
+};
+
+struct mp_pack {
+	AVCodecContext *encoder;
+	AVCodecContext *decoder;
+	AVFrame *in_frame;
+	AVFrame *planar_frame;
+	AVFrame *out_frame;
+	AVPacket *pkt;
+
+	enum video_format format;
+	uint32_t width;
+	uint32_t height;
+};
+
+extern bool mp_pack_init(struct mp_pack *pack, enum video_format format, uint32_t width, uint32_t height);
+extern void mp_pack_free(struct mp_pack *pack);
+
+static inline bool mp_pack_matches(const struct mp_pack *pack, const struct obs_source_frame *frame)
+{
+	return pack->encoder && pack->format == frame->format && pack->width == frame->width &&
+	       pack->height == frame->height;
+}
+
+extern bool mp_pack_compress(struct mp_pack *pack, const struct obs_source_frame *frame,
+			     struct mp_packed_frame *packed);
+extern bool mp_pack_decompress(struct mp_pack *pack, const struct mp_packed_frame *packed,
+			       struct obs_source_frame *frame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,134 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <media-io/audio-mix.h>
+#include <util/bmem.h>
+#include <util/platform.h>
+
+/* one audio tick with an odd offset, to cover unaligned access and tails */
+#define TEST_FRAMES 1024
+#define TEST_OFFSET 3
+#define TEST_COUNT (TEST_FRAMES - TEST_OFFSET)
+#define BENCH_ITERATIONS 20000
+
+struct mix_buffers {
+	float out[TEST_FRAMES];
+	float ref[TEST_FRAMES];
+	float in[TEST_FRAMES];
+	float gain[TEST_FRAMES];
+};
+
+static void init_buffers(struct mix_buffers *bufs)
+{
+	srand(1);
+
+	for (size_t i = 0; i < TEST_FRAMES; i++) {
+		bufs->out[i] = bufs->ref[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		bufs->in[i] = (float)rand() / (float)RAND_MAX * 2.0f - 1.0f;
+		bufs->gain[i] = (float)i / (float)TEST_FRAMES;
+	}
+}
+
+static void assert_buffers_equal(const struct mix_buffers *bufs)
+{
+	for (size_t i = 0; i < TEST_FRAMES; i++)
+		assert_true(fabsf(bufs->out[i] - bufs->ref[i]) <= 1e-6f);
+}
+
+static void mix_add_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const struct audio_mix_kernels *kernels = audio_mix_get_kernels();
+	const struct audio_mix_kernels *ref = audio_mix_get_reference_kernels();
+	struct mix_buffers *bufs = bzalloc(sizeof(*bufs));
+	init_buffers(bufs);
+
+	kernels->add(bufs->out + TEST_OFFSET, bufs->in, TEST_COUNT);
+	ref->add(bufs->ref + TEST_OFFSET, bufs->in, TEST_COUNT);
+	assert_buffers_equal(bufs);
+
+	kernels->add_gain(bufs->out + TEST_OFFSET, bufs->in, 0.25f, TEST_COUNT);
+	ref->add_gain(bufs->ref + TEST_OFFSET, bufs->in, 0.25f, TEST_COUNT);
+	assert_buffers_equal(bufs);
+
+	kernels->add_gain_ramp(bufs->out + TEST_OFFSET, bufs->in, bufs->gain, TEST_COUNT);
+	ref->add_gain_ramp(bufs->ref + TEST_OFFSET, bufs->in, bufs->gain, TEST_COUNT);
+	assert_buffers_equal(bufs);
+
+	bfree(bufs);
+}
+
+static void mix_mul_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const struct audio_mix_kernels *kernels = audio_mix_get_kernels();
+	const struct audio_mix_kernels *ref = audio_mix_get_reference_kernels();
+	struct mix_buffers *bufs = bzalloc(sizeof(*bufs));
+	init_buffers(bufs);
+
+	kernels->mul(bufs->out + TEST_OFFSET, 0.5f, TEST_COUNT);
+	ref->mul(bufs->ref + TEST_OFFSET, 0.5f, TEST_COUNT);
+	assert_buffers_equal(bufs);
+
+	kernels->mul_ramp(bufs->out + TEST_OFFSET, bufs->gain, TEST_COUNT);
+	ref->mul_ramp(bufs->ref + TEST_OFFSET, bufs->gain, TEST_COUNT);
+	assert_buffers_equal(bufs);
+
+	bfree(bufs);
+}
+
+static uint64_t bench_kernels(const struct audio_mix_kernels *kernels, struct mix_buffers *bufs)
+{
+	uint64_t start = os_gettime_ns();
+
+	for (size_t i = 0; i < BENCH_ITERATIONS; i++) {
+		kernels->add(bufs->out, bufs->in, TEST_FRAMES);
+		kernels->add_gain_ramp(bufs->out, bufs->in, bufs->gain, TEST_FRAMES);
+		kernels->mul(bufs->out, 0.5f, TEST_FRAMES);
+	}
+
+	return os_gettime_ns() - start;
+}
+
+static void mix_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	const struct audio_mix_kernels *kernels = audio_mix_get_kernels();
+	const struct audio_mix_kernels *ref = audio_mix_get_reference_kernels();
+	struct mix_buffers *bufs = bzalloc(sizeof(*bufs));
+	init_buffers(bufs);
+
+	uint64_t ref_ns = bench_kernels(ref, bufs);
+	uint64_t kernels_ns = bench_kernels(kernels, bufs);
+
+	printf("audio mix: %s %.3f ms, %s %.3f ms (%.2fx)\n", ref->name, (double)ref_ns / 1000000.0, kernels->name,
+	       (double)kernels_ns / 1000000.0, (double)ref_ns / (double)(kernels_ns ? kernels_ns : 1));
+
+	bfree(bufs);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(mix_add_test),
+		cmocka_unit_test(mix_mul_test),
+	};
+
+	/* timing only, not run by ctest unless OBS_TEST_BENCHMARK is set */
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(mix_benchmark),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("OBS_TEST_BENCHMARK"))
+		ret = cmocka_run_group_tests(benchmarks, NULL, NULL);
+	return ret;
+}
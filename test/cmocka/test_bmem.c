@@ -0,0 +1,107 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+#define NUM_PTRS 1000
+
+static size_t test_size(size_t i)
+{
+	/* covers all size classes as well as sizes above the pool limit */
+	return 1 + (i * 7919) % (300 * 1024);
+}
+
+static void fill(uint8_t *ptr, size_t size, uint8_t val)
+{
+	memset(ptr, val, size);
+}
+
+static bool check(const uint8_t *ptr, size_t size, uint8_t val)
+{
+	for (size_t i = 0; i < size; i++) {
+		if (ptr[i] != val)
+			return false;
+	}
+	return true;
+}
+
+static void *free_thread(void *data)
+{
+	void **ptrs = data;
+
+	for (size_t i = 0; i < NUM_PTRS; i++) {
+		if (ptrs[i] && !check(ptrs[i], test_size(i), (uint8_t)i))
+			return (void *)1;
+		bfree(ptrs[i]);
+	}
+
+	return NULL;
+}
+
+static void bmem_pool_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static void *ptrs[NUM_PTRS];
+	struct bmem_stats stats;
+	long allocs = bnum_allocs();
+
+	bmem_set_pool_enabled(true);
+	bmem_get_stats(&stats);
+	assert_true(stats.pool_enabled);
+
+	for (size_t round = 0; round < 2; round++) {
+		for (size_t i = 0; i < NUM_PTRS; i++) {
+			size_t size = test_size(i);
+			ptrs[i] = bmalloc(size);
+			assert_int_equal((uintptr_t)ptrs[i] % base_get_alignment(), 0);
+			fill(ptrs[i], size, (uint8_t)i);
+		}
+
+		/* growing keeps the contents */
+		for (size_t i = 0; i < NUM_PTRS; i += 10) {
+			size_t size = test_size(i);
+			ptrs[i] = brealloc(ptrs[i], size + 4096);
+			assert_true(check(ptrs[i], size, (uint8_t)i));
+		}
+
+		/* free the first round on another thread, the second one here */
+		if (round == 0) {
+			pthread_t thread;
+			void *ret;
+			assert_int_equal(pthread_create(&thread, NULL, free_thread, ptrs), 0);
+			pthread_join(thread, &ret);
+			assert_null(ret);
+		} else {
+			assert_null(free_thread(ptrs));
+		}
+	}
+
+	assert_int_equal(bnum_allocs(), allocs);
+
+	bmem_get_stats(&stats);
+	assert_true(stats.pool_hits > 0);
+	assert_true(stats.pool_misses > 0);
+	assert_true(stats.reserved_bytes >= stats.used_bytes + stats.cached_bytes);
+	assert_true(stats.fragmentation >= 0.0 && stats.fragmentation <= 1.0);
+
+	/* pool memory is still freed correctly after disabling the pool */
+	void *ptr = bmalloc(64);
+	bmem_set_pool_enabled(false);
+	bfree(ptr);
+
+	bmem_get_stats(&stats);
+	assert_false(stats.pool_enabled);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bmem_pool_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,523 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <jansson.h>
+
+#include <obs-data.h>
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+/* ------------------------------------------------------------------------- */
+/* the previous jansson based implementation, used as reference */
+
+static void ref_add_json_item(obs_data_t *data, const char *key, json_t *json);
+
+static void ref_add_json_object_data(obs_data_t *data, json_t *jobj)
+{
+	const char *item_key;
+	json_t *jitem;
+
+	json_object_foreach (jobj, item_key, jitem) {
+		ref_add_json_item(data, item_key, jitem);
+	}
+}
+
+static void ref_add_json_item(obs_data_t *data, const char *key, json_t *json)
+{
+	if (json_is_object(json)) {
+		obs_data_t *sub_obj = obs_data_create();
+		ref_add_json_object_data(sub_obj, json);
+		obs_data_set_obj(data, key, sub_obj);
+		obs_data_release(sub_obj);
+
+	} else if (json_is_array(json)) {
+		obs_data_array_t *array = obs_data_array_create();
+		size_t idx;
+		json_t *jitem;
+
+		json_array_foreach (json, idx, jitem) {
+			if (!json_is_object(jitem))
+				continue;
+
+			obs_data_t *item = obs_data_create();
+			ref_add_json_object_data(item, jitem);
+			obs_data_array_push_back(array, item);
+			obs_data_release(item);
+		}
+
+		obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+
+	} else if (json_is_string(json)) {
+		obs_data_set_string(data, key, json_string_value(json));
+	} else if (json_is_integer(json)) {
+		obs_data_set_int(data, key, json_integer_value(json));
+	} else if (json_is_real(json)) {
+		obs_data_set_double(data, key, json_real_value(json));
+	} else if (json_is_true(json)) {
+		obs_data_set_bool(data, key, true);
+	} else if (json_is_false(json)) {
+		obs_data_set_bool(data, key, false);
+	} else if (json_is_null(json)) {
+		obs_data_set_obj(data, key, NULL);
+	}
+}
+
+static obs_data_t *ref_create_from_json(const char *json_string)
+{
+	json_error_t error;
+	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
+
+	if (!root)
+		return NULL;
+
+	obs_data_t *data = obs_data_create();
+	ref_add_json_object_data(data, root);
+	json_decref(root);
+	return data;
+}
+
+static json_t *ref_to_json(obs_data_t *data)
+{
+	if (!data)
+		return json_null();
+
+	json_t *json = json_object();
+	obs_data_item_t *item = obs_data_first(data);
+
+	for (; item; obs_data_item_next(&item)) {
+		const char *name = obs_data_item_get_name(item);
+
+		if (!obs_data_item_has_user_value(item))
+			continue;
+
+		switch (obs_data_item_gettype(item)) {
+		case OBS_DATA_STRING:
+			json_object_set_new(json, name, json_string(obs_data_item_get_string(item)));
+			break;
+		case OBS_DATA_NUMBER:
+			if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+				json_object_set_new(json, name, json_integer(obs_data_item_get_int(item)));
+			else
+				json_object_set_new(json, name, json_real(obs_data_item_get_double(item)));
+			break;
+		case OBS_DATA_BOOLEAN:
+			json_object_set_new(json, name, obs_data_item_get_bool(item) ? json_true() : json_false());
+			break;
+		case OBS_DATA_OBJECT: {
+			obs_data_t *obj = obs_data_item_get_obj(item);
+			json_object_set_new(json, name, ref_to_json(obj));
+			obs_data_release(obj);
+			break;
+		}
+		case OBS_DATA_ARRAY: {
+			json_t *jarray = json_array();
+			obs_data_array_t *array = obs_data_item_get_array(item);
+			size_t count = obs_data_array_count(array);
+
+			for (size_t idx = 0; idx < count; idx++) {
+				obs_data_t *sub_item = obs_data_array_item(array, idx);
+				json_array_append_new(jarray, ref_to_json(sub_item));
+				obs_data_release(sub_item);
+			}
+
+			json_object_set_new(json, name, jarray);
+			obs_data_array_release(array);
+			break;
+		}
+		case OBS_DATA_NULL:
+			break;
+		}
+	}
+
+	return json;
+}
+
+/* returns a malloc'd string */
+static char *ref_get_json(obs_data_t *data, bool pretty)
+{
+	json_t *root = ref_to_json(data);
+	char *json = json_dumps(root, JSON_PRESERVE_ORDER | (pretty ? JSON_INDENT(4) : JSON_COMPACT));
+	json_decref(root);
+	return json;
+}
+
+/* ------------------------------------------------------------------------- */
+/* synthetic scene collections */
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 16;
+}
+
+static const char *sample_strings[] = {
+	"",
+	"Display Capture",
+	"C:\\Users\\streamer\\Videos\\intro \"final\".mp4",
+	"/home/streamer/Videos/intro.mkv",
+	"line one\nline two\r\n\ttabbed",
+	"Caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e \xf0\x9f\x8e\xae",
+	"control \x01\x1f\x7f chars",
+	"url: https://example.com/path?a=1&b=2",
+};
+
+#define NUM_SAMPLE_STRINGS (sizeof(sample_strings) / sizeof(sample_strings[0]))
+
+static const double sample_doubles[] = {0.0, 1.0, -1.5, 0.1, 1920.0 / 1080.0, 1e-300, 6.02214076e23, -2.5e-7, 100.0};
+
+#define NUM_SAMPLE_DOUBLES (sizeof(sample_doubles) / sizeof(sample_doubles[0]))
+
+static void fill_settings(obs_data_t *settings, int num_items)
+{
+	for (int i = 0; i < num_items; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "setting_%d", i);
+
+		switch (next_rand() % 5) {
+		case 0:
+			obs_data_set_string(settings, name, sample_strings[next_rand() % NUM_SAMPLE_STRINGS]);
+			break;
+		case 1:
+			obs_data_set_int(settings, name, (long long)next_rand() * 100003 - 50000000000LL);
+			break;
+		case 2:
+			obs_data_set_double(settings, name, sample_doubles[next_rand() % NUM_SAMPLE_DOUBLES]);
+			break;
+		case 3:
+			obs_data_set_bool(settings, name, next_rand() & 1);
+			break;
+		case 4: {
+			obs_data_t *obj = obs_data_create();
+			obs_data_set_int(obj, "x", next_rand() % 3840);
+			obs_data_set_int(obj, "y", next_rand() % 2160);
+			obs_data_set_obj(settings, name, obj);
+			obs_data_release(obj);
+			break;
+		}
+		}
+	}
+}
+
+static obs_data_t *create_source(int idx, int num_filters)
+{
+	obs_data_t *source = obs_data_create();
+	obs_data_t *settings = obs_data_create();
+	obs_data_t *hotkeys = obs_data_create();
+	obs_data_array_t *filters = obs_data_array_create();
+	obs_data_array_t *empty = obs_data_array_create();
+	char name[64];
+
+	snprintf(name, sizeof(name), "Source %d \xe2\x80\x94 \"copy\"", idx);
+	obs_data_set_string(source, "name", name);
+	obs_data_set_string(source, "uuid", "8c5f4ba5-d7d5-4a2f-9d2c-1b9f3e5c7a11");
+	obs_data_set_string(source, "id", "ffmpeg_source");
+	obs_data_set_int(source, "prev_ver", 520093699);
+	obs_data_set_double(source, "volume", sample_doubles[idx % NUM_SAMPLE_DOUBLES]);
+	obs_data_set_bool(source, "enabled", true);
+	obs_data_set_bool(source, "muted", false);
+
+	fill_settings(settings, 12);
+	obs_data_set_obj(source, "settings", settings);
+	obs_data_set_obj(source, "private_settings", NULL);
+
+	obs_data_set_array(hotkeys, "libobs.mute", empty);
+	obs_data_set_array(hotkeys, "libobs.unmute", empty);
+	obs_data_set_obj(source, "hotkeys", hotkeys);
+
+	for (int i = 0; i < num_filters; i++) {
+		obs_data_t *filter = obs_data_create();
+		obs_data_t *filter_settings = obs_data_create();
+
+		snprintf(name, sizeof(name), "Filter %d", i);
+		obs_data_set_string(filter, "name", name);
+		obs_data_set_string(filter, "id", "color_filter_v2");
+		fill_settings(filter_settings, 6);
+		obs_data_set_obj(filter, "settings", filter_settings);
+		obs_data_array_push_back(filters, filter);
+
+		obs_data_release(filter_settings);
+		obs_data_release(filter);
+	}
+
+	obs_data_set_array(source, "filters", filters);
+
+	obs_data_array_release(empty);
+	obs_data_array_release(filters);
+	obs_data_release(hotkeys);
+	obs_data_release(settings);
+	return source;
+}
+
+static obs_data_t *create_collection(uint32_t seed, int num_sources)
+{
+	obs_data_t *collection = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+
+	rand_state = seed;
+
+	obs_data_set_string(collection, "name", "Synthetic \xe2\x9c\x93");
+	obs_data_set_obj(collection, "modules", NULL);
+
+	for (int i = 0; i < num_sources; i++) {
+		obs_data_t *source = create_source(i, (int)(next_rand() % 4));
+		obs_data_array_push_back(sources, source);
+		obs_data_release(source);
+	}
+
+	obs_data_set_array(collection, "sources", sources);
+	obs_data_set_int(collection, "version", 2);
+
+	obs_data_array_release(sources);
+	return collection;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void check_same_output(obs_data_t *data)
+{
+	char *ref_pretty = ref_get_json(data, true);
+	char *ref_compact = ref_get_json(data, false);
+
+	assert_non_null(ref_pretty);
+	assert_non_null(ref_compact);
+	assert_string_equal(obs_data_get_json_pretty(data), ref_pretty);
+	assert_string_equal(obs_data_get_json(data), ref_compact);
+
+	free(ref_pretty);
+	free(ref_compact);
+}
+
+static void check_same_parse(const char *json)
+{
+	obs_data_t *data = obs_data_create_from_json(json);
+	obs_data_t *ref_data = ref_create_from_json(json);
+
+	if (!ref_data) {
+		assert_null(data);
+		return;
+	}
+
+	assert_non_null(data);
+
+	char *ref_json = ref_get_json(ref_data, true);
+	char *json_from_data = ref_get_json(data, true);
+
+	assert_string_equal(json_from_data, ref_json);
+
+	free(json_from_data);
+	free(ref_json);
+	obs_data_release(ref_data);
+	obs_data_release(data);
+}
+
+static void json_write_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_data_t *empty = obs_data_create();
+	check_same_output(empty);
+	obs_data_release(empty);
+
+	obs_data_t *collection = create_collection(1, 200);
+	check_same_output(collection);
+	obs_data_release(collection);
+}
+
+static void json_write_unrepresentable_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* jansson leaves out invalid UTF-8 and non-finite numbers */
+	obs_data_t *data = obs_data_create();
+	obs_data_set_string(data, "valid", "ok");
+	obs_data_set_string(data, "invalid", "bad \xc3\x28 byte");
+	obs_data_set_string(data, "overlong", "\xc0\xaf");
+	obs_data_set_string(data, "surrogate", "\xed\xa0\x80");
+	obs_data_set_int(data, "bad \xff name", 1);
+	obs_data_set_double(data, "nan", NAN);
+	obs_data_set_double(data, "inf", INFINITY);
+	obs_data_set_double(data, "last", 2.0);
+
+	check_same_output(data);
+	assert_string_equal(obs_data_get_json(data), "{\"valid\":\"ok\",\"last\":2.0}");
+
+	obs_data_release(data);
+}
+
+static void json_parse_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const char *inputs[] = {
+		"{}",
+		"[]",
+		"[{\"a\": 1}]",
+		" \r\n\t{ \"a\" : 1 , \"b\":[ ] ,\"c\":{ } } \n",
+		"{\"str\": \"esc \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9 \\u65E5 \\ud83c\\udfae end\"}",
+		"{\"\\u0041key\": \"value\", \"k\\u00e9y\": \"\xc3\xa9\"}",
+		"{\"ints\": {\"a\": 0, \"b\": -0, \"c\": 9223372036854775807, \"d\": -9223372036854775808}}",
+		"{\"reals\": {\"a\": 0.5, \"b\": -1e3, \"c\": 1E+2, \"d\": 2.5e-3, \"e\": 1e-400, \"f\": 0.0}}",
+		"{\"long\": 0.000000000000000000000000000000000000000000000000000000000000000000000000001}",
+		"{\"lits\": {\"t\": true, \"f\": false, \"n\": null}}",
+		"{\"arr\": [1, \"two\", [{\"nested\": true}], {\"kept\": 1}, null, {}]}",
+		"{\"deep\": {\"a\": {\"b\": {\"c\": [{\"d\": [{\"e\": {}}]}]}}}}",
+	};
+
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+		check_same_parse(inputs[i]);
+
+	obs_data_t *collection = create_collection(2, 200);
+	check_same_parse(obs_data_get_json_pretty(collection));
+	check_same_parse(obs_data_get_json(collection));
+	obs_data_release(collection);
+}
+
+static void json_parse_error_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	static const char *inputs[] = {
+		"",
+		"   ",
+		"1",
+		"\"str\"",
+		"{",
+		"{\"a\"}",
+		"{\"a\": }",
+		"{\"a\": 1,}",
+		"{\"a\": 1 \"b\": 2}",
+		"{\"a\": 1, \"a\": 2}",
+		"{\"a\": [1, 2,]}",
+		"{\"a\": 01}",
+		"{\"a\": 1.}",
+		"{\"a\": .5}",
+		"{\"a\": 1e}",
+		"{\"a\": -}",
+		"{\"a\": +1}",
+		"{\"a\": 9223372036854775808}",
+		"{\"a\": -9223372036854775809}",
+		"{\"a\": 1e400}",
+		"{\"a\": tru}",
+		"{\"a\": truex}",
+		"{\"a\": nul}",
+		"{\"a\": \"unterminated}",
+		"{\"a\": \"bad \\x escape\"}",
+		"{\"a\": \"\\u12\"}",
+		"{\"a\": \"\\u0000\"}",
+		"{\"a\": \"\\ud83c\"}",
+		"{\"a\": \"\\ud83c\\u0041\"}",
+		"{\"a\": \"\\udfae\"}",
+		"{\"a\": \"raw \n newline\"}",
+		"{\"a\": \"bad \xc3\x28 byte\"}",
+		"{\"a\": \"overlong \xc0\xaf\"}",
+		"{\"a\": 1} trailing",
+		"{\"a\": 1}}",
+		"{'a': 1}",
+		"{a: 1}",
+	};
+
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+		json_error_t error;
+		json_t *root = json_loads(inputs[i], JSON_REJECT_DUPLICATES, &error);
+		obs_data_t *data = obs_data_create_from_json(inputs[i]);
+
+		assert_null(root);
+		assert_null(data);
+	}
+
+	/* jansson's maximum depth */
+	struct dstr deep = {0};
+	dstr_cat(&deep, "{\"a\": ");
+	for (int i = 0; i < 2100; i++)
+		dstr_cat(&deep, "[");
+	for (int i = 0; i < 2100; i++)
+		dstr_cat(&deep, "]");
+	dstr_cat(&deep, "}");
+
+	assert_null(obs_data_create_from_json(deep.array));
+	dstr_free(&deep);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static double mb_per_sec(size_t bytes, uint64_t ns)
+{
+	return (double)bytes / 1000000.0 / ((double)(ns ? ns : 1) / 1000000000.0);
+}
+
+static void json_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* roughly 20 MB of pretty printed JSON */
+	obs_data_t *collection = create_collection(3, 10000);
+	char *json = bstrdup(obs_data_get_json_pretty(collection));
+	size_t size = strlen(json);
+	uint64_t start;
+
+	start = os_gettime_ns();
+	obs_data_t *ref_data = ref_create_from_json(json);
+	uint64_t ref_parse_time = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	obs_data_t *data = obs_data_create_from_json(json);
+	uint64_t parse_time = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	char *ref_json = ref_get_json(data, true);
+	uint64_t ref_write_time = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	const char *new_json = obs_data_get_json_pretty(data);
+	uint64_t write_time = os_gettime_ns() - start;
+
+	assert_non_null(ref_data);
+	assert_non_null(data);
+	assert_string_equal(new_json, json);
+	assert_string_equal(ref_json, json);
+
+	printf("collection size: %.1f MB\n", (double)size / 1000000.0);
+	printf("parse, jansson:  %8.1f ms (%6.1f MB/s)\n", (double)ref_parse_time / 1000000.0,
+	       mb_per_sec(size, ref_parse_time));
+	printf("parse, direct:   %8.1f ms (%6.1f MB/s)\n", (double)parse_time / 1000000.0,
+	       mb_per_sec(size, parse_time));
+	printf("write, jansson:  %8.1f ms (%6.1f MB/s)\n", (double)ref_write_time / 1000000.0,
+	       mb_per_sec(size, ref_write_time));
+	printf("write, direct:   %8.1f ms (%6.1f MB/s)\n", (double)write_time / 1000000.0,
+	       mb_per_sec(size, write_time));
+
+	free(ref_json);
+	bfree(json);
+	obs_data_release(data);
+	obs_data_release(ref_data);
+	obs_data_release(collection);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(json_write_test),
+		cmocka_unit_test(json_write_unrepresentable_test),
+		cmocka_unit_test(json_parse_test),
+		cmocka_unit_test(json_parse_error_test),
+	};
+
+	/* timing only, not run by ctest unless OBS_TEST_BENCHMARK is set */
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(json_benchmark),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("OBS_TEST_BENCHMARK"))
+		ret = cmocka_run_group_tests(benchmarks, NULL, NULL);
+	return ret;
+}
@@ -0,0 +1,126 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/file-watch.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+
+#define TEST_FILE "test_file_watch.txt"
+
+/* long enough to cover the polling fallback */
+#define TIMEOUT_MS 5000
+
+/* the callback runs on the watcher thread, so it only records what it got
+ * and the test checks it on the main thread */
+struct watch_data {
+	os_event_t *event;
+	pthread_mutex_t mutex;
+	struct dstr last_path;
+	long wrong_paths;
+	volatile long calls;
+};
+
+static void file_changed(void *param, const char *path)
+{
+	struct watch_data *data = param;
+
+	pthread_mutex_lock(&data->mutex);
+	dstr_copy(&data->last_path, path);
+	if (strcmp(path, TEST_FILE) != 0)
+		data->wrong_paths++;
+	pthread_mutex_unlock(&data->mutex);
+
+	os_atomic_inc_long(&data->calls);
+	os_event_signal(data->event);
+}
+
+static void init_watch_data(struct watch_data *data)
+{
+	memset(data, 0, sizeof(*data));
+	assert_int_equal(os_event_init(&data->event, OS_EVENT_TYPE_AUTO), 0);
+	assert_int_equal(pthread_mutex_init(&data->mutex, NULL), 0);
+}
+
+static void free_watch_data(struct watch_data *data)
+{
+	dstr_free(&data->last_path);
+	pthread_mutex_destroy(&data->mutex);
+	os_event_destroy(data->event);
+}
+
+static void wait_notified(struct watch_data *data)
+{
+	assert_int_equal(os_event_timedwait(data->event, TIMEOUT_MS), 0);
+
+	pthread_mutex_lock(&data->mutex);
+	assert_int_equal(data->wrong_paths, 0);
+	assert_string_equal(data->last_path.array, TEST_FILE);
+	pthread_mutex_unlock(&data->mutex);
+}
+
+static void write_test_file(const char *text)
+{
+	assert_true(os_quick_write_utf8_file(TEST_FILE, text, strlen(text), false));
+}
+
+static void file_watch_notify_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct watch_data data;
+	init_watch_data(&data);
+
+	os_unlink(TEST_FILE);
+
+	os_file_watch_t *watch = os_file_watch_create(TEST_FILE, file_changed, &data);
+	assert_non_null(watch);
+
+	/* creating the file */
+	write_test_file("first");
+	wait_notified(&data);
+
+	/* changing it, with a different size so polling picks it up too */
+	write_test_file("second change");
+	wait_notified(&data);
+
+	/* removing it */
+	os_unlink(TEST_FILE);
+	wait_notified(&data);
+
+	os_file_watch_destroy(watch);
+	free_watch_data(&data);
+}
+
+static void file_watch_destroy_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct watch_data data;
+	init_watch_data(&data);
+
+	os_file_watch_t *watch = os_file_watch_create(TEST_FILE, file_changed, &data);
+	assert_non_null(watch);
+	os_file_watch_destroy(watch);
+
+	/* no callbacks once destroyed */
+	long calls = os_atomic_load_long(&data.calls);
+	write_test_file("after destroy");
+	os_sleep_ms(1500);
+	assert_int_equal(os_atomic_load_long(&data.calls), calls);
+
+	os_unlink(TEST_FILE);
+	free_watch_data(&data);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(file_watch_notify_test),
+		cmocka_unit_test(file_watch_destroy_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,273 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <obs-interleave.h>
+#include <util/darray.h>
+#include <util/platform.h>
+
+/* packet timelines of a typical multi-track recording: 3 video renditions
+ * sharing a frame rate (so they have identical DTS), and 6 AAC tracks that
+ * are all in phase, delivered with some encoder jitter */
+#define NUM_VIDEO_TRACKS 3
+#define NUM_AUDIO_TRACKS 6
+#define TIMELINE_SECONDS 20
+#define MAX_ARRIVAL_JITTER 4
+
+struct timeline {
+	DARRAY(struct encoder_packet) packets;
+};
+
+static uint32_t rand_state = 1;
+
+static uint32_t next_rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 16;
+}
+
+static void add_track(struct timeline *tl, enum obs_encoder_type type, size_t track_idx, int32_t timebase_num,
+		      int32_t timebase_den, int64_t duration, int64_t start)
+{
+	int64_t count = (int64_t)TIMELINE_SECONDS * timebase_den / (timebase_num * duration);
+
+	for (int64_t i = 0; i < count; i++) {
+		struct encoder_packet *packet = da_push_back_new(tl->packets);
+		packet->type = type;
+		packet->track_idx = track_idx;
+		packet->timebase_num = timebase_num;
+		packet->timebase_den = timebase_den;
+		packet->dts = start + i * duration;
+		packet->pts = packet->dts;
+		packet->dts_usec = packet->dts * 1000000 * timebase_num / timebase_den;
+		packet->keyframe = type == OBS_ENCODER_AUDIO || i % 60 == 0;
+	}
+}
+
+/* interleaves tracks by sys_dts_usec, which is used as the arrival time
+ * here, so packets of different tracks arrive out of DTS order */
+static int compare_arrival(const void *a, const void *b)
+{
+	const struct encoder_packet *pa = a;
+	const struct encoder_packet *pb = b;
+
+	if (pa->sys_dts_usec != pb->sys_dts_usec)
+		return pa->sys_dts_usec < pb->sys_dts_usec ? -1 : 1;
+	return 0;
+}
+
+static void create_timeline(struct timeline *tl, uint32_t seed)
+{
+	da_init(tl->packets);
+	rand_state = seed;
+
+	for (size_t i = 0; i < NUM_VIDEO_TRACKS; i++)
+		add_track(tl, OBS_ENCODER_VIDEO, i, 1, 60, 1, 0);
+	for (size_t i = 0; i < NUM_AUDIO_TRACKS; i++)
+		add_track(tl, OBS_ENCODER_AUDIO, i, 1, 48000, 1024, 0);
+
+	/* arrival order: DTS plus per-packet jitter, keeping each track in
+	 * DTS order since that's what encoders output */
+	int64_t last_arrival[NUM_VIDEO_TRACKS + NUM_AUDIO_TRACKS] = {0};
+	for (size_t i = 0; i < tl->packets.num; i++) {
+		struct encoder_packet *packet = &tl->packets.array[i];
+		size_t slot = packet->type == OBS_ENCODER_VIDEO ? packet->track_idx
+								 : NUM_VIDEO_TRACKS + packet->track_idx;
+		int64_t arrival = packet->dts_usec + (int64_t)(next_rand() % MAX_ARRIVAL_JITTER) * 10000;
+
+		if (arrival < last_arrival[slot])
+			arrival = last_arrival[slot];
+		last_arrival[slot] = arrival;
+		packet->sys_dts_usec = arrival * 16 + (int64_t)slot;
+	}
+
+	qsort(tl->packets.array, tl->packets.num, sizeof(struct encoder_packet), compare_arrival);
+}
+
+/* the original single array interleaver, used as reference */
+static void reference_insert(struct encoder_packet **array, size_t *num, struct encoder_packet *out)
+{
+	size_t idx;
+	for (idx = 0; idx < *num; idx++) {
+		struct encoder_packet *cur_packet = array[idx];
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
+		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
+			continue;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	memmove(array + idx + 1, array + idx, (*num - idx) * sizeof(*array));
+	array[idx] = out;
+	(*num)++;
+}
+
+static void replay_timeline(uint32_t seed, size_t depth)
+{
+	struct timeline tl;
+	struct packet_interleaver il = {0};
+	struct encoder_packet out;
+	struct encoder_packet **reference;
+	size_t reference_num = 0;
+	size_t sent = 0;
+
+	create_timeline(&tl, seed);
+	reference = bmalloc(tl.packets.num * sizeof(*reference));
+
+	for (size_t i = 0; i < tl.packets.num; i++) {
+		struct encoder_packet *packet = &tl.packets.array[i];
+
+		/* data is only used to identify the packet */
+		packet->data = (uint8_t *)packet;
+
+		reference_insert(reference, &reference_num, packet);
+		packet_interleaver_push(&il, packet);
+		assert_int_equal(il.num_packets, reference_num);
+
+		/* count_before of any queued packet is its position */
+		size_t check = next_rand() % reference_num;
+		size_t track_size = packet_interleaver_track_size(&il, reference[check]->type, reference[check]->track_idx);
+		for (size_t j = 0; j < track_size; j++) {
+			struct interleaved_packet *queued = packet_interleaver_track_get(
+				&il, reference[check]->type, reference[check]->track_idx, j);
+			if (queued->packet.data == reference[check]->data) {
+				assert_int_equal(packet_interleaver_count_before(&il, queued), check);
+				break;
+			}
+		}
+
+		/* keep a buffer of `depth` packets, like the delay buffer or
+		 * waiting for the other tracks would */
+		while (reference_num > depth) {
+			assert_true(packet_interleaver_pop(&il, &out));
+			assert_ptr_equal(out.data, reference[0]->data);
+
+			memmove(reference, reference + 1, --reference_num * sizeof(*reference));
+			sent++;
+		}
+	}
+
+	while (packet_interleaver_pop(&il, &out)) {
+		assert_ptr_equal(out.data, reference[0]->data);
+		memmove(reference, reference + 1, --reference_num * sizeof(*reference));
+		sent++;
+	}
+
+	assert_int_equal(reference_num, 0);
+	assert_int_equal(sent, tl.packets.num);
+	assert_null(packet_interleaver_peek(&il));
+
+	packet_interleaver_free(&il);
+	bfree(reference);
+	da_free(tl.packets);
+}
+
+static void interleave_order_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	replay_timeline(1, 8);
+	replay_timeline(2, 64);
+	replay_timeline(3, 1000);
+}
+
+static void interleave_ties_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* same DTS on everything: video first by track index, then audio in
+	 * the order it was queued */
+	static const struct {
+		enum obs_encoder_type type;
+		size_t track_idx;
+	} pushed[] = {
+		{OBS_ENCODER_AUDIO, 3}, {OBS_ENCODER_VIDEO, 2}, {OBS_ENCODER_AUDIO, 0},
+		{OBS_ENCODER_VIDEO, 0}, {OBS_ENCODER_AUDIO, 1}, {OBS_ENCODER_VIDEO, 1},
+	};
+	static const size_t expected[] = {3, 5, 1, 0, 2, 4};
+
+	struct packet_interleaver il = {0};
+	struct encoder_packet packet = {0};
+
+	for (size_t i = 0; i < sizeof(pushed) / sizeof(pushed[0]); i++) {
+		packet.type = pushed[i].type;
+		packet.track_idx = pushed[i].track_idx;
+		packet.size = i;
+		packet_interleaver_push(&il, &packet);
+	}
+
+	for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+		assert_true(packet_interleaver_pop(&il, &packet));
+		assert_int_equal(packet.size, expected[i]);
+	}
+
+	assert_false(packet_interleaver_pop(&il, &packet));
+	packet_interleaver_free(&il);
+}
+
+static void interleave_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	struct timeline tl;
+	struct packet_interleaver il = {0};
+	struct encoder_packet out;
+	struct encoder_packet **reference;
+	size_t reference_num = 0;
+	size_t depth = 0;
+
+	create_timeline(&tl, 4);
+	reference = bmalloc(tl.packets.num * sizeof(*reference));
+
+	/* roughly a 10 second stream delay worth of packets */
+	depth = tl.packets.num / TIMELINE_SECONDS * 10;
+
+	uint64_t start = os_gettime_ns();
+	for (size_t i = 0; i < tl.packets.num; i++) {
+		reference_insert(reference, &reference_num, &tl.packets.array[i]);
+		if (reference_num > depth)
+			memmove(reference, reference + 1, --reference_num * sizeof(*reference));
+	}
+	uint64_t array_time = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (size_t i = 0; i < tl.packets.num; i++) {
+		packet_interleaver_push(&il, &tl.packets.array[i]);
+		if (il.num_packets > depth)
+			packet_interleaver_pop(&il, &out);
+	}
+	uint64_t queue_time = os_gettime_ns() - start;
+
+	printf("sorted array: %8.1f ns/packet\n", (double)array_time / (double)tl.packets.num);
+	printf("track queues: %8.1f ns/packet\n", (double)queue_time / (double)tl.packets.num);
+
+	packet_interleaver_free(&il);
+	bfree(reference);
+	da_free(tl.packets);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(interleave_order_test),
+		cmocka_unit_test(interleave_ties_test),
+	};
+
+	/* timing only, not run by ctest unless OBS_TEST_BENCHMARK is set */
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(interleave_benchmark),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("OBS_TEST_BENCHMARK"))
+		ret = cmocka_run_group_tests(benchmarks, NULL, NULL);
+	return ret;
+}
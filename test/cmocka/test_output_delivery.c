@@ -0,0 +1,572 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <obs.h>
+#include <media-io/video-frame.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#define QUEUE_SIZE 4
+#define MAX_RECEIVED 4096
+#define FPS 100
+#define KEYFRAME_INTERVAL 25
+#define BLOCKED_CHECK_MS 100
+#define TIMEOUT_MS 10000
+
+/* video packets carry the id of the frame they were encoded from and
+ * whether it is a keyframe */
+#define PACKET_SIZE (sizeof(uint32_t) + 1)
+
+/* an output that only takes packets while its gate is open, so the
+ * delivery queue fills up behind it */
+struct test_consumer {
+	obs_output_t *output;
+	os_event_t *gate;
+	os_event_t *stopped;
+
+	pthread_mutex_t mutex;
+	uint32_t video_ids[MAX_RECEIVED];
+	bool video_keyframes[MAX_RECEIVED];
+	size_t num_video;
+	size_t num_audio;
+
+	int stop_code;
+	bool had_last_error;
+	long stop_signals;
+};
+
+/* feeds frames into the video output in real time, every
+ * KEYFRAME_INTERVAL-th frame is a keyframe */
+struct test_camera {
+	video_t *video;
+	pthread_t thread;
+	os_event_t *stop;
+	uint32_t next_id;
+};
+
+struct test_state {
+	video_t *video;
+	audio_t *audio;
+	obs_encoder_t *video_encoder;
+	obs_encoder_t *audio_encoder;
+	struct test_camera camera;
+};
+
+static struct test_consumer consumer;
+
+/* ------------------------------------------------------------------------- */
+/* output */
+
+static const char *test_output_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "Delivery test output";
+}
+
+static void *test_output_create(obs_data_t *settings, obs_output_t *output)
+{
+	UNUSED_PARAMETER(settings);
+
+	consumer.output = output;
+	return &consumer;
+}
+
+static void test_output_destroy(void *data)
+{
+	UNUSED_PARAMETER(data);
+}
+
+static bool test_output_start(void *data)
+{
+	struct test_consumer *c = data;
+
+	if (!obs_output_can_begin_data_capture(c->output, 0))
+		return false;
+	if (!obs_output_initialize_encoders(c->output, 0))
+		return false;
+
+	return obs_output_begin_data_capture(c->output, 0);
+}
+
+static void test_output_stop(void *data, uint64_t ts)
+{
+	struct test_consumer *c = data;
+
+	UNUSED_PARAMETER(ts);
+	obs_output_end_data_capture(c->output);
+}
+
+static void test_output_encoded_packet(void *data, struct encoder_packet *packet)
+{
+	struct test_consumer *c = data;
+
+	if (!packet)
+		return;
+
+	os_event_wait(c->gate);
+
+	pthread_mutex_lock(&c->mutex);
+	if (packet->type == OBS_ENCODER_VIDEO) {
+		if (c->num_video < MAX_RECEIVED) {
+			memcpy(&c->video_ids[c->num_video], packet->data, sizeof(uint32_t));
+			c->video_keyframes[c->num_video] = packet->keyframe;
+			c->num_video++;
+		}
+	} else {
+		c->num_audio++;
+	}
+	pthread_mutex_unlock(&c->mutex);
+}
+
+static struct obs_output_info test_output = {
+	.id = "delivery_test_output",
+	.flags = OBS_OUTPUT_AV | OBS_OUTPUT_ENCODED,
+	.get_name = test_output_name,
+	.create = test_output_create,
+	.destroy = test_output_destroy,
+	.start = test_output_start,
+	.stop = test_output_stop,
+	.encoded_packet = test_output_encoded_packet,
+};
+
+static void stop_callback(void *data, calldata_t *cd)
+{
+	struct test_consumer *c = data;
+
+	c->stop_code = (int)calldata_int(cd, "code");
+	c->had_last_error = calldata_string(cd, "last_error") != NULL;
+	os_atomic_inc_long(&c->stop_signals);
+	os_event_signal(c->stopped);
+}
+
+/* ------------------------------------------------------------------------- */
+/* encoders */
+
+static const char *test_video_encoder_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "Delivery test video encoder";
+}
+
+static const char *test_audio_encoder_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return "Delivery test audio encoder";
+}
+
+static void *test_encoder_create(obs_data_t *settings, obs_encoder_t *encoder)
+{
+	UNUSED_PARAMETER(settings);
+	UNUSED_PARAMETER(encoder);
+	return bzalloc(PACKET_SIZE);
+}
+
+static void test_encoder_destroy(void *data)
+{
+	bfree(data);
+}
+
+static bool test_video_encode(void *data, struct encoder_frame *frame, struct encoder_packet *packet,
+			      bool *received_packet)
+{
+	uint8_t *packet_data = data;
+
+	memcpy(packet_data, frame->data[0], PACKET_SIZE);
+
+	packet->data = packet_data;
+	packet->size = PACKET_SIZE;
+	packet->pts = frame->pts;
+	packet->dts = frame->pts;
+	packet->type = OBS_ENCODER_VIDEO;
+	packet->keyframe = packet_data[sizeof(uint32_t)] != 0;
+	*received_packet = true;
+	return true;
+}
+
+static bool test_audio_encode(void *data, struct encoder_frame *frame, struct encoder_packet *packet,
+			      bool *received_packet)
+{
+	packet->data = data;
+	packet->size = 1;
+	packet->pts = frame->pts;
+	packet->dts = frame->pts;
+	packet->type = OBS_ENCODER_AUDIO;
+	packet->keyframe = true;
+	*received_packet = true;
+	return true;
+}
+
+static size_t test_audio_frame_size(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return 1024;
+}
+
+static struct obs_encoder_info test_video_encoder = {
+	.id = "delivery_test_video",
+	.type = OBS_ENCODER_VIDEO,
+	.codec = "h264",
+	.get_name = test_video_encoder_name,
+	.create = test_encoder_create,
+	.destroy = test_encoder_destroy,
+	.encode = test_video_encode,
+};
+
+static struct obs_encoder_info test_audio_encoder = {
+	.id = "delivery_test_audio",
+	.type = OBS_ENCODER_AUDIO,
+	.codec = "aac",
+	.get_name = test_audio_encoder_name,
+	.create = test_encoder_create,
+	.destroy = test_encoder_destroy,
+	.encode = test_audio_encode,
+	.get_frame_size = test_audio_frame_size,
+};
+
+/* silence, the timestamps are all that matters */
+static bool test_audio_input(void *param, uint64_t start_ts, uint64_t end_ts, uint64_t *new_ts,
+			     uint32_t active_mixers, struct audio_output_data *mixes)
+{
+	UNUSED_PARAMETER(param);
+	UNUSED_PARAMETER(end_ts);
+	UNUSED_PARAMETER(active_mixers);
+	UNUSED_PARAMETER(mixes);
+
+	*new_ts = start_ts;
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* camera */
+
+static void *camera_thread(void *data)
+{
+	struct test_camera *camera = data;
+	const uint64_t interval = 1000000000ULL / FPS;
+	uint64_t next_ts = os_gettime_ns();
+
+	while (os_event_try(camera->stop) == EAGAIN) {
+		struct video_frame frame;
+
+		/* when the video output is backed up, video-io repeats the
+		 * previous frame instead, so the id doesn't advance */
+		if (video_output_lock_frame(camera->video, &frame, 1, next_ts)) {
+			uint32_t id = camera->next_id++;
+
+			memcpy(frame.data[0], &id, sizeof(id));
+			frame.data[0][sizeof(id)] = id % KEYFRAME_INTERVAL == 0;
+			video_output_unlock_frame(camera->video);
+		}
+
+		next_ts += interval;
+		os_sleepto_ns(next_ts);
+	}
+
+	return NULL;
+}
+
+static void camera_start(struct test_camera *camera, video_t *video)
+{
+	camera->video = video;
+	camera->next_id = 0;
+	assert_int_equal(os_event_init(&camera->stop, OS_EVENT_TYPE_MANUAL), 0);
+	assert_int_equal(pthread_create(&camera->thread, NULL, camera_thread, camera), 0);
+}
+
+static void camera_stop(struct test_camera *camera)
+{
+	if (!camera->stop)
+		return;
+
+	os_event_signal(camera->stop);
+	pthread_join(camera->thread, NULL);
+	os_event_destroy(camera->stop);
+	camera->stop = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static size_t num_video_received(void)
+{
+	pthread_mutex_lock(&consumer.mutex);
+	size_t num = consumer.num_video;
+	pthread_mutex_unlock(&consumer.mutex);
+	return num;
+}
+
+static struct obs_output_delivery_stats get_stats(void)
+{
+	struct obs_output_delivery_stats stats;
+
+	assert_true(obs_output_get_delivery_stats(consumer.output, &stats));
+	return stats;
+}
+
+#define wait_until(condition)                                                 \
+	do {                                                                  \
+		uint64_t end_ts = os_gettime_ns() + TIMEOUT_MS * 1000000ULL; \
+		while (!(condition)) {                                        \
+			assert_true(os_gettime_ns() < end_ts);                \
+			os_sleep_ms(1);                                       \
+		}                                                             \
+	} while (false)
+
+/* a video track can only continue after a gap from a keyframe */
+static void check_gaps_start_at_keyframes(void)
+{
+	pthread_mutex_lock(&consumer.mutex);
+	for (size_t i = 1; i < consumer.num_video; i++) {
+		if (consumer.video_ids[i] > consumer.video_ids[i - 1] + 1)
+			assert_true(consumer.video_keyframes[i]);
+	}
+	pthread_mutex_unlock(&consumer.mutex);
+}
+
+static bool has_gaps(void)
+{
+	bool gaps = false;
+
+	pthread_mutex_lock(&consumer.mutex);
+	for (size_t i = 1; i < consumer.num_video; i++) {
+		if (consumer.video_ids[i] > consumer.video_ids[i - 1] + 1)
+			gaps = true;
+	}
+	pthread_mutex_unlock(&consumer.mutex);
+	return gaps;
+}
+
+static int setup(void **state)
+{
+	struct test_state *ts = bzalloc(sizeof(*ts));
+	*state = ts;
+
+	if (!obs_initialized())
+		return 0;
+
+	struct video_output_info voi = {
+		.name = "delivery test",
+		.format = VIDEO_FORMAT_I420,
+		.fps_num = FPS,
+		.fps_den = 1,
+		.width = 16,
+		.height = 16,
+		.cache_size = 16,
+		.colorspace = VIDEO_CS_709,
+		.range = VIDEO_RANGE_PARTIAL,
+	};
+	struct audio_output_info aoi = {
+		.name = "delivery test",
+		.samples_per_sec = 48000,
+		.format = AUDIO_FORMAT_FLOAT_PLANAR,
+		.speakers = SPEAKERS_STEREO,
+		.input_callback = test_audio_input,
+	};
+
+	if (video_output_open(&ts->video, &voi) != VIDEO_OUTPUT_SUCCESS)
+		return -1;
+	if (audio_output_open(&ts->audio, &aoi) != AUDIO_OUTPUT_SUCCESS)
+		return -1;
+
+	memset(&consumer, 0, sizeof(consumer));
+	if (os_event_init(&consumer.gate, OS_EVENT_TYPE_MANUAL) != 0)
+		return -1;
+	if (os_event_init(&consumer.stopped, OS_EVENT_TYPE_MANUAL) != 0)
+		return -1;
+	if (pthread_mutex_init(&consumer.mutex, NULL) != 0)
+		return -1;
+	os_event_signal(consumer.gate);
+
+	ts->video_encoder = obs_video_encoder_create("delivery_test_video", "delivery test video", NULL, NULL);
+	ts->audio_encoder = obs_audio_encoder_create("delivery_test_audio", "delivery test audio", NULL, 0, NULL);
+	if (!obs_output_create("delivery_test_output", "delivery test", NULL, NULL))
+		return -1;
+
+	obs_encoder_set_video(ts->video_encoder, ts->video);
+	obs_encoder_set_audio(ts->audio_encoder, ts->audio);
+	obs_output_set_video_encoder(consumer.output, ts->video_encoder);
+	obs_output_set_audio_encoder(consumer.output, ts->audio_encoder, 0);
+
+	signal_handler_connect(obs_output_get_signal_handler(consumer.output), "stop", stop_callback, &consumer);
+	return 0;
+}
+
+static int teardown(void **state)
+{
+	struct test_state *ts = *state;
+
+	if (!obs_initialized()) {
+		bfree(ts);
+		return 0;
+	}
+
+	if (consumer.output) {
+		os_event_signal(consumer.gate);
+		obs_output_release(consumer.output);
+		consumer.output = NULL;
+	}
+
+	camera_stop(&ts->camera);
+	obs_encoder_release(ts->video_encoder);
+	obs_encoder_release(ts->audio_encoder);
+	video_output_close(ts->video);
+	audio_output_close(ts->audio);
+
+	pthread_mutex_destroy(&consumer.mutex);
+	os_event_destroy(consumer.stopped);
+	os_event_destroy(consumer.gate);
+	bfree(ts);
+	return 0;
+}
+
+/* starts the output with its gate open, and returns once video is flowing */
+static void start_output(struct test_state *ts, enum obs_output_delivery_overflow overflow)
+{
+	obs_output_set_delivery_queue(consumer.output, QUEUE_SIZE, overflow);
+	assert_true(obs_output_start(consumer.output));
+
+	camera_start(&ts->camera, ts->video);
+	wait_until(num_video_received() > 0);
+}
+
+static void stop_output(struct test_state *ts)
+{
+	os_event_signal(consumer.gate);
+	obs_output_stop(consumer.output);
+	wait_until(!obs_output_active(consumer.output));
+	camera_stop(&ts->camera);
+}
+
+static void delivery_block_test(void **state)
+{
+	struct test_state *ts = *state;
+	struct obs_output_delivery_stats stats;
+
+	if (!obs_initialized())
+		skip();
+
+	start_output(ts, OBS_OUTPUT_DELIVERY_BLOCK);
+
+	/* the encoders have to wait for the output instead of dropping */
+	os_event_reset(consumer.gate);
+	wait_until(get_stats().queued == QUEUE_SIZE);
+	os_sleep_ms(BLOCKED_CHECK_MS);
+
+	stats = get_stats();
+	assert_int_equal(stats.queued, QUEUE_SIZE);
+	assert_int_equal(stats.dropped, 0);
+
+	size_t num_video = num_video_received();
+	os_event_signal(consumer.gate);
+	wait_until(num_video_received() > num_video + KEYFRAME_INTERVAL);
+
+	stop_output(ts);
+
+	assert_false(has_gaps());
+
+	stats = get_stats();
+	assert_true(stats.delivered > 0);
+	assert_int_equal(stats.dropped, 0);
+	assert_int_equal(stats.peak_queued, QUEUE_SIZE);
+	assert_int_equal(obs_output_get_frames_dropped(consumer.output), 0);
+	assert_int_equal(os_atomic_load_long(&consumer.stop_signals), 1);
+	assert_int_equal(consumer.stop_code, OBS_OUTPUT_SUCCESS);
+}
+
+static void delivery_drop_non_key_test(void **state)
+{
+	struct test_state *ts = *state;
+	struct obs_output_delivery_stats stats;
+
+	if (!obs_initialized())
+		skip();
+
+	start_output(ts, OBS_OUTPUT_DELIVERY_DROP_NON_KEY);
+
+	/* video frames are dropped once the queue is full, audio is not */
+	os_event_reset(consumer.gate);
+	wait_until(get_stats().dropped > 0);
+
+	size_t num_video = num_video_received();
+	os_event_signal(consumer.gate);
+	wait_until(num_video_received() > num_video + KEYFRAME_INTERVAL * 2);
+
+	stop_output(ts);
+
+	assert_true(has_gaps());
+	check_gaps_start_at_keyframes();
+
+	stats = get_stats();
+	assert_true(stats.dropped > 0);
+	assert_true(stats.peak_queued <= QUEUE_SIZE * 2);
+	assert_int_equal(obs_output_get_frames_dropped(consumer.output), (int)stats.dropped);
+	assert_int_equal(consumer.stop_code, OBS_OUTPUT_SUCCESS);
+}
+
+static void delivery_error_test(void **state)
+{
+	struct test_state *ts = *state;
+	struct obs_output_delivery_stats stats;
+
+	if (!obs_initialized())
+		skip();
+
+	start_output(ts, OBS_OUTPUT_DELIVERY_ERROR);
+
+	/* overflowing fails the queue, the output is stopped with an error
+	 * once the delivery thread gets to it */
+	os_event_reset(consumer.gate);
+	wait_until(get_stats().dropped > 0);
+
+	os_event_signal(consumer.gate);
+	assert_int_equal(os_event_wait(consumer.stopped), 0);
+	wait_until(!obs_output_active(consumer.output));
+	camera_stop(&ts->camera);
+
+	assert_int_equal(os_atomic_load_long(&consumer.stop_signals), 1);
+	assert_int_equal(consumer.stop_code, OBS_OUTPUT_ERROR);
+	assert_true(consumer.had_last_error);
+	assert_non_null(obs_output_get_last_error(consumer.output));
+
+	stats = get_stats();
+	assert_true(stats.dropped > 0);
+	assert_true(stats.peak_queued <= QUEUE_SIZE);
+	assert_true(obs_output_get_frames_dropped(consumer.output) <= (int)stats.dropped);
+}
+
+static int group_setup(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* needs a display for hotkeys on Linux, the tests are skipped
+	 * without one */
+	if (!obs_startup("en-US", NULL, NULL))
+		return 0;
+
+	obs_register_output(&test_output);
+	obs_register_encoder(&test_video_encoder);
+	obs_register_encoder(&test_audio_encoder);
+	return 0;
+}
+
+static int group_teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	if (obs_initialized())
+		obs_shutdown();
+	return 0;
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(delivery_block_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(delivery_drop_non_key_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(delivery_error_test, setup, teardown),
+	};
+
+	return cmocka_run_group_tests(tests, group_setup, group_teardown);
+}
@@ -0,0 +1,266 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <util/ring.h>
+#include <util/deque.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+#define NUM_PRODUCERS 4
+#define NUM_TEST_ITEMS 20000
+#define NUM_BENCH_ITEMS 500000
+#define RING_SIZE 1024
+
+/* values are tagged with the producer index in the upper bits so the
+ * consumer can check that every producer's items arrive in order */
+#define PRODUCER_SHIFT 24
+
+enum queue_type {
+	QUEUE_SPSC,
+	QUEUE_MPSC,
+	QUEUE_DEQUE,
+};
+
+struct queue_test {
+	enum queue_type type;
+	uint32_t num_items;
+	os_spsc_ring_t *spsc;
+	os_mpsc_ring_t *mpsc;
+	struct os_ring_waiter waiter;
+
+	pthread_mutex_t mutex;
+	os_sem_t *sem;
+	struct deque deque;
+
+	long next[NUM_PRODUCERS];
+	long errors;
+};
+
+struct producer {
+	struct queue_test *test;
+	uint32_t tag;
+};
+
+static bool queue_push(struct queue_test *test, uint32_t val)
+{
+	switch (test->type) {
+	case QUEUE_SPSC:
+		return os_spsc_ring_push(test->spsc, &val);
+	case QUEUE_MPSC:
+		return os_mpsc_ring_push(test->mpsc, &val);
+	case QUEUE_DEQUE:
+		pthread_mutex_lock(&test->mutex);
+		deque_push_back(&test->deque, &val, sizeof(val));
+		pthread_mutex_unlock(&test->mutex);
+		os_sem_post(test->sem);
+		return true;
+	}
+
+	return false;
+}
+
+static bool ring_pop(struct queue_test *test, uint32_t *val)
+{
+	return test->type == QUEUE_SPSC ? os_spsc_ring_pop(test->spsc, val) : os_mpsc_ring_pop(test->mpsc, val);
+}
+
+static size_t ring_size(struct queue_test *test)
+{
+	return test->type == QUEUE_SPSC ? os_spsc_ring_size(test->spsc) : os_mpsc_ring_size(test->mpsc);
+}
+
+static void queue_pop(struct queue_test *test, uint32_t *val)
+{
+	if (test->type == QUEUE_DEQUE) {
+		os_sem_wait(test->sem);
+		pthread_mutex_lock(&test->mutex);
+		deque_pop_front(&test->deque, val, sizeof(*val));
+		pthread_mutex_unlock(&test->mutex);
+		return;
+	}
+
+	while (!ring_pop(test, val)) {
+		os_ring_waiter_prepare(&test->waiter);
+		if (ring_size(test)) {
+			os_ring_waiter_cancel(&test->waiter);
+			continue;
+		}
+
+		os_ring_waiter_wait(&test->waiter);
+	}
+}
+
+static void *producer_thread(void *data)
+{
+	struct producer *producer = data;
+	struct queue_test *test = producer->test;
+
+	for (uint32_t i = 0; i < test->num_items; i++) {
+		while (!queue_push(test, producer->tag | i)) {
+			/* full, make sure the consumer is running */
+			os_ring_waiter_notify(&test->waiter);
+			os_sleep_ms(0);
+		}
+
+		if (test->type != QUEUE_DEQUE)
+			os_ring_waiter_notify(&test->waiter);
+	}
+
+	return NULL;
+}
+
+/* returns the time it took to pass all items through the queue */
+static uint64_t run_queue(enum queue_type type, int num_producers, uint32_t num_items)
+{
+	struct queue_test test = {0};
+	struct producer producers[NUM_PRODUCERS];
+	pthread_t threads[NUM_PRODUCERS];
+	long total = (long)num_producers * num_items;
+
+	test.type = type;
+	test.num_items = num_items;
+	test.spsc = os_spsc_ring_create(sizeof(uint32_t), RING_SIZE);
+	test.mpsc = os_mpsc_ring_create(sizeof(uint32_t), RING_SIZE);
+	assert_non_null(test.spsc);
+	assert_non_null(test.mpsc);
+	assert_int_equal(os_ring_waiter_init(&test.waiter), 0);
+	assert_int_equal(pthread_mutex_init(&test.mutex, NULL), 0);
+	assert_int_equal(os_sem_init(&test.sem, 0), 0);
+
+	uint64_t start = os_gettime_ns();
+
+	for (int i = 0; i < num_producers; i++) {
+		producers[i].test = &test;
+		producers[i].tag = (uint32_t)i << PRODUCER_SHIFT;
+		assert_int_equal(pthread_create(&threads[i], NULL, producer_thread, &producers[i]), 0);
+	}
+
+	for (long i = 0; i < total; i++) {
+		uint32_t val;
+		queue_pop(&test, &val);
+
+		uint32_t producer = val >> PRODUCER_SHIFT;
+		uint32_t seq = val & ((1 << PRODUCER_SHIFT) - 1);
+
+		if (producer >= (uint32_t)num_producers || seq != (uint32_t)test.next[producer]++)
+			test.errors++;
+	}
+
+	for (int i = 0; i < num_producers; i++)
+		pthread_join(threads[i], NULL);
+
+	uint64_t elapsed = os_gettime_ns() - start;
+
+	assert_int_equal(test.errors, 0);
+
+	os_sem_destroy(test.sem);
+	pthread_mutex_destroy(&test.mutex);
+	deque_free(&test.deque);
+	os_ring_waiter_free(&test.waiter);
+	os_mpsc_ring_destroy(test.mpsc);
+	os_spsc_ring_destroy(test.spsc);
+	return elapsed;
+}
+
+static void bench_queue(enum queue_type type, int num_producers, const char *name)
+{
+	uint64_t elapsed = run_queue(type, num_producers, NUM_BENCH_ITEMS);
+	double total = (double)num_producers * NUM_BENCH_ITEMS;
+
+	printf("%-28s %10.0f ops/s\n", name, total * 1000000000.0 / (double)(elapsed ? elapsed : 1));
+}
+
+static void ring_basic_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	os_spsc_ring_t *spsc = os_spsc_ring_create(sizeof(uint64_t), 5);
+	os_mpsc_ring_t *mpsc = os_mpsc_ring_create(sizeof(uint64_t), 5);
+	uint64_t val;
+
+	assert_int_equal(os_spsc_ring_capacity(spsc), 8);
+	assert_int_equal(os_mpsc_ring_capacity(mpsc), 8);
+
+	/* wrap around a few times */
+	for (uint64_t round = 0; round < 3; round++) {
+		for (uint64_t i = 0; i < 8; i++) {
+			val = round * 100 + i;
+			assert_true(os_spsc_ring_push(spsc, &val));
+			assert_true(os_mpsc_ring_push(mpsc, &val));
+		}
+
+		assert_false(os_spsc_ring_push(spsc, &val));
+		assert_false(os_mpsc_ring_push(mpsc, &val));
+		assert_int_equal(os_spsc_ring_size(spsc), 8);
+		assert_int_equal(os_mpsc_ring_size(mpsc), 8);
+
+		for (uint64_t i = 0; i < 8; i++) {
+			assert_true(os_spsc_ring_pop(spsc, &val));
+			assert_int_equal(val, round * 100 + i);
+			assert_true(os_mpsc_ring_pop(mpsc, &val));
+			assert_int_equal(val, round * 100 + i);
+		}
+
+		assert_false(os_spsc_ring_pop(spsc, &val));
+		assert_false(os_mpsc_ring_pop(mpsc, &val));
+		assert_int_equal(os_spsc_ring_size(spsc), 0);
+		assert_int_equal(os_mpsc_ring_size(mpsc), 0);
+	}
+
+	os_mpsc_ring_destroy(mpsc);
+	os_spsc_ring_destroy(spsc);
+}
+
+static void ring_spsc_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	run_queue(QUEUE_SPSC, 1, NUM_TEST_ITEMS);
+}
+
+static void ring_mpsc_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	run_queue(QUEUE_MPSC, NUM_PRODUCERS, NUM_TEST_ITEMS);
+}
+
+static void ring_spsc_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	bench_queue(QUEUE_DEQUE, 1, "deque + mutex, 1 producer");
+	bench_queue(QUEUE_SPSC, 1, "spsc ring, 1 producer");
+}
+
+static void ring_mpsc_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	bench_queue(QUEUE_DEQUE, NUM_PRODUCERS, "deque + mutex, 4 producers");
+	bench_queue(QUEUE_MPSC, NUM_PRODUCERS, "mpsc ring, 4 producers");
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(ring_basic_test),
+		cmocka_unit_test(ring_spsc_test),
+		cmocka_unit_test(ring_mpsc_test),
+	};
+
+	/* timing only, not run by ctest unless OBS_TEST_BENCHMARK is set */
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(ring_spsc_benchmark),
+		cmocka_unit_test(ring_mpsc_benchmark),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("OBS_TEST_BENCHMARK"))
+		ret = cmocka_run_group_tests(benchmarks, NULL, NULL);
+	return ret;
+}
@@ -0,0 +1,254 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "rtmp-stream.h"
+
+#define WRITE_BUF_SIZE (64 * 1024)
+#define SOCKET_BUF_SIZE 4096
+#define CHUNK_SIZE 1000
+#define TIMEOUT_MS 10000
+
+/* runs the linux socket loop against one end of a socketpair, the test plays
+ * both the send thread (filling write_buf) and the server (the other end) */
+struct loop_test {
+	struct rtmp_stream stream;
+	pthread_t thread;
+	bool thread_active;
+	int peer;
+	uint8_t next_out;
+	uint8_t next_in;
+	size_t total_out;
+	size_t total_in;
+};
+
+#define wait_until(condition)                                                 \
+	do {                                                                  \
+		uint64_t end_ts = os_gettime_ns() + TIMEOUT_MS * 1000000ULL; \
+		while (!(condition)) {                                        \
+			assert_true(os_gettime_ns() < end_ts);                \
+			os_sleep_ms(1);                                       \
+		}                                                             \
+	} while (false)
+
+static void set_buffer_size(int fd, int option, int size)
+{
+	assert_int_equal(setsockopt(fd, SOL_SOCKET, option, &size, sizeof(size)), 0);
+}
+
+static int setup(void **state)
+{
+	struct loop_test *test = bzalloc(sizeof(*test));
+	struct rtmp_stream *stream = &test->stream;
+	int fds[2];
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+		return -1;
+
+	/* small socket buffers so the loop runs into EAGAIN quickly */
+	set_buffer_size(fds[0], SO_SNDBUF, SOCKET_BUF_SIZE);
+	set_buffer_size(fds[1], SO_RCVBUF, SOCKET_BUF_SIZE);
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+	stream->rtmp.m_sb.sb_socket = fds[0];
+	test->peer = fds[1];
+
+	stream->write_buf_size = WRITE_BUF_SIZE;
+	stream->write_buf = bmalloc(WRITE_BUF_SIZE);
+	stream->disable_send_window_optimization = true;
+
+	if (pthread_mutex_init(&stream->write_buf_mutex, NULL) != 0)
+		return -1;
+	if (os_event_init(&stream->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		return -1;
+	if (os_event_init(&stream->buffer_space_available_event, OS_EVENT_TYPE_AUTO) != 0)
+		return -1;
+	if (os_event_init(&stream->send_thread_signaled_exit, OS_EVENT_TYPE_MANUAL) != 0)
+		return -1;
+
+	stream->socket_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (stream->socket_wake_fd == -1)
+		return -1;
+
+	if (pthread_create(&test->thread, NULL, socket_thread_linux, stream) != 0)
+		return -1;
+	test->thread_active = true;
+
+	*state = test;
+	return 0;
+}
+
+static void stop_loop(struct loop_test *test)
+{
+	struct rtmp_stream *stream = &test->stream;
+
+	if (!test->thread_active)
+		return;
+
+	os_event_signal(stream->send_thread_signaled_exit);
+	socket_thread_linux_wake(stream);
+	pthread_join(test->thread, NULL);
+	test->thread_active = false;
+}
+
+static int teardown(void **state)
+{
+	struct loop_test *test = *state;
+	struct rtmp_stream *stream = &test->stream;
+
+	/* a shut down socket makes the loop exit by itself */
+	if (test->peer != -1)
+		close(test->peer);
+	stop_loop(test);
+
+	if (stream->rtmp.m_sb.sb_socket != -1)
+		close(stream->rtmp.m_sb.sb_socket);
+	close(stream->socket_wake_fd);
+	os_event_destroy(stream->send_thread_signaled_exit);
+	os_event_destroy(stream->buffer_space_available_event);
+	os_event_destroy(stream->stop_event);
+	pthread_mutex_destroy(&stream->write_buf_mutex);
+	bfree(stream->write_buf);
+	bfree(test);
+	return 0;
+}
+
+/* what the send thread does when librtmp sends data, returns how much fit */
+static size_t queue_data(struct loop_test *test, size_t size)
+{
+	struct rtmp_stream *stream = &test->stream;
+	size_t queued;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	queued = stream->write_buf_size - stream->write_buf_len;
+	if (queued > size)
+		queued = size;
+
+	for (size_t i = 0; i < queued; i++)
+		stream->write_buf[stream->write_buf_len++] = test->next_out++;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+
+	test->total_out += queued;
+	socket_thread_linux_wake(stream);
+	return queued;
+}
+
+/* reads everything the loop sent so far, checking it arrives in order */
+static void receive_data(struct loop_test *test)
+{
+	uint8_t buf[SOCKET_BUF_SIZE];
+	ssize_t ret;
+
+	while ((ret = recv(test->peer, buf, sizeof(buf), 0)) > 0) {
+		for (ssize_t i = 0; i < ret; i++)
+			assert_int_equal(buf[i], test->next_in++);
+		test->total_in += (size_t)ret;
+	}
+}
+
+static size_t write_buf_len(struct loop_test *test)
+{
+	struct rtmp_stream *stream = &test->stream;
+
+	pthread_mutex_lock(&stream->write_buf_mutex);
+	size_t len = stream->write_buf_len;
+	pthread_mutex_unlock(&stream->write_buf_mutex);
+	return len;
+}
+
+/* the value rtmp_stream_congestion reports with the new socket loop */
+static float congestion(struct loop_test *test)
+{
+	return (float)write_buf_len(test) / (float)test->stream.write_buf_size;
+}
+
+static bool all_received(struct loop_test *test)
+{
+	receive_data(test);
+	return test->total_in == test->total_out;
+}
+
+static void buffered_write_test(void **state)
+{
+	struct loop_test *test = *state;
+
+	for (int i = 0; i < 3; i++) {
+		assert_int_equal(queue_data(test, CHUNK_SIZE), CHUNK_SIZE);
+		wait_until(all_received(test));
+	}
+
+	assert_int_equal(write_buf_len(test), 0);
+	assert_true(congestion(test) == 0.0f);
+
+	stop_loop(test);
+	assert_int_equal(test->stream.rtmp.m_sb.sb_socket != -1, true);
+	assert_int_equal(os_event_try(test->stream.send_thread_signaled_exit), EAGAIN);
+}
+
+static void blocked_socket_test(void **state)
+{
+	struct loop_test *test = *state;
+
+	/* nobody reads, so the socket fills up and the loop has to wait for
+	 * the next EPOLLOUT edge, with the rest left in write_buf */
+	assert_int_equal(queue_data(test, WRITE_BUF_SIZE), WRITE_BUF_SIZE);
+	os_sleep_ms(100);
+
+	size_t len = write_buf_len(test);
+	assert_true(len > 0);
+	assert_true(len < WRITE_BUF_SIZE);
+	assert_true(congestion(test) > 0.0f);
+	assert_true(congestion(test) <= 1.0f);
+
+	/* the buffer doesn't drain by itself */
+	os_sleep_ms(100);
+	assert_int_equal(write_buf_len(test), len);
+
+	/* once the server reads, writing resumes without being woken up */
+	wait_until(all_received(test));
+	assert_int_equal(test->total_in, WRITE_BUF_SIZE);
+	assert_int_equal(write_buf_len(test), 0);
+	assert_true(congestion(test) == 0.0f);
+}
+
+static void peer_close_test(void **state)
+{
+	struct loop_test *test = *state;
+	struct rtmp_stream *stream = &test->stream;
+
+	assert_int_equal(queue_data(test, WRITE_BUF_SIZE), WRITE_BUF_SIZE);
+	os_sleep_ms(100);
+	assert_true(write_buf_len(test) > 0);
+
+	/* the remote close is noticed through the socket, and whatever is
+	 * left in the buffer is dropped */
+	close(test->peer);
+	test->peer = -1;
+
+	pthread_join(test->thread, NULL);
+	test->thread_active = false;
+
+	assert_int_equal(stream->rtmp.m_sb.sb_socket, -1);
+	assert_int_equal(stream->write_buf_len, 0);
+	assert_true(stream->rtmp.last_error_code == ECONNRESET || stream->rtmp.last_error_code == EPIPE);
+	assert_int_equal(os_event_try(stream->buffer_space_available_event), 0);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(buffered_write_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(blocked_socket_test, setup, teardown),
+		cmocka_unit_test_setup_teardown(peer_close_test, setup, teardown),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,130 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <callback/signal.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#define NUM_SIGNALS 40
+#define NUM_CALLS 1000000
+
+struct signal_test {
+	long calls;
+	double volume;
+};
+
+static void test_callback(void *param, calldata_t *cd)
+{
+	struct signal_test *test = param;
+	double volume = 0.0;
+
+	calldata_get_float(cd, "volume", &volume);
+	test->volume += volume;
+	test->calls++;
+}
+
+static signal_handler_t *create_handler(void)
+{
+	signal_handler_t *handler = signal_handler_create();
+	struct dstr decl = {0};
+
+	/* like sources, lots of signals with the one being emitted last */
+	for (int i = 0; i < NUM_SIGNALS; i++) {
+		dstr_printf(&decl, "void test_signal_%d(ptr source, in out float volume)", i);
+		assert_true(signal_handler_add(handler, decl.array));
+	}
+
+	dstr_free(&decl);
+	return handler;
+}
+
+static void signal_id_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	signal_id_t id = signal_get_id("test_signal_0");
+	assert_non_null(id);
+	assert_ptr_equal(id, signal_get_id("test_signal_0"));
+	assert_true(id != signal_get_id("test_signal_1"));
+	assert_string_equal(signal_id_get_name(id), "test_signal_0");
+
+	signal_handler_t *handler = create_handler();
+	struct signal_test test = {0};
+	calldata_t cd = {0};
+
+	calldata_set_float(&cd, "volume", 1.0);
+
+	signal_handler_connect(handler, "test_signal_0", test_callback, &test);
+	signal_handler_signal(handler, "test_signal_0", &cd);
+	signal_handler_signal_id(handler, id, &cd);
+	assert_int_equal(test.calls, 2);
+
+	/* not declared on this handler */
+	signal_handler_signal_id(handler, signal_get_id("unknown_signal"), &cd);
+	assert_int_equal(test.calls, 2);
+
+	signal_handler_disconnect(handler, "test_signal_0", test_callback, &test);
+	signal_handler_signal_id(handler, id, &cd);
+	assert_int_equal(test.calls, 2);
+
+	calldata_free(&cd);
+	signal_handler_destroy(handler);
+}
+
+static void signal_benchmark(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	signal_handler_t *handler = create_handler();
+	struct signal_test test = {0};
+	calldata_t cd;
+	uint8_t stack[128];
+	char name[32];
+
+	snprintf(name, sizeof(name), "test_signal_%d", NUM_SIGNALS - 1);
+	signal_handler_connect(handler, name, test_callback, &test);
+	signal_id_t id = signal_get_id(name);
+
+	calldata_init_fixed(&cd, stack, sizeof(stack));
+	calldata_set_ptr(&cd, "source", NULL);
+	calldata_set_float(&cd, "volume", 1.0);
+
+	uint64_t start = os_gettime_ns();
+	for (int i = 0; i < NUM_CALLS; i++)
+		signal_handler_signal(handler, name, &cd);
+	uint64_t by_name = os_gettime_ns() - start;
+
+	start = os_gettime_ns();
+	for (int i = 0; i < NUM_CALLS; i++)
+		signal_handler_signal_id(handler, id, &cd);
+	uint64_t by_id = os_gettime_ns() - start;
+
+	printf("signal by name: %6.1f ns/call\n", (double)by_name / NUM_CALLS);
+	printf("signal by ID:   %6.1f ns/call\n", (double)by_id / NUM_CALLS);
+
+	assert_int_equal(test.calls, NUM_CALLS * 2);
+	assert_true(test.volume == (double)NUM_CALLS * 2.0);
+
+	signal_handler_destroy(handler);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(signal_id_test),
+	};
+
+	/* timing only, not run by ctest unless OBS_TEST_BENCHMARK is set */
+	const struct CMUnitTest benchmarks[] = {
+		cmocka_unit_test(signal_benchmark),
+	};
+
+	int ret = cmocka_run_group_tests(tests, NULL, NULL);
+	if (ret == 0 && getenv("OBS_TEST_BENCHMARK"))
+		ret = cmocka_run_group_tests(benchmarks, NULL, NULL);
+	return ret;
+}